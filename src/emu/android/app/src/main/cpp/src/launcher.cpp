@@ -68,6 +68,7 @@ namespace eka2l1::android {
     }
 
     std::vector<std::string> launcher::get_apps() {
+        alserv->refresh_registries();
         std::vector<apa_app_registry> &registerations = alserv->get_registerations();
         std::vector<std::string> info;
         for (auto &reg : registerations) {
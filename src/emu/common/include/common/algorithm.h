@@ -371,6 +371,22 @@ namespace eka2l1 {
          */
         bool is_platform_case_sensitive();
 
+        /**
+         * \brief Find the smallest and the largest value in an array of unsigned bytes.
+         *
+         * Uses SIMD on x64 and ARM64. The array does not need to be aligned.
+         * If the array is empty, min_value is set to 0xFF and max_value to 0.
+         */
+        void find_min_max(const std::uint8_t *data, const std::size_t count, std::uint8_t &min_value, std::uint8_t &max_value);
+
+        /**
+         * \brief Find the smallest and the largest value in an array of unsigned halfwords.
+         *
+         * Uses SIMD on x64 and ARM64. The array does not need to be aligned.
+         * If the array is empty, min_value is set to 0xFFFF and max_value to 0.
+         */
+        void find_min_max(const std::uint16_t *data, const std::size_t count, std::uint16_t &min_value, std::uint16_t &max_value);
+
         /**
          * \brief Count the number of leading zero bits.
          */
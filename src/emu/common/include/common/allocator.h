@@ -26,6 +26,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 
 namespace eka2l1::common {
@@ -57,17 +58,98 @@ namespace eka2l1::common {
         }
     };
 
+    /**
+     * @brief Statistics of a block allocator, useful to judge how fragmented the managed space is.
+     */
+    struct block_allocator_stats {
+        std::size_t total_size = 0; ///< Total bytes currently managed by the allocator.
+        std::size_t used_size = 0; ///< Total bytes handed out to active allocations.
+        std::size_t free_size = 0; ///< Total bytes sitting in free blocks.
+        std::size_t largest_free_block = 0; ///< Size of the largest free block.
+        std::size_t free_block_count = 0; ///< Number of free blocks.
+        std::size_t active_block_count = 0; ///< Number of active allocations.
+
+        std::uint64_t alloc_count = 0; ///< Number of successful allocations.
+        std::uint64_t free_count = 0; ///< Number of successful frees.
+        std::uint64_t failed_alloc_count = 0; ///< Number of allocations that can't be satisfied.
+        std::uint64_t coalesce_count = 0; ///< Number of times a freed block is merged with a neighbour.
+        std::uint64_t expand_count = 0; ///< Number of times the space is expanded.
+
+        /**
+         * @brief Get the external fragmentation ratio.
+         *
+         * 0 means all free space is in one block and can be handed out in one go, while a value
+         * near 1 means the free space is shattered into many small pieces.
+         */
+        double fragmentation() const {
+            return (free_size == 0) ? 0.0 : (1.0 - static_cast<double>(largest_free_block) / static_cast<double>(free_size));
+        }
+    };
+
+    /**
+     * @brief Two-level segregated fit (TLSF) allocator over a contiguous space.
+     *
+     * Block metadata is kept on the host side, so the managed memory stays untouched
+     * and can be shared with the guest. Allocation and free run in constant time, and
+     * freed blocks are merged with their free physical neighbours.
+     */
     class block_allocator : public space_based_allocator {
+    public:
+        static constexpr std::uint32_t ALIGN_SIZE_LOG2 = 3;
+        static constexpr std::uint32_t ALIGN_SIZE = 1 << ALIGN_SIZE_LOG2;
+
+        static constexpr std::uint32_t SL_INDEX_COUNT_LOG2 = 4;
+        static constexpr std::uint32_t SL_INDEX_COUNT = 1 << SL_INDEX_COUNT_LOG2;
+
+        static constexpr std::uint32_t FL_INDEX_MAX = 32;
+        static constexpr std::uint32_t FL_INDEX_SHIFT = SL_INDEX_COUNT_LOG2 + ALIGN_SIZE_LOG2;
+        static constexpr std::uint32_t FL_INDEX_COUNT = FL_INDEX_MAX - FL_INDEX_SHIFT + 1;
+
+        static constexpr std::size_t SMALL_BLOCK_SIZE = 1 << FL_INDEX_SHIFT;
+
+    private:
+        static constexpr std::uint32_t INVALID_BLOCK = 0xFFFFFFFF;
+
         struct block_info {
             std::uint64_t offset;
             std::size_t size;
 
+            std::uint32_t prev_phys = INVALID_BLOCK;
+            std::uint32_t next_phys = INVALID_BLOCK;
+
+            std::uint32_t prev_free = INVALID_BLOCK;
+            std::uint32_t next_free = INVALID_BLOCK;
+
             bool active{ false };
         };
 
         std::vector<block_info> blocks;
+        std::vector<std::uint32_t> unused_blocks;
+        std::unordered_map<std::uint64_t, std::uint32_t> active_blocks;
+
+        std::uint32_t fl_bitmap;
+        std::uint32_t sl_bitmap[FL_INDEX_COUNT];
+        std::uint32_t free_heads[FL_INDEX_COUNT][SL_INDEX_COUNT];
+
+        std::uint32_t last_block;
+        std::uint64_t managed_end;
+        std::size_t base_padding;
+
+        block_allocator_stats stats_;
         std::mutex lock;
 
+        std::uint32_t new_block(const std::uint64_t offset, const std::size_t size);
+        void recycle_block(const std::uint32_t index);
+
+        void insert_free_block(const std::uint32_t index);
+        void remove_free_block(const std::uint32_t index);
+        std::uint32_t search_suitable_block(const std::size_t size);
+
+        std::uint32_t merge_with_next(const std::uint32_t index);
+
+        void add_space();
+        bool grow(const std::size_t least_size);
+
     public:
         explicit block_allocator(std::uint8_t *sptr, const std::size_t initial_max_size);
 
@@ -77,6 +159,13 @@ namespace eka2l1::common {
         virtual bool expand(std::size_t target) override {
             return false;
         }
+
+        /**
+         * @brief Get statistics about the managed space.
+         *
+         * Counters are maintained on the fly; the largest free block is computed on demand.
+         */
+        block_allocator_stats stats();
     };
 
     struct bitmap_allocator {
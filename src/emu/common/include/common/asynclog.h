@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <common/asynclogarg.h>
+#include <common/log.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace eka2l1::log {
+    /**
+     * @brief Header of a log record. Encoded arguments follow it.
+     */
+    struct async_log_record {
+        std::uint64_t sequence_;
+        const char *format_;                    ///< Format string of the message. Must be a string literal.
+        const char *file_;
+        async_log_format_func format_func_;     ///< Decode the arguments and format the message.
+        std::int32_t line_;
+        std::uint16_t class_;
+        std::uint8_t level_;
+    };
+
+    /**
+     * @brief Single producer, single consumer ring of variable-sized log records.
+     *
+     * The producer is the thread owning the ring, the consumer is whoever drains the async logger.
+     */
+    class async_log_ring {
+        std::vector<std::uint8_t> buffer_;
+        std::size_t mask_;
+
+        std::atomic<std::size_t> head_;
+        std::atomic<std::size_t> tail_;
+        std::size_t pending_head_;
+
+        std::atomic<std::uint64_t> dropped_;
+        std::atomic<bool> retired_;
+
+    public:
+        static constexpr std::uint32_t WRAP_MARKER = 0xFFFFFFFF;
+
+        /**
+         * @param capacity      Size of the ring in bytes. Rounded up to a power of two.
+         */
+        explicit async_log_ring(const std::size_t capacity);
+
+        /**
+         * @brief Reserve space for a record. The record is not visible to the consumer until commit().
+         *
+         * @returns Pointer to write the record to, or nullptr if the ring is full. The record is then counted as dropped.
+         */
+        std::uint8_t *reserve(const std::size_t size);
+        void commit();
+
+        /**
+         * @brief Call a function on every committed record, in the order they were written.
+         *
+         * The records stay in the ring until release() is called with the returned position.
+         *
+         * @returns Position to pass to release().
+         */
+        template <typename F>
+        std::size_t peek(F func) const {
+            std::size_t tail = tail_.load(std::memory_order_relaxed);
+            const std::size_t head = head_.load(std::memory_order_acquire);
+
+            while (tail != head) {
+                const std::size_t index = tail & mask_;
+
+                std::uint32_t size = 0;
+                std::memcpy(&size, buffer_.data() + index, sizeof(std::uint32_t));
+
+                if (size == WRAP_MARKER) {
+                    tail += buffer_.size() - index;
+                    continue;
+                }
+
+                func(buffer_.data() + index + sizeof(std::uint64_t), size);
+                tail += entry_size(size);
+            }
+
+            return tail;
+        }
+
+        void release(const std::size_t position) {
+            tail_.store(position, std::memory_order_release);
+        }
+
+        static std::size_t entry_size(const std::size_t record_size) {
+            // Keep every record 8-byte aligned
+            return (sizeof(std::uint64_t) + record_size + 7) & ~static_cast<std::size_t>(7);
+        }
+
+        bool empty() const {
+            return tail_.load(std::memory_order_relaxed) == head_.load(std::memory_order_acquire);
+        }
+
+        std::uint64_t dropped() const {
+            return dropped_.load(std::memory_order_relaxed);
+        }
+
+        void retire() {
+            retired_.store(true, std::memory_order_release);
+        }
+
+        bool is_retired() const {
+            return retired_.load(std::memory_order_acquire);
+        }
+    };
+
+    struct async_log_stats {
+        std::uint64_t written_ = 0;
+        std::uint64_t dropped_ = 0;
+    };
+
+    /**
+     * @brief Log backend that moves formatting off the emulation threads.
+     *
+     * Each thread logging writes records into its own lock-free ring: a pointer to the format string plus the
+     * raw arguments. A background thread drains all rings, then formats and writes the messages sorted by the
+     * order they were pushed in. If a ring is full, the record is dropped and counted; the drain thread reports drops.
+     *
+     * Filtering is done by the LOG_* macros before a record is pushed, so filtered out classes cost nothing more.
+     */
+    class async_logger {
+        std::shared_ptr<spdlog::logger> target_;
+        std::size_t ring_capacity_;
+
+        std::uint64_t id_;
+
+        std::vector<std::shared_ptr<async_log_ring>> rings_;
+        std::mutex rings_lock_;
+        std::mutex drain_lock_;
+
+        std::atomic<std::uint64_t> sequence_;
+        std::uint64_t written_;
+        std::uint64_t dropped_of_freed_rings_;
+        std::uint64_t dropped_reported_;
+
+        std::thread drain_thread_;
+        std::condition_variable drain_cond_;
+        std::mutex drain_cond_lock_;
+        bool should_stop_;
+
+        async_log_ring &thread_ring();
+
+        std::uint8_t *begin_record(async_log_ring *&ring, const std::size_t args_size, const log_class cls,
+            const spdlog::level::level_enum level, const char *file, const int line, const char *format,
+            async_log_format_func format_func);
+
+        void write_record(const async_log_record &record, const std::uint8_t *args);
+
+        friend std::uint8_t *begin_async_log_record(async_logger *logger, async_log_ring *&ring, const std::size_t args_size,
+            const log_class cls, const spdlog::level::level_enum level, const char *file, const int line, const char *format,
+            async_log_format_func format_func);
+        void drain_thread_loop();
+
+    public:
+        static constexpr std::size_t DEFAULT_RING_CAPACITY = 256 * 1024;
+
+        /**
+         * @param target            Logger that formatted messages are written to.
+         * @param ring_capacity     Size in bytes of the ring given to each logging thread.
+         */
+        explicit async_logger(std::shared_ptr<spdlog::logger> target, const std::size_t ring_capacity = DEFAULT_RING_CAPACITY);
+        ~async_logger();
+
+        /**
+         * @brief Start the background thread draining the rings.
+         */
+        void start();
+
+        /**
+         * @brief Stop the background thread, writing all records pushed so far.
+         */
+        void stop();
+
+        /**
+         * @brief Write all records pushed so far on the caller thread.
+         *
+         * @returns Number of records written.
+         */
+        std::size_t flush();
+
+        async_log_stats stats();
+
+        template <typename... Args>
+        void push(const log_class cls, const spdlog::level::level_enum level, const char *file, const int line,
+            const char *format, const Args &...args) {
+            push_async_log(this, cls, level, file, line, format, args...);
+        }
+    };
+
+    extern std::atomic<async_logger *> active_async_logger;
+}
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <common/log.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+namespace eka2l1::log {
+    /**
+     * @brief Describe how an argument of a log message is stored in a record.
+     *
+     * Only arguments that can be copied without formatting are encoded: arithmetic types, enums,
+     * untyped pointers and strings. A message with any other argument is formatted on the calling thread.
+     */
+    template <typename T, typename = void>
+    struct async_log_arg {
+        static constexpr bool ENCODABLE = false;
+    };
+
+    template <typename T>
+    struct async_log_arg<T, std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_same_v<T, const void *> || std::is_same_v<T, void *>>> {
+        static constexpr bool ENCODABLE = true;
+        using decoded_type = T;
+
+        static std::size_t size(const T &) {
+            return sizeof(T);
+        }
+
+        static std::uint8_t *encode(std::uint8_t *dest, const T &value) {
+            std::memcpy(dest, &value, sizeof(T));
+            return dest + sizeof(T);
+        }
+
+        static T decode(const std::uint8_t *&source) {
+            T value;
+            std::memcpy(&value, source, sizeof(T));
+
+            source += sizeof(T);
+            return value;
+        }
+    };
+
+    struct async_log_string_arg {
+        static constexpr bool ENCODABLE = true;
+        using decoded_type = std::string_view;
+
+        static std::size_t size(const std::string_view value) {
+            return sizeof(std::uint32_t) + value.size();
+        }
+
+        static std::uint8_t *encode(std::uint8_t *dest, const std::string_view value) {
+            const std::uint32_t length = static_cast<std::uint32_t>(value.size());
+
+            std::memcpy(dest, &length, sizeof(std::uint32_t));
+            std::memcpy(dest + sizeof(std::uint32_t), value.data(), length);
+
+            return dest + sizeof(std::uint32_t) + length;
+        }
+
+        static std::string_view decode(const std::uint8_t *&source) {
+            std::uint32_t length = 0;
+            std::memcpy(&length, source, sizeof(std::uint32_t));
+
+            const std::string_view value(reinterpret_cast<const char *>(source + sizeof(std::uint32_t)), length);
+            source += sizeof(std::uint32_t) + length;
+
+            return value;
+        }
+    };
+
+    template <>
+    struct async_log_arg<std::string> : public async_log_string_arg {
+    };
+
+    template <>
+    struct async_log_arg<std::string_view> : public async_log_string_arg {
+    };
+
+    template <>
+    struct async_log_arg<const char *> : public async_log_string_arg {
+        static std::size_t size(const char *value) {
+            return async_log_string_arg::size(value ? std::string_view(value) : std::string_view());
+        }
+
+        static std::uint8_t *encode(std::uint8_t *dest, const char *value) {
+            return async_log_string_arg::encode(dest, value ? std::string_view(value) : std::string_view());
+        }
+    };
+
+    template <>
+    struct async_log_arg<char *> : public async_log_arg<const char *> {
+    };
+
+    using async_log_format_func = std::string (*)(const char *format, const std::uint8_t *args);
+
+    template <typename... Args>
+    std::string format_async_log_args(const char *format, [[maybe_unused]] const std::uint8_t *args) {
+        // Braced initialization decodes the arguments in order
+        std::tuple<typename async_log_arg<Args>::decoded_type...> decoded{ async_log_arg<Args>::decode(args)... };
+
+        return std::apply([format](const auto &...values) {
+            return fmt::vformat(format, fmt::make_format_args(values...));
+        },
+            decoded);
+    }
+
+    std::string format_async_log_preformatted(const char *format, const std::uint8_t *args);
+
+    class async_logger;
+    class async_log_ring;
+
+    /**
+     * @brief Get the logger the LOG_* macros push to, or nullptr if messages are written on the calling thread.
+     */
+    async_logger *get_async_logger();
+
+    /**
+     * @brief Reserve a record in the ring of the calling thread, and fill its header.
+     *
+     * @returns Pointer to write the encoded arguments to, or nullptr if the record was dropped.
+     */
+    std::uint8_t *begin_async_log_record(async_logger *logger, async_log_ring *&ring, const std::size_t args_size,
+        const log_class cls, const spdlog::level::level_enum level, const char *file, const int line, const char *format,
+        async_log_format_func format_func);
+
+    void commit_async_log_record(async_log_ring *ring);
+
+    /**
+     * @brief Push a message to an async logger.
+     *
+     * Only the argument encoding is here, so that the LOG_* macros do not need the whole logger. See asynclog.h.
+     */
+    template <typename... Args>
+    void push_async_log(async_logger *logger, const log_class cls, const spdlog::level::level_enum level, const char *file,
+        const int line, const char *format, const Args &...args) {
+        async_log_ring *ring = nullptr;
+
+        if constexpr ((async_log_arg<std::decay_t<Args>>::ENCODABLE && ...)) {
+            const std::size_t args_size = (static_cast<std::size_t>(0) + ... + async_log_arg<std::decay_t<Args>>::size(args));
+            std::uint8_t *dest = begin_async_log_record(logger, ring, args_size, cls, level, file, line, format,
+                format_async_log_args<std::decay_t<Args>...>);
+
+            if (!dest) {
+                return;
+            }
+
+            ((dest = async_log_arg<std::decay_t<Args>>::encode(dest, args)), ...);
+        } else {
+            const std::string message = fmt::vformat(format, fmt::make_format_args(args...));
+            std::uint8_t *dest = begin_async_log_record(logger, ring, async_log_string_arg::size(message), cls, level, file, line,
+                format, format_async_log_preformatted);
+
+            if (!dest) {
+                return;
+            }
+
+            async_log_string_arg::encode(dest, message);
+        }
+
+        commit_async_log_record(ring);
+    }
+
+    /**
+     * @brief Push a message to the async logger if there is one.
+     *
+     * @returns False if there is no async logger, and the message must be written on the calling thread.
+     */
+    template <typename... Args>
+    bool try_push_async_log(const log_class cls, const spdlog::level::level_enum level, const char *file, const int line,
+        const char *format, const Args &...args) {
+        async_logger *logger = get_async_logger();
+
+        if (!logger) {
+            return false;
+        }
+
+        push_async_log(logger, cls, level, file, line, format, args...);
+        return true;
+    }
+}
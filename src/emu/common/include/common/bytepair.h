@@ -38,6 +38,8 @@ namespace eka2l1 {
          *  \param dest_size The size of the destination buffer
          *  \param buffer The compressed data
          *  \param buf_size The compressed data size		 
+         *
+         *  \returns Number of bytes decompressed, or 0 if the pair table is damaged.
 		*/
         int bytepair_decompress(void *dest, unsigned int dest_size, void *buffer, unsigned int buf_size);
 
@@ -169,25 +169,67 @@ namespace eka2l1::common {
             return push(input.data(), input.size());
         }
 
-        /// Pops slots from the ring buffer
-        /// @param output     Where to store the popped slots
-        /// @param max_slots  Maximum number of slots to pop
-        /// @returns The number of slots actually popped
-        std::size_t pop(void* output, std::size_t max_slots = ~std::size_t(0)) {
+        /// A contiguous run of slots inside the ring buffer
+        struct segment {
+            T *data_ = nullptr;
+            std::size_t count_ = 0;
+        };
+
+        /// Gets the filled slots at the read position without copying them out.
+        /// The slots stay in the ring buffer until they are consumed.
+        /// @param max_slots  Maximum number of slots to return
+        /// @returns Up to two segments (the second one is non-empty if the data wraps around)
+        std::array<segment, 2> read_segments(std::size_t max_slots = ~std::size_t(0)) {
             const std::size_t read_index = read_index_.load();
             const std::size_t slots_filled = write_index_.load() - read_index;
             const std::size_t pop_count = std::min(slots_filled, max_slots);
 
             const std::size_t pos = read_index % capacity_;
-            const std::size_t first_copy = std::min(capacity_ - pos, pop_count);
-            const std::size_t second_copy = pop_count - first_copy;
+            const std::size_t first_count = std::min(capacity_ - pos, pop_count);
+
+            return { segment{ data_.data() + pos, first_count }, segment{ data_.data(), pop_count - first_count } };
+        }
+
+        /// Releases slots previously returned by read_segments
+        /// @param slot_count  Number of slots to release
+        void consume(std::size_t slot_count) {
+            read_index_.store(read_index_.load() + std::min(slot_count, size()));
+        }
+
+        /// Gets the free slots at the write position, so that the producer can fill them in place.
+        /// The slots are not readable until they are committed.
+        /// @returns The contiguous free segment; may be smaller than the total free space if it wraps around
+        segment write_segment() {
+            const std::size_t write_index = write_index_.load();
+            const std::size_t slots_free = capacity_ + read_index_.load() - write_index;
+            const std::size_t pos = write_index % capacity_;
+
+            return segment{ data_.data() + pos, std::min(capacity_ - pos, slots_free) };
+        }
+
+        /// Makes slots filled through write_segment available for reading
+        /// @param slot_count  Number of slots written
+        void commit(std::size_t slot_count) {
+            const std::size_t write_index = write_index_.load();
+            const std::size_t slots_free = capacity_ + read_index_.load() - write_index;
+
+            write_index_.store(write_index + std::min(slot_count, slots_free));
+        }
+
+        /// Pops slots from the ring buffer
+        /// @param output     Where to store the popped slots
+        /// @param max_slots  Maximum number of slots to pop
+        /// @returns The number of slots actually popped
+        std::size_t pop(void* output, std::size_t max_slots = ~std::size_t(0)) {
+            const std::array<segment, 2> segments = read_segments(max_slots);
 
             char* out = static_cast<char*>(output);
-            std::memcpy(out, data_.data() + pos, first_copy * slot_size);
-            out += first_copy * slot_size;
-            std::memcpy(out, data_.data(), second_copy * slot_size);
+            std::memcpy(out, segments[0].data_, segments[0].count_ * slot_size);
+            out += segments[0].count_ * slot_size;
+            std::memcpy(out, segments[1].data_, segments[1].count_ * slot_size);
 
-            read_index_.store(read_index + pop_count);
+            const std::size_t pop_count = segments[0].count_ + segments[1].count_;
+            read_index_.store(read_index_.load() + pop_count);
 
             return pop_count;
         }
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <common/queue.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace eka2l1::common {
+    struct file_write_stats {
+        std::uint64_t bytes_queued_ = 0; ///< Bytes handed to the pool so far.
+        std::uint64_t bytes_written_ = 0; ///< Bytes already written to disk.
+        std::uint64_t files_written_ = 0; ///< Files fully written and closed.
+        double seconds_elapsed_ = 0.0; ///< Time since the pool was created.
+        double read_bytes_per_second_ = 0.0; ///< Rate at which the producer queues data.
+        double write_bytes_per_second_ = 0.0; ///< Rate at which data reaches the disk.
+    };
+
+    /**
+     * @brief Write many host files in the background, while the caller keeps reading the source.
+     *
+     * Each file is bound to one worker thread when it is opened, so writes to a file always happen in the
+     * order they were queued, while different files are written in parallel.
+     *
+     * The amount of queued data is bounded. Queuing a write blocks while too much data is waiting to be written.
+     */
+    class file_write_pool {
+        struct job {
+            enum kind {
+                kind_open,
+                kind_write,
+                kind_close,
+                kind_stop
+            } kind_;
+
+            std::size_t handle_;
+            std::string path_;
+            std::vector<std::uint8_t> data_;
+        };
+
+        using job_ptr = std::shared_ptr<job>;
+
+        struct worker {
+            request_queue<job_ptr> queue_;
+            std::thread thread_;
+        };
+
+        std::vector<std::unique_ptr<worker>> workers_;
+        std::size_t next_handle_;
+
+        std::mutex pending_lock_;
+        std::condition_variable pending_cond_;
+        std::size_t pending_bytes_;
+        std::size_t pending_jobs_;
+        std::size_t max_pending_bytes_;
+
+        std::atomic<std::uint64_t> bytes_queued_;
+        std::atomic<std::uint64_t> bytes_written_;
+        std::atomic<std::uint64_t> files_written_;
+        std::atomic<bool> failed_;
+
+        std::chrono::steady_clock::time_point start_;
+        bool stopped_;
+
+        void queue_job(const std::size_t handle, job_ptr new_job);
+        void run_worker(worker &me);
+        void stop_workers(const bool drop_pending);
+
+    public:
+        /**
+         * @brief Create the pool and start its workers.
+         *
+         * @param worker_count          Number of writer threads. Zero to pick one from the number of host cores.
+         * @param max_pending_bytes     Maximum amount of data waiting to be written before queuing blocks.
+         */
+        explicit file_write_pool(std::size_t worker_count = 0, const std::size_t max_pending_bytes = 0x1000000);
+
+        /**
+         * @brief Write out everything still queued and stop the workers.
+         */
+        ~file_write_pool();
+
+        /**
+         * @brief Create (or truncate) a file to write to.
+         *
+         * The directory of the file must already exist.
+         *
+         * @returns Handle to pass to write() and end_file().
+         */
+        std::size_t begin_file(const std::string &path);
+
+        void write(const std::size_t handle, std::vector<std::uint8_t> &&data);
+        void write(const std::size_t handle, const void *data, const std::size_t size);
+
+        /**
+         * @brief Close a file once all its queued data has been written.
+         */
+        void end_file(const std::size_t handle);
+
+        /**
+         * @brief Wait until every queued operation has been done.
+         *
+         * After this, all files that were ended are closed and can be read back.
+         */
+        void wait_idle();
+
+        /**
+         * @brief Write everything that's queued, and stop the workers.
+         *
+         * @returns False if any file could not be opened or fully written.
+         */
+        bool finish();
+
+        /**
+         * @brief Stop the workers, dropping everything that is not yet written.
+         *
+         * Can be called from another thread. A producer blocked on a full queue then returns, and what it
+         * queues afterwards is dropped.
+         */
+        void abort();
+
+        file_write_stats stats() const;
+    };
+}
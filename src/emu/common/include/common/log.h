@@ -73,9 +73,24 @@ namespace eka2l1 {
         void setup_log(std::shared_ptr<base_logger> extra_logger);
         void toggle_console();
         bool is_console_enabled();
+
+        /**
+         * \brief Format and write log messages on a background thread from now on.
+         *
+         * Must be called after setup_log.
+         */
+        void enable_async_logging();
+
+        /**
+         * \brief Write log messages on the calling thread again. Pending messages are written first.
+         */
+        void disable_async_logging();
     }
 }
 
+// Only what LOG_EMIT needs to push to the async logger, the logger itself is in asynclog.h
+#include <common/asynclogarg.h>
+
 #ifdef DISABLE_LOGGING
 #define LOG_TRACE(class, fmt, ...)
 #define LOG_DEBUG(class, fmt, ...)
@@ -98,35 +113,42 @@ namespace eka2l1 {
 #define COND_CHECK_AND(class, serv) &&eka2l1::log::filterings->is_passed(class, spdlog::level::serv)
 #endif
 
+// A single expression, so that it can sit under the if of COND_CHECK without a dangling else
+#define LOG_EMIT(class, lvl, fmt, ...)                                                                        \
+    (void)(eka2l1::log::try_push_async_log(class, spdlog::level::lvl, __FILE__, __LINE__, fmt, ##__VA_ARGS__) \
+        || (eka2l1::log::spd_logger->log(spdlog::level::lvl, "{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__,       \
+                log_class_to_string(class), ##__VA_ARGS__),                                                    \
+            true))
+
 #define LOG_TRACE(class, fmt, ...) COND_CHECK(class, trace) \
-                                   eka2l1::log::spd_logger->trace("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__)
+                                   LOG_EMIT(class, trace, fmt, ##__VA_ARGS__)
 #define LOG_DEBUG(class, fmt, ...) COND_CHECK(class, debug) \
-                                   eka2l1::log::spd_logger->debug("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__)
+                                   LOG_EMIT(class, debug, fmt, ##__VA_ARGS__)
 #define LOG_INFO(class, fmt, ...) COND_CHECK(class, info) \
-                                  eka2l1::log::spd_logger->info("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__)
+                                  LOG_EMIT(class, info, fmt, ##__VA_ARGS__)
 #define LOG_WARN(class, fmt, ...) COND_CHECK(class, warn) \
-                                  eka2l1::log::spd_logger->warn("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__)
+                                  LOG_EMIT(class, warn, fmt, ##__VA_ARGS__)
 #define LOG_ERROR(class, fmt, ...) COND_CHECK(class, err) \
-                                   eka2l1::log::spd_logger->error("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__)
+                                   LOG_EMIT(class, err, fmt, ##__VA_ARGS__)
 #define LOG_CRITICAL(class, fmt, ...) COND_CHECK(class, critical) \
-                                      eka2l1::log::spd_logger->critical("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__)
+                                      LOG_EMIT(class, critical, fmt, ##__VA_ARGS__)
 
 #define LOG_TRACE_IF(class, flag, fmt, ...) \
     if (flag COND_CHECK_AND(class, trace))  \
-    eka2l1::log::spd_logger->trace("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__)
+    LOG_EMIT(class, trace, fmt, ##__VA_ARGS__)
 #define LOG_DEBUG_IF(class, flag, fmt, ...) \
     if (flag COND_CHECK_AND(class, debug))  \
-    eka2l1::log::spd_logger->debug("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__)
+    LOG_EMIT(class, debug, fmt, ##__VA_ARGS__)
 #define LOG_INFO_IF(class, flag, fmt, ...) \
     if (flag COND_CHECK_AND(class, info))  \
-    eka2l1::log::spd_logger->info("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__)
+    LOG_EMIT(class, info, fmt, ##__VA_ARGS__)
 #define LOG_WARN_IF(class, flag, fmt, ...) \
     if (flag COND_CHECK_AND(class, warn))  \
-    eka2l1::log::spd_logger->warn("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__)
+    LOG_EMIT(class, warn, fmt, ##__VA_ARGS__)
 #define LOG_ERROR_IF(class, flag, fmt, ...) \
     if (flag COND_CHECK_AND(class, err))    \
-    eka2l1::log::spd_logger->error("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__)
+    LOG_EMIT(class, err, fmt, ##__VA_ARGS__)
 #define LOG_CRITICAL_IF(class, flag, fmt, ...) \
     if (flag COND_CHECK_AND(class, critical))  \
-    eka2l1::log::spd_logger->critical("{:s}:{} [{:s}]: " fmt, __FILE__, __LINE__, log_class_to_string(class), ##__VA_ARGS__)
+    LOG_EMIT(class, critical, fmt, ##__VA_ARGS__)
 #endif
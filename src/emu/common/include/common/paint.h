@@ -20,6 +20,9 @@
 #pragma once
 
 #include <common/vecx.h>
+
+#include <cstdint>
+#include <utility>
 #include <vector>
 
 namespace eka2l1::common {
@@ -30,6 +33,8 @@ namespace eka2l1::common {
      */
     class pixel_plotter {
     public:
+        virtual ~pixel_plotter() = default;
+
         /**
          * \brief Resize the bitmap the plotter handle to targeted size.
          * \param size A vector2 contains the width and height of the new bitmap.
@@ -56,6 +61,33 @@ namespace eka2l1::common {
          * \brief Get size of the bitmap this plotter handle.
          */
         virtual eka2l1::vec2 &get_size() = 0;
+
+        /**
+         * \brief Set a run of pixels on a row to a color.
+         * 
+         * The default implementation plots the pixels one by one. Plotters owning a linear buffer
+         * should override this and blend_span, since the painter draws through them.
+         * 
+         * \param y       The row.
+         * \param x_start The first pixel of the run.
+         * \param x_end   The pixel after the last pixel of the run.
+         * \param color   The color to set.
+         */
+        virtual void fill_span(const int y, const int x_start, const int x_end, const eka2l1::vecx<int, 4> &color);
+
+        /**
+         * \brief Blend a color over a run of pixels on a row.
+         * 
+         * Each pixel is mixed with the color by its coverage, 255 replacing the pixel completely.
+         * 
+         * \param y         The row.
+         * \param x_start   The first pixel of the run.
+         * \param coverages Coverage of each pixel in the run.
+         * \param count     Number of pixels in the run.
+         * \param color     The color to blend.
+         */
+        virtual void blend_span(const int y, const int x_start, const std::uint8_t *coverages, const int count,
+            const eka2l1::vecx<int, 4> &color);
     };
 
     /**
@@ -67,6 +99,8 @@ namespace eka2l1::common {
     class buffer_24bmp_pixel_plotter : public pixel_plotter {
         eka2l1::vec2 size_;
         std::vector<std::uint8_t> buf_;
+        std::vector<std::uint8_t> blend_src_;
+        std::vector<std::uint8_t> blend_alpha_;
 
         int aligned_row_size_in_bytes;
 
@@ -75,6 +109,10 @@ namespace eka2l1::common {
         void plot_pixel(const eka2l1::vec2 &pos, const eka2l1::vecx<int, 4> &color) override;
         eka2l1::vecx<int, 4> get_pixel(const eka2l1::vec2 &pos) override;
 
+        void fill_span(const int y, const int x_start, const int x_end, const eka2l1::vecx<int, 4> &color) override;
+        void blend_span(const int y, const int x_start, const std::uint8_t *coverages, const int count,
+            const eka2l1::vecx<int, 4> &color) override;
+
         eka2l1::vec2 &get_size() override {
             return size_;
         }
@@ -86,8 +124,110 @@ namespace eka2l1::common {
         void save_to_bmp(wo_stream *stream);
     };
 
+    /**
+     * \brief A 32-bit bitmap pixel plotter.
+     * 
+     * Pixels are stored as B, G, R, A bytes, and rows are not padded.
+     */
+    class buffer_32bmp_pixel_plotter : public pixel_plotter {
+        eka2l1::vec2 size_;
+        std::vector<std::uint8_t> buf_;
+        std::vector<std::uint8_t> blend_src_;
+        std::vector<std::uint8_t> blend_alpha_;
+
+    public:
+        void resize(const eka2l1::vec2 &size) override;
+        void plot_pixel(const eka2l1::vec2 &pos, const eka2l1::vecx<int, 4> &color) override;
+        eka2l1::vecx<int, 4> get_pixel(const eka2l1::vec2 &pos) override;
+
+        void fill_span(const int y, const int x_start, const int x_end, const eka2l1::vecx<int, 4> &color) override;
+        void blend_span(const int y, const int x_start, const std::uint8_t *coverages, const int count,
+            const eka2l1::vecx<int, 4> &color) override;
+
+        eka2l1::vec2 &get_size() override {
+            return size_;
+        }
+
+        std::uint8_t *data() {
+            return buf_.data();
+        }
+    };
+
+    enum class fill_rule {
+        non_zero,
+        even_odd
+    };
+
+    /**
+     * \brief Scanline rasterizer for filled paths, with anti-aliased edges.
+     * 
+     * Paths are made of straight edges. Each row is sampled on several sub-scanlines, and the
+     * resulting coverage is sent to the plotter as spans: fully covered runs are filled directly,
+     * and the edges are blended.
+     * 
+     * Coordinates are in pixels, with the center of the top left pixel at (0.5, 0.5).
+     */
+    class span_rasterizer {
+        struct edge {
+            float x0_;
+            float y0_;
+            float x1_;
+            float y1_;
+            float dxdy_;
+            int winding_;
+        };
+
+        std::vector<edge> edges_;
+        std::vector<const edge *> active_edges_;
+        std::vector<std::pair<float, int>> crossings_;
+
+        std::vector<float> coverages_;
+        std::vector<float> full_coverages_;
+        std::vector<std::uint8_t> coverage_bytes_;
+
+        float start_x_{ 0 };
+        float start_y_{ 0 };
+        float last_x_{ 0 };
+        float last_y_{ 0 };
+
+        void add_edge(const float x0, const float y0, const float x1, const float y1);
+        void accumulate(const float xa, const float xb, const int clip_left, const int clip_right, const float weight);
+
+    public:
+        /**
+         * \brief Remove all edges, to start a new shape.
+         */
+        void reset();
+
+        void move_to(const float x, const float y);
+        void line_to(const float x, const float y);
+        void close_path();
+
+        /**
+         * \brief Add an ellipse outline to the shape, as a closed path.
+         * 
+         * \param cx  X coordinate of the center.
+         * \param cy  Y coordinate of the center.
+         * \param rx  Radius on the X axis.
+         * \param ry  Radius on the Y axis.
+         */
+        void add_ellipse(const float cx, const float cy, const float rx, const float ry);
+
+        /**
+         * \brief Fill the shape.
+         * 
+         * \param plotter The plotter to draw on.
+         * \param color   The color to fill with.
+         * \param clip    Only pixels inside this rectangle are touched. It is also clipped to the plotter size.
+         * \param rule    Rule deciding which parts of overlapping paths are inside the shape.
+         */
+        void rasterize(pixel_plotter *plotter, const eka2l1::vecx<int, 4> &color, const eka2l1::rect &clip,
+            const fill_rule rule = fill_rule::non_zero);
+    };
+
     class painter {
         pixel_plotter *plotter_;
+        span_rasterizer rasterizer_;
 
         eka2l1::vecx<int, 4> brush_col_;
         eka2l1::vecx<int, 4> fill_col_;
@@ -101,6 +241,8 @@ namespace eka2l1::common {
 
         std::uint32_t flags{ 0 };
 
+        void fill_rect(const eka2l1::rect &re, const eka2l1::vecx<int, 4> &color);
+
     public:
         explicit painter(pixel_plotter *plotter);
 
@@ -186,6 +328,15 @@ namespace eka2l1::common {
          */
         void rect(const eka2l1::rect &re);
 
+        /**
+         * \brief Fill a rectangle with the fill color, without outline.
+         * 
+         * \param re The rectangle to fill. Parts outside of the canvas are clipped.
+         */
+        void fill_rect(const eka2l1::rect &re) {
+            fill_rect(re, fill_col_);
+        }
+
         /**
          * \brief Flood-fill a region with scan-line algorithm.
          * 
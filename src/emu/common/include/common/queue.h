@@ -188,6 +188,26 @@ namespace eka2l1 {
             queue_empty_cond_.notify_one();
         }
 
+        /**
+         * \brief Push an item without waiting for the queue to have space.
+         *
+         * \returns False if the queue is full or aborted. The item is then dropped.
+         */
+        bool try_push(const T &item) {
+            {
+                const std::lock_guard<std::mutex> guard(queue_mut_);
+
+                if (abort_ || (queue_.size() >= max_pending_count_)) {
+                    return false;
+                }
+
+                queue_.push(item);
+            }
+
+            queue_empty_cond_.notify_one();
+            return true;
+        }
+
         std::optional<T> pop(const int ms = 0) {
             T item{ T() };
 
@@ -227,4 +247,84 @@ namespace eka2l1 {
             abort_ = false;
         }
     };
+
+    /**
+     * \brief Lock-free queue with many producers and a single consumer that takes everything at once.
+     *
+     * Producers push with a compare-and-swap on the list head. The consumer swaps the whole list out
+     * in one go, and processes it in the order the elements were pushed.
+     */
+    template <typename T>
+    class mpsc_batch_queue {
+        struct node {
+            T value_;
+            node *next_;
+        };
+
+        std::atomic<node *> head_{ nullptr };
+
+    public:
+        mpsc_batch_queue() = default;
+        mpsc_batch_queue(const mpsc_batch_queue &) = delete;
+        mpsc_batch_queue &operator=(const mpsc_batch_queue &) = delete;
+
+        ~mpsc_batch_queue() {
+            drain([](T &) {});
+        }
+
+        /**
+         * \brief Push an element. Safe to call from any thread.
+         *
+         * \returns True if the queue was empty before this push. Only this producer needs to wake the consumer.
+         */
+        bool push(T value) {
+            node *new_node = new node{ std::move(value), nullptr };
+            node *old_head = head_.load(std::memory_order_relaxed);
+
+            // The node may already be consumed once it's published, so only look at our local copy of the head after
+            do {
+                new_node->next_ = old_head;
+            } while (!head_.compare_exchange_weak(old_head, new_node, std::memory_order_release,
+                std::memory_order_relaxed));
+
+            return (old_head == nullptr);
+        }
+
+        /**
+         * \brief Take all pending elements and call the function on each of them, in push order.
+         *
+         * Must only be called from the consumer thread.
+         *
+         * \returns Number of elements processed.
+         */
+        template <typename F>
+        std::size_t drain(F func) {
+            node *current = head_.exchange(nullptr, std::memory_order_acquire);
+            node *reversed = nullptr;
+
+            while (current) {
+                node *next = current->next_;
+                current->next_ = reversed;
+                reversed = current;
+                current = next;
+            }
+
+            std::size_t count = 0;
+
+            while (reversed) {
+                node *next = reversed->next_;
+                func(reversed->value_);
+
+                delete reversed;
+                reversed = next;
+                count++;
+            }
+
+            return count;
+        }
+
+        bool empty() const {
+            return head_.load(std::memory_order_relaxed) == nullptr;
+        }
+    };
 }
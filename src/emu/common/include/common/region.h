@@ -24,8 +24,17 @@
 #include <vector>
 
 namespace eka2l1::common {
+    /**
+     * @brief A set of pixels, described by non-overlapping rectangles.
+     *
+     * Rectangles are kept in y-x banded form: sorted by top then left, grouped in horizontal bands
+     * where every rectangle shares the same top and bottom, with no rectangles touching inside a band.
+     * Vertically touching bands with the same spans are merged. The same pixels always give the same
+     * rectangles, and union, subtract and intersect are done with one sweep over the bands.
+     */
     struct region {
-        std::vector<eka2l1::rect> rects_;
+        std::vector<eka2l1::rect> rects_; ///< Read only. Use the functions below to modify the region.
+        eka2l1::rect bounding_;
 
         bool empty() const {
             return rects_.empty();
@@ -33,6 +42,7 @@ namespace eka2l1::common {
 
         void make_empty() {
             rects_.clear();
+            bounding_ = eka2l1::rect{};
         }
 
         bool contains(const eka2l1::point &p);
@@ -44,13 +54,13 @@ namespace eka2l1::common {
          */
         void advance(const eka2l1::vec2 &amount);
 
+        /**
+         * @brief       Only keep the part of the region inside a rectangle.
+         */
         void clip(const eka2l1::rect &bounding);
 
         /**
-         * @brief       Check if two regions are identical in terms of rectangles it contains
-         * 
-         * Note that if your rectangle are splitted to more smaller part, this can't check that. Hence
-         * the identical name here.
+         * @brief       Check if two regions cover the same pixels.
          */
         bool identical(const region &lhs) const;
 
@@ -62,11 +72,18 @@ namespace eka2l1::common {
 
         bool add_region(const region &rg);
 
+        /**
+         * @brief       Add rectangles that may overlap each other to this region.
+         */
+        void add_rects(const eka2l1::rect *rects, const std::size_t count);
+
         /**
          * @brief       Get the rectangle that bound the whole region.
          * @returns     Rectangle that bound the region.
          */
-        eka2l1::rect bounding_rect() const;
+        eka2l1::rect bounding_rect() const {
+            return bounding_;
+        }
 
         /**
          * @brief   Get intersection between two regions.
@@ -90,4 +107,4 @@ namespace eka2l1::common {
          */
         void eliminate(const region &reg);
     };
-}
\ No newline at end of file
+}
@@ -25,10 +25,44 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
 namespace eka2l1::common {
+    /**
+     * \brief Widen the leading bytes that fall in [low, high] to UTF-16 code units.
+     *
+     * Code units are written in little-endian order, to a destination with no alignment requirement.
+     * Runs are checked and converted 16 bytes at a time with SIMD where available.
+     *
+     * \param source       The bytes to widen.
+     * \param count        Maximum number of bytes to widen.
+     * \param dest         Destination of the code units. Must hold count code units.
+     * \param low          Lowest byte value of the run.
+     * \param high         Highest byte value of the run.
+     *
+     * \returns Number of bytes widened. Conversion stops at the first byte out of range.
+     */
+    std::size_t widen_byte_run(const std::uint8_t *source, const std::size_t count, std::uint8_t *dest,
+        const std::uint8_t low, const std::uint8_t high);
+
+    /**
+     * \brief Narrow the leading UTF-16 code units that fall in [low, high] to bytes.
+     *
+     * Code units are read in little-endian order, from a source with no alignment requirement.
+     *
+     * \param source       The code units to narrow.
+     * \param count        Maximum number of code units to narrow.
+     * \param dest         Destination of the bytes. Must hold count bytes.
+     * \param low          Lowest code unit value of the run. Must be lower than 0x100.
+     * \param high         Highest code unit value of the run. Must be lower than 0x100.
+     *
+     * \returns Number of code units narrowed. Conversion stops at the first code unit out of range.
+     */
+    std::size_t narrow_unit_run(const std::uint8_t *source, const std::size_t count, std::uint8_t *dest,
+        const std::uint16_t low, const std::uint16_t high);
+
     struct unicode_comp_state {
         enum {
             static_windows_size = 8,
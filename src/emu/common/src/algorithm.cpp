@@ -29,6 +29,12 @@
 #include <intrin.h>
 #endif
 
+#if EKA2L1_ARCH(X64)
+#include <emmintrin.h>
+#elif EKA2L1_ARCH(ARM64)
+#include <arm_neon.h>
+#endif
+
 #include <cctype>
 #include <cwctype>
 
@@ -42,6 +48,115 @@ namespace eka2l1 {
 #endif
         }
 
+        void find_min_max(const std::uint8_t *data, const std::size_t count, std::uint8_t &min_value, std::uint8_t &max_value) {
+            std::uint8_t min_res = 0xFF;
+            std::uint8_t max_res = 0;
+            std::size_t i = 0;
+
+#if EKA2L1_ARCH(X64)
+            if (count >= 16) {
+                __m128i min_vec = _mm_set1_epi8(static_cast<char>(0xFF));
+                __m128i max_vec = _mm_setzero_si128();
+
+                for (; i + 16 <= count; i += 16) {
+                    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+                    min_vec = _mm_min_epu8(min_vec, v);
+                    max_vec = _mm_max_epu8(max_vec, v);
+                }
+
+                // Fold the lanes down to the first byte
+                min_vec = _mm_min_epu8(min_vec, _mm_srli_si128(min_vec, 8));
+                min_vec = _mm_min_epu8(min_vec, _mm_srli_si128(min_vec, 4));
+                min_vec = _mm_min_epu8(min_vec, _mm_srli_si128(min_vec, 2));
+                min_vec = _mm_min_epu8(min_vec, _mm_srli_si128(min_vec, 1));
+
+                max_vec = _mm_max_epu8(max_vec, _mm_srli_si128(max_vec, 8));
+                max_vec = _mm_max_epu8(max_vec, _mm_srli_si128(max_vec, 4));
+                max_vec = _mm_max_epu8(max_vec, _mm_srli_si128(max_vec, 2));
+                max_vec = _mm_max_epu8(max_vec, _mm_srli_si128(max_vec, 1));
+
+                min_res = static_cast<std::uint8_t>(_mm_cvtsi128_si32(min_vec) & 0xFF);
+                max_res = static_cast<std::uint8_t>(_mm_cvtsi128_si32(max_vec) & 0xFF);
+            }
+#elif EKA2L1_ARCH(ARM64)
+            if (count >= 16) {
+                uint8x16_t min_vec = vdupq_n_u8(0xFF);
+                uint8x16_t max_vec = vdupq_n_u8(0);
+
+                for (; i + 16 <= count; i += 16) {
+                    const uint8x16_t v = vld1q_u8(data + i);
+                    min_vec = vminq_u8(min_vec, v);
+                    max_vec = vmaxq_u8(max_vec, v);
+                }
+
+                min_res = vminvq_u8(min_vec);
+                max_res = vmaxvq_u8(max_vec);
+            }
+#endif
+
+            for (; i < count; i++) {
+                min_res = std::min(min_res, data[i]);
+                max_res = std::max(max_res, data[i]);
+            }
+
+            min_value = min_res;
+            max_value = max_res;
+        }
+
+        void find_min_max(const std::uint16_t *data, const std::size_t count, std::uint16_t &min_value, std::uint16_t &max_value) {
+            std::uint16_t min_res = 0xFFFF;
+            std::uint16_t max_res = 0;
+            std::size_t i = 0;
+
+#if EKA2L1_ARCH(X64)
+            if (count >= 8) {
+                // SSE2 only has signed halfword min/max. Flip the sign bit so that unsigned order maps to signed order.
+                const __m128i sign_flip = _mm_set1_epi16(static_cast<short>(0x8000));
+                __m128i min_vec = _mm_set1_epi16(0x7FFF);
+                __m128i max_vec = _mm_set1_epi16(static_cast<short>(0x8000));
+
+                for (; i + 8 <= count; i += 8) {
+                    const __m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)), sign_flip);
+                    min_vec = _mm_min_epi16(min_vec, v);
+                    max_vec = _mm_max_epi16(max_vec, v);
+                }
+
+                min_vec = _mm_min_epi16(min_vec, _mm_srli_si128(min_vec, 8));
+                min_vec = _mm_min_epi16(min_vec, _mm_srli_si128(min_vec, 4));
+                min_vec = _mm_min_epi16(min_vec, _mm_srli_si128(min_vec, 2));
+
+                max_vec = _mm_max_epi16(max_vec, _mm_srli_si128(max_vec, 8));
+                max_vec = _mm_max_epi16(max_vec, _mm_srli_si128(max_vec, 4));
+                max_vec = _mm_max_epi16(max_vec, _mm_srli_si128(max_vec, 2));
+
+                min_res = static_cast<std::uint16_t>((_mm_cvtsi128_si32(min_vec) & 0xFFFF) ^ 0x8000);
+                max_res = static_cast<std::uint16_t>((_mm_cvtsi128_si32(max_vec) & 0xFFFF) ^ 0x8000);
+            }
+#elif EKA2L1_ARCH(ARM64)
+            if (count >= 8) {
+                uint16x8_t min_vec = vdupq_n_u16(0xFFFF);
+                uint16x8_t max_vec = vdupq_n_u16(0);
+
+                for (; i + 8 <= count; i += 8) {
+                    const uint16x8_t v = vld1q_u16(data + i);
+                    min_vec = vminq_u16(min_vec, v);
+                    max_vec = vmaxq_u16(max_vec, v);
+                }
+
+                min_res = vminvq_u16(min_vec);
+                max_res = vmaxvq_u16(max_vec);
+            }
+#endif
+
+            for (; i < count; i++) {
+                min_res = std::min(min_res, data[i]);
+                max_res = std::max(max_res, data[i]);
+            }
+
+            min_value = min_res;
+            max_value = max_res;
+        }
+
         size_t find_nth(std::string targ, std::string str, size_t idx, size_t pos) {
             size_t found_pos = targ.find(str, pos);
 
@@ -27,9 +27,38 @@
 #include <stdexcept>
 
 namespace eka2l1::common {
+    static void tlsf_mapping_insert(const std::size_t size, std::uint32_t &fl, std::uint32_t &sl) {
+        if (size < block_allocator::SMALL_BLOCK_SIZE) {
+            // Small blocks are stored in the first list, each slot is one alignment unit apart
+            fl = 0;
+            sl = static_cast<std::uint32_t>(size) / (block_allocator::SMALL_BLOCK_SIZE / block_allocator::SL_INDEX_COUNT);
+        } else {
+            const std::uint32_t msb = static_cast<std::uint32_t>(common::find_most_significant_bit_one(static_cast<std::uint32_t>(size)) - 1);
+
+            sl = static_cast<std::uint32_t>(size >> (msb - block_allocator::SL_INDEX_COUNT_LOG2)) ^ (1 << block_allocator::SL_INDEX_COUNT_LOG2);
+            fl = msb - (block_allocator::FL_INDEX_SHIFT - 1);
+        }
+    }
+
+    static void tlsf_mapping_search(std::size_t size, std::uint32_t &fl, std::uint32_t &sl) {
+        // Round the size up to the next list, so that every block in the found list is big enough
+        if (size >= block_allocator::SMALL_BLOCK_SIZE) {
+            const std::uint32_t msb = static_cast<std::uint32_t>(common::find_most_significant_bit_one(static_cast<std::uint32_t>(size)) - 1);
+            size += (static_cast<std::size_t>(1) << (msb - block_allocator::SL_INDEX_COUNT_LOG2)) - 1;
+        }
+
+        tlsf_mapping_insert(size, fl, sl);
+    }
+
+    // Keep the size search bound inside 32-bit, also leave space for the rounding done in mapping search.
+    static constexpr std::size_t MAX_BLOCK_ALLOCATE_SIZE = 0x7FFFFFFF;
+
     block_allocator::block_allocator(std::uint8_t *sptr, const std::size_t initial_max_size)
-        : space_based_allocator(sptr, initial_max_size) {
-        const auto alignment_needed = (4 - reinterpret_cast<std::uint64_t>(ptr) % 4) % 4;
+        : space_based_allocator(sptr, initial_max_size)
+        , fl_bitmap(0)
+        , last_block(INVALID_BLOCK)
+        , managed_end(0) {
+        const auto alignment_needed = (ALIGN_SIZE - reinterpret_cast<std::uint64_t>(ptr) % ALIGN_SIZE) % ALIGN_SIZE;
 
         if (alignment_needed > initial_max_size) {
             if (!expand(alignment_needed)) {
@@ -38,60 +67,271 @@ namespace eka2l1::common {
         }
 
         ptr += alignment_needed;
+        base_padding = static_cast<std::size_t>(alignment_needed);
+
+        std::fill(sl_bitmap, sl_bitmap + FL_INDEX_COUNT, 0);
+
+        for (std::uint32_t i = 0; i < FL_INDEX_COUNT; i++) {
+            std::fill(free_heads[i], free_heads[i] + SL_INDEX_COUNT, INVALID_BLOCK);
+        }
+
+        add_space();
     }
 
-    void *block_allocator::allocate(std::size_t bytes) {
-        std::size_t rounded_size = common::next_power_of_two(bytes);
-        std::uint64_t farthest_end_offset = 0;
+    std::uint32_t block_allocator::new_block(const std::uint64_t offset, const std::size_t size) {
+        std::uint32_t index = 0;
 
-        const std::lock_guard<std::mutex> guard(lock);
+        if (!unused_blocks.empty()) {
+            index = unused_blocks.back();
+            unused_blocks.pop_back();
+
+            blocks[index] = block_info{};
+        } else {
+            index = static_cast<std::uint32_t>(blocks.size());
+            blocks.emplace_back();
+        }
+
+        blocks[index].offset = offset;
+        blocks[index].size = size;
+
+        return index;
+    }
+
+    void block_allocator::recycle_block(const std::uint32_t index) {
+        unused_blocks.push_back(index);
+    }
+
+    void block_allocator::insert_free_block(const std::uint32_t index) {
+        std::uint32_t fl = 0;
+        std::uint32_t sl = 0;
+
+        tlsf_mapping_insert(blocks[index].size, fl, sl);
+
+        const std::uint32_t head = free_heads[fl][sl];
+
+        blocks[index].prev_free = INVALID_BLOCK;
+        blocks[index].next_free = head;
+
+        if (head != INVALID_BLOCK) {
+            blocks[head].prev_free = index;
+        }
+
+        free_heads[fl][sl] = index;
+
+        fl_bitmap |= (1U << fl);
+        sl_bitmap[fl] |= (1U << sl);
+
+        stats_.free_block_count++;
+    }
 
-        for (auto &block : blocks) {
-            farthest_end_offset = common::max(farthest_end_offset, block.offset + block.size);
+    void block_allocator::remove_free_block(const std::uint32_t index) {
+        std::uint32_t fl = 0;
+        std::uint32_t sl = 0;
 
-            if (!block.active && block.size >= rounded_size) {
-                // Gonna use it right away
-                if (block.size == rounded_size) {
-                    block.active = true;
-                    return block.offset + ptr;
+        tlsf_mapping_insert(blocks[index].size, fl, sl);
+
+        const std::uint32_t prev = blocks[index].prev_free;
+        const std::uint32_t next = blocks[index].next_free;
+
+        if (prev != INVALID_BLOCK) {
+            blocks[prev].next_free = next;
+        }
+
+        if (next != INVALID_BLOCK) {
+            blocks[next].prev_free = prev;
+        }
+
+        if (free_heads[fl][sl] == index) {
+            free_heads[fl][sl] = next;
+
+            if (next == INVALID_BLOCK) {
+                // The list is now empty, update the bitmaps
+                sl_bitmap[fl] &= ~(1U << sl);
+
+                if (sl_bitmap[fl] == 0) {
+                    fl_bitmap &= ~(1U << fl);
                 }
+            }
+        }
+
+        blocks[index].prev_free = INVALID_BLOCK;
+        blocks[index].next_free = INVALID_BLOCK;
+
+        stats_.free_block_count--;
+    }
+
+    std::uint32_t block_allocator::search_suitable_block(const std::size_t size) {
+        std::uint32_t fl = 0;
+        std::uint32_t sl = 0;
 
-                void *ret_ptr = ptr + block.offset;
+        tlsf_mapping_search(size, fl, sl);
 
-                // Divide it to two if we can
-                block_info new_block;
-                new_block.active = true;
-                new_block.offset = block.offset;
-                new_block.size = rounded_size;
+        if (fl < FL_INDEX_COUNT) {
+            std::uint32_t sl_map = sl_bitmap[fl] & (~0U << sl);
 
-                // Change our old block
-                block.size -= rounded_size;
-                block.offset += rounded_size;
+            if (sl_map == 0) {
+                // No block in this first level is big enough, look for the next first level that has one
+                const std::uint32_t fl_map = (fl + 1 < 32) ? (fl_bitmap & (~0U << (fl + 1))) : 0;
 
-                blocks.push_back(std::move(new_block));
-                return ret_ptr;
+                if (fl_map != 0) {
+                    fl = static_cast<std::uint32_t>(common::find_least_significant_bit_one(fl_map));
+                    sl_map = sl_bitmap[fl];
+                }
+            }
+
+            if (sl_map != 0) {
+                sl = static_cast<std::uint32_t>(common::find_least_significant_bit_one(sl_map));
+                return free_heads[fl][sl];
+            }
+        }
+
+        // The good-fit search skips the list the size itself maps to. Before giving up,
+        // walk that list for a block that still fits, so we don't expand the space needlessly.
+        tlsf_mapping_insert(size, fl, sl);
+
+        if (fl < FL_INDEX_COUNT) {
+            for (std::uint32_t index = free_heads[fl][sl]; index != INVALID_BLOCK; index = blocks[index].next_free) {
+                if (blocks[index].size >= size) {
+                    return index;
+                }
             }
         }
 
-        if (farthest_end_offset + rounded_size > max_size) {
-            // It's time to expand
-            if (!expand(common::max(max_size * 2, max_size + rounded_size))) {
+        return INVALID_BLOCK;
+    }
+
+    std::uint32_t block_allocator::merge_with_next(const std::uint32_t index) {
+        const std::uint32_t next = blocks[index].next_phys;
+        const std::uint32_t next_next = blocks[next].next_phys;
+
+        blocks[index].size += blocks[next].size;
+        blocks[index].next_phys = next_next;
+
+        if (next_next != INVALID_BLOCK) {
+            blocks[next_next].prev_phys = index;
+        } else {
+            last_block = index;
+        }
+
+        recycle_block(next);
+        stats_.coalesce_count++;
+
+        return index;
+    }
+
+    void block_allocator::add_space() {
+        if (max_size < base_padding) {
+            return;
+        }
+
+        const std::uint64_t new_end = ((max_size - base_padding) >> ALIGN_SIZE_LOG2) << ALIGN_SIZE_LOG2;
+
+        if (new_end <= managed_end) {
+            return;
+        }
+
+        const std::size_t added_size = static_cast<std::size_t>(new_end - managed_end);
+
+        if ((last_block != INVALID_BLOCK) && !blocks[last_block].active) {
+            // Extend the free block at the end
+            remove_free_block(last_block);
+            blocks[last_block].size += added_size;
+            insert_free_block(last_block);
+        } else {
+            const std::uint32_t index = new_block(managed_end, added_size);
+            blocks[index].prev_phys = last_block;
+
+            if (last_block != INVALID_BLOCK) {
+                blocks[last_block].next_phys = index;
+            }
+
+            last_block = index;
+            insert_free_block(index);
+        }
+
+        managed_end = new_end;
+    }
+
+    bool block_allocator::grow(const std::size_t least_size) {
+        std::size_t tail_free = 0;
+
+        if ((last_block != INVALID_BLOCK) && !blocks[last_block].active) {
+            tail_free = blocks[last_block].size;
+        }
+
+        if (tail_free >= least_size) {
+            return true;
+        }
+
+        const std::size_t needed = least_size - tail_free;
+        std::size_t target = common::max(max_size * 2, max_size + needed);
+
+        if (!expand(target)) {
+            // Try again with only what we need
+            target = max_size + needed;
+
+            if (!expand(target)) {
+                return false;
+            }
+        }
+
+        max_size = target;
+        stats_.expand_count++;
+
+        add_space();
+        return true;
+    }
+
+    void *block_allocator::allocate(std::size_t bytes) {
+        const std::lock_guard<std::mutex> guard(lock);
+
+        if (bytes > MAX_BLOCK_ALLOCATE_SIZE) {
+            stats_.failed_alloc_count++;
+            return nullptr;
+        }
+
+        const std::size_t aligned_size = common::max<std::size_t>(ALIGN_SIZE, (bytes + ALIGN_SIZE - 1) & ~static_cast<std::size_t>(ALIGN_SIZE - 1));
+        std::uint32_t index = search_suitable_block(aligned_size);
+
+        if (index == INVALID_BLOCK) {
+            // It's time to expand. The tail block is now guaranteed to be free and big enough.
+            if (!grow(aligned_size)) {
+                stats_.failed_alloc_count++;
                 return nullptr;
             }
 
-            max_size = common::max(max_size * 2, max_size + rounded_size);
+            index = last_block;
         }
 
-        // We try our best, but we can't
-        // We should alloc new block
-        block_info new_block;
-        new_block.active = true;
-        new_block.offset = farthest_end_offset;
-        new_block.size = rounded_size;
+        remove_free_block(index);
+
+        if (blocks[index].size - aligned_size >= ALIGN_SIZE) {
+            // Divide it to two, give the rest back to the free lists
+            const std::uint32_t rest = new_block(blocks[index].offset + aligned_size, blocks[index].size - aligned_size);
+            const std::uint32_t next = blocks[index].next_phys;
+
+            blocks[rest].prev_phys = index;
+            blocks[rest].next_phys = next;
 
-        blocks.push_back(std::move(new_block));
+            if (next != INVALID_BLOCK) {
+                blocks[next].prev_phys = rest;
+            } else {
+                last_block = rest;
+            }
 
-        return farthest_end_offset + ptr;
+            blocks[index].next_phys = rest;
+            blocks[index].size = aligned_size;
+
+            insert_free_block(rest);
+        }
+
+        blocks[index].active = true;
+        active_blocks.emplace(blocks[index].offset, index);
+
+        stats_.used_size += blocks[index].size;
+        stats_.alloc_count++;
+
+        return ptr + blocks[index].offset;
     }
 
     bool block_allocator::freep(const void *tptr) {
@@ -99,19 +339,62 @@ namespace eka2l1::common {
 
         const std::lock_guard<std::mutex> guard(lock);
 
-        auto ite = std::find_if(blocks.begin(), blocks.end(),
-            [to_free_offset](const block_info &info) {
-                return info.active && info.offset == to_free_offset;
-            });
+        auto ite = active_blocks.find(to_free_offset);
 
-        if (ite == blocks.end()) {
+        if (ite == active_blocks.end()) {
             return false;
         }
 
-        ite->active = false;
+        std::uint32_t index = ite->second;
+        active_blocks.erase(ite);
+
+        blocks[index].active = false;
+
+        stats_.used_size -= blocks[index].size;
+        stats_.free_count++;
+
+        // Coalesce with free physical neighbours
+        const std::uint32_t prev = blocks[index].prev_phys;
+
+        if ((prev != INVALID_BLOCK) && !blocks[prev].active) {
+            remove_free_block(prev);
+            index = merge_with_next(prev);
+        }
+
+        const std::uint32_t next = blocks[index].next_phys;
+
+        if ((next != INVALID_BLOCK) && !blocks[next].active) {
+            remove_free_block(next);
+            index = merge_with_next(index);
+        }
+
+        insert_free_block(index);
         return true;
     }
 
+    block_allocator_stats block_allocator::stats() {
+        const std::lock_guard<std::mutex> guard(lock);
+
+        block_allocator_stats result = stats_;
+
+        result.total_size = static_cast<std::size_t>(managed_end);
+        result.free_size = result.total_size - result.used_size;
+        result.active_block_count = active_blocks.size();
+        result.largest_free_block = 0;
+
+        if (fl_bitmap != 0) {
+            // The largest block must be in the highest non-empty list
+            const std::uint32_t fl = static_cast<std::uint32_t>(common::find_most_significant_bit_one(fl_bitmap) - 1);
+            const std::uint32_t sl = static_cast<std::uint32_t>(common::find_most_significant_bit_one(sl_bitmap[fl]) - 1);
+
+            for (std::uint32_t index = free_heads[fl][sl]; index != INVALID_BLOCK; index = blocks[index].next_free) {
+                result.largest_free_block = common::max(result.largest_free_block, blocks[index].size);
+            }
+        }
+
+        return result;
+    }
+
     bitmap_allocator::bitmap_allocator(const std::size_t total_bits)
         : words_((total_bits >> 5) + ((total_bits % 32 != 0) ? 1 : 0), 0xFFFFFFFF) {
     }
@@ -0,0 +1,311 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/asynclog.h>
+#include <common/thread.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace eka2l1::log {
+    std::atomic<async_logger *> active_async_logger{ nullptr };
+
+    std::string format_async_log_preformatted(const char *format, const std::uint8_t *args) {
+        return std::string(async_log_string_arg::decode(args));
+    }
+
+    async_logger *get_async_logger() {
+        return active_async_logger.load(std::memory_order_acquire);
+    }
+
+    std::uint8_t *begin_async_log_record(async_logger *logger, async_log_ring *&ring, const std::size_t args_size,
+        const log_class cls, const spdlog::level::level_enum level, const char *file, const int line, const char *format,
+        async_log_format_func format_func) {
+        return logger->begin_record(ring, args_size, cls, level, file, line, format, format_func);
+    }
+
+    void commit_async_log_record(async_log_ring *ring) {
+        ring->commit();
+    }
+
+    async_log_ring::async_log_ring(const std::size_t capacity)
+        : head_(0)
+        , tail_(0)
+        , pending_head_(0)
+        , dropped_(0)
+        , retired_(false) {
+        std::size_t real_capacity = 64;
+        while (real_capacity < capacity) {
+            real_capacity <<= 1;
+        }
+
+        buffer_.resize(real_capacity);
+        mask_ = real_capacity - 1;
+    }
+
+    std::uint8_t *async_log_ring::reserve(const std::size_t size) {
+        const std::size_t entry = entry_size(size);
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        const std::size_t tail = tail_.load(std::memory_order_acquire);
+
+        const std::size_t index = head & mask_;
+        const std::size_t contiguous = buffer_.size() - index;
+
+        // A record never wraps around, the rest of the ring is skipped instead
+        const std::size_t required = (entry > contiguous) ? (contiguous + entry) : entry;
+
+        if ((entry > buffer_.size() / 2) || (buffer_.size() - (head - tail) < required)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        std::size_t write_pos = head;
+
+        if (entry > contiguous) {
+            std::memcpy(buffer_.data() + index, &WRAP_MARKER, sizeof(std::uint32_t));
+            write_pos += contiguous;
+        }
+
+        const std::uint32_t size_to_write = static_cast<std::uint32_t>(size);
+        std::uint8_t *dest = buffer_.data() + (write_pos & mask_);
+
+        std::memcpy(dest, &size_to_write, sizeof(std::uint32_t));
+        pending_head_ = write_pos + entry;
+
+        return dest + sizeof(std::uint64_t);
+    }
+
+    void async_log_ring::commit() {
+        head_.store(pending_head_, std::memory_order_release);
+    }
+
+    static std::atomic<std::uint64_t> async_logger_id_counter{ 1 };
+
+    async_logger::async_logger(std::shared_ptr<spdlog::logger> target, const std::size_t ring_capacity)
+        : target_(target)
+        , ring_capacity_(ring_capacity)
+        , id_(async_logger_id_counter++)
+        , sequence_(0)
+        , written_(0)
+        , dropped_of_freed_rings_(0)
+        , dropped_reported_(0)
+        , should_stop_(false) {
+    }
+
+    async_logger::~async_logger() {
+        stop();
+        flush();
+    }
+
+    struct async_log_thread_ring {
+        std::uint64_t owner_id_ = 0;
+        std::shared_ptr<async_log_ring> ring_;
+
+        ~async_log_thread_ring() {
+            // The drain thread frees the ring once everything in it is written
+            if (ring_) {
+                ring_->retire();
+            }
+        }
+    };
+
+    static thread_local async_log_thread_ring current_thread_ring;
+
+    async_log_ring &async_logger::thread_ring() {
+        if (current_thread_ring.owner_id_ != id_) {
+            // The ring is shared with the logger, since either the thread or the logger may go first
+            auto new_ring = std::make_shared<async_log_ring>(ring_capacity_);
+
+            if (current_thread_ring.ring_) {
+                current_thread_ring.ring_->retire();
+            }
+
+            current_thread_ring.owner_id_ = id_;
+            current_thread_ring.ring_ = new_ring;
+
+            const std::lock_guard<std::mutex> guard(rings_lock_);
+            rings_.push_back(std::move(new_ring));
+        }
+
+        return *current_thread_ring.ring_;
+    }
+
+    std::uint8_t *async_logger::begin_record(async_log_ring *&ring, const std::size_t args_size, const log_class cls,
+        const spdlog::level::level_enum level, const char *file, const int line, const char *format,
+        async_log_format_func format_func) {
+        ring = &thread_ring();
+
+        std::uint8_t *dest = ring->reserve(sizeof(async_log_record) + args_size);
+        if (!dest) {
+            return nullptr;
+        }
+
+        async_log_record record;
+        record.sequence_ = sequence_.fetch_add(1, std::memory_order_relaxed);
+        record.format_ = format;
+        record.file_ = file;
+        record.format_func_ = format_func;
+        record.line_ = static_cast<std::int32_t>(line);
+        record.class_ = static_cast<std::uint16_t>(cls);
+        record.level_ = static_cast<std::uint8_t>(level);
+
+        std::memcpy(dest, &record, sizeof(async_log_record));
+        return dest + sizeof(async_log_record);
+    }
+
+    void async_logger::write_record(const async_log_record &record, const std::uint8_t *args) {
+        std::string message;
+
+        try {
+            message = record.format_func_(record.format_, args);
+        } catch (std::exception &ex) {
+            message = fmt::format("<unable to format \"{}\": {}>", record.format_, ex.what());
+        }
+
+        target_->log(static_cast<spdlog::level::level_enum>(record.level_), "{:s}:{} [{:s}]: {:s}", record.file_, record.line_,
+            log_class_to_string(static_cast<log_class>(record.class_)), message);
+    }
+
+    std::size_t async_logger::flush() {
+        struct pending_record {
+            async_log_record header_;
+            const std::uint8_t *args_;
+        };
+
+        const std::lock_guard<std::mutex> drain_guard(drain_lock_);
+        std::unique_lock<std::mutex> rings_guard(rings_lock_);
+
+        std::vector<pending_record> records;
+        std::vector<std::size_t> release_positions(rings_.size());
+
+        // Rings created after this point are not touched in this flush
+        const std::size_t ring_count = rings_.size();
+
+        for (std::size_t i = 0; i < ring_count; i++) {
+            release_positions[i] = rings_[i]->peek([&](const std::uint8_t *data, const std::uint32_t size) {
+                pending_record record;
+                std::memcpy(&record.header_, data, sizeof(async_log_record));
+                record.args_ = data + sizeof(async_log_record);
+
+                records.push_back(record);
+            });
+        }
+
+        rings_guard.unlock();
+
+        // Keep the order messages were pushed in across threads
+        std::sort(records.begin(), records.end(), [](const pending_record &lhs, const pending_record &rhs) {
+            return lhs.header_.sequence_ < rhs.header_.sequence_;
+        });
+
+        for (const pending_record &record: records) {
+            write_record(record.header_, record.args_);
+        }
+
+        written_ += records.size();
+
+        rings_guard.lock();
+
+        for (std::size_t i = 0; i < ring_count; i++) {
+            rings_[i]->release(release_positions[i]);
+        }
+
+        std::uint64_t total_dropped = 0;
+
+        // Free the rings of threads that have exited, once they are empty
+        for (auto ite = rings_.begin(); ite != rings_.end();) {
+            if ((*ite)->is_retired() && (*ite)->empty()) {
+                dropped_of_freed_rings_ += (*ite)->dropped();
+                ite = rings_.erase(ite);
+            } else {
+                total_dropped += (*ite)->dropped();
+                ite++;
+            }
+        }
+
+        total_dropped += dropped_of_freed_rings_;
+        rings_guard.unlock();
+
+        if (total_dropped > dropped_reported_) {
+            target_->warn("Async logger dropped {} messages, the log buffer of a thread was full", total_dropped - dropped_reported_);
+            dropped_reported_ = total_dropped;
+        }
+
+        return records.size();
+    }
+
+    async_log_stats async_logger::stats() {
+        async_log_stats result;
+
+        const std::lock_guard<std::mutex> drain_guard(drain_lock_);
+        const std::lock_guard<std::mutex> rings_guard(rings_lock_);
+
+        result.written_ = written_;
+        result.dropped_ = dropped_of_freed_rings_;
+
+        for (auto &ring: rings_) {
+            result.dropped_ += ring->dropped();
+        }
+
+        return result;
+    }
+
+    void async_logger::drain_thread_loop() {
+        common::set_thread_name("Async logger thread");
+
+        while (true) {
+            const bool wrote_any = (flush() != 0);
+
+            std::unique_lock<std::mutex> guard(drain_cond_lock_);
+            if (should_stop_) {
+                break;
+            }
+
+            // Producers never wake this thread up, so that pushing stays lock-free
+            if (!wrote_any) {
+                drain_cond_.wait_for(guard, std::chrono::milliseconds(5), [this]() { return should_stop_; });
+            }
+        }
+
+        flush();
+    }
+
+    void async_logger::start() {
+        if (drain_thread_.joinable()) {
+            return;
+        }
+
+        should_stop_ = false;
+        drain_thread_ = std::thread([this]() { drain_thread_loop(); });
+    }
+
+    void async_logger::stop() {
+        if (!drain_thread_.joinable()) {
+            return;
+        }
+
+        {
+            const std::lock_guard<std::mutex> guard(drain_cond_lock_);
+            should_stop_ = true;
+        }
+
+        drain_cond_.notify_one();
+        drain_thread_.join();
+    }
+}
@@ -22,148 +22,276 @@
 #include <common/buffer.h>
 #include <common/bytepair.h>
 #include <common/log.h>
+#include <common/platform.h>
 
 #include <cstdint>
-#include <functional>
-#include <stack>
+#include <cstring>
+
+#if EKA2L1_ARCH(X64)
+#include <emmintrin.h>
+#elif EKA2L1_ARCH(ARM64)
+#include <arm_neon.h>
+#endif
 
 namespace eka2l1 {
     namespace common {
-        int bytepair_decompress(void *destination, unsigned int dest_size, void *buffer, unsigned int buf_size) {
-            uint8_t *data8 = reinterpret_cast<uint8_t *>(buffer);
-            uint32_t lookup_table[0x200];
+        static constexpr std::uint32_t BYTEPAIR_MAX_EXPANSION = 0x10000;
+        static constexpr std::uint32_t BYTEPAIR_EXPANSION_INVALID = 0xFFFFFFFF;
+        static constexpr std::uint32_t BYTEPAIR_SHORT_EXPANSION = 16;
+
+        static inline void copy_16_bytes(std::uint8_t *dest, const std::uint8_t *source) {
+#if EKA2L1_ARCH(X64)
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest), _mm_loadu_si128(reinterpret_cast<const __m128i *>(source)));
+#elif EKA2L1_ARCH(ARM64)
+            vst1q_u8(dest, vld1q_u8(source));
+#else
+            std::memcpy(dest, source, 16);
+#endif
+        }
 
-            uint8_t *lookup_table_first = reinterpret_cast<uint8_t *>(lookup_table);
-            uint8_t *lookup_table_second = lookup_table_first + 0x100;
+        /**
+         * \brief Pair table of a bytepair compressed page.
+         *
+         * Besides the two bytes each token expands to, the length of each token's full expansion
+         * is computed up front. Expansions of up to 16 bytes are built the first time the token
+         * is used, into a slot that is then copied out with a single 16-byte move. Literal bytes
+         * have a slot holding themselves, so they are copied out the same way.
+         */
+        struct bytepair_table {
+            std::uint8_t first_[0x100];
+            std::uint8_t second_[0x100];
+            std::uint8_t non_literal_[0x100];
+            bool pair_defined_[0x100];
+
+            std::uint32_t expansion_length_[0x100];
+
+            // Length of the expansion ready in the slot, 0 if the token must go through the slow path
+            std::uint8_t slot_length_[0x100];
+
+            // A slot is twice the size of the expansion, so both halves can be written with 16-byte moves
+            alignas(16) std::uint8_t slots_[0x100][BYTEPAIR_SHORT_EXPANSION * 2];
+
+            std::uint32_t compute_expansion_length(const std::uint8_t token, std::uint8_t *visiting) {
+                if (!non_literal_[token]) {
+                    return 1;
+                }
 
-            uint32_t marker = ~0u;
-            uint8_t p1, p2;
+                if (expansion_length_[token] != 0) {
+                    return expansion_length_[token];
+                }
 
-            // Fill the table
-            uint32_t b = 0x03020100;
-            uint32_t step = 0x04040404;
+                // A marker without a pair, or pairs referencing each other, means a damaged table
+                if (!pair_defined_[token] || visiting[token]) {
+                    return BYTEPAIR_EXPANSION_INVALID;
+                }
 
-            std::stack<uint8_t> sec_stack;
+                visiting[token] = 1;
 
-            uint8_t *buf_end = reinterpret_cast<uint8_t *>(buffer) + buf_size;
-            uint8_t *dest_end = reinterpret_cast<uint8_t *>(destination) + dest_size;
+                const std::uint32_t first_length = compute_expansion_length(first_[token], visiting);
+                const std::uint32_t second_length = compute_expansion_length(second_[token], visiting);
 
-            uint8_t *dest = reinterpret_cast<uint8_t *>(destination);
+                visiting[token] = 0;
 
-            uint32_t *lut = (uint32_t *)(lookup_table);
+                if ((first_length == BYTEPAIR_EXPANSION_INVALID) || (second_length == BYTEPAIR_EXPANSION_INVALID)) {
+                    return BYTEPAIR_EXPANSION_INVALID;
+                }
 
-            do {
-                *lut++ = b;
-                b += step;
-            } while (b > step);
+                expansion_length_[token] = common::min<std::uint32_t>(first_length + second_length, BYTEPAIR_MAX_EXPANSION);
+                return expansion_length_[token];
+            }
 
-            uint8_t total_pair = *data8++;
+            /**
+             * \brief Build the slot of a token whose expansion is no longer than 16 bytes.
+             */
+            void fill_slot(const std::uint8_t token) {
+                std::uint8_t *slot = slots_[token];
 
-            if (total_pair) {
-                marker = *data8++;
-                lookup_table_first[marker] = (uint8_t)(~marker);
+                const std::uint8_t first = first_[token];
+                const std::uint8_t second = second_[token];
 
-                if (total_pair < 32) {
-                    uint8_t *pair_end = data8 + 3 * total_pair;
+                const std::uint32_t first_length = non_literal_[first] ? expansion_length_[first] : 1;
 
-                    do {
-                        b = *data8++;
-                        p1 = *data8++;
-                        p2 = *data8++;
+                if (non_literal_[first] && !slot_length_[first]) {
+                    fill_slot(first);
+                }
 
-                        lookup_table_first[b] = p1;
-                        lookup_table_second[b] = p2;
-                    } while (data8 < pair_end);
+                if (non_literal_[second] && !slot_length_[second]) {
+                    fill_slot(second);
+                }
 
-                } else {
-                    uint8_t *mask_st = data8;
-                    data8 += 32;
+                copy_16_bytes(slot, slots_[first]);
+                copy_16_bytes(slot + first_length, slots_[second]);
 
-                    for (b = 0; b < 0x100; b++) {
-                        uint8_t mask = mask_st[b >> 3];
+                slot_length_[token] = static_cast<std::uint8_t>(expansion_length_[token]);
+            }
 
-                        if (mask & (1 << (b & 7))) {
-                            // Read the pair
-                            p1 = *data8++;
-                            p2 = *data8++;
+            /**
+             * \brief Write the expansion of a token, stopping at the end of the destination.
+             *
+             * \returns Number of bytes written.
+             */
+            std::uint32_t expand(const std::uint8_t token, std::uint8_t *dest, const std::uint32_t dest_left) const {
+                // Second bytes of the pairs still to be expanded. Depth is bounded by the token count.
+                std::uint8_t pending[0x100];
+                std::uint32_t pending_count = 0;
+                std::uint32_t written = 0;
+
+                std::uint8_t current = token;
+
+                while (written < dest_left) {
+                    if (non_literal_[current]) {
+                        pending[pending_count++] = second_[current];
+                        current = first_[current];
+
+                        continue;
+                    }
 
-                            lookup_table_first[b] = p1;
-                            lookup_table_second[b] = p2;
+                    dest[written++] = current;
 
-                            --total_pair;
-                        }
+                    if (pending_count == 0) {
+                        break;
                     }
 
-                    if (total_pair) {
-                        return 0;
-                    }
+                    current = pending[--pending_count];
                 }
+
+                return written;
             }
+        };
+
+        int bytepair_decompress(void *destination, unsigned int dest_size, void *buffer, unsigned int buf_size) {
+            if (buf_size == 0) {
+                return 0;
+            }
+
+            const std::uint8_t *data8 = reinterpret_cast<const std::uint8_t *>(buffer);
+            const std::uint8_t *buf_end = data8 + buf_size;
 
-            b = *data8++;
-            p1 = lookup_table_first[b];
+            std::uint8_t *dest_begin = reinterpret_cast<std::uint8_t *>(destination);
+            std::uint8_t *dest = dest_begin;
+            std::uint8_t *dest_end = dest_begin + dest_size;
 
-            // I'm so depressed that i have to do this
-            if (p1 != b)
-                goto not_single;
+            std::uint32_t total_pair = *data8++;
+
+            if (total_pair == 0) {
+                // Nothing was compressed in this page
+                const std::size_t copy_size = common::min<std::size_t>(buf_end - data8, dest_size);
+                std::memcpy(dest, data8, copy_size);
+
+                return static_cast<int>(copy_size);
+            }
 
-        process_replace:
             if (data8 >= buf_end) {
-                goto done_data8;
+                return 0;
             }
 
-            b = *data8++;
-            *dest++ = p1;
+            bytepair_table table;
 
-            if (dest >= dest_end) {
-                goto done_dest;
+            for (std::uint32_t b = 0; b < 0x100; b++) {
+                table.first_[b] = static_cast<std::uint8_t>(b);
             }
 
-            p1 = lookup_table_first[b];
+            std::memset(table.pair_defined_, 0, sizeof(table.pair_defined_));
+
+            const std::uint8_t marker = *data8++;
+            table.first_[marker] = static_cast<std::uint8_t>(~marker);
 
-            if (p1 == b)
-                goto process_replace;
+            if (total_pair < 32) {
+                if (buf_end - data8 < static_cast<std::ptrdiff_t>(3 * total_pair)) {
+                    return 0;
+                }
 
-        not_single:
-            if (b == marker) {
-                goto do_marker;
+                for (std::uint32_t i = 0; i < total_pair; i++) {
+                    const std::uint8_t b = *data8++;
+
+                    table.first_[b] = *data8++;
+                    table.second_[b] = *data8++;
+                    table.pair_defined_[b] = true;
+                }
+            } else {
+                if (buf_end - data8 < 32) {
+                    return 0;
+                }
+
+                const std::uint8_t *mask_st = data8;
+                data8 += 32;
+
+                for (std::uint32_t b = 0; b < 0x100; b++) {
+                    if (mask_st[b >> 3] & (1 << (b & 7))) {
+                        if ((buf_end - data8 < 2) || (total_pair == 0)) {
+                            return 0;
+                        }
+
+                        table.first_[b] = *data8++;
+                        table.second_[b] = *data8++;
+                        table.pair_defined_[b] = true;
+
+                        --total_pair;
+                    }
+                }
+
+                if (total_pair) {
+                    return 0;
+                }
             }
 
-        do_pair:
-            p2 = lookup_table_second[b];
-            b = p1;
-            p1 = lookup_table_first[b];
-            sec_stack.push(p2);
+            for (std::uint32_t b = 0; b < 0x100; b++) {
+                table.non_literal_[b] = (table.first_[b] != b) ? 1 : 0;
+            }
 
-        recurse:
-            if (b != p1) {
-                goto do_pair;
+            for (std::uint32_t b = 0; b < 0x100; b++) {
+                table.slots_[b][0] = static_cast<std::uint8_t>(b);
+                table.slot_length_[b] = table.non_literal_[b] ? 0 : 1;
             }
 
-            if (sec_stack.empty()) {
-                goto process_replace;
+            std::memset(table.expansion_length_, 0, sizeof(table.expansion_length_));
+
+            std::uint8_t visiting[0x100] = {};
+
+            for (std::uint32_t b = 0; b < 0x100; b++) {
+                if (table.pair_defined_[b] && (table.compute_expansion_length(static_cast<std::uint8_t>(b), visiting) == BYTEPAIR_EXPANSION_INVALID)) {
+                    return 0;
+                }
             }
 
-            b = sec_stack.top();
-            sec_stack.pop();
+            while ((data8 < buf_end) && (dest < dest_end)) {
+                const std::uint8_t b = *data8++;
+                const std::uint32_t dest_left = static_cast<std::uint32_t>(dest_end - dest);
 
-            *dest++ = p1;
-            p1 = lookup_table_first[b];
+                if (table.slot_length_[b] && (dest_left >= 16)) {
+                    copy_16_bytes(dest, table.slots_[b]);
+                    dest += table.slot_length_[b];
 
-            goto recurse;
+                    continue;
+                }
 
-        do_marker:
-            p1 = *data8++;
-            goto process_replace;
+                if (!table.non_literal_[b]) {
+                    *dest++ = b;
+                    continue;
+                }
 
-        done_data8:
-            *dest++ = p1;
-            return static_cast<int>(dest - static_cast<uint8_t *>(destination));
+                if (b == marker) {
+                    if (data8 >= buf_end) {
+                        break;
+                    }
 
-        done_dest:
-            return static_cast<int>(dest - static_cast<uint8_t *>(destination));
+                    *dest++ = *data8++;
+                    continue;
+                }
+
+                const std::uint32_t length = table.expansion_length_[b];
+
+                if ((length <= BYTEPAIR_SHORT_EXPANSION) && (dest_left >= 16)) {
+                    table.fill_slot(b);
+                    copy_16_bytes(dest, table.slots_[b]);
+
+                    dest += length;
+                } else {
+                    dest += table.expand(b, dest, dest_left);
+                }
+            }
 
-            return 1;
+            return static_cast<int>(dest - dest_begin);
         }
 
         ibytepair_stream::ibytepair_stream(common::ro_stream *stream)
@@ -18,7 +18,9 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <common/cvt.h>
 #include <common/platform.h>
+#include <common/unicode.h>
 
 #include <codecvt>
 #include <locale>
@@ -35,16 +37,108 @@ namespace eka2l1 {
         using char_ucs2 = char16_t;
 #endif
 
-        // VS2017 bug: https://stackoverflow.com/questions/32055357/visual-studio-c-2015-stdcodecvt-with-char16-t-or-char32-t
+        static constexpr char16_t REPLACEMENT_CHARACTER = 0xFFFD;
+
         std::string ucs2_to_utf8(const std::u16string &str) {
             if (str.empty()) {
                 return "";
             }
 
-            std::wstring_convert<std::codecvt_utf8_utf16<char_ucs2>, char_ucs2> convert;
-            auto p = reinterpret_cast<const char_ucs2 *>(str.data());
+            // Every code unit takes at most three bytes, a surrogate pair takes four
+            std::string result(str.size() * 3, '\0');
+
+            const std::uint8_t *source = reinterpret_cast<const std::uint8_t *>(str.data());
+            std::uint8_t *dest = reinterpret_cast<std::uint8_t *>(&result[0]);
+
+            std::size_t i = 0;
+            std::size_t written = 0;
+
+            while (i < str.size()) {
+                // Most strings are ASCII, convert those runs in bulk
+                const std::size_t ascii_run = narrow_unit_run(source + i * 2, str.size() - i, dest + written, 0, 0x7F);
+
+                i += ascii_run;
+                written += ascii_run;
+
+                if (i >= str.size()) {
+                    break;
+                }
+
+                std::uint32_t code = str[i++];
+
+                if ((code >= 0xD800) && (code <= 0xDBFF) && (i < str.size()) && (str[i] >= 0xDC00) && (str[i] <= 0xDFFF)) {
+                    code = 0x10000 + ((code - 0xD800) << 10) + (str[i++] - 0xDC00);
+                } else if ((code >= 0xD800) && (code <= 0xDFFF)) {
+                    // Unpaired surrogate
+                    code = REPLACEMENT_CHARACTER;
+                }
+
+                if (code < 0x800) {
+                    dest[written++] = static_cast<std::uint8_t>(0xC0 | (code >> 6));
+                } else if (code < 0x10000) {
+                    dest[written++] = static_cast<std::uint8_t>(0xE0 | (code >> 12));
+                    dest[written++] = static_cast<std::uint8_t>(0x80 | ((code >> 6) & 0x3F));
+                } else {
+                    dest[written++] = static_cast<std::uint8_t>(0xF0 | (code >> 18));
+                    dest[written++] = static_cast<std::uint8_t>(0x80 | ((code >> 12) & 0x3F));
+                    dest[written++] = static_cast<std::uint8_t>(0x80 | ((code >> 6) & 0x3F));
+                }
 
-            return convert.to_bytes(p, p + str.size());
+                dest[written++] = static_cast<std::uint8_t>(0x80 | (code & 0x3F));
+            }
+
+            result.resize(written);
+            return result;
+        }
+
+        /**
+         * \brief Decode a UTF-8 sequence that is not ASCII.
+         *
+         * Overlong forms, surrogates and truncated sequences are rejected, consuming only their lead byte.
+         *
+         * \returns The code point, or REPLACEMENT_CHARACTER if the sequence is invalid.
+         */
+        static std::uint32_t decode_utf8_sequence(const std::uint8_t *source, const std::size_t size, std::size_t &pos) {
+            const std::uint8_t lead = source[pos++];
+
+            std::uint32_t code = 0;
+            std::uint32_t min_code = 0;
+            std::size_t continuation_count = 0;
+
+            if ((lead >= 0xC2) && (lead <= 0xDF)) {
+                code = lead & 0x1F;
+                min_code = 0x80;
+                continuation_count = 1;
+            } else if ((lead >= 0xE0) && (lead <= 0xEF)) {
+                code = lead & 0x0F;
+                min_code = 0x800;
+                continuation_count = 2;
+            } else if ((lead >= 0xF0) && (lead <= 0xF4)) {
+                code = lead & 0x07;
+                min_code = 0x10000;
+                continuation_count = 3;
+            } else {
+                return REPLACEMENT_CHARACTER;
+            }
+
+            if (size - pos < continuation_count) {
+                return REPLACEMENT_CHARACTER;
+            }
+
+            for (std::size_t i = 0; i < continuation_count; i++) {
+                if ((source[pos + i] & 0xC0) != 0x80) {
+                    return REPLACEMENT_CHARACTER;
+                }
+
+                code = (code << 6) | (source[pos + i] & 0x3F);
+            }
+
+            if ((code < min_code) || (code > 0x10FFFF) || ((code >= 0xD800) && (code <= 0xDFFF))) {
+                return REPLACEMENT_CHARACTER;
+            }
+
+            pos += continuation_count;
+            return code;
         }
 
         std::u16string utf8_to_ucs2(const std::string &str) {
@@ -52,17 +146,46 @@ namespace eka2l1 {
                 return u"";
             }
 
-            std::wstring_convert<std::codecvt_utf8_utf16<char_ucs2>, char_ucs2> converter;
-            auto wstr = converter.from_bytes(str);
+            // Every byte makes at most one code unit
+            std::u16string result(str.size(), u'\0');
+
+            const std::uint8_t *source = reinterpret_cast<const std::uint8_t *>(str.data());
+            std::uint8_t *dest = reinterpret_cast<std::uint8_t *>(&result[0]);
+
+            std::size_t i = 0;
+            std::size_t written = 0;
 
-            std::u16string new_string(wstr.begin(), wstr.end());
+            while (i < str.size()) {
+                // Most strings are ASCII, convert those runs in bulk
+                const std::size_t ascii_run = widen_byte_run(source + i, str.size() - i, dest + written * 2, 0, 0x7F);
 
-            if (new_string.back() == u'\0') {
+                i += ascii_run;
+                written += ascii_run;
+
+                if (i >= str.size()) {
+                    break;
+                }
+
+                std::uint32_t code = decode_utf8_sequence(source, str.size(), i);
+
+                if (code >= 0x10000) {
+                    code -= 0x10000;
+
+                    result[written++] = static_cast<char16_t>(0xD800 + (code >> 10));
+                    result[written++] = static_cast<char16_t>(0xDC00 + (code & 0x3FF));
+                } else {
+                    result[written++] = static_cast<char16_t>(code);
+                }
+            }
+
+            result.resize(written);
+
+            if (result.back() == u'\0') {
                 // Try to remove the null bit
-                new_string.pop_back();
+                result.pop_back();
             }
 
-            return new_string;
+            return result;
         }
 
         std::wstring ucs2_to_wstr(const std::u16string &str) {
@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <common/algorithm.h>
+#include <common/buffer.h>
+#include <common/filewriter.h>
+#include <common/log.h>
+#include <common/thread.h>
+
+#include <unordered_map>
+
+namespace eka2l1::common {
+    file_write_pool::file_write_pool(std::size_t worker_count, const std::size_t max_pending_bytes)
+        : next_handle_(0)
+        , pending_bytes_(0)
+        , pending_jobs_(0)
+        , max_pending_bytes_(max_pending_bytes)
+        , bytes_queued_(0)
+        , bytes_written_(0)
+        , files_written_(0)
+        , failed_(false)
+        , start_(std::chrono::steady_clock::now())
+        , stopped_(false) {
+        if (worker_count == 0) {
+            // Writing is mostly waiting on the disk, a few threads are enough to keep it busy
+            worker_count = common::clamp<std::size_t>(1, 4, std::thread::hardware_concurrency());
+        }
+
+        for (std::size_t i = 0; i < worker_count; i++) {
+            workers_.push_back(std::make_unique<worker>());
+            workers_.back()->queue_.max_pending_count_ = 0xFFFFFFFF;
+        }
+
+        for (auto &wk : workers_) {
+            worker *me = wk.get();
+            me->thread_ = std::thread([this, me]() {
+                common::set_thread_name("File write pool thread");
+                run_worker(*me);
+            });
+        }
+    }
+
+    file_write_pool::~file_write_pool() {
+        finish();
+    }
+
+    void file_write_pool::run_worker(worker &me) {
+        std::unordered_map<std::size_t, std::unique_ptr<wo_std_file_stream>> opened;
+
+        while (auto popped = me.queue_.pop()) {
+            job_ptr current = std::move(popped.value());
+
+            if (current->kind_ == job::kind_stop) {
+                break;
+            }
+
+            switch (current->kind_) {
+            case job::kind_open: {
+                auto stream = std::make_unique<wo_std_file_stream>(current->path_, true);
+
+                if (!stream->valid()) {
+                    LOG_ERROR(COMMON, "Unable to create file {} for writing", current->path_);
+                    failed_ = true;
+                }
+
+                opened[current->handle_] = std::move(stream);
+                break;
+            }
+
+            case job::kind_write: {
+                auto ite = opened.find(current->handle_);
+
+                // Data for a file that failed to open is dropped, it was already reported
+                if ((ite != opened.end()) && ite->second->valid()) {
+                    const std::uint64_t written = ite->second->write(current->data_.data(), current->data_.size());
+                    bytes_written_ += written;
+
+                    if (written != current->data_.size()) {
+                        LOG_ERROR(COMMON, "Unable to write {} bytes to file handle {}", current->data_.size(), current->handle_);
+                        failed_ = true;
+                    }
+                }
+
+                break;
+            }
+
+            case job::kind_close: {
+                auto ite = opened.find(current->handle_);
+
+                if (ite != opened.end()) {
+                    if (ite->second->valid()) {
+                        files_written_++;
+                    }
+
+                    opened.erase(ite);
+                }
+
+                break;
+            }
+
+            default:
+                break;
+            }
+
+            {
+                const std::lock_guard<std::mutex> guard(pending_lock_);
+
+                pending_bytes_ -= current->data_.size();
+                pending_jobs_--;
+            }
+
+            pending_cond_.notify_all();
+        }
+    }
+
+    void file_write_pool::queue_job(const std::size_t handle, job_ptr new_job) {
+        {
+            std::unique_lock<std::mutex> guard(pending_lock_);
+
+            // Always let something through when the queue is empty, even if it's bigger than the limit
+            while (!stopped_ && (pending_bytes_ != 0) && (pending_bytes_ + new_job->data_.size() > max_pending_bytes_)) {
+                pending_cond_.wait(guard);
+            }
+
+            if (stopped_) {
+                return;
+            }
+
+            pending_bytes_ += new_job->data_.size();
+            pending_jobs_++;
+        }
+
+        workers_[handle % workers_.size()]->queue_.push(new_job);
+    }
+
+    std::size_t file_write_pool::begin_file(const std::string &path) {
+        const std::size_t handle = next_handle_++;
+
+        job_ptr new_job = std::make_shared<job>();
+        new_job->kind_ = job::kind_open;
+        new_job->handle_ = handle;
+        new_job->path_ = path;
+
+        queue_job(handle, std::move(new_job));
+        return handle;
+    }
+
+    void file_write_pool::write(const std::size_t handle, std::vector<std::uint8_t> &&data) {
+        if (data.empty()) {
+            return;
+        }
+
+        bytes_queued_ += data.size();
+
+        job_ptr new_job = std::make_shared<job>();
+        new_job->kind_ = job::kind_write;
+        new_job->handle_ = handle;
+        new_job->data_ = std::move(data);
+
+        queue_job(handle, std::move(new_job));
+    }
+
+    void file_write_pool::write(const std::size_t handle, const void *data, const std::size_t size) {
+        const std::uint8_t *data_u8 = reinterpret_cast<const std::uint8_t *>(data);
+        write(handle, std::vector<std::uint8_t>(data_u8, data_u8 + size));
+    }
+
+    void file_write_pool::end_file(const std::size_t handle) {
+        job_ptr new_job = std::make_shared<job>();
+        new_job->kind_ = job::kind_close;
+        new_job->handle_ = handle;
+
+        queue_job(handle, std::move(new_job));
+    }
+
+    void file_write_pool::wait_idle() {
+        std::unique_lock<std::mutex> guard(pending_lock_);
+
+        while (!stopped_ && (pending_jobs_ != 0)) {
+            pending_cond_.wait(guard);
+        }
+    }
+
+    void file_write_pool::stop_workers(const bool drop_pending) {
+        {
+            const std::lock_guard<std::mutex> guard(pending_lock_);
+
+            if (stopped_) {
+                return;
+            }
+
+            stopped_ = true;
+        }
+
+        // A producer waiting for room, or for the pool to be idle, gives up once it sees the pool stopped
+        pending_cond_.notify_all();
+
+        for (auto &wk : workers_) {
+            if (drop_pending) {
+                wk->queue_.abort();
+            } else {
+                job_ptr stop_job = std::make_shared<job>();
+                stop_job->kind_ = job::kind_stop;
+
+                wk->queue_.push(stop_job);
+            }
+        }
+
+        for (auto &wk : workers_) {
+            wk->thread_.join();
+        }
+
+        const std::lock_guard<std::mutex> guard(pending_lock_);
+
+        pending_bytes_ = 0;
+        pending_jobs_ = 0;
+    }
+
+    bool file_write_pool::finish() {
+        stop_workers(false);
+        return !failed_;
+    }
+
+    void file_write_pool::abort() {
+        stop_workers(true);
+    }
+
+    file_write_stats file_write_pool::stats() const {
+        file_write_stats result;
+
+        result.bytes_queued_ = bytes_queued_;
+        result.bytes_written_ = bytes_written_;
+        result.files_written_ = files_written_;
+        result.seconds_elapsed_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+
+        if (result.seconds_elapsed_ > 0.0) {
+            result.read_bytes_per_second_ = static_cast<double>(result.bytes_queued_) / result.seconds_elapsed_;
+            result.write_bytes_per_second_ = static_cast<double>(result.bytes_written_) / result.seconds_elapsed_;
+        }
+
+        return result;
+    }
+}
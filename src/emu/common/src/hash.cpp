@@ -2,10 +2,13 @@
 
 namespace std {
     std::size_t hash<std::pair<int, int>>::operator()(const std::pair<int, int> &p) const {
-        auto h1 = std::hash<int>{}(p.first);
-        auto h2 = std::hash<int>{}(p.second);
+        // A plain XOR maps (a, b) and (b, a), and every (a, a), to the same value
+        std::size_t seed = 0;
 
-        return h1 ^ h2;
+        eka2l1::common::hash_combine(seed, p.first);
+        eka2l1::common::hash_combine(seed, p.second);
+
+        return seed;
     }
 };
 
@@ -17,6 +17,7 @@
  */
 
 #include <common/algorithm.h>
+#include <common/asynclog.h>
 #include <common/fileutils.h>
 #include <common/log.h>
 #include <common/platform.h>
@@ -165,6 +166,27 @@ namespace eka2l1 {
         std::shared_ptr<spdlog::sinks::stdout_color_sink_mt> stdout_color_sink;
         std::shared_ptr<spdlog::sinks::dist_sink_mt> color_dist_sink;
 
+        // Kept reachable after exit, see below
+        async_logger *exited_async_backend = nullptr;
+
+        // Declared after the logger it writes to, so that it is destroyed (and drained) first
+        struct async_backend_holder {
+            std::unique_ptr<async_logger> backend_;
+
+            ~async_backend_holder() {
+                active_async_logger.store(nullptr, std::memory_order_release);
+
+                if (!backend_) {
+                    return;
+                }
+
+                // Write everything pushed so far, but never free the backend: a thread that loaded the
+                // pointer just before it was cleared may still be pushing to it. Those late messages are lost.
+                backend_->stop();
+                exited_async_backend = backend_.release();
+            }
+        } async_backend;
+
         bool console_shown = false;
 
         struct imgui_logger_sink : public spdlog::sinks::base_sink<std::mutex> {
@@ -286,5 +308,28 @@ namespace eka2l1 {
         bool is_console_enabled() {
             return console_shown;
         }
+
+        void enable_async_logging() {
+            if (!spd_logger) {
+                return;
+            }
+
+            // The backend is kept even when disabled, since a thread may still be pushing to it
+            if (!async_backend.backend_) {
+                async_backend.backend_ = std::make_unique<async_logger>(spd_logger);
+            }
+
+            async_backend.backend_->start();
+            active_async_logger.store(async_backend.backend_.get(), std::memory_order_release);
+        }
+
+        void disable_async_logging() {
+            if (!async_backend.backend_) {
+                return;
+            }
+
+            active_async_logger.store(nullptr, std::memory_order_release);
+            async_backend.backend_->stop();
+        }
     }
 }
@@ -20,10 +20,123 @@
 #include <common/bitmap.h>
 #include <common/buffer.h>
 #include <common/paint.h>
+#include <common/platform.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <stack>
 
+#if EKA2L1_ARCH(X64)
+#include <emmintrin.h>
+#elif EKA2L1_ARCH(ARM64)
+#include <arm_neon.h>
+#endif
+
 namespace eka2l1::common {
+    /**
+     * \brief Blend source bytes over destination bytes, with per-byte alpha.
+     * 
+     * Each byte is computed as (src * alpha + dst * (255 - alpha)) / 255, with rounding.
+     */
+    static void blend_bytes(std::uint8_t *dst, const std::uint8_t *src, const std::uint8_t *alpha, const std::size_t count) {
+        std::size_t i = 0;
+
+#if EKA2L1_ARCH(X64)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i all_255 = _mm_set1_epi16(255);
+        const __m128i half = _mm_set1_epi16(128);
+
+        auto blend_half = [&](const __m128i d, const __m128i s, const __m128i a) {
+            __m128i t = _mm_add_epi16(_mm_mullo_epi16(s, a), _mm_mullo_epi16(d, _mm_sub_epi16(all_255, a)));
+            t = _mm_add_epi16(t, half);
+
+            return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+        };
+
+        for (; i + 16 <= count; i += 16) {
+            const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+            const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(alpha + i));
+
+            const __m128i lo = blend_half(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(a, zero));
+            const __m128i hi = blend_half(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(a, zero));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(lo, hi));
+        }
+#elif EKA2L1_ARCH(ARM64)
+        const uint8x16_t all_255 = vdupq_n_u8(255);
+        const uint16x8_t half = vdupq_n_u16(128);
+
+        auto blend_half = [&](const uint8x8_t d, const uint8x8_t s, const uint8x8_t a, const uint8x8_t inv_a) {
+            uint16x8_t t = vaddq_u16(vmull_u8(s, a), vmull_u8(d, inv_a));
+            t = vaddq_u16(t, half);
+
+            return vshrn_n_u16(vaddq_u16(t, vshrq_n_u16(t, 8)), 8);
+        };
+
+        for (; i + 16 <= count; i += 16) {
+            const uint8x16_t d = vld1q_u8(dst + i);
+            const uint8x16_t s = vld1q_u8(src + i);
+            const uint8x16_t a = vld1q_u8(alpha + i);
+            const uint8x16_t inv_a = vsubq_u8(all_255, a);
+
+            const uint8x8_t lo = blend_half(vget_low_u8(d), vget_low_u8(s), vget_low_u8(a), vget_low_u8(inv_a));
+            const uint8x8_t hi = blend_half(vget_high_u8(d), vget_high_u8(s), vget_high_u8(a), vget_high_u8(inv_a));
+
+            vst1q_u8(dst + i, vcombine_u8(lo, hi));
+        }
+#endif
+
+        for (; i < count; i++) {
+            std::uint32_t t = src[i] * alpha[i] + dst[i] * (255 - alpha[i]) + 128;
+            dst[i] = static_cast<std::uint8_t>((t + (t >> 8)) >> 8);
+        }
+    }
+
+    /**
+     * \brief Clip a run of pixels to a row of given width.
+     * 
+     * \returns False if nothing is left of the run.
+     */
+    static bool clip_span(const eka2l1::vec2 &size, const int y, int &x_start, int &x_end) {
+        if ((y < 0) || (y >= size.y)) {
+            return false;
+        }
+
+        x_start = std::max<int>(x_start, 0);
+        x_end = std::min<int>(x_end, size.x);
+
+        return x_start < x_end;
+    }
+
+    void pixel_plotter::fill_span(const int y, const int x_start, const int x_end, const eka2l1::vecx<int, 4> &color) {
+        for (int x = x_start; x < x_end; x++) {
+            plot_pixel({ x, y }, color);
+        }
+    }
+
+    void pixel_plotter::blend_span(const int y, const int x_start, const std::uint8_t *coverages, const int count,
+        const eka2l1::vecx<int, 4> &color) {
+        const eka2l1::vec2 size = get_size();
+
+        for (int i = 0; i < count; i++) {
+            const eka2l1::vec2 pos{ x_start + i, y };
+
+            if ((pos.x < 0) || (pos.x >= size.x) || (pos.y < 0) || (pos.y >= size.y) || (coverages[i] == 0)) {
+                continue;
+            }
+
+            eka2l1::vecx<int, 4> result = get_pixel(pos);
+
+            for (std::size_t c = 0; c < 4; c++) {
+                result[c] = (color[c] * coverages[i] + result[c] * (255 - coverages[i]) + 127) / 255;
+            }
+
+            plot_pixel(pos, result);
+        }
+    }
+
     void buffer_24bmp_pixel_plotter::resize(const eka2l1::vec2 &size) {
         aligned_row_size_in_bytes = size.x * 3;
 
@@ -54,6 +167,51 @@ namespace eka2l1::common {
             255 };
     }
 
+    void buffer_24bmp_pixel_plotter::fill_span(const int y, int x_start, int x_end, const eka2l1::vecx<int, 4> &color) {
+        if (!clip_span(size_, y, x_start, x_end)) {
+            return;
+        }
+
+        std::uint8_t *dest = &buf_[aligned_row_size_in_bytes * y + x_start * 3];
+        const std::uint8_t pixel[3] = { static_cast<std::uint8_t>(color[2]), static_cast<std::uint8_t>(color[1]),
+            static_cast<std::uint8_t>(color[0]) };
+
+        for (int x = x_start; x < x_end; x++, dest += 3) {
+            dest[0] = pixel[0];
+            dest[1] = pixel[1];
+            dest[2] = pixel[2];
+        }
+    }
+
+    void buffer_24bmp_pixel_plotter::blend_span(const int y, int x_start, const std::uint8_t *coverages, int count,
+        const eka2l1::vecx<int, 4> &color) {
+        int x_end = x_start + count;
+        const int x_org = x_start;
+
+        if (!clip_span(size_, y, x_start, x_end)) {
+            return;
+        }
+
+        coverages += x_start - x_org;
+        count = x_end - x_start;
+
+        // Expand the color and coverage to match the pixel layout, so the blend can run on plain bytes
+        blend_src_.resize(count * 3);
+        blend_alpha_.resize(count * 3);
+
+        for (int i = 0; i < count; i++) {
+            blend_src_[i * 3] = static_cast<std::uint8_t>(color[2]);
+            blend_src_[i * 3 + 1] = static_cast<std::uint8_t>(color[1]);
+            blend_src_[i * 3 + 2] = static_cast<std::uint8_t>(color[0]);
+
+            blend_alpha_[i * 3] = coverages[i];
+            blend_alpha_[i * 3 + 1] = coverages[i];
+            blend_alpha_[i * 3 + 2] = coverages[i];
+        }
+
+        blend_bytes(&buf_[aligned_row_size_in_bytes * y + x_start * 3], blend_src_.data(), blend_alpha_.data(), count * 3);
+    }
+
     void buffer_24bmp_pixel_plotter::save_to_bmp(wo_stream *stream) {
         common::bmp_header header;
         header.file_size = static_cast<std::uint32_t>(sizeof(common::bmp_header) + sizeof(common::dib_header_v1) + buf_.size());
@@ -76,6 +234,284 @@ namespace eka2l1::common {
         stream->write(&buf_[0], static_cast<std::uint32_t>(buf_.size()));
     }
 
+    void buffer_32bmp_pixel_plotter::resize(const eka2l1::vec2 &size) {
+        buf_.resize(size.x * size.y * 4);
+        size_ = size;
+    }
+
+    void buffer_32bmp_pixel_plotter::plot_pixel(const eka2l1::vec2 &pos, const eka2l1::vecx<int, 4> &color) {
+        if (pos.x < 0 || pos.x >= size_.x || pos.y < 0 || pos.y >= size_.y) {
+            return;
+        }
+
+        std::uint8_t *dest = &buf_[(pos.y * size_.x + pos.x) * 4];
+
+        dest[0] = static_cast<std::uint8_t>(color[2]);
+        dest[1] = static_cast<std::uint8_t>(color[1]);
+        dest[2] = static_cast<std::uint8_t>(color[0]);
+        dest[3] = static_cast<std::uint8_t>(color[3]);
+    }
+
+    eka2l1::vecx<int, 4> buffer_32bmp_pixel_plotter::get_pixel(const eka2l1::vec2 &pos) {
+        const std::uint8_t *source = &buf_[(pos.y * size_.x + pos.x) * 4];
+        return { source[2], source[1], source[0], source[3] };
+    }
+
+    void buffer_32bmp_pixel_plotter::fill_span(const int y, int x_start, int x_end, const eka2l1::vecx<int, 4> &color) {
+        if (!clip_span(size_, y, x_start, x_end)) {
+            return;
+        }
+
+        const std::uint8_t pixel[4] = { static_cast<std::uint8_t>(color[2]), static_cast<std::uint8_t>(color[1]),
+            static_cast<std::uint8_t>(color[0]), static_cast<std::uint8_t>(color[3]) };
+
+        std::uint32_t pixel_value = 0;
+        std::memcpy(&pixel_value, pixel, sizeof(pixel_value));
+
+        std::uint32_t *dest = reinterpret_cast<std::uint32_t *>(&buf_[(y * size_.x + x_start) * 4]);
+        std::fill(dest, dest + (x_end - x_start), pixel_value);
+    }
+
+    void buffer_32bmp_pixel_plotter::blend_span(const int y, int x_start, const std::uint8_t *coverages, int count,
+        const eka2l1::vecx<int, 4> &color) {
+        int x_end = x_start + count;
+        const int x_org = x_start;
+
+        if (!clip_span(size_, y, x_start, x_end)) {
+            return;
+        }
+
+        coverages += x_start - x_org;
+        count = x_end - x_start;
+
+        blend_src_.resize(count * 4);
+        blend_alpha_.resize(count * 4);
+
+        for (int i = 0; i < count; i++) {
+            blend_src_[i * 4] = static_cast<std::uint8_t>(color[2]);
+            blend_src_[i * 4 + 1] = static_cast<std::uint8_t>(color[1]);
+            blend_src_[i * 4 + 2] = static_cast<std::uint8_t>(color[0]);
+            blend_src_[i * 4 + 3] = static_cast<std::uint8_t>(color[3]);
+
+            std::memset(&blend_alpha_[i * 4], coverages[i], 4);
+        }
+
+        blend_bytes(&buf_[(y * size_.x + x_start) * 4], blend_src_.data(), blend_alpha_.data(), count * 4);
+    }
+
+    // Number of samples taken vertically for each row. Horizontal coverage is computed exactly.
+    static constexpr int SPAN_RASTERIZER_SUBSCANLINE_COUNT = 4;
+
+    void span_rasterizer::reset() {
+        edges_.clear();
+    }
+
+    void span_rasterizer::add_edge(const float x0, const float y0, const float x1, const float y1) {
+        if (y0 == y1) {
+            // Horizontal edges never cross a scanline
+            return;
+        }
+
+        edge e;
+
+        if (y0 < y1) {
+            e = { x0, y0, x1, y1, 0.0f, 1 };
+        } else {
+            e = { x1, y1, x0, y0, 0.0f, -1 };
+        }
+
+        e.dxdy_ = (e.x1_ - e.x0_) / (e.y1_ - e.y0_);
+        edges_.push_back(e);
+    }
+
+    void span_rasterizer::move_to(const float x, const float y) {
+        close_path();
+
+        start_x_ = last_x_ = x;
+        start_y_ = last_y_ = y;
+    }
+
+    void span_rasterizer::line_to(const float x, const float y) {
+        add_edge(last_x_, last_y_, x, y);
+
+        last_x_ = x;
+        last_y_ = y;
+    }
+
+    void span_rasterizer::close_path() {
+        if ((last_x_ != start_x_) || (last_y_ != start_y_)) {
+            line_to(start_x_, start_y_);
+        }
+    }
+
+    void span_rasterizer::add_ellipse(const float cx, const float cy, const float rx, const float ry) {
+        if ((rx <= 0.0f) || (ry <= 0.0f)) {
+            return;
+        }
+
+        // Keep each segment around two pixels long, so the outline stays smooth at every size
+        constexpr float PI = 3.14159265358979f;
+        const int segment_count = std::clamp(static_cast<int>(PI * (rx + ry) / 2.0f), 16, 1024);
+
+        move_to(cx + rx, cy);
+
+        for (int i = 1; i < segment_count; i++) {
+            const float angle = 2.0f * PI * static_cast<float>(i) / static_cast<float>(segment_count);
+            line_to(cx + rx * std::cos(angle), cy + ry * std::sin(angle));
+        }
+
+        close_path();
+    }
+
+    void span_rasterizer::accumulate(float xa, float xb, const int clip_left, const int clip_right, const float weight) {
+        xa = std::max<float>(xa, static_cast<float>(clip_left));
+        xb = std::min<float>(xb, static_cast<float>(clip_right));
+
+        if (xa >= xb) {
+            return;
+        }
+
+        const int first = static_cast<int>(xa);
+        const int last = static_cast<int>(xb);
+
+        if (first == last) {
+            coverages_[first - clip_left] += (xb - xa) * weight;
+            return;
+        }
+
+        coverages_[first - clip_left] += (static_cast<float>(first + 1) - xa) * weight;
+
+        // Pixels fully inside are marked as a range, and resolved once per row
+        full_coverages_[first + 1 - clip_left] += weight;
+        full_coverages_[last - clip_left] -= weight;
+
+        if (last < clip_right) {
+            coverages_[last - clip_left] += (xb - static_cast<float>(last)) * weight;
+        }
+    }
+
+    void span_rasterizer::rasterize(pixel_plotter *plotter, const eka2l1::vecx<int, 4> &color, const eka2l1::rect &clip,
+        const fill_rule rule) {
+        if (edges_.empty()) {
+            return;
+        }
+
+        const eka2l1::rect area = clip.intersect(eka2l1::rect({ 0, 0 }, plotter->get_size()));
+
+        if (area.empty()) {
+            return;
+        }
+
+        float min_y = edges_[0].y0_;
+        float max_y = edges_[0].y1_;
+
+        for (const edge &e : edges_) {
+            min_y = std::min<float>(min_y, e.y0_);
+            max_y = std::max<float>(max_y, e.y1_);
+        }
+
+        const int clip_left = area.top.x;
+        const int clip_right = area.top.x + area.size.x;
+        const int width = area.size.x;
+
+        const int row_start = std::max<int>(area.top.y, static_cast<int>(std::floor(min_y)));
+        const int row_end = std::min<int>(area.top.y + area.size.y, static_cast<int>(std::ceil(max_y)));
+
+        std::sort(edges_.begin(), edges_.end(), [](const edge &lhs, const edge &rhs) {
+            return lhs.y0_ < rhs.y0_;
+        });
+
+        coverages_.resize(width + 1);
+        full_coverages_.resize(width + 1);
+        coverage_bytes_.resize(width);
+
+        active_edges_.clear();
+        std::size_t next_edge = 0;
+
+        const float weight = 1.0f / SPAN_RASTERIZER_SUBSCANLINE_COUNT;
+
+        for (int y = row_start; y < row_end; y++) {
+            // Update the list of edges crossing this row
+            while ((next_edge < edges_.size()) && (edges_[next_edge].y0_ < static_cast<float>(y + 1))) {
+                active_edges_.push_back(&edges_[next_edge++]);
+            }
+
+            active_edges_.erase(std::remove_if(active_edges_.begin(), active_edges_.end(), [y](const edge *e) {
+                return e->y1_ <= static_cast<float>(y);
+            }),
+                active_edges_.end());
+
+            if (active_edges_.empty()) {
+                continue;
+            }
+
+            std::fill(coverages_.begin(), coverages_.end(), 0.0f);
+            std::fill(full_coverages_.begin(), full_coverages_.end(), 0.0f);
+
+            for (int sub = 0; sub < SPAN_RASTERIZER_SUBSCANLINE_COUNT; sub++) {
+                const float sample_y = static_cast<float>(y) + (static_cast<float>(sub) + 0.5f) * weight;
+                crossings_.clear();
+
+                for (const edge *e : active_edges_) {
+                    if ((sample_y >= e->y0_) && (sample_y < e->y1_)) {
+                        crossings_.emplace_back(e->x0_ + (sample_y - e->y0_) * e->dxdy_, e->winding_);
+                    }
+                }
+
+                std::sort(crossings_.begin(), crossings_.end());
+
+                int winding = 0;
+
+                for (std::size_t i = 0; i + 1 < crossings_.size(); i++) {
+                    winding += crossings_[i].second;
+
+                    const bool inside = (rule == fill_rule::non_zero) ? (winding != 0) : ((winding & 1) != 0);
+
+                    if (inside) {
+                        accumulate(crossings_[i].first, crossings_[i + 1].first, clip_left, clip_right, weight);
+                    }
+                }
+            }
+
+            // Resolve the coverage into bytes, and find the bounds of what has been touched
+            float full_coverage = 0.0f;
+            int touched_start = width;
+            int touched_end = 0;
+
+            for (int i = 0; i < width; i++) {
+                full_coverage += full_coverages_[i];
+
+                const float total = std::min<float>(coverages_[i] + full_coverage, 1.0f);
+                coverage_bytes_[i] = static_cast<std::uint8_t>(total * 255.0f + 0.5f);
+
+                if (coverage_bytes_[i] != 0) {
+                    touched_start = std::min<int>(touched_start, i);
+                    touched_end = i + 1;
+                }
+            }
+
+            // Send fully covered runs as fills, the rest as blends
+            int run_start = touched_start;
+
+            while (run_start < touched_end) {
+                const bool full = (coverage_bytes_[run_start] == 255);
+                int run_end = run_start + 1;
+
+                while ((run_end < touched_end) && ((coverage_bytes_[run_end] == 255) == full)) {
+                    run_end++;
+                }
+
+                if (full) {
+                    plotter->fill_span(y, clip_left + run_start, clip_left + run_end, color);
+                } else {
+                    plotter->blend_span(y, clip_left + run_start, &coverage_bytes_[run_start], run_end - run_start, color);
+                }
+
+                run_start = run_end;
+            }
+        }
+    }
+
     painter::painter(pixel_plotter *plotter)
         : plotter_(plotter) {
     }
@@ -83,12 +519,17 @@ namespace eka2l1::common {
     void painter::new_art(const eka2l1::vec2 &size) {
         plotter_->resize(size);
 
-        // Clear the bitmap
-        for (int i = 0; i < size.x; i++) {
-            for (int j = 0; j < size.y; j++) {
-                // Plot empty white transparent pixel
-                plotter_->plot_pixel({ i, j }, { 255, 255, 255, 255 });
-            }
+        // Clear the bitmap with empty white transparent pixels
+        for (int y = 0; y < size.y; y++) {
+            plotter_->fill_span(y, 0, size.x, { 255, 255, 255, 255 });
+        }
+    }
+
+    void painter::fill_rect(const eka2l1::rect &re, const eka2l1::vecx<int, 4> &color) {
+        const eka2l1::rect area = re.intersect(eka2l1::rect({ 0, 0 }, plotter_->get_size()));
+
+        for (int y = area.top.y; y < area.top.y + area.size.y; y++) {
+            plotter_->fill_span(y, area.top.x, area.top.x + area.size.x, color);
         }
     }
 
@@ -193,43 +634,29 @@ namespace eka2l1::common {
     }
 
     void painter::circle(const eka2l1::vec2 &pos, const int radius) {
-        if (flags & PAINTER_FLAG_FILL_WHEN_DRAW) {
-            // Hehe
-            auto old_color = brush_col_;
-            set_brush_color(fill_col_);
-
-            circle_one_pix(pos, radius + brush_thick_);
-            flood(pos, true);
-
-            set_brush_color(old_color);
-        }
-
-        circle_one_pix(pos, radius);
-
-        if (brush_thick_ > 1) {
-            circle_one_pix(pos, radius + brush_thick_);
-            flood({ pos.x + radius + 1, pos.y }, true);
-        }
+        ellipse(pos, { radius, radius });
     }
 
     void painter::ellipse(const eka2l1::vec2 &pos, const eka2l1::vec2 &rad) {
-        if (flags & PAINTER_FLAG_FILL_WHEN_DRAW) {
-            // Hehe
-            auto old_color = brush_col_;
-            set_brush_color(fill_col_);
+        const eka2l1::rect canvas({ 0, 0 }, plotter_->get_size());
 
-            ellipse_one_pix(pos, rad + brush_thick_);
-            flood(pos, true);
+        // Shape coordinates are at the pixel center
+        const float cx = static_cast<float>(pos.x) + 0.5f;
+        const float cy = static_cast<float>(pos.y) + 0.5f;
 
-            set_brush_color(old_color);
+        if (flags & PAINTER_FLAG_FILL_WHEN_DRAW) {
+            rasterizer_.reset();
+            rasterizer_.add_ellipse(cx, cy, static_cast<float>(rad.x) + 0.5f, static_cast<float>(rad.y) + 0.5f);
+            rasterizer_.rasterize(plotter_, fill_col_, canvas);
         }
 
-        ellipse_one_pix(pos, rad);
+        // The outline is a ring starting at the radius, as thick as the brush
+        const float thickness = static_cast<float>(std::max<int>(brush_thick_, 1));
 
-        if (brush_thick_ > 1) {
-            ellipse_one_pix(pos, rad + brush_thick_);
-            flood({ pos.x + rad.x + 1, pos.y }, true);
-        }
+        rasterizer_.reset();
+        rasterizer_.add_ellipse(cx, cy, static_cast<float>(rad.x) - 0.5f + thickness, static_cast<float>(rad.y) - 0.5f + thickness);
+        rasterizer_.add_ellipse(cx, cy, static_cast<float>(rad.x) - 0.5f, static_cast<float>(rad.y) - 0.5f);
+        rasterizer_.rasterize(plotter_, brush_col_, canvas, fill_rule::even_odd);
     }
 
     void painter::ellipse_one_pix(const eka2l1::vec2 &pos, const eka2l1::vec2 &rad) {
@@ -283,7 +710,8 @@ namespace eka2l1::common {
         vertical_line({ re.top.x + re.size.x, re.top.y }, re.size.y);
 
         if (flags & PAINTER_FLAG_FILL_WHEN_DRAW) {
-            flood(re.top + brush_thick_, true);
+            const eka2l1::vec2 inner_top = re.top + brush_thick_;
+            fill_rect(eka2l1::rect(inner_top, re.top + re.size - inner_top), brush_col_);
         }
     }
 
@@ -20,202 +20,474 @@
 #include <common/algorithm.h>
 #include <common/region.h>
 
+#include <algorithm>
 #include <climits>
 
 namespace eka2l1::common {
     /**
-     * NOTE: CODE REVIEWED FROM SYMBIAN OPEN SOURCE.
+     * NOTE: The banded representation follows the one used by X11 and pixman regions.
      */
 
-    eka2l1::rect region::bounding_rect() const {
-        eka2l1::vec2 tl{ INT_MAX, INT_MAX };
-        eka2l1::vec2 br{ INT_MIN, INT_MIN };
+    enum region_op_type {
+        REGION_OP_UNION,
+        REGION_OP_SUBTRACT,
+        REGION_OP_INTERSECT
+    };
 
-        for (std::size_t i = 0; i < rects_.size(); i++) {
-            tl.x = common::min(tl.x, rects_[i].top.x);
-            tl.y = common::min(tl.y, rects_[i].top.y);
-            br.x = common::max(br.x, rects_[i].top.x + rects_[i].size.x);
-            br.y = common::max(br.y, rects_[i].top.y + rects_[i].size.y);
+    struct region_span {
+        int left_;
+        int right_;
+
+        bool operator==(const region_span &rhs) const {
+            return (left_ == rhs.left_) && (right_ == rhs.right_);
         }
+    };
 
-        return eka2l1::rect{ tl, br - tl };
+    static bool is_rect_drawable(const eka2l1::rect &rect) {
+        return (rect.size.x > 0) && (rect.size.y > 0);
     }
 
-    bool region::add_rect(const eka2l1::rect &rect) {
-        if (rect.empty()) {
-            return true;
+    /**
+     * @brief Iterate bands of a region in banded form.
+     */
+    struct region_band_walker {
+        const std::vector<eka2l1::rect> &rects_;
+        std::size_t begin_;
+        std::size_t end_;
+        int top_; ///< Part of the band above this has been processed already.
+
+        explicit region_band_walker(const std::vector<eka2l1::rect> &rects)
+            : rects_(rects)
+            , begin_(0)
+            , end_(0)
+            , top_(0) {
+            find_end();
         }
 
-        if (rects_.empty()) {
-            rects_.push_back(rect);
-            return true;
+        void find_end() {
+            end_ = begin_;
+
+            if (begin_ < rects_.size()) {
+                top_ = rects_[begin_].top.y;
+            }
+
+            while ((end_ < rects_.size()) && (rects_[end_].top.y == rects_[begin_].top.y)) {
+                end_++;
+            }
         }
 
-        if (rect.contains(bounding_rect())) {
-            rects_.clear();
-            rects_.push_back(rect);
+        bool valid() const {
+            return begin_ < rects_.size();
+        }
 
-            return true;
+        int top() const {
+            return top_;
         }
 
-        for (std::size_t i = 0; i < rects_.size(); i++) {
-            if ((rects_[i].top.x + rects_[i].size.x <= rect.top.x) || (rects_[i].top.x >= rect.top.x + rect.size.x) || (rects_[i].top.y + rects_[i].size.y <= rect.top.y) || (rects_[i].top.y >= rect.top.y + rect.size.y))
-                continue;
+        int bottom() const {
+            return rects_[begin_].top.y + rects_[begin_].size.y;
+        }
 
-            if ((rects_[i].top.x <= rect.top.x) && (rects_[i].top.y <= rect.top.y) && (rects_[i].top.x + rects_[i].size.x >= rect.top.x + rect.size.x) && (rects_[i].top.y + rects_[i].size.y >= rect.top.y + rect.size.y)) {
-                // This rectangle already covers the new rectangle, no modification done
-                return false;
+        /**
+         * @brief Move the top of the band down, going to the next band if it is passed.
+         */
+        void advance_to(const int y) {
+            if (y >= bottom()) {
+                begin_ = end_;
+                find_end();
+            } else {
+                top_ = y;
             }
+        }
 
-            eka2l1::rect intersector;
-            intersector = rect.intersect(rects_[i]);
-
-            if (intersector.top.y + intersector.size.y != rect.top.y + rect.size.y)
-                rects_.push_back(eka2l1::rect({ rect.top.x, intersector.top.y }, { rect.size.x, rect.size.y + rect.top.y - intersector.top.y }));
+        void spans(std::vector<region_span> &result) const {
+            result.clear();
 
-            if (intersector.top.y != rect.top.y)
-                rects_.push_back(eka2l1::rect({ rect.top.x, rect.top.y }, { rect.size.x, intersector.top.y - rect.top.y }));
+            for (std::size_t i = begin_; i < end_; i++) {
+                result.push_back(region_span{ rects_[i].top.x, rects_[i].top.x + rects_[i].size.x });
+            }
+        }
+    };
 
-            if (intersector.top.x + intersector.size.x != rect.top.x + rect.size.x)
-                rects_.push_back(eka2l1::rect({ intersector.top.x + intersector.size.x, intersector.top.y },
-                    { rect.top.x + rect.size.x - intersector.top.x - intersector.size.x, intersector.size.y }));
+    static void combine_spans(const std::vector<region_span> &a, const std::vector<region_span> &b, const region_op_type op,
+        std::vector<region_span> &result) {
+        result.clear();
 
-            if (intersector.top.x != rect.top.x)
-                rects_.push_back(eka2l1::rect({ rect.top.x, intersector.top.y }, { intersector.top.x - rect.top.x, intersector.size.y }));
+        std::size_t ia = 0;
+        std::size_t ib = 0;
 
-            rects_.erase(rects_.begin() + i);
-            return true;
-        }
+        switch (op) {
+        case REGION_OP_UNION:
+            while ((ia < a.size()) || (ib < b.size())) {
+                region_span next;
 
-        rects_.push_back(rect);
-        return true;
-    }
+                if ((ib == b.size()) || ((ia < a.size()) && (a[ia].left_ <= b[ib].left_))) {
+                    next = a[ia++];
+                } else {
+                    next = b[ib++];
+                }
 
-    bool region::add_region(const region &rg) {
-        bool modded = false;
-        for (std::size_t i = 0; i < rg.rects_.size(); i++) {
-            if (add_rect(rg.rects_[i])) {
-                modded = true;
+                if (!result.empty() && (result.back().right_ >= next.left_)) {
+                    result.back().right_ = common::max(result.back().right_, next.right_);
+                } else {
+                    result.push_back(next);
+                }
             }
-        }
 
-        return modded;
-    }
+            break;
 
-    void region::eliminate(const eka2l1::rect &rect) {
-        if (rect.empty()) {
-            return;
-        }
+        case REGION_OP_INTERSECT:
+            while ((ia < a.size()) && (ib < b.size())) {
+                const int left = common::max(a[ia].left_, b[ib].left_);
+                const int right = common::min(a[ia].right_, b[ib].right_);
 
-        std::size_t limit = rects_.size();
+                if (left < right) {
+                    result.push_back(region_span{ left, right });
+                }
 
-        for (std::size_t i = 0; i < limit; i++) {
-            if ((rect.top == rects_[i].top) && (rect.size == rects_[i].size)) {
-                rects_.erase(rects_.begin() + i);
-                return;
+                if (a[ia].right_ < b[ib].right_) {
+                    ia++;
+                } else {
+                    ib++;
+                }
             }
 
-            const eka2l1::rect intersection_reg = rect.intersect(rects_[i]);
+            break;
+
+        case REGION_OP_SUBTRACT:
+            for (; ia < a.size(); ia++) {
+                int left = a[ia].left_;
+                const int right = a[ia].right_;
+
+                // Skip what ends before this span
+                while ((ib < b.size()) && (b[ib].right_ <= left)) {
+                    ib++;
+                }
 
-            if (!intersection_reg.empty()) {
-                const eka2l1::rect original_iterate = rects_[i];
-                rects_.erase(rects_.begin() + i);
+                std::size_t cut = ib;
 
-                const eka2l1::vec2 intersect_reg_br = intersection_reg.bottom_right();
-                const eka2l1::vec2 iterate_br = original_iterate.bottom_right();
+                while ((cut < b.size()) && (b[cut].left_ < right)) {
+                    if (b[cut].left_ > left) {
+                        result.push_back(region_span{ left, b[cut].left_ });
+                    }
 
-                if (iterate_br.y != intersect_reg_br.y) {
-                    rects_.push_back(eka2l1::rect({ original_iterate.top.x, intersect_reg_br.y }, { iterate_br.x, iterate_br.y }));
-                    rects_.back().transform_from_symbian_rectangle();
+                    left = common::max(left, b[cut].right_);
+                    if (b[cut].right_ > right) {
+                        break;
+                    }
+
+                    cut++;
                 }
 
-                if (iterate_br.x != intersect_reg_br.x) {
-                    rects_.push_back(eka2l1::rect({ intersect_reg_br.x, intersection_reg.top.y }, { iterate_br.x, intersect_reg_br.y }));
-                    rects_.back().transform_from_symbian_rectangle();
+                if (left < right) {
+                    result.push_back(region_span{ left, right });
                 }
+            }
+
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    /**
+     * @brief Append a band to a region under construction, merging it with the band above if they line up.
+     */
+    static void append_band(std::vector<eka2l1::rect> &result, std::size_t &last_band_start, const int top, const int bottom,
+        const std::vector<region_span> &spans) {
+        if (spans.empty()) {
+            return;
+        }
+
+        const std::size_t last_band_count = result.size() - last_band_start;
+
+        if ((last_band_count == spans.size()) && (last_band_count != 0) && (result[last_band_start].top.y + result[last_band_start].size.y == top)) {
+            bool same_spans = true;
 
-                if (intersection_reg.top.x != original_iterate.top.x) {
-                    rects_.push_back(eka2l1::rect({ original_iterate.top.x, intersection_reg.top.y }, { intersection_reg.top.x, intersect_reg_br.y }));
-                    rects_.back().transform_from_symbian_rectangle();
+            for (std::size_t i = 0; i < spans.size(); i++) {
+                const eka2l1::rect &above = result[last_band_start + i];
+
+                if ((above.top.x != spans[i].left_) || (above.top.x + above.size.x != spans[i].right_)) {
+                    same_spans = false;
+                    break;
                 }
+            }
 
-                if (intersection_reg.top.y != original_iterate.top.y) {
-                    rects_.push_back(eka2l1::rect(original_iterate.top, { iterate_br.x, intersection_reg.top.y }));
-                    rects_.back().transform_from_symbian_rectangle();
+            if (same_spans) {
+                for (std::size_t i = last_band_start; i < result.size(); i++) {
+                    result[i].size.y = bottom - result[i].top.y;
                 }
 
-                limit--;
+                return;
             }
         }
+
+        last_band_start = result.size();
+
+        for (const region_span &span : spans) {
+            result.push_back(eka2l1::rect({ span.left_, top }, { span.right_ - span.left_, bottom - top }));
+        }
     }
 
-    void region::eliminate(const region &reg) {
-        for (std::size_t i = 0; i < reg.rects_.size(); i++) {
-            eliminate(reg.rects_[i]);
+    /**
+     * @brief Combine two regions in banded form, by sweeping through their bands from top to bottom.
+     *
+     * Each slab between two consecutive band edges lies within at most one band of each region, so
+     * the result is made by combining the spans of those two bands.
+     */
+    static void do_region_op(const std::vector<eka2l1::rect> &a, const std::vector<eka2l1::rect> &b, const region_op_type op,
+        std::vector<eka2l1::rect> &result) {
+        result.clear();
+
+        region_band_walker walker_a(a);
+        region_band_walker walker_b(b);
+
+        std::vector<region_span> spans_a;
+        std::vector<region_span> spans_b;
+        std::vector<region_span> spans_result;
+
+        std::size_t last_band_start = 0;
+
+        while (walker_a.valid() || walker_b.valid()) {
+            if ((op != REGION_OP_UNION) && !walker_a.valid()) {
+                break;
+            }
+
+            if ((op == REGION_OP_INTERSECT) && !walker_b.valid()) {
+                break;
+            }
+
+            // Start of the slab is the first band top not passed yet
+            int top = 0;
+
+            if (walker_a.valid() && walker_b.valid()) {
+                top = common::min(walker_a.top(), walker_b.top());
+            } else {
+                top = walker_a.valid() ? walker_a.top() : walker_b.top();
+            }
+
+            const bool in_a = walker_a.valid() && (walker_a.top() <= top);
+            const bool in_b = walker_b.valid() && (walker_b.top() <= top);
+
+            // End of the slab is the nearest band edge below its start
+            int bottom = INT_MAX;
+
+            if (walker_a.valid()) {
+                bottom = common::min(bottom, in_a ? walker_a.bottom() : walker_a.top());
+            }
+
+            if (walker_b.valid()) {
+                bottom = common::min(bottom, in_b ? walker_b.bottom() : walker_b.top());
+            }
+
+            if (in_a) {
+                walker_a.spans(spans_a);
+            } else {
+                spans_a.clear();
+            }
+
+            if (in_b) {
+                walker_b.spans(spans_b);
+            } else {
+                spans_b.clear();
+            }
+
+            combine_spans(spans_a, spans_b, op, spans_result);
+            append_band(result, last_band_start, top, bottom, spans_result);
+
+            // Cut the processed slab off the bands
+            if (in_a) {
+                walker_a.advance_to(bottom);
+            }
+
+            if (in_b) {
+                walker_b.advance_to(bottom);
+            }
         }
     }
 
-    region region::intersect(const region &target) const {
-        region intersection;
+    static eka2l1::rect calculate_bounding_rect(const std::vector<eka2l1::rect> &rects) {
+        if (rects.empty()) {
+            return eka2l1::rect{};
+        }
 
-        for (std::size_t i = 0; i < rects_.size(); i++) {
-            for (std::size_t j = 0; j < target.rects_.size(); j++) {
-                eka2l1::rect the_intersect = target.rects_[j].intersect(rects_[i]);
+        int left = INT_MAX;
+        int right = INT_MIN;
 
-                if (!the_intersect.empty()) {
-                    intersection.rects_.push_back(the_intersect);
-                }
+        // In banded form, the leftmost and rightmost rectangles of a band are its first and last
+        for (std::size_t i = 0; i < rects.size(); i++) {
+            if ((i == 0) || (rects[i].top.y != rects[i - 1].top.y)) {
+                left = common::min(left, rects[i].top.x);
+            }
+
+            if ((i + 1 == rects.size()) || (rects[i].top.y != rects[i + 1].top.y)) {
+                right = common::max(right, rects[i].top.x + rects[i].size.x);
             }
         }
 
-        return intersection;
+        const int top = rects.front().top.y;
+        const int bottom = rects.back().top.y + rects.back().size.y;
+
+        return eka2l1::rect({ left, top }, { right - left, bottom - top });
     }
 
-    bool region::identical(const region &rhs) const {
-        if (rects_.size() != rhs.rects_.size()) {
+    static void apply_region_op(region &target, const std::vector<eka2l1::rect> &other, const region_op_type op) {
+        std::vector<eka2l1::rect> result;
+        do_region_op(target.rects_, other, op, result);
+
+        target.rects_ = std::move(result);
+        target.bounding_ = calculate_bounding_rect(target.rects_);
+    }
+
+    bool region::add_rect(const eka2l1::rect &rect) {
+        if (!is_rect_drawable(rect)) {
             return false;
         }
 
-        for (std::size_t i = 0; i < rects_.size(); i++) {
-            if ((rects_[i].size != rhs.rects_[i].size) || (rects_[i].top != rhs.rects_[i].top)) {
-                return false;
-            }
+        if (rects_.empty() || rect.contains(bounding_)) {
+            const bool modified = (rects_.size() != 1) || !(rects_[0] == rect);
+
+            rects_.assign(1, rect);
+            bounding_ = rect;
+
+            return modified;
+        }
+
+        const std::size_t previous_count = rects_.size();
+        std::vector<eka2l1::rect> result;
+
+        do_region_op(rects_, { rect }, REGION_OP_UNION, result);
+
+        // Union only grows, so same count and same rectangles mean nothing was added
+        if ((result.size() == previous_count) && (result == rects_)) {
+            return false;
         }
 
+        rects_ = std::move(result);
+        bounding_ = calculate_bounding_rect(rects_);
+
         return true;
     }
 
-    void region::advance(const eka2l1::vec2 &amount) {
-        for (std::size_t i = 0; i < rects_.size(); i++) {
-            rects_[i].top += amount;
+    bool region::add_region(const region &rg) {
+        if (rg.empty()) {
+            return false;
+        }
+
+        std::vector<eka2l1::rect> result;
+        do_region_op(rects_, rg.rects_, REGION_OP_UNION, result);
+
+        if (result == rects_) {
+            return false;
         }
+
+        rects_ = std::move(result);
+        bounding_ = calculate_bounding_rect(rects_);
+
+        return true;
     }
 
-    void region::clip(const eka2l1::rect &bounding) {
-        eka2l1::vec2 top_left = bounding.top;
-        eka2l1::vec2 bottom_right = bounding.bottom_right();
+    void region::add_rects(const eka2l1::rect *rects, const std::size_t count) {
+        std::vector<region> pending;
+        pending.reserve(count);
 
-        for (std::size_t i = 0; i < rects_.size(); i++) {
-            if (rects_[i].top.x < top_left.x) {
-                rects_[i].top.x = top_left.x;
-            }
+        for (std::size_t i = 0; i < count; i++) {
+            if (is_rect_drawable(rects[i])) {
+                region single;
+                single.add_rect(rects[i]);
 
-            if (rects_[i].top.y < top_left.y) {
-                rects_[i].top.x = top_left.x;
+                pending.push_back(std::move(single));
             }
+        }
 
-            if (rects_[i].bottom_right().x > bottom_right.x) {
-                rects_[i].size.x = bottom_right.x - rects_[i].top.x;
-            }
-            
-            if (rects_[i].bottom_right().y > bottom_right.y) {
-                rects_[i].size.y = bottom_right.y - rects_[i].top.y;
+        if (pending.empty()) {
+            return;
+        }
+
+        // Merge in pairs, so that each rectangle goes through log(n) unions instead of n
+        while (pending.size() > 1) {
+            std::vector<region> merged;
+            merged.reserve((pending.size() + 1) / 2);
+
+            for (std::size_t i = 0; i < pending.size(); i += 2) {
+                if (i + 1 < pending.size()) {
+                    apply_region_op(pending[i], pending[i + 1].rects_, REGION_OP_UNION);
+                }
+
+                merged.push_back(std::move(pending[i]));
             }
+
+            pending = std::move(merged);
+        }
+
+        add_region(pending[0]);
+    }
+
+    void region::eliminate(const eka2l1::rect &rect) {
+        if (!is_rect_drawable(rect) || rects_.empty() || rect.intersect(bounding_).empty()) {
+            return;
+        }
+
+        apply_region_op(*this, { rect }, REGION_OP_SUBTRACT);
+    }
+
+    void region::eliminate(const region &reg) {
+        if (reg.empty() || rects_.empty() || reg.bounding_.intersect(bounding_).empty()) {
+            return;
         }
+
+        apply_region_op(*this, reg.rects_, REGION_OP_SUBTRACT);
+    }
+
+    region region::intersect(const region &target) const {
+        region intersection;
+
+        if (empty() || target.empty() || bounding_.intersect(target.bounding_).empty()) {
+            return intersection;
+        }
+
+        do_region_op(rects_, target.rects_, REGION_OP_INTERSECT, intersection.rects_);
+        intersection.bounding_ = calculate_bounding_rect(intersection.rects_);
+
+        return intersection;
+    }
+
+    bool region::identical(const region &rhs) const {
+        // The banded form of the same pixels is unique
+        return rects_ == rhs.rects_;
+    }
+
+    void region::advance(const eka2l1::vec2 &amount) {
+        for (std::size_t i = 0; i < rects_.size(); i++) {
+            rects_[i].top += amount;
+        }
+
+        if (!rects_.empty()) {
+            bounding_.top += amount;
+        }
+    }
+
+    void region::clip(const eka2l1::rect &bounding) {
+        if (rects_.empty() || bounding.contains(bounding_)) {
+            return;
+        }
+
+        if (!is_rect_drawable(bounding)) {
+            make_empty();
+            return;
+        }
+
+        apply_region_op(*this, { bounding }, REGION_OP_INTERSECT);
     }
 
     bool region::contains(const eka2l1::point &p) {
         for (std::size_t i = 0; i < rects_.size(); i++) {
+            if (rects_[i].top.y > p.y) {
+                // Sorted by top, nothing further can contain it
+                break;
+            }
+
             if (rects_[i].contains(p)) {
                 return true;
             }
@@ -223,4 +495,4 @@ namespace eka2l1::common {
 
         return false;
     }
-}
\ No newline at end of file
+}
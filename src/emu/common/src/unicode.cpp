@@ -22,10 +22,120 @@
  */
 
 #include <common/log.h>
+#include <common/platform.h>
 #include <common/unicode.h>
+
+#include <algorithm>
 #include <vector>
 
+#if EKA2L1_ARCH(X64)
+#include <emmintrin.h>
+#elif EKA2L1_ARCH(ARM64)
+#include <arm_neon.h>
+#endif
+
 namespace eka2l1::common {
+    std::size_t widen_byte_run(const std::uint8_t *source, const std::size_t count, std::uint8_t *dest,
+        const std::uint8_t low, const std::uint8_t high) {
+        std::size_t i = 0;
+
+#if EKA2L1_ARCH(X64)
+        const __m128i low_vec = _mm_set1_epi8(static_cast<char>(low));
+        const __m128i high_vec = _mm_set1_epi8(static_cast<char>(high));
+        const __m128i zero = _mm_setzero_si128();
+
+        for (; i + 16 <= count; i += 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+            const __m128i in_range = _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(v, low_vec), v),
+                _mm_cmpeq_epi8(_mm_min_epu8(v, high_vec), v));
+
+            if (_mm_movemask_epi8(in_range) != 0xFFFF) {
+                break;
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i * 2), _mm_unpacklo_epi8(v, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i * 2 + 16), _mm_unpackhi_epi8(v, zero));
+        }
+#elif EKA2L1_ARCH(ARM64)
+        const uint8x16_t low_vec = vdupq_n_u8(low);
+        const uint8x16_t high_vec = vdupq_n_u8(high);
+        const uint8x16_t zero = vdupq_n_u8(0);
+
+        for (; i + 16 <= count; i += 16) {
+            const uint8x16_t v = vld1q_u8(source + i);
+            const uint8x16_t in_range = vandq_u8(vcgeq_u8(v, low_vec), vcleq_u8(v, high_vec));
+
+            if (vminvq_u8(in_range) != 0xFF) {
+                break;
+            }
+
+            vst1q_u8(dest + i * 2, vzip1q_u8(v, zero));
+            vst1q_u8(dest + i * 2 + 16, vzip2q_u8(v, zero));
+        }
+#endif
+
+        for (; i < count; i++) {
+            if ((source[i] < low) || (source[i] > high)) {
+                break;
+            }
+
+            dest[i * 2] = source[i];
+            dest[i * 2 + 1] = 0;
+        }
+
+        return i;
+    }
+
+    std::size_t narrow_unit_run(const std::uint8_t *source, const std::size_t count, std::uint8_t *dest,
+        const std::uint16_t low, const std::uint16_t high) {
+        std::size_t i = 0;
+
+#if EKA2L1_ARCH(X64)
+        // SSE2 only compares signed 16-bit values, so bias both sides to compare them unsigned
+        const __m128i bias = _mm_set1_epi16(static_cast<short>(0x8000));
+        const __m128i low_vec = _mm_set1_epi16(static_cast<short>(low ^ 0x8000));
+        const __m128i high_vec = _mm_set1_epi16(static_cast<short>((high ^ 0x8000) + 1));
+
+        for (; i + 8 <= count; i += 8) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i * 2));
+            const __m128i biased = _mm_xor_si128(v, bias);
+            const __m128i in_range = _mm_andnot_si128(_mm_cmplt_epi16(biased, low_vec), _mm_cmplt_epi16(biased, high_vec));
+
+            if (_mm_movemask_epi8(in_range) != 0xFFFF) {
+                break;
+            }
+
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(dest + i), _mm_packus_epi16(v, v));
+        }
+#elif EKA2L1_ARCH(ARM64)
+        const uint16x8_t low_vec = vdupq_n_u16(low);
+        const uint16x8_t high_vec = vdupq_n_u16(high);
+
+        for (; i + 8 <= count; i += 8) {
+            const uint16x8_t v = vreinterpretq_u16_u8(vld1q_u8(source + i * 2));
+            const uint16x8_t in_range = vandq_u16(vcgeq_u16(v, low_vec), vcleq_u16(v, high_vec));
+
+            if (vminvq_u16(in_range) != 0xFFFF) {
+                break;
+            }
+
+            vst1_u8(dest + i, vmovn_u16(v));
+        }
+#endif
+
+        for (; i < count; i++) {
+            const std::uint16_t unit = static_cast<std::uint16_t>(source[i * 2] | (source[i * 2 + 1] << 8));
+
+            if ((unit < low) || (unit > high)) {
+                break;
+            }
+
+            dest[i] = static_cast<std::uint8_t>(unit);
+        }
+
+        return i;
+    }
+
     static std::uint32_t dyn_window_default[8] = {
         0x0080, // Latin-1 supplement
         0x00C0, // parts of Latin-1 supplement and Latin Extended-A
@@ -353,6 +463,28 @@ namespace eka2l1::common {
         unicode_mode = false;
 
         for (; this->dest_size > 0;) {
+            if (!unicode_mode && dest_buf && (this->source_size > 0)) {
+                // Printable ASCII stands for itself. While the default window is active, so does the
+                // rest of Latin-1, since a window byte then maps to the code point of the same value.
+                const std::uint8_t run_high = (active_window_base == 0x0080) ? 0xFF : 0x7F;
+                const std::uint8_t next = source_buf[source_pointer];
+
+                if ((next >= 0x20) && (next <= run_high)) {
+                    const std::size_t run_max = static_cast<std::size_t>(std::min(this->source_size, this->dest_size / 2));
+                    const int run = static_cast<int>(widen_byte_run(source_buf + source_pointer, run_max,
+                        dest_buf + dest_pointer, 0x20, run_high));
+
+                    source_pointer += run;
+                    this->source_size -= run;
+                    dest_pointer += run * 2;
+                    this->dest_size -= run * 2;
+
+                    if (this->dest_size <= 0) {
+                        break;
+                    }
+                }
+            }
+
             int last_source_size = this->source_size;
             std::uint8_t b = 0;
 
@@ -595,6 +727,28 @@ namespace eka2l1::common {
         static constexpr std::size_t ACTION_FLUSH_SIZE = 4;
 
         for (; this->dest_size > 0;) {
+            if (actions_.empty() && !unicode_mode && dest_buf && (this->source_size >= 2)) {
+                // Printable ASCII is written as it is. Runs are taken a whole flush group at a time, so the
+                // output stays the same as when the characters go through the actions.
+                const std::uint8_t *next = source_buf + source_pointer;
+
+                if ((next[1] == 0) && (next[0] >= 0x20) && (next[0] <= 0x7F)) {
+                    const std::size_t run_max = static_cast<std::size_t>(std::min(this->source_size / 2, this->dest_size));
+                    std::size_t run = narrow_unit_run(next, run_max, dest_buf + dest_pointer, 0x20, 0x7F);
+
+                    run -= run % ACTION_FLUSH_SIZE;
+
+                    source_pointer += static_cast<int>(run * 2);
+                    this->source_size -= static_cast<int>(run * 2);
+                    dest_pointer += static_cast<int>(run);
+                    this->dest_size -= static_cast<int>(run);
+
+                    if (this->dest_size <= 0) {
+                        break;
+                    }
+                }
+            }
+
             std::uint16_t uc = 0;
 
             if (!read_byte16(&uc)) {
@@ -93,6 +93,7 @@ namespace eka2l1::config {
         bool log_ipc{ false };
         bool log_passed{ false };
         bool log_exports{ false };
+        bool log_async{ false };
 
         std::string cpu_backend{ "dynarmic" };
         int device{ 0 };
@@ -111,6 +112,9 @@ namespace eka2l1::config {
         bool enable_srv_drm{ true };
 
         bool fbs_enable_compression_queue{ false };
+        std::uint32_t fbs_glyph_cache_size{ 8192 }; ///< In KB
+        bool fbs_glyph_prerasterize{ false };
+        std::uint32_t fbs_bitmap_cache_size{ 8192 }; ///< In KB
         bool enable_btrace{ false };
 
         bool stop_warn_touch_disabled{ false };
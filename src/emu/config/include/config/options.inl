@@ -49,6 +49,9 @@ OPTION(enable-srv-rights, enable_srv_rights, true)
 OPTION(enable-srv-sa, enable_srv_sa, true)
 OPTION(enable-srv-drm, enable_srv_drm, true)
 OPTION(fbs-enable-compression-queue, fbs_enable_compression_queue, false)
+OPTION(fbs-glyph-cache-size, fbs_glyph_cache_size, 8192)
+OPTION(fbs-glyph-prerasterize, fbs_glyph_prerasterize, false)
+OPTION(fbs-bitmap-cache-size, fbs_bitmap_cache_size, 8192)
 OPTION(enable-btrace, enable_btrace, false)
 OPTION(stop-warn-touchscreen-disabled, stop_warn_touch_disabled, false)
 OPTION(dump-imb-range-code, dump_imb_range_code, false)
@@ -76,6 +79,7 @@ OPTION(sf2-bank-path, sf2_bank_path, "resources/defaultbank.sf2")
 OPTION(bt-central-server-url, bt_central_server_url, "btnetplay.12z1.com")
 OPTION(enable-hw-gles1, enable_hw_gles1, true)
 OPTION(log-filter, log_filter, DEFAULT_LOG_FILTERING)
+OPTION(log-async, log_async, false)
 OPTION(hide-system-apps, hide_system_apps, true)
 OPTION(btnet-port-offset, btnet_port_offset, 15000)
 OPTION(btnet-password, btnet_password, "")
@@ -550,6 +550,13 @@ namespace eka2l1::dispatch {
         virtual egl_context_type context_type() const = 0;
         virtual void init_context_state() = 0;
         virtual void on_surface_changed(egl_surface *prev_read, egl_surface *prev_draw) {}
+
+        /**
+         * @brief Called after commands the context does not track were recorded into its command builder.
+         *
+         * Any driver state assumed by the context must be forgotten.
+         */
+        virtual void on_untracked_commands_recorded() {}
     };
 
     using egl_context_instance = std::unique_ptr<egl_context>;
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace eka2l1 {
+    namespace common {
+        class chunkyseri;
+    }
+}
+
+namespace eka2l1::dispatch {
+    struct gles_texture_env_info;
+
+    /**
+     * @brief Clear fragment states that do not affect the generated shader.
+     */
+    std::uint64_t gles1_cleanse_fragment_statuses(const std::uint64_t fragment_statuses);
+
+    /**
+     * @brief Get the key identifying the vertex shader generated for the given states.
+     *
+     * States that do not affect the generated source are cleared, so that they map to the same key.
+     */
+    std::uint64_t gles1_vertex_shader_key(const std::uint64_t vertex_statuses, const std::uint32_t active_texs);
+
+    /**
+     * @brief Get the key identifying the fragment shader generated for the given states.
+     *
+     * @param cleansed_fragment_statuses    Fragment statuses, cleansed with gles1_cleanse_fragment_statuses.
+     * @param active_texs                   Mask of the active texture units.
+     * @param tex_env_infos                 Environment info of all texture units. Only the active ones are hashed.
+     */
+    std::uint64_t gles1_fragment_shader_key(const std::uint64_t cleansed_fragment_statuses, const std::uint32_t active_texs,
+        const gles_texture_env_info *tex_env_infos);
+
+    /**
+     * @brief A vertex and fragment shader combination a program was linked from.
+     */
+    struct gles1_cached_program {
+        std::uint64_t vertex_key_ = 0;
+        std::uint64_t fragment_key_ = 0;
+        std::uint64_t vertex_statuses_ = 0;         ///< Vertex statuses the program was generated for.
+        std::uint64_t fragment_statuses_ = 0;       ///< Cleansed fragment statuses the program was generated for.
+        std::uint32_t active_texs_ = 0;
+    };
+
+    /**
+     * @brief Host-side cache of the shaders generated for GLES1 fixed-function states.
+     *
+     * Generated sources are stored together with their state keys, and the combinations that were linked
+     * into programs. On the next run, the programs can be compiled before the app starts drawing, instead of
+     * when each state combination first shows up.
+     *
+     * Sources depend on the backend they were generated for, so a cache written for another source flavour
+     * is discarded on load.
+     */
+    class gles1_shader_disk_cache {
+        std::unordered_map<std::uint64_t, std::string> vertex_sources_;
+        std::unordered_map<std::uint64_t, std::string> fragment_sources_;
+        std::vector<gles1_cached_program> programs_;
+
+        std::string path_;
+        std::uint32_t source_flavour_;
+        bool dirty_;
+
+        int do_state(common::chunkyseri &seri);
+
+    public:
+        /**
+         * @param path              Path to the cache file on the host.
+         * @param source_flavour    Identify the kind of sources the generator produces (the backend and its dialect).
+         */
+        explicit gles1_shader_disk_cache(const std::string &path, const std::uint32_t source_flavour);
+
+        /**
+         * @brief Load the cache from the host file.
+         *
+         * @returns True if the cache file exists and is compatible.
+         */
+        bool load();
+
+        /**
+         * @brief Write the cache to the host file, if there are any changes.
+         *
+         * @returns True on success, or if nothing needs to be written.
+         */
+        bool save();
+
+        const std::string *find_vertex_source(const std::uint64_t key) const;
+        const std::string *find_fragment_source(const std::uint64_t key) const;
+
+        void add_vertex_source(const std::uint64_t key, const std::string &source);
+        void add_fragment_source(const std::uint64_t key, const std::string &source);
+
+        /**
+         * @brief Record a linked shader combination. Recording the same combination twice does nothing.
+         */
+        void add_program(const gles1_cached_program &program);
+
+        const std::vector<gles1_cached_program> &programs() const {
+            return programs_;
+        }
+
+        const std::string &path() const {
+            return path_;
+        }
+    };
+}
@@ -20,12 +20,14 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <unordered_map>
 #include <string>
 
 #include <drivers/graphics/common.h>
 #include <drivers/graphics/graphics.h>
 #include <dispatch/libraries/gles1/consts.h>
+#include <dispatch/libraries/gles1/shadercache.h>
 
 namespace eka2l1::dispatch {
     struct gles_texture_env_info;
@@ -64,13 +66,34 @@ namespace eka2l1::dispatch {
 
     struct gles1_shaderman {
     protected:
-        std::unordered_map<std::uint64_t, drivers::handle> vertex_cache_;
-        std::unordered_map<std::uint64_t, drivers::handle> fragment_cache_;
-        std::unordered_map<std::uint64_t, std::unordered_map<std::uint64_t,
-            std::pair<drivers::handle, std::unique_ptr<gles1_shader_variables_info>>>> program_cache_;
+        // Modules and programs are shared by all contexts, while the disk cache is per app. Each of them remembers
+        // the generation of the disk cache it was last recorded to, so a hit after a switch still gets recorded.
+        struct cached_module {
+            drivers::handle handle_;
+            std::string source_;
+            std::uint32_t disk_generation_;
+        };
+
+        struct linked_program {
+            drivers::handle handle_;
+            std::unique_ptr<gles1_shader_variables_info> info_;
+            std::uint32_t disk_generation_;
+        };
+
+        std::unordered_map<std::uint64_t, cached_module> vertex_cache_;
+        std::unordered_map<std::uint64_t, cached_module> fragment_cache_;
+        std::unordered_map<std::uint64_t, std::unordered_map<std::uint64_t, linked_program>> program_cache_;
 
         drivers::graphics_driver *driver_;
-        void *fragment_status_hasher_;
+        std::unique_ptr<gles1_shader_disk_cache> disk_cache_;
+        std::uint32_t disk_generation_;
+
+        drivers::handle retrieve_vertex_module(const std::uint64_t vertex_key, const std::uint64_t vertex_statuses,
+            const std::uint32_t active_texs);
+        drivers::handle retrieve_fragment_module(const std::uint64_t fragment_key, const std::uint64_t cleansed_fragment_statuses,
+            const std::uint32_t active_texs, gles_texture_env_info *tex_env_infos);
+        linked_program *retrieve_linked_program(const drivers::handle vert_module, const drivers::handle fragment_module,
+            const std::uint64_t vertex_statuses, const std::uint64_t fragment_statuses, const std::uint32_t active_texs);
 
     public:
         explicit gles1_shaderman(drivers::graphics_driver *driver);
@@ -80,5 +103,30 @@ namespace eka2l1::dispatch {
 
         drivers::handle retrieve_program(const std::uint64_t vertex_statuses, const std::uint64_t fragment_statuses,
             const std::uint32_t active_texs, gles_texture_env_info *tex_env_infos, gles1_shader_variables_info *&info);
+
+        /**
+         * @brief Use a host file to keep the generated shaders between runs.
+         *
+         * The previous disk cache is saved first. Nothing is done if the path is already in use.
+         * A graphics driver must be set, since the cached sources depend on its backend.
+         *
+         * Shaders already generated for another app are kept, and are recorded to this cache once they are used.
+         *
+         * @param path      Path to the cache file on the host.
+         * @returns True if a compatible cache was loaded from the file, false if not or if the path is already in use.
+         */
+        bool load_disk_cache(const std::string &path);
+
+        /**
+         * @brief Write newly generated shaders to the disk cache file.
+         */
+        bool save_disk_cache();
+
+        /**
+         * @brief Compile and link every program recorded in the disk cache, before they are first drawn with.
+         *
+         * @returns Number of programs ready to be used.
+         */
+        std::size_t prewarm();
     };
 }
\ No newline at end of file
@@ -21,6 +21,7 @@
 
 #include <dispatch/libraries/egl/def.h>
 #include <dispatch/libraries/gles_shared/consts.h>
+#include <dispatch/libraries/gles_shared/shadow.h>
 #include <dispatch/def.h>
 
 #include <common/container.h>
@@ -32,6 +33,8 @@
 #include <optional>
 #include <stack>
 #include <tuple>
+#include <unordered_map>
+#include <vector>
 
 namespace eka2l1 {
     class system;
@@ -279,6 +282,59 @@ namespace eka2l1::dispatch {
         void flush(drivers::graphics_command_builder &builder);
     };
 
+    /**
+     * @brief Identify a client-side vertex array range uploaded through the vertex buffer pusher.
+     */
+    struct gles_client_upload_key {
+        std::uint32_t base_address_;
+        std::uint32_t stride_;
+        std::int32_t first_index_;
+        std::size_t size_;
+    };
+
+    inline bool operator==(const gles_client_upload_key &lhs, const gles_client_upload_key &rhs) {
+        return (lhs.base_address_ == rhs.base_address_) && (lhs.stride_ == rhs.stride_) && (lhs.first_index_ == rhs.first_index_)
+            && (lhs.size_ == rhs.size_);
+    }
+
+    struct gles_client_upload_key_hash {
+        std::size_t operator()(const gles_client_upload_key &key) const noexcept;
+    };
+
+    struct gles_client_upload_entry {
+        drivers::handle buffer_;
+        std::size_t offset_;
+        std::vector<std::uint8_t> snapshot_;        ///< Copy of the guest data at upload time, to detect modifications.
+    };
+
+    /**
+     * @brief Remember client-side vertex arrays already uploaded in the current frame.
+     *
+     * Games commonly issue many small draws from the same static array. If the guest address, stride and
+     * referenced range match a previous upload and the data is unchanged, the previous upload is reused.
+     *
+     * Pushed buffers are not overwritten until the frame ends, so the cache must be cleared at the same time.
+     */
+    class gles_client_upload_cache {
+        std::unordered_map<gles_client_upload_key, gles_client_upload_entry, gles_client_upload_key_hash> entries_;
+
+    public:
+        /**
+         * @brief Find a previous upload of the given data.
+         *
+         * @param key           Range of the upload.
+         * @param data          Current guest data of the range. Size is taken from the key.
+         * @param buffer        On success, the driver buffer holding the data.
+         * @param offset        On success, the offset of the data in the buffer.
+         *
+         * @returns True if the data was uploaded before and has not changed since.
+         */
+        bool find(const gles_client_upload_key &key, const std::uint8_t *data, drivers::handle &buffer, std::size_t &offset) const;
+
+        void add(const gles_client_upload_key &key, const std::uint8_t *data, const drivers::handle buffer, const std::size_t offset);
+        void clear();
+    };
+
     using gles_driver_object_instance = std::unique_ptr<gles_driver_object>;
 
     enum gles_get_data_type {
@@ -393,8 +449,12 @@ namespace eka2l1::dispatch {
         // Vertex and index buffers
         gles_buffer_pusher vertex_buffer_pusher_;
         gles_buffer_pusher index_buffer_pusher_;
+        gles_client_upload_cache client_upload_cache_;
         bool attrib_changed_;
 
+        // Driver state already recorded in the command list
+        gles_state_shadow state_shadow_;
+
         float blend_colour_[4];
         common::roundabout texture_update_list_;
 
@@ -409,6 +469,7 @@ namespace eka2l1::dispatch {
         virtual void init_context_state() override;
         void return_handle_to_pool(const gles_object_type type, const drivers::handle h, const int subtype = 0);
         void on_surface_changed(egl_surface *prev_read, egl_surface *prev_draw) override;
+        void on_untracked_commands_recorded() override;
         void flush_state_changes();
         
         virtual void flush_to_driver(drivers::graphics_driver *driver, const bool is_frame_swap_flush = false) override;
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <drivers/graphics/common.h>
+#include <drivers/itc.h>
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace eka2l1::dispatch {
+    struct gles_state_shadow_stats {
+        std::uint64_t emitted_ = 0;                 ///< State commands that were written to the command list.
+        std::uint64_t elided_states_ = 0;           ///< Fixed function state (blend, depth, stencil...) matching the driver state.
+        std::uint64_t elided_features_ = 0;         ///< Enable/disable of a feature already in that state.
+        std::uint64_t elided_texture_binds_ = 0;
+        std::uint64_t elided_program_binds_ = 0;
+        std::uint64_t elided_uniforms_ = 0;
+
+        std::uint64_t total_elided() const {
+            return elided_states_ + elided_features_ + elided_texture_binds_ + elided_program_binds_ + elided_uniforms_;
+        }
+
+        gles_state_shadow_stats &operator+=(const gles_state_shadow_stats &rhs);
+    };
+
+    /**
+     * @brief Shadow of the driver state recorded in a command list, to drop state changes that do nothing.
+     *
+     * Guest code usually sets the same blend function, enables, textures and matrices again before every draw.
+     * State commands are only written to the command builder if they differ from what was last written.
+     *
+     * The driver state is shared with other command lists (window composition, other contexts) that run between
+     * this context's lists, so the shadow must be invalidated whenever a new command list begins. It must also be
+     * invalidated after recording commands that change the driver state behind the shadow's back.
+     *
+     * Viewport and scissor are not shadowed, since they are resolved against the framebuffer bound at execution time.
+     */
+    class gles_state_shadow {
+    public:
+        enum fixed_state_slot {
+            FIXED_STATE_CULL_FACE,
+            FIXED_STATE_FRONT_FACE_RULE,
+            FIXED_STATE_COLOR_MASK,
+            FIXED_STATE_DEPTH_BIAS,
+            FIXED_STATE_STENCIL_MASK_FRONT,
+            FIXED_STATE_STENCIL_MASK_BACK,
+            FIXED_STATE_BLEND_FORMULA,
+            FIXED_STATE_LINE_WIDTH,
+            FIXED_STATE_DEPTH_MASK,
+            FIXED_STATE_DEPTH_PASS_COND,
+            FIXED_STATE_DEPTH_RANGE,
+            FIXED_STATE_STENCIL_FUNC_FRONT,
+            FIXED_STATE_STENCIL_FUNC_BACK,
+            FIXED_STATE_STENCIL_OP_FRONT,
+            FIXED_STATE_STENCIL_OP_BACK,
+            FIXED_STATE_BLEND_COLOUR,
+            FIXED_STATE_COUNT
+        };
+
+        static constexpr std::size_t MAX_FEATURE_COUNT = 16;
+        static constexpr std::size_t MAX_TEXTURE_UNIT_COUNT = 16;
+
+        static constexpr std::size_t MAX_FIXED_STATE_SIZE = 32;
+        static constexpr std::uint32_t STATS_REPORT_FRAME_COUNT = 600;
+
+        struct fixed_state_value {
+            bool valid_ = false;
+            std::uint8_t data_[MAX_FIXED_STATE_SIZE];
+        };
+
+    private:
+        drivers::graphics_command_builder &builder_;
+
+        std::array<fixed_state_value, FIXED_STATE_COUNT> fixed_states_;
+
+        // 0 = unknown, 1 = disabled, 2 = enabled
+        std::array<std::uint8_t, MAX_FEATURE_COUNT> features_;
+        std::array<drivers::handle, MAX_TEXTURE_UNIT_COUNT> textures_;
+
+        drivers::handle program_;
+        bool program_valid_;
+
+        // Uniform values are kept by the driver per program
+        std::unordered_map<drivers::handle, std::unordered_map<int, std::vector<std::uint8_t>>> uniforms_;
+
+        gles_state_shadow_stats stats_;
+        gles_state_shadow_stats last_frame_stats_;
+
+        // Accumulated over several frames, then logged
+        gles_state_shadow_stats report_stats_;
+        std::uint32_t report_frame_count_;
+
+        bool should_emit_fixed(const fixed_state_slot slot, const void *value, const std::size_t size);
+        bool should_emit_per_face(const drivers::rendering_face face, const fixed_state_slot front_slot,
+            const fixed_state_slot back_slot, const void *value, const std::size_t size);
+
+    public:
+        explicit gles_state_shadow(drivers::graphics_command_builder &builder);
+
+        /**
+         * @brief Forget everything known about the driver state. The next state change of each kind is always emitted.
+         */
+        void invalidate();
+
+        /**
+         * @brief Forget the bound program and textures, for example after recording a bitmap draw.
+         */
+        void invalidate_bindings();
+
+        /**
+         * @brief End the current frame, making its statistics available through last_frame_stats().
+         *
+         * Every STATS_REPORT_FRAME_COUNT frames, the statistics of those frames are also logged as trace.
+         */
+        void done_frame();
+
+        const gles_state_shadow_stats &stats() const {
+            return stats_;
+        }
+
+        const gles_state_shadow_stats &last_frame_stats() const {
+            return last_frame_stats_;
+        }
+
+        void set_feature(const drivers::graphics_feature feature, const bool enabled);
+        void set_cull_face(const drivers::rendering_face face);
+        void set_front_face_rule(const drivers::rendering_face_determine_rule rule);
+        void set_color_mask(const std::uint8_t mask);
+        void set_depth_bias(const float constant_factor, const float clamp, const float slope_factor);
+        void set_stencil_mask(const drivers::rendering_face face, const std::uint32_t mask);
+        void blend_formula(const drivers::blend_equation rgb_equation, const drivers::blend_equation a_equation,
+            const drivers::blend_factor rgb_frag_output_factor, const drivers::blend_factor rgb_current_factor,
+            const drivers::blend_factor a_frag_output_factor, const drivers::blend_factor a_current_factor);
+        void set_line_width(const float width);
+        void set_depth_mask(const std::uint32_t mask);
+        void set_depth_pass_condition(const drivers::condition_func func);
+        void set_depth_range(const float min, const float max);
+        void set_stencil_pass_condition(const drivers::rendering_face face, const drivers::condition_func cond_func,
+            const int cond_func_ref_value, const std::uint32_t mask);
+        void set_stencil_action(const drivers::rendering_face face, const drivers::stencil_action on_stencil_fail,
+            const drivers::stencil_action on_stencil_pass_depth_fail, const drivers::stencil_action on_both_stencil_depth_pass);
+        void set_blend_colour(const float colour[4]);
+
+        void bind_texture(const drivers::handle h, const int binding);
+        void use_program(const drivers::handle h);
+
+        /**
+         * @brief Set a uniform of the program currently in use.
+         *
+         * Must be called after use_program. If the program is not known, the uniform is always emitted.
+         */
+        void set_dynamic_uniform(const int binding, const drivers::shader_var_type var_type, const void *data,
+            const std::size_t data_size);
+    };
+}
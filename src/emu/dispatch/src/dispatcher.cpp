@@ -107,6 +107,7 @@ namespace eka2l1::dispatch {
     }
 
     void dispatcher::shutdown(drivers::graphics_driver *driver) {
+        egl_controller_.get_es1_shaderman().save_disk_cache();
         post_transferer_.destroy(driver);
     }
 
@@ -83,6 +83,7 @@ namespace eka2l1::dispatch {
             context->cmd_builder_.draw_bitmap(handle_, 0, eka2l1::rect(eka2l1::vec2(0, 0), new_scaled_size),
                 eka2l1::rect(eka2l1::vec2(0, 0), eka2l1::vec2(0, 0)));
             context->cmd_builder_.destroy_bitmap(handle_);
+            context->on_untracked_commands_recorded();
 
             handle_ = new_surface;
             current_scale_ = backed_screen_->display_scale_factor;
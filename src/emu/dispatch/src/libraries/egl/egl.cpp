@@ -384,10 +384,23 @@ namespace eka2l1::dispatch {
             }
         }
 
+        dispatcher *dp = sys->get_dispatcher();
+        dispatch::egl_controller &controller = dp->get_egl_controller();
+
         switch (version) {
-        case egl_config::EGL_TARGET_CONTEXT_ES11:
+        case egl_config::EGL_TARGET_CONTEXT_ES11: {
             context_inst = std::make_unique<egl_context_es1>();
+
+            // Compile the shaders this app used in previous runs, before it starts drawing
+            kernel::process *crr_pr = sys->get_kernel_system()->crr_process();
+            gles1_shaderman &shaderman = controller.get_es1_shaderman();
+
+            if (crr_pr && shaderman.load_disk_cache(fmt::format("cache/gles1/{:08X}.bin", crr_pr->get_uid()))) {
+                shaderman.prewarm();
+            }
+
             break;
+        }
 
         case egl_config::EGL_TARGET_CONTEXT_ES2:
             context_inst = std::make_unique<egl_context_es2>();
@@ -400,9 +413,6 @@ namespace eka2l1::dispatch {
             return EGL_NO_CONTEXT_EMU;
         }
 
-        dispatcher *dp = sys->get_dispatcher();
-        dispatch::egl_controller &controller = dp->get_egl_controller();
-
         egl_context_handle hh = controller.add_context(context_inst);
         if (!hh) {
             LOG_ERROR(HLE_DISPATCHER, "Fail to add GLES context to management!");
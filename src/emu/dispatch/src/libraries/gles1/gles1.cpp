@@ -2568,7 +2568,7 @@ namespace eka2l1::dispatch {
             return false;
         }
 
-        cmd_builder_.use_program(program);
+        state_shadow_.use_program(program);
 
         if (var_info) {
             // Not binded by uniform buffer/constant buffer
@@ -2577,23 +2577,23 @@ namespace eka2l1::dispatch {
                 for (std::size_t i = 0; i < GLES1_EMU_MAX_PALETTE_MATRICES; i++) {
                     memcpy(palette_mats_data.data() + i * 64, glm::value_ptr(palette_mats_[i]), 64);
                 }
-                cmd_builder_.set_dynamic_uniform(var_info->palette_mat_loc_, drivers::shader_var_type::mat4,
+                state_shadow_.set_dynamic_uniform(var_info->palette_mat_loc_, drivers::shader_var_type::mat4,
                     palette_mats_data.data(), palette_mats_data.size());
             } else {
-                cmd_builder_.set_dynamic_uniform(var_info->view_model_mat_loc_, drivers::shader_var_type::mat4,
+                state_shadow_.set_dynamic_uniform(var_info->view_model_mat_loc_, drivers::shader_var_type::mat4,
                     glm::value_ptr(model_view_mat_stack_.top()), 64);
             }
 
-            cmd_builder_.set_dynamic_uniform(var_info->proj_mat_loc_, drivers::shader_var_type::mat4,
+            state_shadow_.set_dynamic_uniform(var_info->proj_mat_loc_, drivers::shader_var_type::mat4,
                 glm::value_ptr(proj_mat_stack_.top()), 64);
 
             if ((vertex_statuses_ & egl_context_es1::VERTEX_STATE_CLIENT_COLOR_ARRAY) == 0) {
-                cmd_builder_.set_dynamic_uniform(var_info->color_loc_, drivers::shader_var_type::vec4,
+                state_shadow_.set_dynamic_uniform(var_info->color_loc_, drivers::shader_var_type::vec4,
                     color_uniforms_, 16);
             }
 
             if ((vertex_statuses_ & egl_context_es1::VERTEX_STATE_CLIENT_NORMAL_ARRAY) == 0) {
-                cmd_builder_.set_dynamic_uniform(var_info->normal_loc_, drivers::shader_var_type::vec3,
+                state_shadow_.set_dynamic_uniform(var_info->normal_loc_, drivers::shader_var_type::vec3,
                     normal_uniforms_, 12);
             }
 
@@ -2602,61 +2602,61 @@ namespace eka2l1::dispatch {
             for (std::uint32_t i = 0; i < GLES1_EMU_MAX_TEXTURE_COUNT; i++, coordarray_mask <<= 1) {
                 if (active_texs & (0b11 << (i * 2))) {
                     if ((vertex_statuses_ & coordarray_mask) == 0)
-                        cmd_builder_.set_dynamic_uniform(var_info->texcoord_loc_[i], drivers::shader_var_type::vec4,
+                        state_shadow_.set_dynamic_uniform(var_info->texcoord_loc_[i], drivers::shader_var_type::vec4,
                             texture_units_[i].coord_uniforms_, 16);
 
-                    cmd_builder_.set_dynamic_uniform(var_info->texture_mat_loc_[i], drivers::shader_var_type::mat4,
+                    state_shadow_.set_dynamic_uniform(var_info->texture_mat_loc_[i], drivers::shader_var_type::mat4,
                         glm::value_ptr(texture_units_[i].texture_mat_stack_.top()), 64);
 
                     cmd_builder_.set_texture_for_shader(i, var_info->texview_loc_[i], drivers::shader_module_type::fragment);
-                    cmd_builder_.set_dynamic_uniform(var_info->texenv_color_loc_[i], drivers::shader_var_type::vec4,
+                    state_shadow_.set_dynamic_uniform(var_info->texenv_color_loc_[i], drivers::shader_var_type::vec4,
                         texture_units_[i].env_colors_, 16);
                 }
             }
             
             for (std::uint8_t i = 0; i < GLES1_EMU_MAX_CLIP_PLANE; i++) {
                 if (fragment_statuses_ & (1 << (egl_context_es1::FRAGMENT_STATE_CLIP_PLANE_BIT_POS + i))) {
-                    cmd_builder_.set_dynamic_uniform(var_info->clip_plane_loc_[i], drivers::shader_var_type::vec4,
+                    state_shadow_.set_dynamic_uniform(var_info->clip_plane_loc_[i], drivers::shader_var_type::vec4,
                         clip_planes_transformed_[i], 16);
                 }
             }
 
-            cmd_builder_.set_dynamic_uniform(var_info->material_ambient_loc_, drivers::shader_var_type::vec4,
+            state_shadow_.set_dynamic_uniform(var_info->material_ambient_loc_, drivers::shader_var_type::vec4,
                 material_ambient_, 16);
 
-            cmd_builder_.set_dynamic_uniform(var_info->material_diffuse_loc_, drivers::shader_var_type::vec4,
+            state_shadow_.set_dynamic_uniform(var_info->material_diffuse_loc_, drivers::shader_var_type::vec4,
                 material_diffuse_, 16);
             
-            cmd_builder_.set_dynamic_uniform(var_info->material_specular_loc_, drivers::shader_var_type::vec4,
+            state_shadow_.set_dynamic_uniform(var_info->material_specular_loc_, drivers::shader_var_type::vec4,
                 material_specular_, 16);
 
-            cmd_builder_.set_dynamic_uniform(var_info->material_emission_loc_, drivers::shader_var_type::vec4,
+            state_shadow_.set_dynamic_uniform(var_info->material_emission_loc_, drivers::shader_var_type::vec4,
                 material_emission_, 16);
 
-            cmd_builder_.set_dynamic_uniform(var_info->material_shininess_loc_, drivers::shader_var_type::real,
+            state_shadow_.set_dynamic_uniform(var_info->material_shininess_loc_, drivers::shader_var_type::real,
                 &material_shininess_, 4);
 
-            cmd_builder_.set_dynamic_uniform(var_info->global_ambient_loc_, drivers::shader_var_type::vec4,
+            state_shadow_.set_dynamic_uniform(var_info->global_ambient_loc_, drivers::shader_var_type::vec4,
                 global_ambient_, 16);
 
             if (fragment_statuses_ & egl_context_es1::FRAGMENT_STATE_ALPHA_TEST) {
-                cmd_builder_.set_dynamic_uniform(var_info->alpha_test_ref_loc_, drivers::shader_var_type::real,
+                state_shadow_.set_dynamic_uniform(var_info->alpha_test_ref_loc_, drivers::shader_var_type::real,
                     &alpha_test_ref_, 4);
             }
 
             if (fragment_statuses_ & egl_context_es1::FRAGMENT_STATE_FOG_ENABLE) {
-                cmd_builder_.set_dynamic_uniform(var_info->fog_color_loc_, drivers::shader_var_type::vec4,
+                state_shadow_.set_dynamic_uniform(var_info->fog_color_loc_, drivers::shader_var_type::vec4,
                     fog_color_, 16);
 
                 std::uint64_t fog_mode = (fragment_statuses_ & egl_context_es1::FRAGMENT_STATE_FOG_MODE_MASK);
 
                 if (fog_mode == egl_context_es1::FRAGMENT_STATE_FOG_MODE_LINEAR) {
-                    cmd_builder_.set_dynamic_uniform(var_info->fog_start_loc_, drivers::shader_var_type::real,
+                    state_shadow_.set_dynamic_uniform(var_info->fog_start_loc_, drivers::shader_var_type::real,
                         &fog_start_, 4);
-                    cmd_builder_.set_dynamic_uniform(var_info->fog_end_loc_, drivers::shader_var_type::real,
+                    state_shadow_.set_dynamic_uniform(var_info->fog_end_loc_, drivers::shader_var_type::real,
                         &fog_end_, 4);
                 } else {
-                    cmd_builder_.set_dynamic_uniform(var_info->fog_density_loc_, drivers::shader_var_type::real,
+                    state_shadow_.set_dynamic_uniform(var_info->fog_density_loc_, drivers::shader_var_type::real,
                         &fog_density_, 4);
                 }
             }
@@ -2664,21 +2664,21 @@ namespace eka2l1::dispatch {
             if (vertex_statuses_ & egl_context_es1::VERTEX_STATE_LIGHTING_ENABLE) {
                 for (std::uint32_t i = 0, mask = egl_context_es1::VERTEX_STATE_LIGHT0_ON; i < GLES1_EMU_MAX_LIGHT; i++, mask <<= 1) {
                     if (vertex_statuses_ & mask) {
-                        cmd_builder_.set_dynamic_uniform(var_info->light_dir_or_pos_loc_[i], drivers::shader_var_type::vec4,
+                        state_shadow_.set_dynamic_uniform(var_info->light_dir_or_pos_loc_[i], drivers::shader_var_type::vec4,
                             lights_[i].position_or_dir_transformed_, 16);
-                        cmd_builder_.set_dynamic_uniform(var_info->light_ambient_loc_[i], drivers::shader_var_type::vec4,
+                        state_shadow_.set_dynamic_uniform(var_info->light_ambient_loc_[i], drivers::shader_var_type::vec4,
                             lights_[i].ambient_, 16);
-                        cmd_builder_.set_dynamic_uniform(var_info->light_diffuse_loc_[i], drivers::shader_var_type::vec4,
+                        state_shadow_.set_dynamic_uniform(var_info->light_diffuse_loc_[i], drivers::shader_var_type::vec4,
                             lights_[i].diffuse_, 16);
-                        cmd_builder_.set_dynamic_uniform(var_info->light_specular_loc_[i], drivers::shader_var_type::vec4,
+                        state_shadow_.set_dynamic_uniform(var_info->light_specular_loc_[i], drivers::shader_var_type::vec4,
                             lights_[i].specular_, 16);
-                        cmd_builder_.set_dynamic_uniform(var_info->light_spot_dir_loc_[i], drivers::shader_var_type::vec3,
+                        state_shadow_.set_dynamic_uniform(var_info->light_spot_dir_loc_[i], drivers::shader_var_type::vec3,
                             lights_[i].spot_dir_transformed_, 12);
-                        cmd_builder_.set_dynamic_uniform(var_info->light_spot_cutoff_loc_[i], drivers::shader_var_type::real,
+                        state_shadow_.set_dynamic_uniform(var_info->light_spot_cutoff_loc_[i], drivers::shader_var_type::real,
                             &lights_[i].spot_cutoff_, 4);
-                        cmd_builder_.set_dynamic_uniform(var_info->light_spot_exponent_loc_[i], drivers::shader_var_type::real,
+                        state_shadow_.set_dynamic_uniform(var_info->light_spot_exponent_loc_[i], drivers::shader_var_type::real,
                             &lights_[i].spot_exponent_, 4);
-                        cmd_builder_.set_dynamic_uniform(var_info->light_attenuatation_vec_loc_[i], drivers::shader_var_type::vec3,
+                        state_shadow_.set_dynamic_uniform(var_info->light_attenuatation_vec_loc_[i], drivers::shader_var_type::vec3,
                             lights_[i].attenuatation_, 12);
                     }
                 }
@@ -2875,7 +2875,7 @@ namespace eka2l1::dispatch {
                 auto *obj = objects_.get(texture_units_[i].binded_texture_handle_);
 
                 if (obj)
-                    cmd_builder_.bind_texture((*obj)->handle_value(), i);
+                    state_shadow_.bind_texture((*obj)->handle_value(), i);
             }
         }
 
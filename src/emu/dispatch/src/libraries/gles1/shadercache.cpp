@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <dispatch/libraries/gles1/def.h>
+#include <dispatch/libraries/gles1/shadercache.h>
+
+#include <common/buffer.h>
+#include <common/chunkyseri.h>
+#include <common/fileutils.h>
+#include <common/log.h>
+#include <common/path.h>
+
+#include <algorithm>
+
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
+namespace eka2l1::dispatch {
+    static constexpr std::uint32_t GLES1_SHADER_CACHE_MAGIC = 0x43533147; // G1SC
+
+    // Bump this when the shader generator changes, so that stale sources are not used
+    static constexpr std::uint32_t GLES1_SHADER_CACHE_VERSION = 2;
+
+    std::uint64_t gles1_cleanse_fragment_statuses(const std::uint64_t fragment_statuses) {
+        std::uint64_t cleansed_fragment_statuses = fragment_statuses;
+        if ((fragment_statuses & egl_context_es1::FRAGMENT_STATE_ALPHA_TEST) == 0) {
+            cleansed_fragment_statuses &= ~egl_context_es1::FRAGMENT_STATE_ALPHA_FUNC_MASK;
+        }
+
+        if ((fragment_statuses & egl_context_es1::FRAGMENT_STATE_FOG_ENABLE) == 0) {
+            cleansed_fragment_statuses &= ~egl_context_es1::FRAGMENT_STATE_FOG_MODE_MASK;
+        }
+
+        return cleansed_fragment_statuses;
+    }
+
+    std::uint64_t gles1_vertex_shader_key(const std::uint64_t vertex_statuses, const std::uint32_t active_texs) {
+        std::uint64_t vertex_hash = vertex_statuses | (static_cast<std::uint64_t>(active_texs) << egl_context_es1::VERTEX_STATE_REVERSED_BITS_POS);
+
+        // These are only used for state tracking really!
+        vertex_hash &= ~(egl_context_es1::VERTEX_STATE_CLIENT_WEIGHT_ARRAY | egl_context_es1::VERTEX_STATE_CLIENT_MATRIX_INDEX_ARRAY);
+
+        if ((vertex_hash & egl_context_es1::VERTEX_STATE_SKINNING_ENABLE) == 0) {
+            vertex_hash &= ~egl_context_es1::VERTEX_STATE_SKIN_WEIGHTS_PER_VERTEX_MASK;
+        }
+
+        if ((vertex_hash & egl_context_es1::VERTEX_STATE_LIGHTING_ENABLE) == 0) {
+            vertex_hash &= ~egl_context_es1::VERTEX_STATE_LIGHT_RELATED_MASK;
+        }
+
+        if (active_texs != 0) {
+            // Clean texcoord bits of unused textures...
+            for (std::uint8_t i = 0; i < GLES1_EMU_MAX_TEXTURE_COUNT; i++) {
+                if ((active_texs & (0b11 << (i * 2))) == 0) {
+                    vertex_hash &= ~(1 << (egl_context_es1::VERTEX_STATE_CLIENT_TEXCOORD_ARRAY_POS + i));
+                }
+            }
+        }
+
+        return vertex_hash;
+    }
+
+    // Only the named fields, the bytes of the bitfield struct also hold unused bits that may never be written
+    static std::uint64_t pack_texture_env_info(const gles_texture_env_info &info) {
+        std::uint64_t packed = 0;
+        int shift = 0;
+
+        auto pack = [&](const std::uint64_t value, const int bit_count) {
+            packed |= (value << shift);
+            shift += bit_count;
+        };
+
+        pack(info.env_mode_, 3);
+        pack(info.src0_rgb_, 3);
+        pack(info.src1_rgb_, 3);
+        pack(info.src2_rgb_, 3);
+        pack(info.src0_a_, 3);
+        pack(info.src1_a_, 3);
+        pack(info.src2_a_, 3);
+        pack(info.src0_rgb_op_, 2);
+        pack(info.src1_rgb_op_, 2);
+        pack(info.src2_rgb_op_, 2);
+        pack(info.src0_a_op_, 2);
+        pack(info.src1_a_op_, 2);
+        pack(info.src2_a_op_, 2);
+        pack(info.combine_rgb_func_, 3);
+        pack(info.combine_a_func_, 3);
+
+        return packed;
+    }
+
+    std::uint64_t gles1_fragment_shader_key(const std::uint64_t cleansed_fragment_statuses, const std::uint32_t active_texs,
+        const gles_texture_env_info *tex_env_infos) {
+        XXH64_state_t hasher;
+
+        // Doodle GLES1 (the seed I try to write 0_0)
+        XXH64_reset(&hasher, 0xD00D1E61E51ULL);
+        XXH64_update(&hasher, &cleansed_fragment_statuses, sizeof(std::uint64_t));
+        XXH64_update(&hasher, &active_texs, sizeof(std::uint32_t));
+
+        if (active_texs != 0) {
+            for (std::size_t i = 0; i < GLES1_EMU_MAX_TEXTURE_COUNT; i++) {
+                if (active_texs & (0b11 << (i * 2))) {
+                    const std::uint64_t packed_env_info = pack_texture_env_info(tex_env_infos[i]);
+                    XXH64_update(&hasher, &packed_env_info, sizeof(std::uint64_t));
+                }
+            }
+        }
+
+        return XXH64_digest(&hasher);
+    }
+
+    gles1_shader_disk_cache::gles1_shader_disk_cache(const std::string &path, const std::uint32_t source_flavour)
+        : path_(path)
+        , source_flavour_(source_flavour)
+        , dirty_(false) {
+    }
+
+    static void do_state_for_sources(common::chunkyseri &seri, std::unordered_map<std::uint64_t, std::string> &sources) {
+        std::uint32_t source_count = static_cast<std::uint32_t>(sources.size());
+        seri.absorb(source_count);
+
+        if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+            for (std::uint32_t i = 0; i < source_count; i++) {
+                std::uint64_t key = 0;
+                std::string source;
+
+                seri.absorb(key);
+                seri.absorb(source);
+
+                sources.emplace(key, std::move(source));
+            }
+        } else {
+            for (auto &[key, source] : sources) {
+                std::uint64_t key_copy = key;
+
+                seri.absorb(key_copy);
+                seri.absorb(source);
+            }
+        }
+    }
+
+    int gles1_shader_disk_cache::do_state(common::chunkyseri &seri) {
+        std::uint32_t magic = GLES1_SHADER_CACHE_MAGIC;
+        std::uint32_t version = GLES1_SHADER_CACHE_VERSION;
+        std::uint32_t source_flavour = source_flavour_;
+
+        seri.absorb(magic);
+        seri.absorb(version);
+        seri.absorb(source_flavour);
+
+        if ((magic != GLES1_SHADER_CACHE_MAGIC) || (version != GLES1_SHADER_CACHE_VERSION)) {
+            return -1;
+        }
+
+        if (source_flavour != source_flavour_) {
+            return -2;
+        }
+
+        do_state_for_sources(seri, vertex_sources_);
+        do_state_for_sources(seri, fragment_sources_);
+
+        seri.absorb_container(programs_, [](common::chunkyseri &seri, gles1_cached_program &program) {
+            seri.absorb(program.vertex_key_);
+            seri.absorb(program.fragment_key_);
+            seri.absorb(program.vertex_statuses_);
+            seri.absorb(program.fragment_statuses_);
+            seri.absorb(program.active_texs_);
+        });
+
+        return 0;
+    }
+
+    bool gles1_shader_disk_cache::load() {
+        common::ro_std_file_stream stream(path_, true);
+        if (!stream.valid()) {
+            return false;
+        }
+
+        std::vector<std::uint8_t> buf(stream.size());
+        if (buf.empty() || (stream.read(buf.data(), buf.size()) != buf.size())) {
+            return false;
+        }
+
+        common::chunkyseri seri(buf.data(), buf.size(), common::SERI_MODE_READ);
+        if (do_state(seri) != 0) {
+            LOG_INFO(HLE_DISPATCHER, "GLES1 shader cache {} is outdated, rebuilding", path_);
+
+            vertex_sources_.clear();
+            fragment_sources_.clear();
+            programs_.clear();
+
+            return false;
+        }
+
+        dirty_ = false;
+        return true;
+    }
+
+    bool gles1_shader_disk_cache::save() {
+        if (!dirty_) {
+            return true;
+        }
+
+        std::vector<std::uint8_t> buf;
+
+        {
+            common::chunkyseri seri(nullptr, 0, common::SERI_MODE_MEASURE);
+            do_state(seri);
+
+            buf.resize(seri.size());
+        }
+
+        common::chunkyseri seri(buf.data(), buf.size(), common::SERI_MODE_WRITE);
+        do_state(seri);
+
+        const std::string cache_dir = eka2l1::file_directory(path_);
+        if (!cache_dir.empty()) {
+            common::create_directories(cache_dir);
+        }
+
+        common::wo_std_file_stream stream(path_, true);
+        if (!stream.valid() || (stream.write(buf.data(), buf.size()) != buf.size())) {
+            LOG_WARN(HLE_DISPATCHER, "Unable to write GLES1 shader cache to {}", path_);
+            return false;
+        }
+
+        dirty_ = false;
+        return true;
+    }
+
+    const std::string *gles1_shader_disk_cache::find_vertex_source(const std::uint64_t key) const {
+        auto ite = vertex_sources_.find(key);
+        if (ite == vertex_sources_.end()) {
+            return nullptr;
+        }
+
+        return &ite->second;
+    }
+
+    const std::string *gles1_shader_disk_cache::find_fragment_source(const std::uint64_t key) const {
+        auto ite = fragment_sources_.find(key);
+        if (ite == fragment_sources_.end()) {
+            return nullptr;
+        }
+
+        return &ite->second;
+    }
+
+    void gles1_shader_disk_cache::add_vertex_source(const std::uint64_t key, const std::string &source) {
+        if (vertex_sources_.emplace(key, source).second) {
+            dirty_ = true;
+        }
+    }
+
+    void gles1_shader_disk_cache::add_fragment_source(const std::uint64_t key, const std::string &source) {
+        if (fragment_sources_.emplace(key, source).second) {
+            dirty_ = true;
+        }
+    }
+
+    void gles1_shader_disk_cache::add_program(const gles1_cached_program &program) {
+        auto ite = std::find_if(programs_.begin(), programs_.end(), [&](const gles1_cached_program &existing) {
+            return (existing.vertex_key_ == program.vertex_key_) && (existing.fragment_key_ == program.fragment_key_);
+        });
+
+        if (ite != programs_.end()) {
+            return;
+        }
+
+        programs_.push_back(program);
+        dirty_ = true;
+    }
+}
@@ -22,13 +22,12 @@
 
 #include <dispatch/libraries/gles1/def.h>
 
-#define XXH_INLINE_ALL
-#include <xxhash.h>
+#include <common/log.h>
 
 namespace eka2l1::dispatch {
     gles1_shaderman::gles1_shaderman(drivers::graphics_driver *driver)
         : driver_(driver)
-        , fragment_status_hasher_(nullptr) {
+        , disk_generation_(0) {
 
     }
 
@@ -41,65 +40,108 @@ namespace eka2l1::dispatch {
             drivers::graphics_command_builder builder;
 
             for (auto &module: vertex_cache_) {
-                builder.destroy(module.second);
+                builder.destroy(module.second.handle_);
             }
 
             for (auto &module: fragment_cache_) {
-                builder.destroy(module.second);
+                builder.destroy(module.second.handle_);
             }
 
             for (auto &vert_index: program_cache_) {
                 for (auto &frag_index: vert_index.second)
-                    builder.destroy(frag_index.second.first);
+                    builder.destroy(frag_index.second.handle_);
             }
 
             drivers::command_list retrieved = builder.retrieve_command_list();
             driver_->submit_command_list(retrieved);
         }
+    }
 
-        if (fragment_status_hasher_) {
-            XXH64_freeState(reinterpret_cast<XXH64_state_t*>(fragment_status_hasher_));
+    bool gles1_shaderman::load_disk_cache(const std::string &path) {
+        if (disk_cache_ && (disk_cache_->path() == path)) {
+            return false;
         }
-    }
-    
-    drivers::handle gles1_shaderman::retrieve_program(const std::uint64_t vertex_statuses, const std::uint64_t fragment_statuses,
-        const std::uint32_t active_texs, gles_texture_env_info *tex_env_infos, gles1_shader_variables_info *&info) {
-        // Turn off states that are not used (for hashing)
-        std::uint64_t cleansed_fragment_statuses = fragment_statuses;
-        if ((fragment_statuses & egl_context_es1::FRAGMENT_STATE_ALPHA_TEST) == 0) {
-            cleansed_fragment_statuses &= ~egl_context_es1::FRAGMENT_STATE_ALPHA_FUNC_MASK;
+
+        if (!driver_) {
+            return false;
         }
 
-        if ((fragment_statuses & egl_context_es1::FRAGMENT_STATE_FOG_ENABLE) == 0) {
-            cleansed_fragment_statuses &= ~egl_context_es1::FRAGMENT_STATE_FOG_MODE_MASK;
+        save_disk_cache();
+
+        // Generated sources differ between backends and between desktop GL and GLES
+        const std::uint32_t source_flavour = (static_cast<std::uint32_t>(driver_->get_current_api()) << 1)
+            | (driver_->is_stricted() ? 1 : 0);
+
+        disk_cache_ = std::make_unique<gles1_shader_disk_cache>(path, source_flavour);
+        disk_generation_++;
+
+        return disk_cache_->load();
+    }
+
+    bool gles1_shaderman::save_disk_cache() {
+        if (!disk_cache_) {
+            return true;
         }
 
-        drivers::handle vert_module = 0;
-        std::uint64_t vertex_hash = vertex_statuses | (static_cast<std::uint64_t>(active_texs) << egl_context_es1::VERTEX_STATE_REVERSED_BITS_POS);
-        
-        // These are only used for state tracking really!
-        vertex_hash &= ~(egl_context_es1::VERTEX_STATE_CLIENT_WEIGHT_ARRAY | egl_context_es1::VERTEX_STATE_CLIENT_MATRIX_INDEX_ARRAY);
+        return disk_cache_->save();
+    }
 
-        if ((vertex_hash & egl_context_es1::VERTEX_STATE_SKINNING_ENABLE) == 0) {
-            vertex_hash &= ~egl_context_es1::VERTEX_STATE_SKIN_WEIGHTS_PER_VERTEX_MASK;
+    std::size_t gles1_shaderman::prewarm() {
+        if (!disk_cache_ || !driver_) {
+            return 0;
         }
-        
-        if ((vertex_hash & egl_context_es1::VERTEX_STATE_LIGHTING_ENABLE) == 0) {
-            vertex_hash &= ~egl_context_es1::VERTEX_STATE_LIGHT_RELATED_MASK;
+
+        std::size_t ready_count = 0;
+
+        for (const gles1_cached_program &program: disk_cache_->programs()) {
+            // Without the texture environments, the fragment module can only come from the cached source
+            if (!disk_cache_->find_fragment_source(program.fragment_key_) && (fragment_cache_.find(program.fragment_key_) == fragment_cache_.end())) {
+                continue;
+            }
+
+            drivers::handle vert_module = retrieve_vertex_module(program.vertex_key_, program.vertex_statuses_, program.active_texs_);
+            if (!vert_module) {
+                continue;
+            }
+
+            drivers::handle fragment_module = retrieve_fragment_module(program.fragment_key_, program.fragment_statuses_,
+                program.active_texs_, nullptr);
+            if (!fragment_module) {
+                continue;
+            }
+
+            if (linked_program *linked = retrieve_linked_program(vert_module, fragment_module, program.vertex_statuses_,
+                    program.fragment_statuses_, program.active_texs_)) {
+                // Came from this cache, nothing to record
+                linked->disk_generation_ = disk_generation_;
+                ready_count++;
+            }
         }
 
-        if (active_texs != 0) {
-            // Clean texcoord bits of unused textures...
-            for (std::uint8_t i = 0; i < GLES1_EMU_MAX_TEXTURE_COUNT; i++) {
-                if ((active_texs & (0b11 << (i * 2))) == 0) {
-                    vertex_hash &= ~(1 << (egl_context_es1::VERTEX_STATE_CLIENT_TEXCOORD_ARRAY_POS + i));
-                }
+        LOG_INFO(HLE_DISPATCHER, "Prewarmed {} GLES1 shader programs from {}", ready_count, disk_cache_->path());
+        return ready_count;
+    }
+
+    drivers::handle gles1_shaderman::retrieve_vertex_module(const std::uint64_t vertex_key, const std::uint64_t vertex_statuses,
+        const std::uint32_t active_texs) {
+        auto vert_cache_ite = vertex_cache_.find(vertex_key);
+        if (vert_cache_ite != vertex_cache_.end()) {
+            cached_module &module = vert_cache_ite->second;
+
+            if (disk_cache_ && (module.disk_generation_ != disk_generation_)) {
+                disk_cache_->add_vertex_source(vertex_key, module.source_);
+                module.disk_generation_ = disk_generation_;
             }
+
+            return module.handle_;
         }
 
-        auto vert_cache_ite = vertex_cache_.find(vertex_hash);
-        if (vert_cache_ite == vertex_cache_.end()) {
-            std::string source_shader;
+        const std::string *cached_source = disk_cache_ ? disk_cache_->find_vertex_source(vertex_key) : nullptr;
+        std::string source_shader;
+
+        if (cached_source) {
+            source_shader = *cached_source;
+        } else {
             switch (driver_->get_current_api()) {
             case drivers::graphic_api::opengl:
                 source_shader = generate_gl_vertex_shader(vertex_statuses, active_texs, driver_->is_stricted());
@@ -109,42 +151,44 @@ namespace eka2l1::dispatch {
                 LOG_ERROR(HLE_DISPATCHER, "Current backend does not support GLES1 shadergen yet!");
                 return 0;
             }
+        }
 
-            vert_module = drivers::create_shader_module(driver_, source_shader.data(), source_shader.size(),
-                drivers::shader_module_type::vertex);
+        drivers::handle vert_module = drivers::create_shader_module(driver_, source_shader.data(), source_shader.size(),
+            drivers::shader_module_type::vertex);
 
-            if (!vert_module) {
-                LOG_ERROR(HLE_DISPATCHER, "Fail to create GLES1 vertex shader module!");
-                return 0;
-            }
-
-            vertex_cache_.emplace(vertex_hash, vert_module);
-        } else {
-            vert_module = vert_cache_ite->second;
+        if (!vert_module) {
+            LOG_ERROR(HLE_DISPATCHER, "Fail to create GLES1 vertex shader module!");
+            return 0;
         }
 
-        drivers::handle fragment_module = 0;
-        if (!fragment_status_hasher_) {
-            fragment_status_hasher_ = XXH64_createState();
+        if (disk_cache_ && !cached_source) {
+            disk_cache_->add_vertex_source(vertex_key, source_shader);
         }
 
-        // Doodle GLES1 (the seed I try to write 0_0)
-        XXH64_reset(reinterpret_cast<XXH64_state_t*>(fragment_status_hasher_), 0xD00D1E61E51ULL);
-        XXH64_update(reinterpret_cast<XXH64_state_t*>(fragment_status_hasher_), &cleansed_fragment_statuses, sizeof(std::uint64_t));
-        XXH64_update(reinterpret_cast<XXH64_state_t*>(fragment_status_hasher_), &active_texs, sizeof(std::uint32_t));
+        vertex_cache_.emplace(vertex_key, cached_module{ vert_module, std::move(source_shader), disk_cache_ ? disk_generation_ : 0 });
+        return vert_module;
+    }
 
-        if (active_texs != 0) {
-            for (std::size_t i = 0; i < GLES1_EMU_MAX_TEXTURE_COUNT; i++) {
-                if (active_texs & (0b11 << (i * 2))) {
-                    XXH64_update(reinterpret_cast<XXH64_state_t*>(fragment_status_hasher_), tex_env_infos + i, sizeof(gles_texture_env_info));
-                }
+    drivers::handle gles1_shaderman::retrieve_fragment_module(const std::uint64_t fragment_key, const std::uint64_t cleansed_fragment_statuses,
+        const std::uint32_t active_texs, gles_texture_env_info *tex_env_infos) {
+        auto frag_cache_ite = fragment_cache_.find(fragment_key);
+        if (frag_cache_ite != fragment_cache_.end()) {
+            cached_module &module = frag_cache_ite->second;
+
+            if (disk_cache_ && (module.disk_generation_ != disk_generation_)) {
+                disk_cache_->add_fragment_source(fragment_key, module.source_);
+                module.disk_generation_ = disk_generation_;
             }
+
+            return module.handle_;
         }
 
-        std::uint64_t fragment_module_hash = XXH64_digest(reinterpret_cast<XXH64_state_t*>(fragment_status_hasher_));
-        auto frag_cache_ite = fragment_cache_.find(fragment_module_hash);
-        if (frag_cache_ite == fragment_cache_.end()) {
-            std::string source_shader;
+        const std::string *cached_source = disk_cache_ ? disk_cache_->find_fragment_source(fragment_key) : nullptr;
+        std::string source_shader;
+
+        if (cached_source) {
+            source_shader = *cached_source;
+        } else {
             switch (driver_->get_current_api()) {
             case drivers::graphic_api::opengl:
                 source_shader = generate_gl_fragment_shader(cleansed_fragment_statuses, active_texs, tex_env_infos, driver_->is_stricted());
@@ -154,33 +198,72 @@ namespace eka2l1::dispatch {
                 LOG_ERROR(HLE_DISPATCHER, "Current backend does not support GLES1 shadergen yet!");
                 return 0;
             }
+        }
 
-            fragment_module = drivers::create_shader_module(driver_, source_shader.data(), source_shader.size(),
-                drivers::shader_module_type::fragment);
+        drivers::handle fragment_module = drivers::create_shader_module(driver_, source_shader.data(), source_shader.size(),
+            drivers::shader_module_type::fragment);
 
-            if (!fragment_module) {
-                LOG_ERROR(HLE_DISPATCHER, "Fail to create GLES1 fragment shader module!");
-                return 0;
-            }
+        if (!fragment_module) {
+            LOG_ERROR(HLE_DISPATCHER, "Fail to create GLES1 fragment shader module!");
+            return 0;
+        }
 
-            fragment_cache_.emplace(fragment_module_hash, fragment_module);
-        } else {
-            fragment_module = frag_cache_ite->second;
+        if (disk_cache_ && !cached_source) {
+            disk_cache_->add_fragment_source(fragment_key, source_shader);
         }
 
-        // Got the two handles, try to produce a program
-        bool need_produce_program = false;
+        fragment_cache_.emplace(fragment_key, cached_module{ fragment_module, std::move(source_shader), disk_cache_ ? disk_generation_ : 0 });
+        return fragment_module;
+    }
+
+    drivers::handle gles1_shaderman::retrieve_program(const std::uint64_t vertex_statuses, const std::uint64_t fragment_statuses,
+        const std::uint32_t active_texs, gles_texture_env_info *tex_env_infos, gles1_shader_variables_info *&info) {
+        // Turn off states that are not used (for hashing)
+        const std::uint64_t cleansed_fragment_statuses = gles1_cleanse_fragment_statuses(fragment_statuses);
+        const std::uint64_t vertex_key = gles1_vertex_shader_key(vertex_statuses, active_texs);
 
+        drivers::handle vert_module = retrieve_vertex_module(vertex_key, vertex_statuses, active_texs);
+        if (!vert_module) {
+            return 0;
+        }
+
+        const std::uint64_t fragment_key = gles1_fragment_shader_key(cleansed_fragment_statuses, active_texs, tex_env_infos);
+
+        drivers::handle fragment_module = retrieve_fragment_module(fragment_key, cleansed_fragment_statuses, active_texs, tex_env_infos);
+        if (!fragment_module) {
+            return 0;
+        }
+
+        linked_program *linked = retrieve_linked_program(vert_module, fragment_module, vertex_statuses, fragment_statuses,
+            active_texs);
+
+        if (!linked) {
+            return 0;
+        }
+
+        if (disk_cache_ && (linked->disk_generation_ != disk_generation_)) {
+            gles1_cached_program cached;
+            cached.vertex_key_ = vertex_key;
+            cached.fragment_key_ = fragment_key;
+            cached.vertex_statuses_ = vertex_statuses;
+            cached.fragment_statuses_ = cleansed_fragment_statuses;
+            cached.active_texs_ = active_texs;
+
+            disk_cache_->add_program(cached);
+            linked->disk_generation_ = disk_generation_;
+        }
+
+        info = linked->info_.get();
+        return linked->handle_;
+    }
+
+    gles1_shaderman::linked_program *gles1_shaderman::retrieve_linked_program(const drivers::handle vert_module, const drivers::handle fragment_module,
+        const std::uint64_t vertex_statuses, const std::uint64_t fragment_statuses, const std::uint32_t active_texs) {
         auto level1_program_ite = program_cache_.find(vert_module);
-        if (level1_program_ite == program_cache_.end()) {
-            need_produce_program = true;
-        } else {
+        if (level1_program_ite != program_cache_.end()) {
             auto level2_program_ite = level1_program_ite->second.find(fragment_module);
-            if (level2_program_ite == level1_program_ite->second.end()) {
-                need_produce_program = true;
-            } else {
-                info = level2_program_ite->second.second.get();
-                return level2_program_ite->second.first;
+            if (level2_program_ite != level1_program_ite->second.end()) {
+                return &level2_program_ite->second;
             }
         }
 
@@ -188,7 +271,7 @@ namespace eka2l1::dispatch {
         drivers::handle program_handle = drivers::create_shader_program(driver_, vert_module, fragment_module, &metadata);
         if (!program_handle) {
             LOG_ERROR(HLE_DISPATCHER, "Fail to create GLES1 shader program!");
-            return 0;
+            return nullptr;
         }
 
         std::unique_ptr<gles1_shader_variables_info> info_inst = nullptr;
@@ -296,9 +379,11 @@ namespace eka2l1::dispatch {
             }
         }
 
-        info = info_inst.get();
-        program_cache_[vert_module][fragment_module] = { program_handle, std::move(info_inst) };
+        linked_program &linked = program_cache_[vert_module][fragment_module];
+        linked.handle_ = program_handle;
+        linked.info_ = std::move(info_inst);
+        linked.disk_generation_ = 0;
 
-        return program_handle;
+        return &linked;
     }
 }
\ No newline at end of file
@@ -1189,7 +1189,7 @@ APPLY_PENDING_ROUTES:
                         // Set this to 0 for future
                         texture_units_[i] = 0;
                     } else {
-                        cmd_builder_.bind_texture((*obj)->handle_value(), static_cast<int>(i));
+                        state_shadow_.bind_texture((*obj)->handle_value(), static_cast<int>(i));
                     }
                 }
             }
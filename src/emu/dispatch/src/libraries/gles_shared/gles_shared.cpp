@@ -28,6 +28,11 @@
 #include <system/epoc.h>
 #include <kernel/kernel.h>
 
+#include <common/algorithm.h>
+#include <common/hash.h>
+
+#include <cstring>
+
 namespace eka2l1::dispatch {
     static bool decompress_palette_data(std::vector<std::uint8_t> &dest, std::vector<std::size_t> &out_size, std::uint8_t *source, std::int32_t width,
         std::int32_t height, std::uint32_t source_format, std::int32_t mip_count, drivers::texture_format &dest_format,
@@ -582,6 +587,8 @@ namespace eka2l1::dispatch {
         if (is_frame_swap_flush) {
             vertex_buffer_pusher_.done_frame();
             index_buffer_pusher_.done_frame();
+            client_upload_cache_.clear();
+            state_shadow_.done_frame();
         }
     }
 
@@ -594,6 +601,10 @@ namespace eka2l1::dispatch {
         scissor_bl_.size = eka2l1::vec2(-1, -1);
     }
 
+    void egl_context_es_shared::on_untracked_commands_recorded() {
+        state_shadow_.invalidate();
+    }
+
     void egl_context_es_shared::flush_state_changes() {
         while (!texture_update_list_.empty()) {
             gles_driver_texture *tex = E_LOFF(texture_update_list_.first()->deque(), gles_driver_texture, update_link_);
@@ -606,7 +617,7 @@ namespace eka2l1::dispatch {
         }
 
         if (state_change_tracker_ & STATE_CHANGED_CULL_FACE) {
-            cmd_builder_.set_cull_face(active_cull_face_);
+            state_shadow_.set_cull_face(active_cull_face_);
         }
 
         if (state_change_tracker_ & STATE_CHANGED_SCISSOR_RECT) {
@@ -621,7 +632,7 @@ namespace eka2l1::dispatch {
         }
 
         if (state_change_tracker_ & STATE_CHANGED_FRONT_FACE_RULE) {
-            cmd_builder_.set_front_face_rule(active_front_face_rule_);
+            state_shadow_.set_front_face_rule(active_front_face_rule_);
         }
 
         if (state_change_tracker_ & STATE_CHANGED_VIEWPORT_RECT) {
@@ -638,50 +649,50 @@ namespace eka2l1::dispatch {
         }
 
         if (state_change_tracker_ & STATE_CHANGED_COLOR_MASK) {
-            cmd_builder_.set_color_mask(color_mask_);
+            state_shadow_.set_color_mask(color_mask_);
         }
 
         if (state_change_tracker_ & STATE_CHANGED_DEPTH_BIAS) {    
-            cmd_builder_.set_depth_bias(polygon_offset_units_, 1.0, polygon_offset_factor_);
+            state_shadow_.set_depth_bias(polygon_offset_units_, 1.0, polygon_offset_factor_);
         }
 
         if (state_change_tracker_ & STATE_CHANGED_STENCIL_MASK_FRONT) {
-            cmd_builder_.set_stencil_mask(drivers::rendering_face::front, stencil_mask_front_);
+            state_shadow_.set_stencil_mask(drivers::rendering_face::front, stencil_mask_front_);
         }
 
         if (state_change_tracker_ & STATE_CHANGED_STENCIL_MASK_BACK) {
-            cmd_builder_.set_stencil_mask(drivers::rendering_face::back, stencil_mask_front_);
+            state_shadow_.set_stencil_mask(drivers::rendering_face::back, stencil_mask_front_);
         }
 
         if (state_change_tracker_ & STATE_CHANGED_BLEND_FACTOR) {
-            cmd_builder_.blend_formula(blend_equation_rgb_, blend_equation_a_, source_blend_factor_rgb_, dest_blend_factor_rgb_,
+            state_shadow_.blend_formula(blend_equation_rgb_, blend_equation_a_, source_blend_factor_rgb_, dest_blend_factor_rgb_,
                 source_blend_factor_a_, dest_blend_factor_a_);
         }
 
         if (state_change_tracker_ & STATE_CHANGED_LINE_WIDTH) {    
-            cmd_builder_.set_line_width(line_width_);
+            state_shadow_.set_line_width(line_width_);
         }
 
         if (state_change_tracker_ & STATE_CHANGED_DEPTH_MASK) {    
-            cmd_builder_.set_depth_mask(depth_mask_);
+            state_shadow_.set_depth_mask(depth_mask_);
         }
 
         if (state_change_tracker_ & STATE_CHANGED_DEPTH_PASS_COND) {
             drivers::condition_func func;
             cond_func_from_gl_enum(depth_func_, func);
 
-            cmd_builder_.set_depth_pass_condition(func);
+            state_shadow_.set_depth_pass_condition(func);
         }
 
         if (state_change_tracker_ & STATE_CHANGED_DEPTH_RANGE) {
-            cmd_builder_.set_depth_range(depth_range_min_, depth_range_max_);
+            state_shadow_.set_depth_range(depth_range_min_, depth_range_max_);
         }
 
         if (state_change_tracker_ & STATE_CHANGED_STENCIL_FUNC_FRONT) {
             drivers::condition_func stencil_func_drv;
             cond_func_from_gl_enum(stencil_func_front_, stencil_func_drv);
 
-            cmd_builder_.set_stencil_pass_condition(drivers::rendering_face::front, stencil_func_drv,
+            state_shadow_.set_stencil_pass_condition(drivers::rendering_face::front, stencil_func_drv,
                 stencil_func_ref_front_, stencil_func_mask_front_);
         }
         
@@ -689,7 +700,7 @@ namespace eka2l1::dispatch {
             drivers::condition_func stencil_func_drv;
             cond_func_from_gl_enum(stencil_func_back_, stencil_func_drv);
 
-            cmd_builder_.set_stencil_pass_condition(drivers::rendering_face::back, stencil_func_drv,
+            state_shadow_.set_stencil_pass_condition(drivers::rendering_face::back, stencil_func_drv,
                 stencil_func_ref_back_, stencil_func_mask_back_);
         }
 
@@ -699,7 +710,7 @@ namespace eka2l1::dispatch {
             stencil_action_from_gl_enum(stencil_depth_fail_action_front_, stencil_action_depth_fail_drv);
             stencil_action_from_gl_enum(stencil_depth_pass_action_front_, stencil_action_depth_pass_drv);
     
-            cmd_builder_.set_stencil_action(drivers::rendering_face::front, stencil_action_fail_drv,
+            state_shadow_.set_stencil_action(drivers::rendering_face::front, stencil_action_fail_drv,
                 stencil_action_depth_fail_drv, stencil_action_depth_pass_drv);
         }
         
@@ -709,25 +720,28 @@ namespace eka2l1::dispatch {
             stencil_action_from_gl_enum(stencil_depth_fail_action_back_, stencil_action_depth_fail_drv);
             stencil_action_from_gl_enum(stencil_depth_pass_action_back_, stencil_action_depth_pass_drv);
     
-            cmd_builder_.set_stencil_action(drivers::rendering_face::back, stencil_action_fail_drv,
+            state_shadow_.set_stencil_action(drivers::rendering_face::back, stencil_action_fail_drv,
                 stencil_action_depth_fail_drv, stencil_action_depth_pass_drv);
         }
 
         if (state_change_tracker_ & STATE_CHANGED_BLEND_COLOUR) {
-            cmd_builder_.set_blend_colour(blend_colour_);
+            state_shadow_.set_blend_colour(blend_colour_);
         }
 
         state_change_tracker_ = 0;
     }
 
     void egl_context_es_shared::init_context_state() {
+        // A new command list begins, other lists may have changed the driver state in between
+        state_shadow_.invalidate();
+
         cmd_builder_.bind_bitmap(draw_surface_->handle_, read_surface_->handle_);
-        cmd_builder_.set_cull_face(active_cull_face_);
-        cmd_builder_.set_front_face_rule(active_front_face_rule_);
-        cmd_builder_.set_color_mask(color_mask_);
-        cmd_builder_.set_stencil_mask(drivers::rendering_face::front, stencil_mask_front_);
-        cmd_builder_.set_stencil_mask(drivers::rendering_face::back, stencil_mask_back_);
-        cmd_builder_.set_blend_colour(blend_colour_);
+        state_shadow_.set_cull_face(active_cull_face_);
+        state_shadow_.set_front_face_rule(active_front_face_rule_);
+        state_shadow_.set_color_mask(color_mask_);
+        state_shadow_.set_stencil_mask(drivers::rendering_face::front, stencil_mask_front_);
+        state_shadow_.set_stencil_mask(drivers::rendering_face::back, stencil_mask_back_);
+        state_shadow_.set_blend_colour(blend_colour_);
 
         drivers::condition_func depth_func_drv;
         cond_func_from_gl_enum(depth_func_, depth_func_drv);
@@ -746,35 +760,35 @@ namespace eka2l1::dispatch {
         stencil_action_from_gl_enum(stencil_depth_fail_action_back_, stencil_action_depth_fail_drv_back);
         stencil_action_from_gl_enum(stencil_depth_pass_action_back_, stencil_action_depth_pass_drv_back);
 
-        cmd_builder_.set_depth_pass_condition(depth_func_drv);
-        cmd_builder_.set_depth_mask(depth_mask_);
-        cmd_builder_.blend_formula(blend_equation_rgb_, blend_equation_a_, source_blend_factor_rgb_, dest_blend_factor_rgb_,
+        state_shadow_.set_depth_pass_condition(depth_func_drv);
+        state_shadow_.set_depth_mask(depth_mask_);
+        state_shadow_.blend_formula(blend_equation_rgb_, blend_equation_a_, source_blend_factor_rgb_, dest_blend_factor_rgb_,
             source_blend_factor_a_, dest_blend_factor_a_);
 
-        cmd_builder_.set_line_width(line_width_);
-        cmd_builder_.set_depth_bias(polygon_offset_units_, 1.0, polygon_offset_factor_);
-        cmd_builder_.set_depth_range(depth_range_min_, depth_range_max_);
-        cmd_builder_.set_stencil_pass_condition(drivers::rendering_face::front, stencil_func_drv_front,
+        state_shadow_.set_line_width(line_width_);
+        state_shadow_.set_depth_bias(polygon_offset_units_, 1.0, polygon_offset_factor_);
+        state_shadow_.set_depth_range(depth_range_min_, depth_range_max_);
+        state_shadow_.set_stencil_pass_condition(drivers::rendering_face::front, stencil_func_drv_front,
             stencil_func_ref_front_, stencil_func_mask_front_);
-        cmd_builder_.set_stencil_pass_condition(drivers::rendering_face::back, stencil_func_drv_back,
+        state_shadow_.set_stencil_pass_condition(drivers::rendering_face::back, stencil_func_drv_back,
             stencil_func_ref_back_, stencil_func_mask_back_);
-        cmd_builder_.set_stencil_action(drivers::rendering_face::front, stencil_action_fail_drv_front,
+        state_shadow_.set_stencil_action(drivers::rendering_face::front, stencil_action_fail_drv_front,
             stencil_action_depth_fail_drv_front, stencil_action_depth_pass_drv_front);
-        cmd_builder_.set_stencil_action(drivers::rendering_face::back, stencil_action_fail_drv_back,
+        state_shadow_.set_stencil_action(drivers::rendering_face::back, stencil_action_fail_drv_back,
             stencil_action_depth_fail_drv_back, stencil_action_depth_pass_drv_back);
 
-        cmd_builder_.set_feature(drivers::graphics_feature::blend, non_shader_statuses_ & NON_SHADER_STATE_BLEND_ENABLE);
-        cmd_builder_.set_feature(drivers::graphics_feature::clipping, non_shader_statuses_ & NON_SHADER_STATE_SCISSOR_ENABLE);
-        cmd_builder_.set_feature(drivers::graphics_feature::cull, non_shader_statuses_ & NON_SHADER_STATE_CULL_FACE_ENABLE);
-        cmd_builder_.set_feature(drivers::graphics_feature::depth_test, non_shader_statuses_ & NON_SHADER_STATE_DEPTH_TEST_ENABLE);
-        cmd_builder_.set_feature(drivers::graphics_feature::dither, non_shader_statuses_ & NON_SHADER_STATE_DITHER);
-        cmd_builder_.set_feature(drivers::graphics_feature::line_smooth, non_shader_statuses_ & NON_SHADER_STATE_LINE_SMOOTH);
-        cmd_builder_.set_feature(drivers::graphics_feature::multisample, non_shader_statuses_ & NON_SHADER_STATE_MULTISAMPLE);
-        cmd_builder_.set_feature(drivers::graphics_feature::polygon_offset_fill, non_shader_statuses_ & NON_SHADER_STATE_POLYGON_OFFSET_FILL);
-        cmd_builder_.set_feature(drivers::graphics_feature::sample_alpha_to_coverage, non_shader_statuses_ & NON_SHADER_STATE_SAMPLE_ALPHA_TO_COVERAGE);
-        cmd_builder_.set_feature(drivers::graphics_feature::sample_alpha_to_one, non_shader_statuses_ & NON_SHADER_STATE_SAMPLE_ALPHA_TO_ONE);
-        cmd_builder_.set_feature(drivers::graphics_feature::sample_coverage, non_shader_statuses_ & NON_SHADER_STATE_SAMPLE_COVERAGE);
-        cmd_builder_.set_feature(drivers::graphics_feature::stencil_test, non_shader_statuses_ & NON_SHADER_STATE_STENCIL_TEST_ENABLE);
+        state_shadow_.set_feature(drivers::graphics_feature::blend, non_shader_statuses_ & NON_SHADER_STATE_BLEND_ENABLE);
+        state_shadow_.set_feature(drivers::graphics_feature::clipping, non_shader_statuses_ & NON_SHADER_STATE_SCISSOR_ENABLE);
+        state_shadow_.set_feature(drivers::graphics_feature::cull, non_shader_statuses_ & NON_SHADER_STATE_CULL_FACE_ENABLE);
+        state_shadow_.set_feature(drivers::graphics_feature::depth_test, non_shader_statuses_ & NON_SHADER_STATE_DEPTH_TEST_ENABLE);
+        state_shadow_.set_feature(drivers::graphics_feature::dither, non_shader_statuses_ & NON_SHADER_STATE_DITHER);
+        state_shadow_.set_feature(drivers::graphics_feature::line_smooth, non_shader_statuses_ & NON_SHADER_STATE_LINE_SMOOTH);
+        state_shadow_.set_feature(drivers::graphics_feature::multisample, non_shader_statuses_ & NON_SHADER_STATE_MULTISAMPLE);
+        state_shadow_.set_feature(drivers::graphics_feature::polygon_offset_fill, non_shader_statuses_ & NON_SHADER_STATE_POLYGON_OFFSET_FILL);
+        state_shadow_.set_feature(drivers::graphics_feature::sample_alpha_to_coverage, non_shader_statuses_ & NON_SHADER_STATE_SAMPLE_ALPHA_TO_COVERAGE);
+        state_shadow_.set_feature(drivers::graphics_feature::sample_alpha_to_one, non_shader_statuses_ & NON_SHADER_STATE_SAMPLE_ALPHA_TO_ONE);
+        state_shadow_.set_feature(drivers::graphics_feature::sample_coverage, non_shader_statuses_ & NON_SHADER_STATE_SAMPLE_COVERAGE);
+        state_shadow_.set_feature(drivers::graphics_feature::stencil_test, non_shader_statuses_ & NON_SHADER_STATE_STENCIL_TEST_ENABLE);
 
         if (viewport_bl_.size == eka2l1::vec2(-1, -1)) {
             viewport_bl_.size = draw_surface_->dimension_;
@@ -917,6 +931,45 @@ namespace eka2l1::dispatch {
         current_buffer_ = 0;
     }
 
+    std::size_t gles_client_upload_key_hash::operator()(const gles_client_upload_key &key) const noexcept {
+        std::size_t seed = 0x7570;
+
+        common::hash_combine(seed, key.base_address_);
+        common::hash_combine(seed, key.stride_);
+        common::hash_combine(seed, key.first_index_);
+        common::hash_combine(seed, key.size_);
+
+        return seed;
+    }
+
+    bool gles_client_upload_cache::find(const gles_client_upload_key &key, const std::uint8_t *data, drivers::handle &buffer, std::size_t &offset) const {
+        auto ite = entries_.find(key);
+        if (ite == entries_.end()) {
+            return false;
+        }
+
+        if (std::memcmp(ite->second.snapshot_.data(), data, key.size_) != 0) {
+            return false;
+        }
+
+        buffer = ite->second.buffer_;
+        offset = ite->second.offset_;
+
+        return true;
+    }
+
+    void gles_client_upload_cache::add(const gles_client_upload_key &key, const std::uint8_t *data, const drivers::handle buffer, const std::size_t offset) {
+        gles_client_upload_entry &entry = entries_[key];
+
+        entry.buffer_ = buffer;
+        entry.offset_ = offset;
+        entry.snapshot_.assign(data, data + key.size_);
+    }
+
+    void gles_client_upload_cache::clear() {
+        entries_.clear();
+    }
+
     std::uint32_t get_gl_attrib_stride(const gles_vertex_attrib &attrib) {
         std::uint32_t stride = attrib.stride_;
         if (!stride) {
@@ -1016,7 +1069,8 @@ namespace eka2l1::dispatch {
         , unpack_alignment_(4)
         , depth_range_min_(0.0f)
         , depth_range_max_(1.0f)
-        , attrib_changed_(false) {
+        , attrib_changed_(false)
+        , state_shadow_(cmd_builder_) {
         clear_color_[0] = 0.0f;
         clear_color_[1] = 0.0f;
         clear_color_[2] = 0.0f;
@@ -1314,8 +1368,13 @@ namespace eka2l1::dispatch {
                 vertex_buffer_pusher_.initialize(common::MB(4));
             }
 
+            const gles_client_upload_key upload_key{ attrib.offset_, stride, first_index_real, total_buffer_size };
             std::size_t offset_big = 0;
-            buffer_handle_drv = vertex_buffer_pusher_.push_buffer(drv, data_raw, total_buffer_size, offset_big);
+
+            if (!client_upload_cache_.find(upload_key, data_raw, buffer_handle_drv, offset_big)) {
+                buffer_handle_drv = vertex_buffer_pusher_.push_buffer(drv, data_raw, total_buffer_size, offset_big);
+                client_upload_cache_.add(upload_key, data_raw, buffer_handle_drv, offset_big);
+            }
 
             offset = static_cast<int>(offset_big);
 
@@ -1384,7 +1443,7 @@ namespace eka2l1::dispatch {
         switch (feature) {
         case GL_BLEND_EMU:
             non_shader_statuses_ |= egl_context_es_shared::NON_SHADER_STATE_BLEND_ENABLE;
-            cmd_builder_.set_feature(drivers::graphics_feature::blend, true);
+            state_shadow_.set_feature(drivers::graphics_feature::blend, true);
 
             break;
 
@@ -1394,67 +1453,67 @@ namespace eka2l1::dispatch {
 
         case GL_CULL_FACE_EMU:
             non_shader_statuses_ |= egl_context_es_shared::NON_SHADER_STATE_CULL_FACE_ENABLE;
-            cmd_builder_.set_feature(drivers::graphics_feature::cull, true);
+            state_shadow_.set_feature(drivers::graphics_feature::cull, true);
 
             break;
 
         case GL_DEPTH_TEST_EMU:
             non_shader_statuses_ |= egl_context_es_shared::NON_SHADER_STATE_DEPTH_TEST_ENABLE;
-            cmd_builder_.set_feature(drivers::graphics_feature::depth_test, true);
+            state_shadow_.set_feature(drivers::graphics_feature::depth_test, true);
 
             break;
 
         case GL_STENCIL_TEST_EMU:
             non_shader_statuses_ |= egl_context_es_shared::NON_SHADER_STATE_STENCIL_TEST_ENABLE;
-            cmd_builder_.set_feature(drivers::graphics_feature::stencil_test, true);
+            state_shadow_.set_feature(drivers::graphics_feature::stencil_test, true);
 
             break;
 
         case GL_LINE_SMOOTH_EMU:
             non_shader_statuses_ |= egl_context_es_shared::NON_SHADER_STATE_LINE_SMOOTH;
-            cmd_builder_.set_feature(drivers::graphics_feature::line_smooth, true);
+            state_shadow_.set_feature(drivers::graphics_feature::line_smooth, true);
 
             break;
 
         case GL_DITHER_EMU:
             non_shader_statuses_ |= egl_context_es_shared::NON_SHADER_STATE_DITHER;
-            cmd_builder_.set_feature(drivers::graphics_feature::dither, true);
+            state_shadow_.set_feature(drivers::graphics_feature::dither, true);
 
             break;
 
         case GL_SCISSOR_TEST_EMU:
             non_shader_statuses_ |= egl_context_es_shared::NON_SHADER_STATE_SCISSOR_ENABLE;
-            cmd_builder_.set_feature(drivers::graphics_feature::clipping, true);
+            state_shadow_.set_feature(drivers::graphics_feature::clipping, true);
 
             break;
 
         case GL_SAMPLE_COVERAGE_EMU:
             non_shader_statuses_ |= egl_context_es_shared::NON_SHADER_STATE_SAMPLE_COVERAGE;
-            cmd_builder_.set_feature(drivers::graphics_feature::sample_coverage, true);
+            state_shadow_.set_feature(drivers::graphics_feature::sample_coverage, true);
 
             break;
 
         case GL_MULTISAMPLE_EMU:
             non_shader_statuses_ |= egl_context_es_shared::NON_SHADER_STATE_MULTISAMPLE;
-            cmd_builder_.set_feature(drivers::graphics_feature::multisample, true);
+            state_shadow_.set_feature(drivers::graphics_feature::multisample, true);
 
             break;
 
         case GL_SAMPLE_ALPHA_TO_COVERAGE_EMU:
             non_shader_statuses_ |= egl_context_es_shared::NON_SHADER_STATE_SAMPLE_ALPHA_TO_COVERAGE;
-            cmd_builder_.set_feature(drivers::graphics_feature::sample_alpha_to_coverage, true);
+            state_shadow_.set_feature(drivers::graphics_feature::sample_alpha_to_coverage, true);
 
             break;
 
         case GL_SAMPLE_ALPHA_TO_ONE_EMU:
             non_shader_statuses_ |= egl_context_es_shared::NON_SHADER_STATE_SAMPLE_ALPHA_TO_ONE;
-            cmd_builder_.set_feature(drivers::graphics_feature::sample_alpha_to_one, true);
+            state_shadow_.set_feature(drivers::graphics_feature::sample_alpha_to_one, true);
 
             break;
 
         case GL_POLYGON_OFFSET_FILL_EMU:
             non_shader_statuses_ |= egl_context_es_shared::NON_SHADER_STATE_POLYGON_OFFSET_FILL;
-            cmd_builder_.set_feature(drivers::graphics_feature::polygon_offset_fill, true);
+            state_shadow_.set_feature(drivers::graphics_feature::polygon_offset_fill, true);
 
             break;
 
@@ -1469,7 +1528,7 @@ namespace eka2l1::dispatch {
         switch (feature) {
         case GL_BLEND_EMU:
             non_shader_statuses_ &= ~egl_context_es_shared::NON_SHADER_STATE_BLEND_ENABLE;
-            cmd_builder_.set_feature(drivers::graphics_feature::blend, false);
+            state_shadow_.set_feature(drivers::graphics_feature::blend, false);
 
             break;
 
@@ -1479,66 +1538,66 @@ namespace eka2l1::dispatch {
 
         case GL_CULL_FACE_EMU:
             non_shader_statuses_ &= ~egl_context_es_shared::NON_SHADER_STATE_CULL_FACE_ENABLE;
-            cmd_builder_.set_feature(drivers::graphics_feature::cull, false);
+            state_shadow_.set_feature(drivers::graphics_feature::cull, false);
 
             break;
 
         case GL_DEPTH_TEST_EMU:
             non_shader_statuses_ &= ~egl_context_es_shared::NON_SHADER_STATE_DEPTH_TEST_ENABLE;
-            cmd_builder_.set_feature(drivers::graphics_feature::depth_test, false);
+            state_shadow_.set_feature(drivers::graphics_feature::depth_test, false);
 
             break;
 
         case GL_STENCIL_TEST_EMU:
             non_shader_statuses_ &= ~egl_context_es_shared::NON_SHADER_STATE_STENCIL_TEST_ENABLE;
-            cmd_builder_.set_feature(drivers::graphics_feature::stencil_test, false);
+            state_shadow_.set_feature(drivers::graphics_feature::stencil_test, false);
 
             break;
 
         case GL_LINE_SMOOTH_EMU:
             non_shader_statuses_ &= ~egl_context_es_shared::NON_SHADER_STATE_LINE_SMOOTH;
-            cmd_builder_.set_feature(drivers::graphics_feature::line_smooth, false);
+            state_shadow_.set_feature(drivers::graphics_feature::line_smooth, false);
 
             break;
 
         case GL_DITHER_EMU:
             non_shader_statuses_ &= ~egl_context_es_shared::NON_SHADER_STATE_DITHER;
-            cmd_builder_.set_feature(drivers::graphics_feature::dither, false);
+            state_shadow_.set_feature(drivers::graphics_feature::dither, false);
 
             break;
 
         case GL_SCISSOR_TEST_EMU:
             non_shader_statuses_ &= ~egl_context_es_shared::NON_SHADER_STATE_SCISSOR_ENABLE;
-            cmd_builder_.set_feature(drivers::graphics_feature::clipping, false);
+            state_shadow_.set_feature(drivers::graphics_feature::clipping, false);
 
             break;
 
         case GL_SAMPLE_COVERAGE_EMU:
             non_shader_statuses_ &= ~egl_context_es_shared::NON_SHADER_STATE_SAMPLE_COVERAGE;
-            cmd_builder_.set_feature(drivers::graphics_feature::sample_coverage, false);
+            state_shadow_.set_feature(drivers::graphics_feature::sample_coverage, false);
 
             break;
 
         case GL_MULTISAMPLE_EMU:
             non_shader_statuses_ &= ~egl_context_es_shared::NON_SHADER_STATE_MULTISAMPLE;
-            cmd_builder_.set_feature(drivers::graphics_feature::multisample, false);
+            state_shadow_.set_feature(drivers::graphics_feature::multisample, false);
 
             break;
 
         case GL_SAMPLE_ALPHA_TO_COVERAGE_EMU:
             non_shader_statuses_ &= ~egl_context_es_shared::NON_SHADER_STATE_SAMPLE_ALPHA_TO_COVERAGE;
-            cmd_builder_.set_feature(drivers::graphics_feature::sample_alpha_to_coverage, false);
+            state_shadow_.set_feature(drivers::graphics_feature::sample_alpha_to_coverage, false);
 
             break;
 
         case GL_SAMPLE_ALPHA_TO_ONE_EMU:
             non_shader_statuses_ &= ~egl_context_es_shared::NON_SHADER_STATE_SAMPLE_ALPHA_TO_ONE;
-            cmd_builder_.set_feature(drivers::graphics_feature::sample_alpha_to_one, false);
+            state_shadow_.set_feature(drivers::graphics_feature::sample_alpha_to_one, false);
             break;
 
         case GL_POLYGON_OFFSET_FILL_EMU:
             non_shader_statuses_ &= ~egl_context_es_shared::NON_SHADER_STATE_POLYGON_OFFSET_FILL;
-            cmd_builder_.set_feature(drivers::graphics_feature::polygon_offset_fill, false);
+            state_shadow_.set_feature(drivers::graphics_feature::polygon_offset_fill, false);
 
             break;
 
@@ -3219,16 +3278,25 @@ namespace eka2l1::dispatch {
             if (indicies_data_raw) {
                 std::int32_t max_vert_index = 0;
 
-                for (std::int32_t i = 0; i < count; i++) {
-                    std::int32_t index = 0;
-                    if (index_type == GL_UNSIGNED_BYTE_EMU) {
-                        index = static_cast<std::int32_t>((reinterpret_cast<const std::uint8_t*>(indicies_data_raw))[i]);
-                    } else {
-                        index = static_cast<std::int32_t>((reinterpret_cast<const std::uint16_t*>(indicies_data_raw))[i]);
-                    }
+                if (count == 0) {
+                    min_vert_index = 0;
+                } else if (index_type == GL_UNSIGNED_BYTE_EMU) {
+                    std::uint8_t min_index_byte = 0;
+                    std::uint8_t max_index_byte = 0;
+
+                    common::find_min_max(indicies_data_raw, static_cast<std::size_t>(count), min_index_byte, max_index_byte);
+
+                    min_vert_index = min_index_byte;
+                    max_vert_index = max_index_byte;
+                } else {
+                    std::uint16_t min_index_word = 0;
+                    std::uint16_t max_index_word = 0;
+
+                    common::find_min_max(reinterpret_cast<const std::uint16_t*>(indicies_data_raw), static_cast<std::size_t>(count),
+                        min_index_word, max_index_word);
 
-                    max_vert_index = common::max(index, max_vert_index);
-                    min_vert_index = common::min(min_vert_index, index);
+                    min_vert_index = min_index_word;
+                    max_vert_index = max_index_word;
                 }
 
                 total_vert = max_vert_index + 1;
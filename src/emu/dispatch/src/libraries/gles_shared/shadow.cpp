@@ -0,0 +1,330 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <dispatch/libraries/gles_shared/shadow.h>
+#include <common/log.h>
+
+#include <cstring>
+
+namespace eka2l1::dispatch {
+    // Pack the arguments back to back, so that padding never takes part in the comparison
+    template <typename... Args>
+    static std::size_t pack_state_value(std::uint8_t *dest, const Args &...args) {
+        std::size_t offset = 0;
+        ((std::memcpy(dest + offset, &args, sizeof(Args)), offset += sizeof(Args)), ...);
+
+        return offset;
+    }
+
+    gles_state_shadow_stats &gles_state_shadow_stats::operator+=(const gles_state_shadow_stats &rhs) {
+        emitted_ += rhs.emitted_;
+        elided_states_ += rhs.elided_states_;
+        elided_features_ += rhs.elided_features_;
+        elided_texture_binds_ += rhs.elided_texture_binds_;
+        elided_program_binds_ += rhs.elided_program_binds_;
+        elided_uniforms_ += rhs.elided_uniforms_;
+
+        return *this;
+    }
+
+    gles_state_shadow::gles_state_shadow(drivers::graphics_command_builder &builder)
+        : builder_(builder)
+        , report_frame_count_(0) {
+        invalidate();
+    }
+
+    void gles_state_shadow::invalidate() {
+        for (fixed_state_value &value: fixed_states_) {
+            value.valid_ = false;
+        }
+
+        features_.fill(0);
+        invalidate_bindings();
+    }
+
+    void gles_state_shadow::invalidate_bindings() {
+        textures_.fill(0);
+
+        program_ = 0;
+        program_valid_ = false;
+
+        uniforms_.clear();
+    }
+
+    void gles_state_shadow::done_frame() {
+        last_frame_stats_ = stats_;
+        stats_ = gles_state_shadow_stats();
+
+        report_stats_ += last_frame_stats_;
+
+        if (++report_frame_count_ < STATS_REPORT_FRAME_COUNT) {
+            return;
+        }
+
+        LOG_TRACE(HLE_GLES1, "State shadow over {} frames: {} state commands emitted, {} elided ({} fixed states, {} features, "
+            "{} texture binds, {} program binds, {} uniforms)", report_frame_count_, report_stats_.emitted_, report_stats_.total_elided(),
+            report_stats_.elided_states_, report_stats_.elided_features_, report_stats_.elided_texture_binds_,
+            report_stats_.elided_program_binds_, report_stats_.elided_uniforms_);
+
+        report_stats_ = gles_state_shadow_stats();
+        report_frame_count_ = 0;
+    }
+
+    static bool fixed_state_matches(const gles_state_shadow::fixed_state_value &current, const void *value, const std::size_t size) {
+        return current.valid_ && (std::memcmp(current.data_, value, size) == 0);
+    }
+
+    static void store_fixed_state(gles_state_shadow::fixed_state_value &current, const void *value, const std::size_t size) {
+        std::memcpy(current.data_, value, size);
+        current.valid_ = true;
+    }
+
+    bool gles_state_shadow::should_emit_fixed(const fixed_state_slot slot, const void *value, const std::size_t size) {
+        fixed_state_value &current = fixed_states_[slot];
+
+        if (fixed_state_matches(current, value, size)) {
+            stats_.elided_states_++;
+            return false;
+        }
+
+        store_fixed_state(current, value, size);
+
+        stats_.emitted_++;
+        return true;
+    }
+
+    bool gles_state_shadow::should_emit_per_face(const drivers::rendering_face face, const fixed_state_slot front_slot,
+        const fixed_state_slot back_slot, const void *value, const std::size_t size) {
+        switch (face) {
+        case drivers::rendering_face::front:
+            return should_emit_fixed(front_slot, value, size);
+
+        case drivers::rendering_face::back:
+            return should_emit_fixed(back_slot, value, size);
+
+        default:
+            break;
+        }
+
+        fixed_state_value &front = fixed_states_[front_slot];
+        fixed_state_value &back = fixed_states_[back_slot];
+
+        if (fixed_state_matches(front, value, size) && fixed_state_matches(back, value, size)) {
+            stats_.elided_states_++;
+            return false;
+        }
+
+        store_fixed_state(front, value, size);
+        store_fixed_state(back, value, size);
+
+        stats_.emitted_++;
+        return true;
+    }
+
+    void gles_state_shadow::set_feature(const drivers::graphics_feature feature, const bool enabled) {
+        const std::size_t index = static_cast<std::size_t>(feature);
+        const std::uint8_t new_state = enabled ? 2 : 1;
+
+        if (index < MAX_FEATURE_COUNT) {
+            if (features_[index] == new_state) {
+                stats_.elided_features_++;
+                return;
+            }
+
+            features_[index] = new_state;
+        }
+
+        stats_.emitted_++;
+        builder_.set_feature(feature, enabled);
+    }
+
+    void gles_state_shadow::set_cull_face(const drivers::rendering_face face) {
+        std::uint8_t value[MAX_FIXED_STATE_SIZE];
+        const std::size_t size = pack_state_value(value, face);
+
+        if (should_emit_fixed(FIXED_STATE_CULL_FACE, value, size)) {
+            builder_.set_cull_face(face);
+        }
+    }
+
+    void gles_state_shadow::set_front_face_rule(const drivers::rendering_face_determine_rule rule) {
+        std::uint8_t value[MAX_FIXED_STATE_SIZE];
+        const std::size_t size = pack_state_value(value, rule);
+
+        if (should_emit_fixed(FIXED_STATE_FRONT_FACE_RULE, value, size)) {
+            builder_.set_front_face_rule(rule);
+        }
+    }
+
+    void gles_state_shadow::set_color_mask(const std::uint8_t mask) {
+        std::uint8_t value[MAX_FIXED_STATE_SIZE];
+        const std::size_t size = pack_state_value(value, mask);
+
+        if (should_emit_fixed(FIXED_STATE_COLOR_MASK, value, size)) {
+            builder_.set_color_mask(mask);
+        }
+    }
+
+    void gles_state_shadow::set_depth_bias(const float constant_factor, const float clamp, const float slope_factor) {
+        std::uint8_t value[MAX_FIXED_STATE_SIZE];
+        const std::size_t size = pack_state_value(value, constant_factor, clamp, slope_factor);
+
+        if (should_emit_fixed(FIXED_STATE_DEPTH_BIAS, value, size)) {
+            builder_.set_depth_bias(constant_factor, clamp, slope_factor);
+        }
+    }
+
+    void gles_state_shadow::set_stencil_mask(const drivers::rendering_face face, const std::uint32_t mask) {
+        std::uint8_t value[MAX_FIXED_STATE_SIZE];
+        const std::size_t size = pack_state_value(value, mask);
+
+        if (!should_emit_per_face(face, FIXED_STATE_STENCIL_MASK_FRONT, FIXED_STATE_STENCIL_MASK_BACK, value, size)) {
+            return;
+        }
+
+        builder_.set_stencil_mask(face, mask);
+    }
+
+    void gles_state_shadow::blend_formula(const drivers::blend_equation rgb_equation, const drivers::blend_equation a_equation,
+        const drivers::blend_factor rgb_frag_output_factor, const drivers::blend_factor rgb_current_factor,
+        const drivers::blend_factor a_frag_output_factor, const drivers::blend_factor a_current_factor) {
+        std::uint8_t value[MAX_FIXED_STATE_SIZE];
+        const std::size_t size = pack_state_value(value, rgb_equation, a_equation, rgb_frag_output_factor, rgb_current_factor,
+            a_frag_output_factor, a_current_factor);
+
+        if (should_emit_fixed(FIXED_STATE_BLEND_FORMULA, value, size)) {
+            builder_.blend_formula(rgb_equation, a_equation, rgb_frag_output_factor, rgb_current_factor, a_frag_output_factor,
+                a_current_factor);
+        }
+    }
+
+    void gles_state_shadow::set_line_width(const float width) {
+        std::uint8_t value[MAX_FIXED_STATE_SIZE];
+        const std::size_t size = pack_state_value(value, width);
+
+        if (should_emit_fixed(FIXED_STATE_LINE_WIDTH, value, size)) {
+            builder_.set_line_width(width);
+        }
+    }
+
+    void gles_state_shadow::set_depth_mask(const std::uint32_t mask) {
+        std::uint8_t value[MAX_FIXED_STATE_SIZE];
+        const std::size_t size = pack_state_value(value, mask);
+
+        if (should_emit_fixed(FIXED_STATE_DEPTH_MASK, value, size)) {
+            builder_.set_depth_mask(mask);
+        }
+    }
+
+    void gles_state_shadow::set_depth_pass_condition(const drivers::condition_func func) {
+        std::uint8_t value[MAX_FIXED_STATE_SIZE];
+        const std::size_t size = pack_state_value(value, func);
+
+        if (should_emit_fixed(FIXED_STATE_DEPTH_PASS_COND, value, size)) {
+            builder_.set_depth_pass_condition(func);
+        }
+    }
+
+    void gles_state_shadow::set_depth_range(const float min, const float max) {
+        std::uint8_t value[MAX_FIXED_STATE_SIZE];
+        const std::size_t size = pack_state_value(value, min, max);
+
+        if (should_emit_fixed(FIXED_STATE_DEPTH_RANGE, value, size)) {
+            builder_.set_depth_range(min, max);
+        }
+    }
+
+    void gles_state_shadow::set_stencil_pass_condition(const drivers::rendering_face face, const drivers::condition_func cond_func,
+        const int cond_func_ref_value, const std::uint32_t mask) {
+        std::uint8_t value[MAX_FIXED_STATE_SIZE];
+        const std::size_t size = pack_state_value(value, cond_func, cond_func_ref_value, mask);
+
+        if (!should_emit_per_face(face, FIXED_STATE_STENCIL_FUNC_FRONT, FIXED_STATE_STENCIL_FUNC_BACK, value, size)) {
+            return;
+        }
+
+        builder_.set_stencil_pass_condition(face, cond_func, cond_func_ref_value, mask);
+    }
+
+    void gles_state_shadow::set_stencil_action(const drivers::rendering_face face, const drivers::stencil_action on_stencil_fail,
+        const drivers::stencil_action on_stencil_pass_depth_fail, const drivers::stencil_action on_both_stencil_depth_pass) {
+        std::uint8_t value[MAX_FIXED_STATE_SIZE];
+        const std::size_t size = pack_state_value(value, on_stencil_fail, on_stencil_pass_depth_fail, on_both_stencil_depth_pass);
+
+        if (!should_emit_per_face(face, FIXED_STATE_STENCIL_OP_FRONT, FIXED_STATE_STENCIL_OP_BACK, value, size)) {
+            return;
+        }
+
+        builder_.set_stencil_action(face, on_stencil_fail, on_stencil_pass_depth_fail, on_both_stencil_depth_pass);
+    }
+
+    void gles_state_shadow::set_blend_colour(const float colour[4]) {
+        std::uint8_t value[MAX_FIXED_STATE_SIZE];
+        std::memcpy(value, colour, 4 * sizeof(float));
+
+        if (should_emit_fixed(FIXED_STATE_BLEND_COLOUR, value, 4 * sizeof(float))) {
+            builder_.set_blend_colour(colour);
+        }
+    }
+
+    void gles_state_shadow::bind_texture(const drivers::handle h, const int binding) {
+        if ((binding >= 0) && (static_cast<std::size_t>(binding) < MAX_TEXTURE_UNIT_COUNT)) {
+            if (h && (textures_[binding] == h)) {
+                stats_.elided_texture_binds_++;
+                return;
+            }
+
+            textures_[binding] = h;
+        }
+
+        stats_.emitted_++;
+        builder_.bind_texture(h, binding);
+    }
+
+    void gles_state_shadow::use_program(const drivers::handle h) {
+        if (program_valid_ && (program_ == h)) {
+            stats_.elided_program_binds_++;
+            return;
+        }
+
+        program_ = h;
+        program_valid_ = true;
+
+        stats_.emitted_++;
+        builder_.use_program(h);
+    }
+
+    void gles_state_shadow::set_dynamic_uniform(const int binding, const drivers::shader_var_type var_type, const void *data,
+        const std::size_t data_size) {
+        if (program_valid_) {
+            std::vector<std::uint8_t> &current = uniforms_[program_][binding];
+
+            if ((current.size() == data_size) && (std::memcmp(current.data(), data, data_size) == 0)) {
+                stats_.elided_uniforms_++;
+                return;
+            }
+
+            const std::uint8_t *data_bytes = reinterpret_cast<const std::uint8_t *>(data);
+            current.assign(data_bytes, data_bytes + data_size);
+        }
+
+        stats_.emitted_++;
+        builder_.set_dynamic_uniform(binding, var_type, data, data_size);
+    }
+}
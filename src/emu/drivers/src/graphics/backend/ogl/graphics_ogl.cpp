@@ -731,7 +731,7 @@ namespace eka2l1::drivers {
         common::region to_clip;
         eka2l1::rect *to_clip_rects = reinterpret_cast<eka2l1::rect*>(cmd.data_[1]);
 
-        to_clip.rects_.insert(to_clip.rects_.begin(), to_clip_rects, to_clip_rects + cmd.data_[0]);
+        to_clip.add_rects(to_clip_rects, static_cast<std::size_t>(cmd.data_[0]));
 
         float scale = 0.0f;
         float temp = 0.0f;
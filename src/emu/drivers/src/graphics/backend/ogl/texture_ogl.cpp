@@ -299,16 +299,22 @@ namespace eka2l1::drivers {
     }
 
     void ogl_texture::bind(graphics_driver *driver, const int binding) {
-        glGetIntegerv(get_binding_enum_dim(dimensions), &last_tex);
         glGetIntegerv(GL_ACTIVE_TEXTURE, &last_active);
-
         glActiveTexture(GL_TEXTURE0 + binding);
+
+        // Save what was bound on the unit we take over, not on the one that was active. Clients skip
+        // rebinding textures they believe are still bound, so a temporary bind must leave no trace.
+        glGetIntegerv(get_binding_enum_dim(dimensions), &last_tex);
+        last_unit = binding;
+
         glBindTexture(to_gl_tex_dim(dimensions), texture);
     }
 
     void ogl_texture::unbind(graphics_driver *driver) {
-        glActiveTexture(last_active);
+        glActiveTexture(GL_TEXTURE0 + last_unit);
         glBindTexture(to_gl_tex_dim(dimensions), last_tex);
+        glActiveTexture(last_active);
+
         last_tex = 0;
     }
 
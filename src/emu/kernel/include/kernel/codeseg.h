@@ -25,7 +25,10 @@
 #include <mem/ptr.h>
 #include <utils/sec.h>
 
+#include <cstddef>
+#include <list>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
 namespace eka2l1 {
@@ -84,6 +87,93 @@ namespace eka2l1::kernel {
         std::uint8_t *code_data;
     };
 
+    /**
+     * @brief Time spent preparing the image of a codeseg each time it is attached, in nanoseconds.
+     */
+    struct codeseg_load_stats {
+        std::uint32_t attach_count_ = 0;
+        std::uint32_t image_cache_hits_ = 0;
+
+        std::uint64_t copy_ns_ = 0; ///< Copying code and data into their chunks, either from the image or the cache.
+        std::uint64_t import_fixup_ns_ = 0;
+        std::uint64_t relocate_ns_ = 0;
+    };
+
+    struct codeseg_image_key {
+        std::uint64_t image_hash_;
+        std::uint64_t dependencies_hash_; ///< Hash of the load address and image of every dependency.
+
+        address code_run_addr_;
+        address data_run_addr_;
+
+        bool operator==(const codeseg_image_key &rhs) const {
+            return (image_hash_ == rhs.image_hash_) && (dependencies_hash_ == rhs.dependencies_hash_)
+                && (code_run_addr_ == rhs.code_run_addr_) && (data_run_addr_ == rhs.data_run_addr_);
+        }
+    };
+
+    struct codeseg_image_key_hash {
+        std::size_t operator()(const codeseg_image_key &key) const {
+            return static_cast<std::size_t>(key.image_hash_ ^ (key.dependencies_hash_ * 31)
+                ^ ((static_cast<std::uint64_t>(key.code_run_addr_) << 32) | key.data_run_addr_));
+        }
+    };
+
+    /**
+     * @brief Keep the code and data of codesegs after imports are patched and relocations applied.
+     *
+     * An image loaded again at the same addresses, against the same dependencies, produces the exact same
+     * bytes, so it is copied from here instead of redoing every fixup. Least recently used images are
+     * dropped once the cache gets over its size limit.
+     */
+    class codeseg_image_cache {
+    public:
+        struct entry {
+            codeseg_image_key key_;
+
+            std::vector<std::uint8_t> code_;
+            std::vector<std::uint8_t> data_;
+        };
+
+    private:
+        using lru_list = std::list<entry>;
+
+        lru_list lru_;
+        std::unordered_map<codeseg_image_key, lru_list::iterator, codeseg_image_key_hash> entries_;
+
+        std::size_t total_size_;
+        std::size_t max_size_;
+
+    public:
+        static constexpr std::size_t DEFAULT_MAX_SIZE = 32 * 1024 * 1024;
+
+        explicit codeseg_image_cache(const std::size_t max_size = DEFAULT_MAX_SIZE);
+
+        const entry *find(const codeseg_image_key &key);
+
+        /**
+         * @brief Store the relocated image of a codeseg.
+         *
+         * @param key           The image and the addresses it was relocated for.
+         * @param code          Pointer to the relocated code.
+         * @param code_size     Size of the code.
+         * @param data          Pointer to the relocated initialized data. Can be null.
+         * @param data_size     Size of the initialized data.
+         */
+        void add(const codeseg_image_key &key, const std::uint8_t *code, const std::size_t code_size,
+            const std::uint8_t *data, const std::size_t data_size);
+
+        void clear();
+
+        std::size_t total_size() const {
+            return total_size_;
+        }
+
+        std::size_t count() const {
+            return entries_.size();
+        }
+    };
+
     enum codeseg_state {
         codeseg_state_none,
         codeseg_state_attaching,
@@ -161,13 +251,22 @@ namespace eka2l1::kernel {
 
         std::vector<std::uint64_t> relocation_list;
         std::uint32_t hash_;
+        std::uint64_t image_hash_;
+
+        codeseg_load_stats load_stats_;
 
         bool patched_{ false };
         bool ep_disabled_{ false };
         bool hash_inited_{ false };
+        bool image_hash_inited_{ false };
 
         void calculate_hash();
 
+        codeseg_image_key make_image_key(kernel::process *pr, const address code_run_addr, const address data_run_addr);
+        void patch_imports(kernel::process *pr, std::uint8_t *code_base_ptr);
+        void relocate_image(std::uint8_t *code_base_ptr, std::uint8_t *data_base_ptr, const address code_run_addr,
+            const address data_run_addr);
+
     public:
         /*! \brief Create a new codeseg
          *
@@ -281,6 +380,17 @@ namespace eka2l1::kernel {
         std::vector<kernel::process*> attached_processes() const;
         std::uint32_t get_hash();
 
+        /**
+         * @brief Get the hash of everything that decides how this codeseg looks once relocated.
+         *
+         * This includes code, initialized data, relocations, imports and exports.
+         */
+        std::uint64_t get_image_hash();
+
+        const codeseg_load_stats &get_load_stats() const {
+            return load_stats_;
+        }
+
         // Use for patching
         void set_export(const std::uint32_t ordinal, eka2l1::ptr<void> address);
         void set_entry_point(eka2l1::ptr<void> address);
@@ -107,6 +107,14 @@ namespace eka2l1 {
     using kernel_obj_unq_ptr = std::unique_ptr<kernel::kernel_obj>;
     using prop_ident_pair = std::pair<int, int>;
 
+    struct property_lookup_stats {
+        std::uint64_t lookups_ = 0;                 ///< Number of get_prop and delete_prop calls.
+        std::uint64_t misses_ = 0;                  ///< Lookups that found no property.
+        std::uint64_t index_rebuilds_ = 0;          ///< Times the index was rebuilt, after a deletion or an identity change.
+        std::uint64_t notifications_ = 0;           ///< Number of property value changes notified.
+        std::uint64_t notified_subscribers_ = 0;    ///< Number of subscriptions completed by those notifications.
+    };
+
     /*! \brief Check for template type and returns the right kernel::object_type value
     */
     template <typename T>
@@ -277,6 +285,14 @@ namespace eka2l1 {
         std::vector<kernel_obj_unq_ptr> servers_;
         std::vector<kernel_obj_unq_ptr> sessions_;
         std::vector<kernel_obj_unq_ptr> props_;
+
+        // Properties get their category and key after being created, through set_prop_identity. Ones that never
+        // get it are indexed on the next lookup
+        std::unordered_map<prop_ident_pair, property_ptr> prop_index_;
+        std::vector<property_ptr> unindexed_props_;
+        bool prop_index_dirty_;
+        property_lookup_stats prop_stats_;
+
         std::vector<kernel_obj_unq_ptr> prop_refs_;
         std::vector<kernel_obj_unq_ptr> chunks_;
         std::vector<kernel_obj_unq_ptr> mutexes_;
@@ -285,6 +301,8 @@ namespace eka2l1 {
         std::vector<kernel_obj_unq_ptr> change_notifiers_;
         std::vector<kernel_obj_unq_ptr> libraries_;
         std::vector<kernel_obj_unq_ptr> codesegs_;
+        kernel::codeseg_image_cache codeseg_image_cache_;
+
         std::vector<kernel_obj_unq_ptr> timers_;
         std::vector<kernel_obj_unq_ptr> message_queues_;
         std::vector<kernel_obj_unq_ptr> logical_devices_;
@@ -357,6 +375,9 @@ namespace eka2l1 {
     protected:
         void setup_new_process(process_ptr pr);
 
+        void rebuild_prop_index();
+        property_ptr find_prop_in_index(const int category, const int key);
+
         void setup_nanokern_controller();
         void setup_custom_code();
         void setup_stub_io_mapping(const address addr);
@@ -461,6 +482,28 @@ namespace eka2l1 {
         property_ptr get_prop(int category, int key); // Get property by category and key
         property_ptr delete_prop(int category, int key);
 
+        /**
+         * @brief Give a property its category and key.
+         *
+         * Properties must not have their identity assigned directly, otherwise get_prop may not find them.
+         *
+         * @param prop          The property to change.
+         * @param category      The new category of the property.
+         * @param key           The new key of the property.
+         */
+        void set_prop_identity(property_ptr prop, const int category, const int key);
+
+        /**
+         * @brief Account a property value change, for the P&S statistics.
+         *
+         * @param subscriber_count      Number of subscriptions that got completed by the change.
+         */
+        void record_prop_notification(const std::size_t subscriber_count);
+
+        const property_lookup_stats &get_prop_lookup_stats() const {
+            return prop_stats_;
+        }
+
         void complete_undertakers(kernel::thread *literally_dies);
 
         kernel::thread *crr_thread();
@@ -529,6 +572,10 @@ namespace eka2l1 {
             return lib_mngr_.get();
         }
 
+        kernel::codeseg_image_cache &get_codeseg_image_cache() {
+            return codeseg_image_cache_;
+        }
+
         config::state *get_config() {
             return conf_;
         }
@@ -703,7 +750,7 @@ namespace eka2l1 {
                 ADD_OBJECT_TO_CONTAINER(kernel::object_type::process, processes_, setup_new_process(reinterpret_cast<process_ptr>(obj.get())));
                 ADD_OBJECT_TO_CONTAINER(kernel::object_type::chunk, chunks_, )
                 ADD_OBJECT_TO_CONTAINER(kernel::object_type::server, servers_, )
-                ADD_OBJECT_TO_CONTAINER(kernel::object_type::prop, props_, )
+                ADD_OBJECT_TO_CONTAINER(kernel::object_type::prop, props_, unindexed_props_.push_back(reinterpret_cast<property_ptr>(obj.get())))
                 ADD_OBJECT_TO_CONTAINER(kernel::object_type::prop_ref, prop_refs_, )
                 ADD_OBJECT_TO_CONTAINER(kernel::object_type::session, sessions_, )
                 ADD_OBJECT_TO_CONTAINER(kernel::object_type::library, libraries_, )
@@ -26,6 +26,7 @@
 #include <xxHash/xxhash.h>
 
 #include <algorithm>
+#include <chrono>
 
 namespace eka2l1::kernel {
     codeseg::codeseg(kernel_system *kern, const std::string &name, codeseg_create_info &info)
@@ -33,7 +34,9 @@ namespace eka2l1::kernel {
         , patched_(false)
         , code_chunk_shared(nullptr)
         , hash_(0)
-        , hash_inited_(false) {
+        , image_hash_(0)
+        , hash_inited_(false)
+        , image_hash_inited_(false) {
         obj_type = kernel::object_type::codeseg;
 
         std::copy(info.uids, info.uids + 3, uids);
@@ -67,7 +70,7 @@ namespace eka2l1::kernel {
             std::copy(info.code_data, info.code_data + info.code_size, code_data.get());
         }
 
-        relocation_list = info.relocation_list;
+        relocation_list = std::move(info.relocation_list);
     }
 
     int codeseg::destroy() {
@@ -142,6 +145,10 @@ namespace eka2l1::kernel {
         bool code_chunk_for_reuse = eligible_for_codeseg_reuse();
         bool need_patch_and_reloc = true;
 
+        // Copies are done once we know whether the relocated image is cached
+        bool code_need_copy = false;
+        bool data_need_copy = false;
+
         unmark();
 
         if (code_addr == 0) {
@@ -162,9 +169,8 @@ namespace eka2l1::kernel {
 
                 the_addr_of_code_run = code_chunk->base(new_foe).ptr_address();
 
-                // Copy data
                 code_base_ptr = reinterpret_cast<std::uint8_t *>(code_chunk->host_base());
-                std::copy(code_data.get(), code_data.get() + code_size, code_base_ptr); // .code
+                code_need_copy = true;
 
                 if (code_chunk_for_reuse) {
                     code_chunk_shared = code_chunk;
@@ -209,7 +215,7 @@ namespace eka2l1::kernel {
             the_addr_of_data_run = dt_chunk->base(new_foe).ptr_address() + add_offset;
 
             // Confirmed that if data is in ROM, only BSS is reserved
-            std::copy(constant_data.get(), constant_data.get() + data_size, data_base_ptr); // .data
+            data_need_copy = true;
 
             const std::uint32_t bss_off = data_size;
             std::fill(data_base_ptr + bss_off, data_base_ptr + bss_off + bss_size, 0); // .bss
@@ -226,99 +232,185 @@ namespace eka2l1::kernel {
         // Attach all of its dependencies
         for (auto &dependency : dependencies) {
             dependency.dep_->attach(new_foe);
+        }
 
-            // Patch what imports we need
-            if (need_patch_and_reloc) {
-                if ((code_addr && forcefully) || !code_addr) {
-                    for (const std::uint64_t import : dependency.import_info_) {
-                        const std::uint16_t ord = (import & 0xFFFF);
-                        const std::uint16_t adj = (import >> 16) & 0xFFFF;
-                        const std::uint32_t offset_to_apply = (import >> 32) & 0xFFFFFFFF;
-
-                        const address addr = dependency.dep_->lookup(new_foe, ord);
-                        if (!addr) {
-                            LOG_ERROR(KERNEL, "Invalid ordinal {}, requested from {}", ord, dependency.dep_->name());
-                        }
-
-                        *reinterpret_cast<std::uint32_t *>(&code_base_ptr[offset_to_apply]) = addr + adj;
-                    }
-                }
+        using load_clock = std::chrono::steady_clock;
+        const auto elapsed_ns = [](const load_clock::time_point since) -> std::uint64_t {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(load_clock::now() - since).count());
+        };
+
+        load_stats_.attach_count_++;
+
+        // Only RAM-loaded code gets a fresh copy to fix up. ROM code is patched in place
+        const bool image_cacheable = need_patch_and_reloc && (code_addr == 0);
+        const codeseg_image_cache::entry *cached_image = nullptr;
+
+        codeseg_image_key image_key{};
+        codeseg_image_cache &image_cache = kern->get_codeseg_image_cache();
+
+        if (image_cacheable) {
+            image_key = make_image_key(new_foe, the_addr_of_code_run, the_addr_of_data_run);
+            cached_image = image_cache.find(image_key);
+        }
+
+        auto stage_start = load_clock::now();
+
+        if (cached_image) {
+            if (code_need_copy) {
+                std::copy(cached_image->code_.begin(), cached_image->code_.end(), code_base_ptr);
+            }
+
+            if (data_need_copy) {
+                std::copy(cached_image->data_.begin(), cached_image->data_.end(), data_base_ptr);
+            }
+
+            need_patch_and_reloc = false;
+            load_stats_.image_cache_hits_++;
+        } else {
+            if (code_need_copy) {
+                std::copy(code_data.get(), code_data.get() + code_size, code_base_ptr); // .code
+            }
+
+            if (data_need_copy) {
+                std::copy(constant_data.get(), constant_data.get() + data_size, data_base_ptr); // .data
             }
         }
 
+        load_stats_.copy_ns_ += elapsed_ns(stage_start);
+
         if (need_patch_and_reloc) {
+            // Patch what imports we need
+            if ((code_addr && forcefully) || !code_addr) {
+                stage_start = load_clock::now();
+                patch_imports(new_foe, code_base_ptr);
+
+                load_stats_.import_fixup_ns_ += elapsed_ns(stage_start);
+            }
+
             if (!relocation_list.empty()) {
-                const std::uint32_t code_delta = the_addr_of_code_run - code_base;
-                const std::uint32_t data_delta = the_addr_of_data_run - data_base;
+                stage_start = load_clock::now();
+                relocate_image(code_base_ptr, data_base_ptr, the_addr_of_code_run, the_addr_of_data_run);
 
-                // Relocate the image
-                for (const std::uint64_t relocate_info : relocation_list) {
-                    const loader::relocation_type rel_type = static_cast<loader::relocation_type>((relocate_info >> 32) & 0xFFFF);
-                    const std::uint32_t offset_to_relocate = static_cast<std::uint32_t>(relocate_info);
+                load_stats_.relocate_ns_ += elapsed_ns(stage_start);
+            }
 
-                    loader::relocate_section sect_type = static_cast<loader::relocate_section>((relocate_info >> 48) & 0xFFFF);
-                    address the_delta = 0;
+            if (image_cacheable) {
+                image_cache.add(image_key, code_base_ptr, code_size, data_need_copy ? data_base_ptr : nullptr, data_size);
+            }
+        }
 
-                    std::uint8_t *base_ptr = nullptr;
+        if (new_foe)
+            new_foe->codeseg_list.push(&attaches.back()->process_link);
 
-                    switch (sect_type) {
-                    case loader::relocate_section_text:
-                        base_ptr = code_base_ptr;
-                        break;
+        kern->run_codeseg_loaded_callback(obj_name, new_foe, this);
 
-                    case loader::relocate_section_data:
-                        base_ptr = data_base_ptr;
-                        break;
+        return true;
+    }
 
-                    default:
-                        break;
-                    }
+    void codeseg::patch_imports(kernel::process *pr, std::uint8_t *code_base_ptr) {
+        for (auto &dependency : dependencies) {
+            for (const std::uint64_t import : dependency.import_info_) {
+                const std::uint16_t ord = (import & 0xFFFF);
+                const std::uint16_t adj = (import >> 16) & 0xFFFF;
+                const std::uint32_t offset_to_apply = (import >> 32) & 0xFFFFFFFF;
+
+                const address addr = dependency.dep_->lookup(pr, ord);
+                if (!addr) {
+                    LOG_ERROR(KERNEL, "Invalid ordinal {}, requested from {}", ord, dependency.dep_->name());
+                }
 
-                    std::uint32_t *to_relocate_ptr = reinterpret_cast<std::uint32_t *>(&base_ptr[offset_to_relocate]);
+                *reinterpret_cast<std::uint32_t *>(&code_base_ptr[offset_to_apply]) = addr + adj;
+            }
+        }
+    }
 
-                    switch (rel_type) {
-                    case loader::relocation_type::data:
-                        the_delta = data_delta;
-                        break;
+    void codeseg::relocate_image(std::uint8_t *code_base_ptr, std::uint8_t *data_base_ptr, const address code_run_addr,
+        const address data_run_addr) {
+        const std::uint32_t code_delta = code_run_addr - code_base;
+        const std::uint32_t data_delta = data_run_addr - data_base;
 
-                    case loader::relocation_type::text:
-                        the_delta = code_delta;
-                        break;
+        for (const std::uint64_t relocate_info : relocation_list) {
+            const loader::relocation_type rel_type = static_cast<loader::relocation_type>((relocate_info >> 32) & 0xFFFF);
+            const std::uint32_t offset_to_relocate = static_cast<std::uint32_t>(relocate_info);
 
-                    case loader::relocation_type::inferred: {
-                        // This one is harder
-                        std::uint32_t val = *to_relocate_ptr;
+            loader::relocate_section sect_type = static_cast<loader::relocate_section>((relocate_info >> 48) & 0xFFFF);
+            address the_delta = 0;
 
-                        if ((code_base <= val) && (val <= code_base + code_size)) {
-                            the_delta = code_delta;
-                        } else if ((data_base <= val) && (val <= data_base + data_size + bss_size)) {
-                            the_delta = data_delta;
-                        } else {
-                            LOG_ERROR(KERNEL, "Unable to infer the relocation type of offset 0x{:X}", val);
-                        }
+            std::uint8_t *base_ptr = nullptr;
 
-                        break;
-                    }
+            switch (sect_type) {
+            case loader::relocate_section_text:
+                base_ptr = code_base_ptr;
+                break;
 
-                    case loader::relocation_type::reserved:
-                        continue;
+            case loader::relocate_section_data:
+                base_ptr = data_base_ptr;
+                break;
 
-                    default:
-                        LOG_ERROR(KERNEL, "Unknown code relocation type {}", static_cast<std::uint32_t>(rel_type));
-                        break;
-                    }
+            default:
+                break;
+            }
+
+            std::uint32_t *to_relocate_ptr = reinterpret_cast<std::uint32_t *>(&base_ptr[offset_to_relocate]);
+
+            switch (rel_type) {
+            case loader::relocation_type::data:
+                the_delta = data_delta;
+                break;
 
-                    *to_relocate_ptr = *to_relocate_ptr + the_delta;
+            case loader::relocation_type::text:
+                the_delta = code_delta;
+                break;
+
+            case loader::relocation_type::inferred: {
+                // This one is harder
+                std::uint32_t val = *to_relocate_ptr;
+
+                if ((code_base <= val) && (val <= code_base + code_size)) {
+                    the_delta = code_delta;
+                } else if ((data_base <= val) && (val <= data_base + data_size + bss_size)) {
+                    the_delta = data_delta;
+                } else {
+                    LOG_ERROR(KERNEL, "Unable to infer the relocation type of offset 0x{:X}", val);
                 }
+
+                break;
             }
+
+            case loader::relocation_type::reserved:
+                continue;
+
+            default:
+                LOG_ERROR(KERNEL, "Unknown code relocation type {}", static_cast<std::uint32_t>(rel_type));
+                break;
+            }
+
+            *to_relocate_ptr = *to_relocate_ptr + the_delta;
         }
+    }
 
-        if (new_foe)
-            new_foe->codeseg_list.push(&attaches.back()->process_link);
+    codeseg_image_key codeseg::make_image_key(kernel::process *pr, const address code_run_addr, const address data_run_addr) {
+        codeseg_image_key key;
+        key.image_hash_ = get_image_hash();
+        key.code_run_addr_ = code_run_addr;
+        key.data_run_addr_ = data_run_addr;
 
-        kern->run_codeseg_loaded_callback(obj_name, new_foe, this);
+        // Imports resolve to the exports of each dependency where it is loaded in this process
+        XXH64_state_t *state = XXH64_createState();
+        XXH64_reset(state, 0);
 
-        return true;
+        for (auto &dependency : dependencies) {
+            const std::uint64_t dep_hash = dependency.dep_->get_image_hash();
+            const address dep_addrs[2] = { dependency.dep_->get_code_run_addr(pr), dependency.dep_->get_data_run_addr(pr) };
+
+            XXH64_update(state, &dep_hash, sizeof(dep_hash));
+            XXH64_update(state, dep_addrs, sizeof(dep_addrs));
+        }
+
+        key.dependencies_hash_ = XXH64_digest(state);
+        XXH64_freeState(state);
+
+        return key;
     }
 
     bool codeseg::detach(kernel::process *de_foe) {
@@ -698,14 +790,17 @@ namespace eka2l1::kernel {
         }
 
         export_table[ordinal - 1] = address.ptr_address();
+        image_hash_inited_ = false;
     }
 
     void codeseg::set_entry_point(eka2l1::ptr<void> address) {
         ep = address.ptr_address();
+        image_hash_inited_ = false;
     }
 
     void codeseg::set_patched() {
         patched_ = true;
+        image_hash_inited_ = false;
     }
 
     void codeseg::set_entry_point_disabled() {
@@ -744,6 +839,41 @@ namespace eka2l1::kernel {
         XXH32_freeState(state);
     }
 
+    std::uint64_t codeseg::get_image_hash() {
+        if (image_hash_inited_) {
+            return image_hash_;
+        }
+
+        XXH64_state_t *state = XXH64_createState();
+        XXH64_reset(state, 0x5B001101);
+
+        const std::uint32_t layout[] = { code_addr, data_addr, code_base, data_base, code_size, data_size, bss_size,
+            static_cast<std::uint32_t>(patched_) };
+
+        XXH64_update(state, layout, sizeof(layout));
+
+        if (code_data) {
+            XXH64_update(state, code_data.get(), code_size);
+        }
+
+        if (constant_data) {
+            XXH64_update(state, constant_data.get(), data_size);
+        }
+
+        XXH64_update(state, relocation_list.data(), relocation_list.size() * sizeof(std::uint64_t));
+        XXH64_update(state, export_table.data(), export_table.size() * sizeof(std::uint32_t));
+
+        for (auto &dependency : dependencies) {
+            XXH64_update(state, dependency.import_info_.data(), dependency.import_info_.size() * sizeof(std::uint64_t));
+        }
+
+        image_hash_ = XXH64_digest(state);
+        image_hash_inited_ = true;
+
+        XXH64_freeState(state);
+        return image_hash_;
+    }
+
     std::uint32_t codeseg::get_hash() {
         if (!hash_inited_) {
             calculate_hash();
@@ -752,4 +882,56 @@ namespace eka2l1::kernel {
 
         return hash_;
     }
+
+    codeseg_image_cache::codeseg_image_cache(const std::size_t max_size)
+        : total_size_(0)
+        , max_size_(max_size) {
+    }
+
+    const codeseg_image_cache::entry *codeseg_image_cache::find(const codeseg_image_key &key) {
+        auto ite = entries_.find(key);
+        if (ite == entries_.end()) {
+            return nullptr;
+        }
+
+        lru_.splice(lru_.begin(), lru_, ite->second);
+        return &(*ite->second);
+    }
+
+    void codeseg_image_cache::add(const codeseg_image_key &key, const std::uint8_t *code, const std::size_t code_size,
+        const std::uint8_t *data, const std::size_t data_size) {
+        const std::size_t entry_size = code_size + (data ? data_size : 0);
+        if ((entry_size > max_size_) || (entries_.find(key) != entries_.end())) {
+            return;
+        }
+
+        while (!lru_.empty() && (total_size_ + entry_size > max_size_)) {
+            const entry &oldest = lru_.back();
+
+            total_size_ -= oldest.code_.size() + oldest.data_.size();
+            entries_.erase(oldest.key_);
+
+            lru_.pop_back();
+        }
+
+        entry new_entry;
+        new_entry.key_ = key;
+        new_entry.code_.assign(code, code + code_size);
+
+        if (data) {
+            new_entry.data_.assign(data, data + data_size);
+        }
+
+        lru_.push_front(std::move(new_entry));
+        entries_.emplace(key, lru_.begin());
+
+        total_size_ += entry_size;
+    }
+
+    void codeseg_image_cache::clear() {
+        lru_.clear();
+        entries_.clear();
+
+        total_size_ = 0;
+    }
 }
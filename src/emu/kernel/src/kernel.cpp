@@ -63,7 +63,8 @@ namespace eka2l1 {
 
     kernel_system::kernel_system(system *esys, ntimer *timing, io_system *io_sys,
         config::state *old_conf, config::app_settings *settings, loader::rom *rom_info, arm::core *cpu, disasm *disassembler)
-        : btrace_inst_(nullptr)
+        : prop_index_dirty_(false)
+        , btrace_inst_(nullptr)
         , lib_mngr_(nullptr)
         , thr_sch_(nullptr)
         , timing_(timing)
@@ -125,6 +126,10 @@ namespace eka2l1 {
         OBJECT_CONTAINER_CLEANUP(undertakers_);
         OBJECT_CONTAINER_CLEANUP(prop_refs_);
         OBJECT_CONTAINER_CLEANUP(props_);
+
+        prop_index_.clear();
+        unindexed_props_.clear();
+        prop_index_dirty_ = false;
         OBJECT_CONTAINER_CLEANUP(chunks_);
 
         for (std::size_t i = 0; i < msgs_.size(); i++) {
@@ -135,6 +140,8 @@ namespace eka2l1 {
         OBJECT_CONTAINER_CLEANUP(processes_);
         OBJECT_CONTAINER_CLEANUP(libraries_);
         OBJECT_CONTAINER_CLEANUP(codesegs_);
+        codeseg_image_cache_.clear();
+
         OBJECT_CONTAINER_CLEANUP(message_queues_);
         OBJECT_CONTAINER_CLEANUP(logical_channels_);
         OBJECT_CONTAINER_CLEANUP(logical_devices_);
@@ -743,6 +750,11 @@ namespace eka2l1 {
             return true;
         }
 
+        if (obj->get_object_type() == kernel::object_type::prop) {
+            // The index may hold the property under an older identity, so just rebuild it on next lookup
+            prop_index_dirty_ = true;
+        }
+
         switch (obj->get_object_type()) {
 #define OBJECT_SEARCH(obj_type, obj_map)                                                                         \
     case kernel::object_type::obj_type: {                                                                        \
@@ -958,45 +970,91 @@ namespace eka2l1 {
         (msgs_.begin() + msg->id - 1)->reset();
     }
 
-    property_ptr kernel_system::get_prop(int category, int key) {
-        auto prop_res = std::find_if(props_.begin(), props_.end(),
-            [=](const auto &prop_obj) {
-                property_ptr prop = reinterpret_cast<property_ptr>(prop_obj.get());
-                if (prop->first == category && prop->second == key) {
-                    return true;
-                }
+    void kernel_system::rebuild_prop_index() {
+        prop_index_.clear();
+        unindexed_props_.clear();
+        prop_index_dirty_ = false;
 
-                return false;
-            });
+        for (auto &prop_obj : props_) {
+            property_ptr prop = reinterpret_cast<property_ptr>(prop_obj.get());
+            prop_index_.emplace(prop_ident_pair(prop->first, prop->second), prop);
+        }
 
-        if (prop_res == props_.end()) {
-            return property_ptr(nullptr);
+        prop_stats_.index_rebuilds_++;
+    }
+
+    property_ptr kernel_system::find_prop_in_index(const int category, const int key) {
+        prop_stats_.lookups_++;
+
+        if (prop_index_dirty_) {
+            rebuild_prop_index();
+        }
+
+        for (property_ptr prop : unindexed_props_) {
+            prop_index_.emplace(prop_ident_pair(prop->first, prop->second), prop);
+        }
+
+        unindexed_props_.clear();
+
+        auto prop_ite = prop_index_.find(prop_ident_pair(category, key));
+        if (prop_ite == prop_index_.end()) {
+            prop_stats_.misses_++;
+            return nullptr;
         }
 
-        return reinterpret_cast<property_ptr>(prop_res->get());
+        // Identities are only changed through set_prop_identity, which keeps the index up to date
+        assert((prop_ite->second->first == category) && (prop_ite->second->second == key));
+        return prop_ite->second;
+    }
+
+    void kernel_system::set_prop_identity(property_ptr prop, const int category, const int key) {
+        auto prop_ite = prop_index_.find(prop_ident_pair(prop->first, prop->second));
+
+        if ((prop_ite != prop_index_.end()) && (prop_ite->second == prop)) {
+            // Already indexed under its old identity, which another property may share. Rare, start over
+            prop_index_dirty_ = true;
+        }
+
+        prop->first = category;
+        prop->second = key;
+
+        if (!prop_index_dirty_) {
+            prop_index_.emplace(prop_ident_pair(category, key), prop);
+        }
+    }
+
+    property_ptr kernel_system::get_prop(int category, int key) {
+        return find_prop_in_index(category, key);
     }
 
     property_ptr kernel_system::delete_prop(int category, int key) {
-        auto prop_res = std::find_if(props_.begin(), props_.end(),
-            [=](const auto &prop_obj) {
-                property_ptr prop = reinterpret_cast<property_ptr>(prop_obj.get());
-                if (prop->first == category && prop->second == key) {
-                    return true;
-                }
+        property_ptr prop_ptr = find_prop_in_index(category, key);
+        if (!prop_ptr) {
+            return property_ptr(nullptr);
+        }
 
-                return false;
-            });
+        // Container is sorted by unique ID, same as the other kernel objects
+        auto prop_res = std::lower_bound(props_.begin(), props_.end(), prop_ptr, [](const auto &lhs, const auto &rhs) {
+            return lhs->unique_id() < rhs->unique_id();
+        });
 
-        if (prop_res == props_.end()) {
+        if ((prop_res == props_.end()) || (prop_res->get() != prop_ptr)) {
             return property_ptr(nullptr);
         }
 
-        property_ptr prop_ptr = reinterpret_cast<property_ptr>(prop_res->get());
         props_.erase(prop_res);
 
+        // Another property with the same identity may have been shadowed by this one
+        prop_index_dirty_ = true;
+
         return prop_ptr;
     }
 
+    void kernel_system::record_prop_notification(const std::size_t subscriber_count) {
+        prop_stats_.notifications_++;
+        prop_stats_.notified_subscribers_ += subscriber_count;
+    }
+
     kernel::handle kernel_system::mirror(kernel::thread *own_thread, kernel::handle handle, kernel::owner_type owner) {
         kernel_obj_ptr target_obj = get_kernel_obj_raw(handle, crr_thread());
         kernel::handle_inspect_info info = kernel::inspect_handle(handle);
@@ -48,14 +48,17 @@
 namespace eka2l1::hle {
     // Given relocation entries, relocate the code and data
     static bool build_relocation_list(const std::vector<loader::e32_reloc_entry> &entries, std::vector<std::uint64_t> &relocation_list, const loader::relocate_section sect) {
-        for (std::uint32_t i = 0; i < entries.size(); i++) {
-            const loader::e32_reloc_entry &entry = entries[i];
-
+        for (const loader::e32_reloc_entry &entry : entries) {
             for (const auto &rel_info : entry.rels_info) {
                 // Get the lower 12 bit for virtual_address
                 const std::uint32_t virtual_addr = entry.base + (rel_info & 0x0FFF);
                 loader::relocation_type rel_type = static_cast<loader::relocation_type>(rel_info & 0xF000);
 
+                // Padding to keep blocks word-aligned, there is nothing to apply
+                if (rel_type == loader::relocation_type::reserved) {
+                    continue;
+                }
+
                 relocation_list.push_back((virtual_addr) | (static_cast<std::uint64_t>(rel_type) << 32) | (static_cast<std::uint64_t>(sect) << 48));
             }
         }
@@ -64,6 +67,17 @@ namespace eka2l1::hle {
     }
 
     static bool build_relocation_list(std::vector<std::uint64_t> &relocation_list, loader::e32img *img) {
+        std::size_t total_entries = 0;
+        for (const loader::e32_reloc_entry &entry : img->code_reloc_section.entries) {
+            total_entries += entry.rels_info.size();
+        }
+
+        for (const loader::e32_reloc_entry &entry : img->data_reloc_section.entries) {
+            total_entries += entry.rels_info.size();
+        }
+
+        relocation_list.reserve(relocation_list.size() + total_entries);
+
         if (!build_relocation_list(img->code_reloc_section.entries, relocation_list, loader::relocate_section::relocate_section_text)) {
             return false;
         }
@@ -127,8 +127,15 @@ namespace eka2l1 {
         }
 
         void property::notify_request(const std::int32_t err) {
+            std::size_t subscriber_count = 0;
+
             while (auto subscription = subscription_queue.pop()) {
                 subscription.value()->complete(err);
+                subscriber_count++;
+            }
+
+            if (kern) {
+                kern->record_prop_notification(subscriber_count);
             }
         }
 
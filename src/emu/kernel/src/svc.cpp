@@ -2511,8 +2511,7 @@ namespace eka2l1::epoc {
                 return epoc::error_general;
             }
 
-            prop->first = cage;
-            prop->second = val;
+            kern->set_prop_identity(prop, cage, val);
         }
 
         auto property_ref_handle_and_obj = kern->create_and_add<service::property_reference>(
@@ -2560,8 +2559,7 @@ namespace eka2l1::epoc {
                 return epoc::error_general;
             }
 
-            prop->first = cage;
-            prop->second = key;
+            kern->set_prop_identity(prop, cage, key);
         }
 
         prop->define(prop_type, info->size);
@@ -4504,8 +4502,7 @@ namespace eka2l1::epoc {
                 return epoc::error_general;
             }
 
-            prop->first = create_info->arg0_;
-            prop->second = create_info->arg1_;
+            kern->set_prop_identity(prop, create_info->arg0_, create_info->arg1_);
         }
 
         prop->define(static_cast<service::property_type>(create_info->arg2_), create_info->arg3_);
@@ -4531,8 +4528,7 @@ namespace eka2l1::epoc {
                 return epoc::error_general;
             }
 
-            prop->first = create_info->arg1_;
-            prop->second = create_info->arg2_;
+            kern->set_prop_identity(prop, create_info->arg1_, create_info->arg2_);
         }
 
         auto property_ref_handle_and_obj = kern->create_and_add<service::property_reference>(
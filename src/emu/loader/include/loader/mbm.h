@@ -74,6 +74,16 @@ namespace eka2l1::loader {
         bool do_read_headers();
         bool valid();
 
+        /**
+         * @brief       Load the header of a bitmap that was not requested when the headers were read.
+         *
+         * The trailer must already be read by do_read_headers.
+         *
+         * @param       index         The index of the bitmap to load the header of.
+         * @returns     True on success, or if the header was already loaded.
+         */
+        bool load_header(const std::size_t index);
+
         mbm_file(common::ro_stream *stream)
             : stream(stream) {
         }
@@ -125,5 +135,8 @@ namespace eka2l1::loader {
          * \returns     The offset in bytes from the beginning of the file.
          */
         std::size_t bitmap_data_offset(const std::size_t index);
+
+    private:
+        bool do_load_header(const std::size_t index);
     };
 }
@@ -28,6 +28,7 @@
 
 namespace eka2l1::common {
     class ro_stream;
+    class file_write_pool;
 }
 
 namespace eka2l1::loader {
@@ -78,5 +79,11 @@ namespace eka2l1::loader {
         bool read(common::ro_stream &stream, const int version);
     };
 
-    bool dump_rofs_system(common::ro_stream &stream, const std::string &path, progress_changed_callback progress_cb, cancel_requested_callback cancel_cb);
+    /**
+     * @brief Extract all files of a ROFS image to a host folder.
+     *
+     * @param writer    Pool to write the files on. If null, one is created for this call only.
+     */
+    bool dump_rofs_system(common::ro_stream &stream, const std::string &path, progress_changed_callback progress_cb, cancel_requested_callback cancel_cb,
+        common::file_write_pool *writer = nullptr);
 }
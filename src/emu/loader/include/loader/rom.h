@@ -26,12 +26,14 @@
 #include <cstdint>
 #include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace eka2l1 {
     namespace common {
         class ro_stream;
         class wo_stream;
+        class file_write_pool;
     }
 
     namespace loader {
@@ -225,7 +227,29 @@ namespace eka2l1 {
 
             root_dir_list root;
 
+            // Case-folded full path (without drive) to the burned file and directory. These point into the tree
+            // above, which is why the ROM can be moved but not copied.
+            std::unordered_map<std::u16string, loader::rom_entry *> file_index;
+            std::unordered_map<std::u16string, loader::rom_dir *> dir_index;
+
+            rom() = default;
+            rom(const rom &) = delete;
+            rom(rom &&) = default;
+
+            rom &operator=(const rom &) = delete;
+            rom &operator=(rom &&) = default;
+
+            /**
+             * @brief Build the path index of the burn tree, to speed up lookups.
+             *
+             * Must be called again if the tree is modified. ROMs returned by load_rom already have the index built.
+             */
+            void build_path_index();
+
+            loader::rom_dir *burn_tree_find_dir(const std::u16string &vir_path);
             loader::rom_dir *burn_tree_find_dir(const std::string &vir_path);
+
+            std::optional<loader::rom_entry> burn_tree_find_entry(const std::u16string &vir_path);
             std::optional<loader::rom_entry> burn_tree_find_entry(const std::string &vir_path);
         };
 
@@ -248,7 +272,16 @@ namespace eka2l1 {
          * @returns 0 on nothing happens, > 0 on success, < 0 on error.
          */
         int defrag_rom(common::ro_stream *stream, common::wo_stream *dest_stream);
+        /**
+         * @brief Extract all files burned into a ROM to a host folder.
+         *
+         * @param stream        The ROM binary stream.
+         * @param dest_base     Host folder to extract files to.
+         * @param writer        Pool to write the files on. If null, one is created for this call only.
+         *
+         * @returns True on success.
+         */
         bool dump_rom_files(common::ro_stream *stream, const std::string &dest_base, progress_changed_callback progress_cb = nullptr,
-            cancel_requested_callback cancel_cb = nullptr);
+            cancel_requested_callback cancel_cb = nullptr, common::file_write_pool *writer = nullptr);
     }
 }
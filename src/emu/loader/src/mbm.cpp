@@ -52,6 +52,46 @@ namespace eka2l1::loader {
         return (trailer.count > 0) && (index < trailer.count) && (trailer.sbm_offsets[index]);
     }
 
+    bool mbm_file::do_load_header(const std::size_t index) {
+        stream->seek(header.trailer_off + (index + 1) * 4, common::seek_where::beg);
+
+        if (stream->read(&trailer.sbm_offsets[index], 4) != 4) {
+            return false;
+        }
+
+        // Remember the current offset first
+        if (is_rom_version) {
+            stream->seek(trailer.sbm_offsets[index] + 5 * sizeof(std::uint32_t), common::seek_where::beg);
+        } else {
+            stream->seek(trailer.sbm_offsets[index], common::seek_where::beg);
+        }
+
+        if (!sbm_headers[index].internalize(*stream)) {
+            return false;
+        }
+
+        return true;
+    }
+
+    bool mbm_file::load_header(const std::size_t index) {
+        if (index >= trailer.count) {
+            return false;
+        }
+
+        if (!is_header_loaded(index) && !do_load_header(index)) {
+            return false;
+        }
+
+        // The data size of a ROM bitmap is calculated from the offset of the next one
+        if (is_rom_version && ((index + 1) < trailer.sbm_offsets.size()) && !is_header_loaded(index + 1)) {
+            if (!do_load_header(index + 1)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
     bool mbm_file::do_read_headers() {
         if (stream->read(&header, sizeof(uint32_t)) != sizeof(uint32_t)) {
             return false;
@@ -84,27 +124,6 @@ namespace eka2l1::loader {
 
         sbm_headers.resize(trailer.count);
 
-        auto do_load_header = [this](const std::size_t index) {
-            stream->seek(header.trailer_off + (index + 1) * 4, common::seek_where::beg);
-
-            if (stream->read(&trailer.sbm_offsets[index], 4) != 4) {
-                return false;
-            }
-
-            // Remember the current offset first
-            if (is_rom_version) {
-                stream->seek(trailer.sbm_offsets[index] + 5 * sizeof(std::uint32_t), common::seek_where::beg);
-            } else {
-                stream->seek(trailer.sbm_offsets[index], common::seek_where::beg);
-            }
-
-            if (!sbm_headers[index].internalize(*stream)) {
-                return false;
-            }
-
-            return true;
-        };
-
         if (index_to_loads.empty()) {
             for (std::size_t i = 0; i < trailer.sbm_offsets.size(); i++) {
                 if (!do_load_header(i))
@@ -112,14 +131,9 @@ namespace eka2l1::loader {
             }
         } else {
             for (const std::size_t i : index_to_loads) {
-                if (!do_load_header(i))
+                // Invalid indexes are reported by is_header_loaded later
+                if ((i < trailer.count) && !load_header(i))
                     return false;
-
-                if (is_rom_version && ((i + 1) < trailer.sbm_offsets.size())) {
-                    if (!do_load_header(i + 1)) {
-                        return false;
-                    }
-                }
             }
 
             index_to_loads.clear();
@@ -19,12 +19,15 @@
 
 #include <common/buffer.h>
 #include <common/fileutils.h>
+#include <common/filewriter.h>
 #include <common/log.h>
 #include <common/path.h>
 #include <loader/rofs.h>
 
 #include <common/cvt.h>
 
+#include <memory>
+
 namespace eka2l1::loader {
     bool rofs_entry::read(common::ro_stream &stream, const int version) {
         const std::uint64_t start_pos = stream.tell();
@@ -118,7 +121,7 @@ namespace eka2l1::loader {
         return true;
     }
 
-    static bool extract_file(common::ro_stream &stream, rofs_entry &entry, const std::string &base,
+    static bool extract_file(common::ro_stream &stream, common::file_write_pool &writer, rofs_entry &entry, const std::string &base,
         const int file_offset, progress_changed_callback progress_cb, cancel_requested_callback cancel_cb, std::size_t &max_pos) {
         std::string fname = common::ucs2_to_utf8(entry.filename_);
         if (common::is_platform_case_sensitive()) {
@@ -126,28 +129,36 @@ namespace eka2l1::loader {
         }
 
         fname = add_path(base, fname);
-        std::ofstream extract_stream(fname, std::ios_base::binary);
+        const std::size_t out_handle = writer.begin_file(fname);
 
         const std::uint64_t org_pos = stream.tell();
         stream.seek(entry.file_addr_ - file_offset, common::seek_where::beg);
 
         static constexpr std::uint32_t CHUNK_SIZE = 0x10000;
-        std::vector<char> buf;
 
         std::int64_t size_left = static_cast<std::int64_t>(entry.file_size_);
+        bool result = true;
+
         while (size_left > 0) {
             if (cancel_cb && cancel_cb()) {
-                return false;
+                result = false;
+                break;
             }
 
             const std::uint32_t size_to_take = common::min<std::uint32_t>(static_cast<std::uint32_t>(size_left),
                 CHUNK_SIZE);
 
-            buf.resize(size_to_take);
+            std::vector<std::uint8_t> buf(size_to_take);
 
             const std::uint64_t amount_read = stream.read(buf.data(), size_to_take);
             if (amount_read < size_to_take) {
-                LOG_WARN(LOADER, "Can't read {} bytes, skipping", size_to_take - amount_read);
+                LOG_WARN(LOADER, "Can't read {} bytes, skipping the rest of the file", size_to_take - amount_read);
+
+                buf.resize(static_cast<std::size_t>(amount_read));
+                writer.write(out_handle, std::move(buf));
+
+                result = false;
+                break;
             }
 
             if (progress_cb) {
@@ -155,15 +166,18 @@ namespace eka2l1::loader {
                 progress_cb(max_pos, stream.size());
             }
 
-            extract_stream.write(buf.data(), size_to_take);
+            writer.write(out_handle, std::move(buf));
             size_left -= size_to_take;
         }
 
+        // The pool keeps the file open until it is ended, whatever stopped the extraction
+        writer.end_file(out_handle);
+
         stream.seek(org_pos, common::seek_where::beg);
-        return true;
+        return result;
     }
 
-    static bool extract_directory(common::ro_stream &stream, const std::string &base,
+    static bool extract_directory(common::ro_stream &stream, common::file_write_pool &writer, const std::string &base,
         const int version, const int file_offset, const std::uint32_t offset,
         progress_changed_callback progress_cb, cancel_requested_callback cancel_cb, std::size_t &max_pos) {
         common::create_directories(base);
@@ -188,7 +202,7 @@ namespace eka2l1::loader {
                     return false;
                 }
 
-                if (!extract_file(stream, file_entry, base, file_offset, progress_cb, cancel_cb, max_pos)) {
+                if (!extract_file(stream, writer, file_entry, base, file_offset, progress_cb, cancel_cb, max_pos)) {
                     LOG_ERROR(LOADER, "Fail to extract file with name: {}", common::ucs2_to_utf8(file_entry.filename_));
                 }
             }
@@ -200,7 +214,7 @@ namespace eka2l1::loader {
                 subdir_name = common::lowercase_string(subdir_name);
             }
 
-            if (!extract_directory(stream, eka2l1::add_path(base, subdir_name + eka2l1::get_separator()),
+            if (!extract_directory(stream, writer, eka2l1::add_path(base, subdir_name + eka2l1::get_separator()),
                     version, file_offset, subdir_ent.file_addr_, progress_cb, cancel_cb, max_pos)) {
                 return false;
             }
@@ -219,7 +233,8 @@ namespace eka2l1::loader {
         return false;
     }
 
-    bool dump_rofs_system(common::ro_stream &stream, const std::string &path, progress_changed_callback progress_cb, cancel_requested_callback cancel_cb) {
+    bool dump_rofs_system(common::ro_stream &stream, const std::string &path, progress_changed_callback progress_cb, cancel_requested_callback cancel_cb,
+        common::file_write_pool *writer) {
         rofs_header rheader;
         if (stream.read(&rheader, sizeof(rofs_header)) != sizeof(rofs_header)) {
             return false;
@@ -237,10 +252,17 @@ namespace eka2l1::loader {
         int file_offset = rheader.dir_tree_offset_ - rheader.header_size_;
         std::size_t max_pos = 0;
 
-        const bool result = extract_directory(stream, path, rheader.rofs_format_version_, file_offset, rheader.dir_tree_offset_,
+        std::unique_ptr<common::file_write_pool> own_writer;
+
+        if (!writer) {
+            own_writer = std::make_unique<common::file_write_pool>();
+            writer = own_writer.get();
+        }
+
+        const bool result = extract_directory(stream, *writer, path, rheader.rofs_format_version_, file_offset, rheader.dir_tree_offset_,
             progress_cb, cancel_cb, max_pos);
 
-        if (!result) {
+        if (!result || (own_writer && !own_writer->finish())) {
             return false;
         }
 
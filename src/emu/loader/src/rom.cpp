@@ -23,68 +23,113 @@
 #include <common/bytepair.h>
 #include <common/cvt.h>
 #include <common/fileutils.h>
+#include <common/filewriter.h>
 #include <common/log.h>
 #include <common/path.h>
 
 #include <loader/rom.h>
 
+#include <cwctype>
+#include <memory>
+
 namespace eka2l1::loader {
     enum class file_attrib {
         dir = 0x0010
     };
 
-    loader::rom_dir *rom::burn_tree_find_dir(const std::string &vir_path) {
-        auto ite = path_iterator(vir_path);
-        loader::rom_dir *last_dir_found = &(root.root_dirs[0].dir);
+    /**
+     * @brief Turn a virtual path into the form used as key by the path index.
+     *
+     * The drive is dropped, separators are unified and collapsed, trailing separators removed and all
+     * characters lowered, so that "Z:/Sys//Bin/" and "z:\\sys\\bin" give the same key.
+     */
+    static std::u16string make_rom_index_key(const std::u16string &vir_path) {
+        std::size_t start = 0;
+
+        if ((vir_path.length() >= 2) && (vir_path[1] == u':')) {
+            start = 2;
+        }
 
-        // Skip through the drive
-        ite++;
+        std::u16string key;
+        key.reserve(vir_path.length() - start + 1);
 
-        std::vector<std::string> components;
+        for (std::size_t i = start; i < vir_path.length(); i++) {
+            const char16_t c = vir_path[i];
 
-        for (; ite; ite++) {
-            components.push_back(*ite);
-        }
+            if ((c == u'\\') || (c == u'/')) {
+                if (key.empty() || (key.back() != u'\\')) {
+                    key.push_back(u'\\');
+                }
 
-        if (components.size() == 0) {
-            return nullptr;
+                continue;
+            }
+
+            if (key.empty()) {
+                key.push_back(u'\\');
+            }
+
+            key.push_back(static_cast<char16_t>(std::towlower(c)));
         }
 
-        for (std::size_t i = 0; i < components.size(); i++) {
-            loader::rom_dir temp;
-            temp.name = common::utf8_to_ucs2(components[i]);
+        while (!key.empty() && (key.back() == u'\\')) {
+            key.pop_back();
+        }
 
-            auto res1 = std::lower_bound(last_dir_found->subdirs.begin(), last_dir_found->subdirs.end(), temp,
-                [](const loader::rom_dir &lhs, const loader::rom_dir &rhs) { return common::compare_ignore_case(lhs.name, rhs.name) == -1; });
+        return key;
+    }
 
-            if (res1 != last_dir_found->subdirs.end() && (common::compare_ignore_case(res1->name, temp.name) == 0)) {
-                last_dir_found = &(last_dir_found->subdirs[std::distance(last_dir_found->subdirs.begin(), res1)]);
-            } else {
-                return nullptr;
+    static void index_rom_dir(rom &romf, rom_dir &dir, const std::u16string &dir_key) {
+        for (auto &entry : dir.entries) {
+            if (!entry.dir) {
+                romf.file_index.emplace(dir_key + u'\\' + common::lowercase_ucs2_string(entry.name), &entry);
             }
         }
 
-        return last_dir_found;
+        for (auto &subdir : dir.subdirs) {
+            const std::u16string subdir_key = dir_key + u'\\' + common::lowercase_ucs2_string(subdir.name);
+
+            romf.dir_index.emplace(subdir_key, &subdir);
+            index_rom_dir(romf, subdir, subdir_key);
+        }
     }
 
-    std::optional<loader::rom_entry> rom::burn_tree_find_entry(const std::string &vir_path) {
-        loader::rom_dir *last_dir_found = burn_tree_find_dir(eka2l1::file_directory(vir_path, true));
+    void rom::build_path_index() {
+        file_index.clear();
+        dir_index.clear();
 
-        if (!last_dir_found) {
-            return std::nullopt;
+        if (root.root_dirs.empty()) {
+            return;
         }
 
-        loader::rom_entry temp_entry;
-        temp_entry.name = common::utf8_to_ucs2(eka2l1::filename(vir_path, true));
+        index_rom_dir(*this, root.root_dirs[0].dir, u"");
+    }
 
-        auto res2 = std::lower_bound(last_dir_found->entries.begin(), last_dir_found->entries.end(), temp_entry,
-            [](const loader::rom_entry &lhs, const loader::rom_entry &rhs) { return common::compare_ignore_case(lhs.name, rhs.name) == -1; });
+    loader::rom_dir *rom::burn_tree_find_dir(const std::u16string &vir_path) {
+        auto ite = dir_index.find(make_rom_index_key(vir_path));
 
-        if (res2 != last_dir_found->entries.end() && !res2->dir && (common::compare_ignore_case(temp_entry.name, res2->name) == 0)) {
-            return *res2;
+        if (ite == dir_index.end()) {
+            return nullptr;
         }
 
-        return std::nullopt;
+        return ite->second;
+    }
+
+    loader::rom_dir *rom::burn_tree_find_dir(const std::string &vir_path) {
+        return burn_tree_find_dir(common::utf8_to_ucs2(vir_path));
+    }
+
+    std::optional<loader::rom_entry> rom::burn_tree_find_entry(const std::u16string &vir_path) {
+        auto ite = file_index.find(make_rom_index_key(vir_path));
+
+        if (ite == file_index.end()) {
+            return std::nullopt;
+        }
+
+        return *ite->second;
+    }
+
+    std::optional<loader::rom_entry> rom::burn_tree_find_entry(const std::string &vir_path) {
+        return burn_tree_find_entry(common::utf8_to_ucs2(vir_path));
     }
 
     uint32_t rom_to_offset(address romstart, address off) {
@@ -284,7 +329,10 @@ namespace eka2l1::loader {
 
         romf.root = read_root_dir_list(romf, stream);
 
-        return romf;
+        std::optional<rom> result = std::move(romf);
+        result->build_path_index();
+
+        return result;
     }
 
     int defrag_rom(common::ro_stream *stream, common::wo_stream *dest_stream) {
@@ -384,8 +432,8 @@ namespace eka2l1::loader {
         return 1;
     }
 
-    static bool dump_rom_file(common::ro_stream *stream, rom_entry &entry, const std::string &path_base, const std::uint32_t rom_base,
-        std::size_t &passed_size, progress_changed_callback progress_cb, cancel_requested_callback cancel_cb) {
+    static bool dump_rom_file(common::ro_stream *stream, common::file_write_pool &writer, rom_entry &entry, const std::string &path_base,
+        const std::uint32_t rom_base, std::size_t &passed_size, progress_changed_callback progress_cb, cancel_requested_callback cancel_cb) {
         std::u16string fname = entry.name;
         if (common::is_platform_case_sensitive()) {
             fname = common::lowercase_ucs2_string(fname);
@@ -393,24 +441,23 @@ namespace eka2l1::loader {
 
         fname = eka2l1::add_path(common::utf8_to_ucs2(path_base), fname);
 
-        common::wo_std_file_stream file_out_stream(common::ucs2_to_utf8(fname), true);
+        const std::size_t out_handle = writer.begin_file(common::ucs2_to_utf8(fname));
         stream->seek(entry.address_lin - rom_base, common::seek_where::beg);
 
         static constexpr std::int64_t MAX_CHUNK_SIZE = 0x10000;
         std::int64_t size_left = static_cast<std::int64_t>(entry.size);
 
-        std::vector<char> buf;
-
         while (size_left > 0) {
             if (cancel_cb && cancel_cb()) {
+                writer.end_file(out_handle);
                 return false;
             }
 
             const std::int64_t size_take = common::min(MAX_CHUNK_SIZE, size_left);
-            buf.resize(size_take);
+            std::vector<std::uint8_t> buf(static_cast<std::size_t>(size_take));
 
             stream->read(buf.data(), buf.size());
-            file_out_stream.write(buf.data(), buf.size());
+            writer.write(out_handle, std::move(buf));
 
             passed_size += size_take;
             if (progress_cb) {
@@ -420,16 +467,17 @@ namespace eka2l1::loader {
             size_left -= size_take;
         }
 
+        writer.end_file(out_handle);
         return true;
     }
 
-    static bool dump_rom_directory(common::ro_stream *stream, rom_dir &dir, std::string base, std::uint32_t rom_base,
-        std::size_t &passed_size, progress_changed_callback progress_cb, cancel_requested_callback cancel_cb) {
+    static bool dump_rom_directory(common::ro_stream *stream, common::file_write_pool &writer, rom_dir &dir, std::string base,
+        std::uint32_t rom_base, std::size_t &passed_size, progress_changed_callback progress_cb, cancel_requested_callback cancel_cb) {
         common::create_directories(base);
 
         for (auto &entry : dir.entries) {
             if (!(entry.attrib & 0x10) && (entry.size != 0)) {
-                if (!dump_rom_file(stream, entry, base, rom_base, passed_size, progress_cb, cancel_cb)) {
+                if (!dump_rom_file(stream, writer, entry, base, rom_base, passed_size, progress_cb, cancel_cb)) {
                     return false;
                 }
             }
@@ -444,7 +492,7 @@ namespace eka2l1::loader {
                 new_base = eka2l1::add_path(base, common::ucs2_to_utf8(subdir.name));
             }
 
-            if (!dump_rom_directory(stream, subdir, new_base, rom_base, passed_size, progress_cb, cancel_cb)) {
+            if (!dump_rom_directory(stream, writer, subdir, new_base, rom_base, passed_size, progress_cb, cancel_cb)) {
                 return false;
             }
         }
@@ -452,20 +500,32 @@ namespace eka2l1::loader {
         return true;
     }
 
-    bool dump_rom_files(common::ro_stream *stream, const std::string &dest_base, progress_changed_callback progress_cb, cancel_requested_callback cancel_cb) {
+    bool dump_rom_files(common::ro_stream *stream, const std::string &dest_base, progress_changed_callback progress_cb, cancel_requested_callback cancel_cb,
+        common::file_write_pool *writer) {
         std::optional<rom> rom_parse_result = load_rom(stream);
         if (!rom_parse_result.has_value()) {
             return false;
         }
 
+        std::unique_ptr<common::file_write_pool> own_writer;
+
+        if (!writer) {
+            own_writer = std::make_unique<common::file_write_pool>();
+            writer = own_writer.get();
+        }
+
         std::size_t passed_size = 0;
 
         for (root_dir &rdir : rom_parse_result->root.root_dirs) {
-            if (!dump_rom_directory(stream, rdir.dir, dest_base, rom_parse_result->header.rom_base, passed_size, progress_cb, cancel_cb)) {
+            if (!dump_rom_directory(stream, *writer, rdir.dir, dest_base, rom_parse_result->header.rom_base, passed_size, progress_cb, cancel_cb)) {
                 return false;
             }
         }
 
+        if (own_writer && !own_writer->finish()) {
+            return false;
+        }
+
         if (progress_cb)
             progress_cb(1, 1);
 
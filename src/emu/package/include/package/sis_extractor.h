@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <common/types.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace eka2l1 {
+    namespace common {
+        class ro_stream;
+    }
+
+    namespace loader {
+        struct sis_data;
+        struct sis_compressed;
+
+        /**
+         * \brief Extract file data from a SIS package to host files.
+         *
+         * Data is inflated and written in bounded chunks, so memory usage does not depend on the size of
+         * the files. Files are extracted in parallel on a set of worker threads. Reading from the package
+         * stream is serialized, but decompression and writing are not.
+         *
+         * Progress and cancel callbacks are only ever called on the thread calling extract().
+         */
+        class sis_extractor {
+        public:
+            struct target {
+                std::string file_path_; ///< UTF-8 path of the host file to write to.
+                std::uint32_t data_index_; ///< Index of the file data in the data unit.
+                std::uint16_t data_unit_index_; ///< Index of the data unit in the SIS data.
+            };
+
+        private:
+            common::ro_stream *stream_;
+            sis_data *data_;
+
+            std::mutex stream_lock_;
+            std::atomic<std::uint64_t> extracted_size_;
+            std::atomic<bool> stop_;
+
+            progress_changed_callback progress_cb_;
+            cancel_requested_callback cancel_cb_;
+            std::uint64_t total_size_;
+
+            sis_compressed *get_compressed(const target &info);
+
+            /**
+             * \brief Extract one file.
+             *
+             * \param info              The file to extract.
+             * \param report_inline     True if progress and cancel callbacks should be called from this function.
+             *
+             * \returns True on success.
+             */
+            bool extract_one(const target &info, const bool report_inline);
+            void report_progress();
+
+        public:
+            explicit sis_extractor(common::ro_stream *stream, sis_data *data);
+
+            /**
+             * \brief Extract the given files.
+             *
+             * If the same file is targeted multiple times, only the last target is extracted, which is
+             * the same result as extracting all of them in order.
+             *
+             * On failure or cancellation, all files written so far are removed.
+             *
+             * \param targets       The files to extract.
+             * \param progress_cb   Callback receiving the number of bytes extracted and the total. Can be null.
+             * \param cancel_cb     Callback returning true if extraction should stop. Can be null.
+             * \param worker_count  Number of threads to extract on. Zero means the number of host cores.
+             *
+             * \returns True if all files were extracted.
+             */
+            bool extract(const std::vector<target> &targets, progress_changed_callback progress_cb = nullptr,
+                cancel_requested_callback cancel_cb = nullptr, std::size_t worker_count = 0);
+        };
+    }
+}
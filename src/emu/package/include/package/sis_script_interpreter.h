@@ -30,6 +30,7 @@
 
 #include <loader/sis_fields.h>
 #include <package/manager.h>
+#include <package/sis_extractor.h>
 
 namespace eka2l1 {
     class system;
@@ -65,15 +66,7 @@ namespace eka2l1 {
             std::stack<sis_controller *> current_controllers;
             std::vector<std::u16string> gathered_sis_paths;
 
-            struct extract_target_info {
-                std::string file_path_;
-                std::uint32_t data_unit_index_;
-                std::uint16_t data_unit_block_index_;
-            };
-
-            std::vector<extract_target_info> extract_targets;
-            std::size_t extract_target_accumulated_size;
-            std::size_t extract_target_decomped_size;
+            std::vector<sis_extractor::target> extract_targets;
 
             progress_changed_callback progress_changed_cb;
             cancel_requested_callback cancel_cb;
@@ -119,17 +112,6 @@ namespace eka2l1 {
              */
             std::vector<uint8_t> get_small_file_buf(uint32_t data_idx, uint16_t crr_blck_idx);
 
-            /**
-             * \brief Get the data in the index of a buffer block in the SIS, write it to a physical file.
-             * 
-             * Usually uses for extracting large app data.
-             * 
-             * \param path          UTF-8 path to the physical file.
-             * \param data_idx      The index of the source buffer in block buffer.
-             * \param crr_block_idx The block index..
-             */
-            bool extract_file(const std::string &path, const uint32_t idx, uint16_t crr_blck_idx);
-
         public:
             show_text_func show_text; ///< Hook function to display texts.
             choose_lang_func choose_lang; ///< Hook function to choose controller's language.
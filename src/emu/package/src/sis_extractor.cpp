@@ -0,0 +1,353 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <common/algorithm.h>
+#include <common/buffer.h>
+#include <common/fileutils.h>
+#include <common/log.h>
+#include <common/path.h>
+
+#include <loader/sis_fields.h>
+#include <package/sis_extractor.h>
+
+#include <miniz.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+
+namespace eka2l1::loader {
+    // Keep both small, each worker holds one of each
+    static constexpr std::size_t EXTRACT_READ_CHUNK_SIZE = 0x10000;
+    static constexpr std::size_t EXTRACT_INFLATE_CHUNK_SIZE = 0x40000;
+
+    sis_extractor::sis_extractor(common::ro_stream *stream, sis_data *data)
+        : stream_(stream)
+        , data_(data)
+        , extracted_size_(0)
+        , stop_(false)
+        , total_size_(0) {
+    }
+
+    sis_compressed *sis_extractor::get_compressed(const target &info) {
+        if (info.data_unit_index_ >= data_->data_units.fields.size()) {
+            return nullptr;
+        }
+
+        sis_data_unit *data_unit = reinterpret_cast<sis_data_unit *>(data_->data_units.fields[info.data_unit_index_].get());
+
+        if (info.data_index_ >= data_unit->data_unit.fields.size()) {
+            return nullptr;
+        }
+
+        return &reinterpret_cast<sis_file_data *>(data_unit->data_unit.fields[info.data_index_].get())->raw_data;
+    }
+
+    void sis_extractor::report_progress() {
+        if (!progress_cb_) {
+            return;
+        }
+
+        if (total_size_ != 0) {
+            progress_cb_(static_cast<std::size_t>(extracted_size_.load()), static_cast<std::size_t>(total_size_));
+        } else {
+            progress_cb_(100, 100);
+        }
+    }
+
+    bool sis_extractor::extract_one(const target &info, const bool report_inline) {
+        if ((info.data_unit_index_ < data_->data_units.fields.size())
+            && reinterpret_cast<sis_data_unit *>(data_->data_units.fields[info.data_unit_index_].get())->data_unit.fields.empty()) {
+            // Stub sis without file data
+            return true;
+        }
+
+        sis_compressed *compressed = get_compressed(info);
+
+        if (!compressed) {
+            LOG_ERROR(PACKAGE, "File data index {} out of range for {}", info.data_index_, info.file_path_);
+            return false;
+        }
+
+        const bool deflated = (compressed->algorithm == sis_compressed_algorithm::deflated);
+
+        std::uint64_t left = ((compressed->len_low) | (static_cast<std::uint64_t>(compressed->len_high) << 32)) - 12;
+        std::uint64_t read_offset = compressed->offset;
+
+        std::vector<std::uint8_t> read_chunk(static_cast<std::size_t>(common::min<std::uint64_t>(left, EXTRACT_READ_CHUNK_SIZE)));
+        std::vector<std::uint8_t> inflated_chunk;
+
+        mz_stream stream;
+        std::memset(&stream, 0, sizeof(mz_stream));
+
+        if (deflated) {
+            inflated_chunk.resize(EXTRACT_INFLATE_CHUNK_SIZE);
+
+            if (inflateInit(&stream) != MZ_OK) {
+                LOG_ERROR(PACKAGE, "Can not intialize inflate stream");
+                return false;
+            }
+        }
+
+        std::uint64_t total_inflated_size = 0;
+        bool result = true;
+        bool stream_ended = false;
+
+        {
+            common::wo_std_file_stream std_fstream(info.file_path_, true);
+
+            while ((left > 0) && !stream_ended) {
+                if (report_inline && cancel_cb_ && cancel_cb_()) {
+                    stop_ = true;
+                }
+
+                if (stop_) {
+                    result = false;
+                    break;
+                }
+
+                const std::size_t grab = static_cast<std::size_t>(common::min<std::uint64_t>(left, read_chunk.size()));
+
+                {
+                    const std::lock_guard<std::mutex> guard(stream_lock_);
+                    stream_->seek(read_offset, common::seek_where::beg);
+
+                    if (stream_->read(read_chunk.data(), grab) != grab) {
+                        LOG_ERROR(PACKAGE, "Stream fail, skipping this file, should report to developers.");
+                        result = false;
+                        break;
+                    }
+                }
+
+                read_offset += grab;
+                left -= grab;
+
+                if (!deflated) {
+                    std_fstream.write(read_chunk.data(), grab);
+                    extracted_size_ += grab;
+                } else {
+                    stream.next_in = read_chunk.data();
+                    stream.avail_in = static_cast<unsigned int>(grab);
+
+                    // One chunk of input may expand to any size. Keep draining until all of it is consumed, and on the
+                    // last chunk, until the stream ends. Inflate may return early with input left after flushing its window.
+                    while (true) {
+                        stream.next_out = inflated_chunk.data();
+                        stream.avail_out = static_cast<unsigned int>(inflated_chunk.size());
+
+                        const int res = inflate(&stream, MZ_NO_FLUSH);
+
+                        if ((res != MZ_OK) && (res != MZ_STREAM_END) && (res != MZ_BUF_ERROR)) {
+                            LOG_ERROR(PACKAGE, "Decompress failed ({})! Report to developers", mz_error(res));
+                            result = false;
+                            break;
+                        }
+
+                        const std::size_t produced = inflated_chunk.size() - stream.avail_out;
+
+                        std_fstream.write(inflated_chunk.data(), produced);
+                        total_inflated_size += produced;
+                        extracted_size_ += produced;
+
+                        if (res == MZ_STREAM_END) {
+                            stream_ended = true;
+                            break;
+                        }
+
+                        if ((res == MZ_BUF_ERROR) || ((stream.avail_in == 0) && (stream.avail_out != 0) && (left != 0))) {
+                            break;
+                        }
+                    }
+
+                    if (!result) {
+                        break;
+                    }
+                }
+
+                if (report_inline) {
+                    report_progress();
+                }
+            }
+        }
+
+        if (deflated) {
+            if (result && (total_inflated_size != compressed->uncompressed_size)) {
+                LOG_ERROR(PACKAGE, "Sanity check failed: Total inflated size not equal to specified uncompress size "
+                                   "in SISCompressed ({} vs {})!",
+                    total_inflated_size, compressed->uncompressed_size);
+            }
+
+            inflateEnd(&stream);
+        }
+
+        return result;
+    }
+
+    bool sis_extractor::extract(const std::vector<target> &targets, progress_changed_callback progress_cb,
+        cancel_requested_callback cancel_cb, std::size_t worker_count) {
+        progress_cb_ = progress_cb;
+        cancel_cb_ = cancel_cb;
+        extracted_size_ = 0;
+        total_size_ = 0;
+        stop_ = false;
+
+        // Writing the same file from two workers would race, only keep the last write to each file.
+        std::unordered_map<std::string, std::size_t> last_target_of_path;
+
+        for (std::size_t i = 0; i < targets.size(); i++) {
+            last_target_of_path[common::lowercase_string(targets[i].file_path_)] = i;
+        }
+
+        std::vector<const target *> work;
+
+        for (std::size_t i = 0; i < targets.size(); i++) {
+            if (last_target_of_path[common::lowercase_string(targets[i].file_path_)] != i) {
+                continue;
+            }
+
+            if (sis_compressed *compressed = get_compressed(targets[i])) {
+                total_size_ += (compressed->algorithm == sis_compressed_algorithm::deflated) ? compressed->uncompressed_size
+                    : (((compressed->len_low) | (static_cast<std::uint64_t>(compressed->len_high) << 32)) - 12);
+            }
+
+            // Prepare the destination here, the file system functions are not meant to be raced on
+            common::create_directories(eka2l1::file_directory(targets[i].file_path_));
+
+            if (common::is_system_case_insensitive() && common::exists(targets[i].file_path_)) {
+                if (!common::remove(targets[i].file_path_)) {
+                    LOG_WARN(PACKAGE, "Unable to remove {} to extract new file", targets[i].file_path_);
+                }
+            }
+
+            work.push_back(&targets[i]);
+        }
+
+        if (work.empty()) {
+            if (progress_cb_) {
+                progress_cb_(1, 1);
+            }
+
+            return true;
+        }
+
+        if (worker_count == 0) {
+            worker_count = std::thread::hardware_concurrency();
+        }
+
+        worker_count = common::max<std::size_t>(1, common::min<std::size_t>(worker_count, work.size()));
+
+        std::vector<bool> started(work.size(), false);
+        bool result = true;
+
+        if (worker_count == 1) {
+            for (std::size_t i = 0; i < work.size(); i++) {
+                started[i] = true;
+
+                if (!extract_one(*work[i], true)) {
+                    result = false;
+                    break;
+                }
+            }
+        } else {
+            std::atomic<std::size_t> next_work(0);
+            std::atomic<std::size_t> finished_workers(0);
+            std::atomic<bool> failed(false);
+
+            std::mutex done_lock;
+            std::condition_variable done_cond;
+
+            std::vector<std::uint8_t> started_flags(work.size(), 0);
+
+            auto worker_func = [&]() {
+                while (!stop_) {
+                    const std::size_t index = next_work++;
+
+                    if (index >= work.size()) {
+                        break;
+                    }
+
+                    started_flags[index] = 1;
+
+                    if (!extract_one(*work[index], false)) {
+                        failed = true;
+                        stop_ = true;
+                    }
+                }
+
+                {
+                    const std::lock_guard<std::mutex> guard(done_lock);
+                    finished_workers++;
+                }
+
+                done_cond.notify_one();
+            };
+
+            std::vector<std::thread> workers;
+
+            for (std::size_t i = 0; i < worker_count; i++) {
+                workers.emplace_back(worker_func);
+            }
+
+            // Callbacks may touch the UI, so they stay on this thread
+            {
+                std::unique_lock<std::mutex> guard(done_lock);
+
+                while (finished_workers != worker_count) {
+                    done_cond.wait_for(guard, std::chrono::milliseconds(20));
+
+                    guard.unlock();
+
+                    if (cancel_cb_ && cancel_cb_()) {
+                        stop_ = true;
+                    }
+
+                    report_progress();
+                    guard.lock();
+                }
+            }
+
+            for (auto &worker : workers) {
+                worker.join();
+            }
+
+            // The last workers may finish after the final report in the loop above
+            report_progress();
+
+            result = !failed && !stop_;
+
+            for (std::size_t i = 0; i < work.size(); i++) {
+                started[i] = (started_flags[i] != 0);
+            }
+        }
+
+        if (!result) {
+            for (std::size_t i = 0; i < work.size(); i++) {
+                if (started[i]) {
+                    common::remove(work[i]->file_path_);
+                }
+            }
+        }
+
+        return result;
+    }
+}
@@ -22,7 +22,6 @@
 #include <common/buffer.h>
 #include <common/cvt.h>
 #include <common/fileutils.h>
-#include <common/flate.h>
 #include <common/log.h>
 #include <common/path.h>
 #include <common/time.h>
@@ -73,8 +72,6 @@ namespace eka2l1 {
             : main_controller(main_controller)
             , install_data(inst_data)
             , conf(nullptr)
-            , extract_target_accumulated_size(0)
-            , extract_target_decomped_size(0)
             , progress_changed_cb(nullptr)
             , install_drive(inst_drv)
             , data_stream(stream)
@@ -85,160 +82,28 @@ namespace eka2l1 {
         std::vector<uint8_t> ss_interpreter::get_small_file_buf(uint32_t data_idx, uint16_t crr_blck_idx) {
             sis_file_data *data = reinterpret_cast<sis_file_data *>(
                 reinterpret_cast<sis_data_unit *>(install_data->data_units.fields[crr_blck_idx].get())->data_unit.fields[data_idx].get());
-            sis_compressed compressed = data->raw_data;
+            const sis_compressed &compressed = data->raw_data;
 
             std::uint64_t us = ((compressed.len_low) | (static_cast<uint64_t>(compressed.len_high) << 32)) - 12;
 
-            compressed.compressed_data.resize(us);
+            std::vector<uint8_t> compressed_data(us);
 
             data_stream->seek(compressed.offset, common::seek_where::beg);
-            data_stream->read(&compressed.compressed_data[0], us);
+            data_stream->read(compressed_data.data(), us);
 
             if (compressed.algorithm == sis_compressed_algorithm::none) {
-                return compressed.compressed_data;
+                return compressed_data;
             }
 
-            compressed.uncompressed_data.resize(compressed.uncompressed_size);
-            mz_stream stream;
+            std::vector<uint8_t> uncompressed_data(compressed.uncompressed_size);
+            mz_ulong uncompressed_size = static_cast<mz_ulong>(uncompressed_data.size());
 
-            stream.zalloc = nullptr;
-            stream.zfree = nullptr;
-
-            if (inflateInit(&stream) != MZ_OK) {
-                LOG_ERROR(PACKAGE, "Can not intialize inflate stream");
-            }
-
-            flate::inflate_data(&stream, compressed.compressed_data.data(),
-                compressed.uncompressed_data.data(), static_cast<std::uint32_t>(us));
-
-            inflateEnd(&stream);
-
-            return compressed.uncompressed_data;
-        }
-
-        // Assuming this file is small since it's stored in std::vector
-        // Directly write this
-        void extract_file_with_buf(const std::string &path, std::vector<uint8_t> &data) {
-            std::string rp = eka2l1::file_directory(path);
-            common::create_directories(rp);
-
-            LOG_INFO(PACKAGE, "Write to: {}", path);
-
-            common::wo_std_file_stream stream(path, true);
-            stream.write(data.data(), data.size());
-        }
-
-        bool ss_interpreter::extract_file(const std::string &path, const uint32_t idx, uint16_t crr_blck_idx) {
-            std::string rp = eka2l1::file_directory(path);
-            common::create_directories(rp);
-
-            // Delete the file, starts over
-            if (common::is_system_case_insensitive() && common::exists(path)) {
-                if (!common::remove(path)) {
-                    LOG_WARN(PACKAGE, "Unable to remove {} to extract new file", path);
-                }
-            }
-
-            sis_data_unit *data_unit = reinterpret_cast<sis_data_unit *>(install_data->data_units.fields[crr_blck_idx].get());
-
-            if (data_unit->data_unit.fields.empty()) {
-                // Stub sis without file data
-                return true;
-            }
-
-            sis_file_data *data = reinterpret_cast<sis_file_data *>(data_unit->data_unit.fields[idx].get());
-
-            sis_compressed compressed = data->raw_data;
-
-            std::uint64_t left = ((compressed.len_low) | (static_cast<std::uint64_t>(compressed.len_high) << 32)) - 12;
-            data_stream->seek(compressed.offset, common::seek_where::beg);
-
-            std::vector<unsigned char> temp_chunk;
-            temp_chunk.resize(CHUNK_SIZE);
-
-            std::vector<unsigned char> temp_inflated_chunk;
-            temp_inflated_chunk.resize(CHUNK_MAX_INFLATED_SIZE);
-
-            mz_stream stream;
-
-            stream.zalloc = nullptr;
-            stream.zfree = nullptr;
-
-            if (compressed.algorithm == sis_compressed_algorithm::deflated) {
-                if (inflateInit(&stream) != MZ_OK) {
-                    LOG_ERROR(PACKAGE, "Can not intialize inflate stream");
-                }
-            }
-
-            std::uint32_t total_inflated_size = 0;
-            bool cancel_requested = false;
-
-            {
-                common::wo_std_file_stream std_fstream(path, true);
-
-                while (left > 0) {
-                    if (cancel_cb && cancel_cb()) {
-                        cancel_requested = true;
-                        break;
-                    }
-
-                    std::fill(temp_chunk.begin(), temp_chunk.end(), 0);
-                    int grab = static_cast<int>(left < CHUNK_SIZE ? left : CHUNK_SIZE);
-
-                    data_stream->read(&temp_chunk[0], grab);
-
-                    if (!data_stream->valid()) {
-                        LOG_ERROR(PACKAGE, "Stream fail, skipping this file, should report to developers.");
-                        return false;
-                    }
-
-                    if (compressed.algorithm == sis_compressed_algorithm::deflated) {
-                        uint32_t inflated_size = 0;
-
-                        auto res = flate::inflate_data(&stream, temp_chunk.data(), temp_inflated_chunk.data(), grab, &inflated_size);
-
-                        if (!res) {
-                            LOG_ERROR(PACKAGE, "Decompress failed! Report to developers");
-                            return false;
-                        }
-
-                        std_fstream.write(temp_inflated_chunk.data(), inflated_size);
-
-                        total_inflated_size += inflated_size;
-                        extract_target_decomped_size += inflated_size;
-                    } else {
-                        std_fstream.write(temp_chunk.data(), grab);
-                        extract_target_decomped_size += grab;
-                    }
-
-                    left -= grab;
-
-                    if (progress_changed_cb) {
-                        if (extract_target_accumulated_size != 0) {
-                            progress_changed_cb(extract_target_decomped_size, extract_target_accumulated_size);
-                        } else {
-                            progress_changed_cb(100, 100);
-                        }
-                    }
-                }
-
-                if (compressed.algorithm == sis_compressed_algorithm::deflated) {
-                    if (!cancel_requested && (total_inflated_size != compressed.uncompressed_size)) {
-                        LOG_ERROR(PACKAGE, "Sanity check failed: Total inflated size not equal to specified uncompress size "
-                                           "in SISCompressed ({} vs {})!",
-                            total_inflated_size, compressed.uncompressed_size);
-                    }
-
-                    inflateEnd(&stream);
-                }
-            }
-
-            if (cancel_requested) {
-                common::remove(path);
-                return false;
+            if (mz_uncompress(uncompressed_data.data(), &uncompressed_size, compressed_data.data(), static_cast<mz_ulong>(us)) != MZ_OK) {
+                LOG_ERROR(PACKAGE, "Unable to inflate file data");
             }
 
-            return true;
+            uncompressed_data.resize(uncompressed_size);
+            return uncompressed_data;
         }
 
         int ss_interpreter::gasp_true_form_of_integral_expression(const sis_expression &expr) {
@@ -608,13 +473,12 @@ namespace eka2l1 {
                         }
 
                         if (!install_data->data_units.fields.empty()) {
-                            extract_target_info info;
+                            sis_extractor::target info;
                             info.file_path_ = raw_path;
-                            info.data_unit_block_index_ = file->idx;
+                            info.data_index_ = file->idx;
                             info.data_unit_index_ = crr_blck_idx;
 
                             extract_targets.push_back(info);
-                            extract_target_accumulated_size += file->uncompressed_len;
                         }
 
                         if (!lowered) {
@@ -697,9 +561,6 @@ namespace eka2l1 {
             gathered_sis_paths.clear();
             extract_targets.clear();
 
-            extract_target_accumulated_size = 0;
-            extract_target_decomped_size = 0;
-
             progress_changed_cb = cb;
             cancel_cb = ccb;
 
@@ -711,22 +572,9 @@ namespace eka2l1 {
                 if (cb)
                     cb(1, 1);
             } else {
-                std::size_t n = 0;
-                bool cancel_requested = false;
-
-                for (; n < extract_targets.size(); n++) {
-                    extract_target_info &target = extract_targets[n];
-                    if (!extract_file(target.file_path_, target.data_unit_block_index_, target.data_unit_index_)) {
-                        cancel_requested = true;
-                        break;
-                    }
-                }
-
-                if (cancel_requested) {
-                    for (std::size_t i = 0; i < n; i++) {
-                        common::remove(extract_targets[i].file_path_);
-                    }
+                sis_extractor extractor(data_stream, install_data);
 
+                if (!extractor.extract(extract_targets, cb, ccb)) {
                     return nullptr;
                 }
             }
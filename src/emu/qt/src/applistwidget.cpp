@@ -442,6 +442,8 @@ void applist_widget::reload_whole_list() {
                 scanning_done_evt_.set();
                 return;
             }
+
+            lister_->refresh_registries();
             std::vector<eka2l1::apa_app_registry> &registries = lister_->get_registerations();
             exit_mutex_.unlock();
 
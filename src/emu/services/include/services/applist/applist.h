@@ -23,10 +23,15 @@
 #include <services/applist/common.h>
 #include <services/framework.h>
 
+#include <common/vecx.h>
+#include <common/watcher.h>
 #include <utils/des.h>
 #include <vfs/vfs.h>
 
+#include <atomic>
 #include <functional>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -34,6 +39,7 @@ namespace eka2l1 {
     class io_system;
     class fbs_server;
     class fs_server;
+    class apa_registry_cache;
 
     struct fbsbitmap;
 
@@ -90,6 +96,7 @@ namespace eka2l1 {
 
         std::int16_t icon_count;
         std::u16string icon_file_path;
+        std::vector<eka2l1::vec2> icon_sizes; ///< Size of each bitmap in the MBM icon file, read once when the registry is parsed.
 
         std::vector<apa_app_icon> app_icons;
         std::vector<data_type> data_types;
@@ -194,6 +201,12 @@ namespace eka2l1 {
         std::vector<std::size_t> poll_events_;
         std::size_t drive_change_handle_{ 0 };
 
+        std::unique_ptr<apa_registry_cache> reg_cache_;
+
+        common::directory_watcher reg_watcher_;
+        std::map<drive_number, std::vector<std::int32_t>> reg_watch_handles_;
+        std::atomic<std::uint32_t> pending_rescan_drives_{ 0 };
+
         fbs_server *fbsserv;
         fs_server *fsserv;
 
@@ -219,6 +232,25 @@ namespace eka2l1 {
         bool rescan_registries_on_drive_oldarch(eka2l1::io_system *io, const drive_number num);
         bool rescan_registries_on_drive_newarch(eka2l1::io_system *io, const drive_number num);
         bool rescan_registries_on_drive_newarch_with_path(eka2l1::io_system *io, const drive_number num, const std::u16string &path);
+        bool rescan_registries_on_drive(eka2l1::io_system *io, const drive_number num);
+
+        void load_registry_cache();
+        void save_registry_cache();
+
+        /**
+         * \brief Watch the host folders containing registrations of a drive, so changes made outside
+         *        of the emulated file server (for example, copying apps to the drive folder) get picked up.
+         */
+        void watch_registries_on_drive(eka2l1::io_system *io, const drive_number num);
+        void unwatch_registries_on_drive(const drive_number num);
+
+        /**
+         * \brief Rescan drives that had their registration folders changed since the last scan.
+         *
+         * Only changed registrations are reparsed, which may erase or move registries in the list.
+         * Must be called with the list lock held, and never while references to registries are kept.
+         */
+        void process_pending_rescans(eka2l1::io_system *io);
 
         /*! \brief Get the number of screen shared for an app. 
          * 
@@ -321,5 +353,14 @@ namespace eka2l1 {
          * \brief Get all app registerations.
          */
         std::vector<apa_app_registry> &get_registerations();
+
+        /**
+         * \brief Apply changes made to the registration folders on the host since the last refresh.
+         *
+         * References and pointers to registries obtained before this call may be invalidated. It's
+         * called at the start of every IPC request, users outside of the server should call it before
+         * getting the registries.
+         */
+        void refresh_registries();
     };
 }
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <services/applist/applist.h>
+
+#include <common/types.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace eka2l1 {
+    class io_system;
+
+    namespace common {
+        class chunkyseri;
+    }
+
+    /**
+     * @brief Identify the state of a file a registry was built from.
+     */
+    struct apa_registry_source_stamp {
+        std::u16string path_;
+        std::uint64_t last_modified_ = 0;
+        std::uint64_t size_ = 0;
+    };
+
+    /**
+     * @brief Serialize an app registry, excluding its icon bitmaps.
+     */
+    void do_state_for_registry(common::chunkyseri &seri, apa_app_registry &reg);
+
+    /**
+     * @brief Host-side cache of parsed app registries.
+     *
+     * Each registry is stored together with the stamp of every file it was built from (the registration
+     * file, the localisable resource and the icon file). A cached registry is only reused if none of those
+     * files changed since, and the localisable resource picked for the language is still the same one
+     * (none may have existed, or a better match may have appeared), so parsing is only done for new or modified apps.
+     *
+     * Registries holding icon bitmaps (from AIF files) are not cached, since the bitmaps live in the FBS server.
+     */
+    class apa_registry_cache {
+        struct cache_entry {
+            std::vector<apa_registry_source_stamp> sources_;
+            std::u16string localised_path_; ///< Localisable resource picked for the language. Empty if there was none.
+            apa_app_registry registry_;
+        };
+
+        std::unordered_map<std::u16string, cache_entry> entries_;
+
+        std::string path_;
+        language lang_;
+        bool dirty_;
+
+        int do_state(common::chunkyseri &seri);
+
+    public:
+        explicit apa_registry_cache(const std::string &path, const language lang);
+
+        /**
+         * @brief Load the cache from the host file.
+         *
+         * @returns True if the cache file exists and is compatible.
+         */
+        bool load();
+
+        /**
+         * @brief Write the cache to the host file, if there are any changes.
+         *
+         * @returns True on success, or if nothing needs to be written.
+         */
+        bool save();
+
+        /**
+         * @brief Find a cached registry still matching its source files.
+         *
+         * @param io                The IO system, used to check the secondary source files.
+         * @param rsc_path          Path to the registration file.
+         * @param last_modified     Current last modified time of the registration file.
+         * @param size              Current size of the registration file.
+         * @param localised_path    If not null, receive the localisable resource picked for the language. Empty if there was none.
+         *
+         * @returns Pointer to the cached registry, nullptr if not available or outdated.
+         */
+        const apa_app_registry *find(io_system *io, const std::u16string &rsc_path, const std::uint64_t last_modified,
+            const std::uint64_t size, std::u16string *localised_path = nullptr);
+
+        /**
+         * @brief Add or replace a registry in the cache.
+         *
+         * @param reg       The registry to cache.
+         * @param sources           Stamps of the files the registry was built from. The first one must be the registration file.
+         * @param localised_path    Localisable resource picked for the language. Empty if none was found.
+         */
+        void add(const apa_app_registry &reg, const std::vector<apa_registry_source_stamp> &sources,
+            const std::u16string &localised_path);
+
+        void remove(const std::u16string &rsc_path);
+
+        std::size_t size() const {
+            return entries_.size();
+        }
+    };
+}
@@ -24,6 +24,7 @@
 #pragma once
 
 #include <memory>
+#include <string>
 #include <services/centralrepo/repo.h>
 
 namespace eka2l1 {
@@ -32,4 +33,29 @@ namespace eka2l1 {
     }
 
     int do_state_for_cre(common::chunkyseri &seri, eka2l1::central_repo &repo);
+
+    /**
+     * \brief Load a repository from its precompiled binary cache on the host.
+     *
+     * The cache is only used if its source file still has the same size and modification time
+     * as when the cache was written.
+     *
+     * \param cache_path  Host path of the cache file.
+     * \param source_path Host path of the file the repository was originally parsed from.
+     * \param repo        Repository to load into.
+     *
+     * \returns True if the cache is valid and has been loaded.
+     */
+    bool load_cre_cache(const std::string &cache_path, const std::string &source_path, eka2l1::central_repo &repo);
+
+    /**
+     * \brief Write a precompiled binary cache of a repository, so it can be loaded without reparsing.
+     *
+     * \param cache_path  Host path of the cache file.
+     * \param source_path Host path of the file the repository was parsed from.
+     * \param repo        Repository to write.
+     *
+     * \returns True on success.
+     */
+    bool save_cre_cache(const std::string &cache_path, const std::string &source_path, eka2l1::central_repo &repo);
 }
\ No newline at end of file
@@ -28,6 +28,7 @@
 #include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace eka2l1 {
@@ -91,7 +92,7 @@ namespace eka2l1 {
 
         std::uint32_t owner_uid;
 
-        std::vector<central_repo_entry> entries;
+        std::vector<central_repo_entry> entries; ///< Sorted by key, so lookups can be binary searched.
         std::vector<central_repo_client_subsession *> attached;
 
         central_repo_entry_access_policy default_policy;
@@ -108,6 +109,28 @@ namespace eka2l1 {
         void write_changes(eka2l1::io_system *io, device_manager *mngr);
         central_repo_entry *find_entry(const std::uint32_t key);
 
+        /**
+         * \brief Restore the key order of the entry list.
+         *
+         * Must be called after the entry list is filled by something other than add_new_entry.
+         */
+        void sort_entries();
+
+        /**
+         * \brief Get the range of entries that may match the given key filter.
+         *
+         * Since entries are sorted by key, every key satisfying (key & mask) == (partial_key & mask)
+         * lies between (partial_key & mask) and (partial_key | ~mask). Entries in the returned range
+         * still have to be checked against the mask, but everything outside it can be skipped.
+         *
+         * \param partial_key The bit pattern to be matched.
+         * \param mask        The mask that requires which bit is mandatory.
+         *
+         * \returns Pair of begin and end iterator of the candidate range.
+         */
+        std::pair<std::vector<central_repo_entry>::iterator, std::vector<central_repo_entry>::iterator>
+        entries_in_mask_range(const std::uint32_t partial_key, const std::uint32_t mask);
+
         std::uint32_t get_default_meta_for_new_key(const std::uint32_t key);
 
         bool add_new_entry(const std::uint32_t key, const central_repo_entry_variant &var);
@@ -21,6 +21,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include <common/vecx.h>
@@ -45,12 +46,24 @@ namespace eka2l1::epoc::adapter {
      * \brief Base class for adapter.
      */
     class font_file_adapter_base {
+        std::mutex rasterize_lock_;
+
     protected:
         virtual std::uint32_t get_glyph_advance(const std::size_t face_index, const std::uint32_t codepoint, const std::uint16_t font_size, const bool vertical = false) = 0;
 
     public:
         virtual ~font_file_adapter_base() {}
 
+        /**
+         * \brief Lock held while rasterizing a glyph.
+         *
+         * Glyphs may be rasterized from the FBS glyph cache thread and the FBS server thread at the same time,
+         * and adapters are not safe to use from multiple threads.
+         */
+        std::mutex &rasterize_lock() {
+            return rasterize_lock_;
+        }
+
         virtual bool is_valid() = 0;
         virtual bool vectorizable() const = 0;
         virtual std::uint32_t line_gap(const std::size_t idx) {
@@ -21,6 +21,7 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include <common/container.h>
@@ -33,6 +34,7 @@ namespace eka2l1::epoc::adapter {
     private:
         std::vector<std::uint8_t> data_;
         std::map<int, stbtt_fontinfo> cache_info;
+        std::mutex cache_info_lock; ///< Glyphs may be rasterized from the FBS glyph cache thread.
 
         stbtt_fontinfo info_;
         common::identity_container<std::unique_ptr<stbtt_pack_context>> contexts_;
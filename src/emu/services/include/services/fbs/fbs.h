@@ -30,6 +30,8 @@
 #include <services/fbs/font.h>
 #include <services/fbs/font_atlas.h>
 #include <services/fbs/font_store.h>
+#include <services/fbs/glyph_cache.h>
+#include <services/fbs/mbm_cache.h>
 #include <services/framework.h>
 #include <services/window/common.h>
 
@@ -365,6 +367,8 @@ namespace eka2l1 {
         epoc::open_font_session_cache_link *session_cache_link;
 
         epoc::font_store persistent_font_store;
+        std::unique_ptr<epoc::glyph_cache> shared_glyph_cache;
+        std::unique_ptr<epoc::mbm_cache> bitmap_file_cache;
 
         void load_fonts(eka2l1::io_system *io);
 
@@ -451,6 +455,10 @@ namespace eka2l1 {
             return base_large_chunk;
         }
 
+        epoc::mbm_cache *get_bitmap_file_cache() {
+            return bitmap_file_cache.get();
+        }
+
         std::uint8_t *get_large_chunk_pointer(const std::uint64_t start_offset) const {
             return base_large_chunk + start_offset;
         }
@@ -482,10 +490,13 @@ namespace eka2l1 {
          * \param idx_          Index of the bitmap in MBM. Index base is 0.
          * \param size_         Reference variable to assign the new size in case the data is decompressed.
          * \param err_code      Pointer to integer which will holds error code. Must not be null.
+         * \param source        The file the MBM is read from. If not null, decompressed data is taken from and
+         *                      added to the bitmap file cache.
          * 
          * \return Pointer to the data.
          */
-        void *load_data_to_rom(loader::mbm_file &mbmf_, const std::size_t idx_, std::size_t &size_decomp, int *err_code);
+        void *load_data_to_rom(loader::mbm_file &mbmf_, const std::size_t idx_, std::size_t &size_decomp, int *err_code,
+            const epoc::mbm_file_identity *source = nullptr);
 
         /*! \brief Use to Allocate structure from server side.
          *
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <common/queue.h>
+#include <services/fbs/font.h>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace eka2l1::epoc {
+    namespace adapter {
+        class font_file_adapter_base;
+    }
+
+    /**
+     * @brief Identify a rasterized glyph, independent of the session requesting it.
+     */
+    struct glyph_cache_key {
+        adapter::font_file_adapter_base *adapter_ = nullptr;
+        std::size_t face_index_ = 0;
+        std::uint16_t font_size_ = 0;
+        std::int32_t baseline_offset_ = 0;
+        std::uint32_t codepoint_ = 0;
+    };
+
+    inline bool operator==(const glyph_cache_key &lhs, const glyph_cache_key &rhs) {
+        return (lhs.adapter_ == rhs.adapter_) && (lhs.face_index_ == rhs.face_index_) && (lhs.font_size_ == rhs.font_size_)
+            && (lhs.baseline_offset_ == rhs.baseline_offset_) && (lhs.codepoint_ == rhs.codepoint_);
+    }
+
+    struct glyph_cache_key_hash {
+        std::size_t operator()(const glyph_cache_key &key) const noexcept;
+    };
+
+    struct rasterized_glyph {
+        bool exists_ = false; ///< False if the font does not have this glyph.
+
+        std::vector<std::uint8_t> data_;
+        int width_ = 0;
+        int height_ = 0;
+
+        glyph_bitmap_type bitmap_type_ = glyph_bitmap_type::default_glyph_bitmap;
+        open_font_character_metric metric_;
+    };
+
+    using rasterized_glyph_ptr = std::shared_ptr<const rasterized_glyph>;
+
+    struct glyph_cache_stats {
+        std::uint64_t hits_ = 0;
+        std::uint64_t misses_ = 0;
+        std::uint64_t evictions_ = 0;
+        std::uint64_t prerasterized_ = 0;
+
+        std::size_t memory_usage_ = 0;
+        std::size_t entry_count_ = 0;
+    };
+
+    /**
+     * @brief Host-side cache of rasterized glyph bitmaps and metrics, shared between all FBS sessions.
+     *
+     * Session caches living in the guest memory are small and per process, so without this the
+     * same glyph gets rasterized again for every client and after every session cache eviction.
+     *
+     * Entries are evicted in least recently used order when the memory budget is exceeded. Ranges of
+     * commonly used characters can be rasterized ahead of time on a separate thread.
+     */
+    class glyph_cache {
+        using lru_list = std::list<std::pair<glyph_cache_key, rasterized_glyph_ptr>>;
+
+        lru_list lru_;
+        std::unordered_map<glyph_cache_key, lru_list::iterator, glyph_cache_key_hash> entries_;
+
+        std::size_t memory_budget_;
+        glyph_cache_stats stats_;
+        std::mutex lock_;
+
+        struct prerasterize_request {
+            glyph_cache_key base_key_;
+            std::uint32_t start_code_;
+            std::uint32_t end_code_;
+        };
+
+        request_queue<prerasterize_request> prerasterize_queue_;
+        std::unique_ptr<std::thread> prerasterize_thread_;
+
+        rasterized_glyph_ptr rasterize(const glyph_cache_key &key);
+        rasterized_glyph_ptr find_no_lock(const glyph_cache_key &key);
+
+        void add(const glyph_cache_key &key, rasterized_glyph_ptr glyph);
+        void run_prerasterize();
+
+    public:
+        explicit glyph_cache(const std::size_t memory_budget, const bool enable_prerasterize);
+        ~glyph_cache();
+
+        /**
+         * @brief Get a glyph from the cache, rasterize and cache it if it's not available yet.
+         *
+         * @param key       The glyph to get.
+         * @returns The rasterized glyph. Check the exists flag to see if the font has this glyph.
+         */
+        rasterized_glyph_ptr get(const glyph_cache_key &key);
+
+        /**
+         * @brief Queue a range of characters to be rasterized in the background.
+         *
+         * Does nothing if background rasterization is disabled, or if too many ranges are already queued.
+         *
+         * @param base_key      Key describing the font. Codepoint field is ignored.
+         * @param start_code    First codepoint of the range.
+         * @param end_code      Last codepoint of the range (inclusive).
+         */
+        void prerasterize(const glyph_cache_key &base_key, const std::uint32_t start_code, const std::uint32_t end_code);
+
+        /**
+         * @brief Stop the background rasterization thread.
+         */
+        void abort();
+
+        glyph_cache_stats stats();
+    };
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <loader/mbm.h>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace eka2l1::common {
+    class ro_stream;
+}
+
+namespace eka2l1::epoc {
+    /**
+     * @brief Identify the content of an MBM file. A file modified since it was cached is read again.
+     */
+    struct mbm_file_identity {
+        std::u16string path_;
+        std::uint64_t last_modified_ = 0;
+        std::uint64_t size_ = 0;
+    };
+
+    struct decoded_bitmap_key {
+        std::u16string path_;
+        std::size_t index_ = 0;
+    };
+
+    inline bool operator==(const decoded_bitmap_key &lhs, const decoded_bitmap_key &rhs) {
+        return (lhs.index_ == rhs.index_) && (lhs.path_ == rhs.path_);
+    }
+
+    struct decoded_bitmap_key_hash {
+        std::size_t operator()(const decoded_bitmap_key &key) const noexcept;
+    };
+
+    struct mbm_cache_stats {
+        std::uint64_t index_hits_ = 0;
+        std::uint64_t index_misses_ = 0;
+        std::uint64_t bitmap_hits_ = 0;
+        std::uint64_t bitmap_misses_ = 0;
+        std::uint64_t evictions_ = 0;
+
+        std::size_t memory_usage_ = 0;
+        std::size_t entry_count_ = 0;
+    };
+
+    /**
+     * @brief Cache of MBM file indexes and decompressed bitmap data, shared between all FBS sessions.
+     *
+     * Applications load the same bitmaps from the same few MBM files (avkon, skins) over and over. Without this,
+     * every load that is not shared parses the file trailer and headers, then decompresses the bitmap twice:
+     * once to know its size, once into the bitmap memory.
+     *
+     * File indexes are kept for every file loaded from, since they are small. Decompressed data is evicted in
+     * least recently used order when the memory budget is exceeded.
+     */
+    class mbm_cache {
+        struct index_entry {
+            std::uint64_t last_modified_ = 0;
+            std::uint64_t size_ = 0;
+
+            std::unique_ptr<loader::mbm_file> file_;
+        };
+
+        struct decoded_bitmap {
+            decoded_bitmap_key key_;
+            std::uint64_t last_modified_ = 0;
+            std::uint64_t file_size_ = 0;
+
+            std::vector<std::uint8_t> data_;
+        };
+
+        using lru_list = std::list<decoded_bitmap>;
+
+        std::unordered_map<std::u16string, index_entry> indexes_;
+
+        lru_list lru_;
+        std::unordered_map<decoded_bitmap_key, lru_list::iterator, decoded_bitmap_key_hash> bitmaps_;
+
+        std::size_t memory_budget_;
+        mbm_cache_stats stats_;
+
+        void remove_bitmap(std::unordered_map<decoded_bitmap_key, lru_list::iterator, decoded_bitmap_key_hash>::iterator ite);
+
+    public:
+        explicit mbm_cache(const std::size_t memory_budget);
+
+        /**
+         * @brief Get the index of an MBM file, with the header of a bitmap loaded.
+         *
+         * The returned index reads from the given stream, and stays valid until the next call.
+         *
+         * @param file              The file to get the index of.
+         * @param stream            Stream to read the file from, if it is not cached or has changed.
+         * @param bitmap_index      Index of the bitmap which header must be loaded.
+         *
+         * @returns Nullptr if the file is corrupted. Check is_header_loaded() to know if the bitmap exists.
+         */
+        loader::mbm_file *get_index(const mbm_file_identity &file, common::ro_stream *stream, const std::size_t bitmap_index);
+
+        /**
+         * @brief Get the decompressed data of a bitmap in a file.
+         *
+         * @returns Nullptr if the data is not cached.
+         */
+        const std::vector<std::uint8_t> *get_decoded_bitmap(const mbm_file_identity &file, const std::size_t bitmap_index);
+
+        void add_decoded_bitmap(const mbm_file_identity &file, const std::size_t bitmap_index, const std::uint8_t *data,
+            const std::size_t size);
+
+        const mbm_cache_stats &stats() const {
+            return stats_;
+        }
+    };
+}
@@ -20,6 +20,7 @@
 #pragma once
 
 #include <services/internet/protocols/common.h>
+#include <services/internet/protocols/task_queue.h>
 #include <services/socket/protocol.h>
 #include <services/socket/socket.h>
 
@@ -200,6 +201,9 @@ namespace eka2l1::epoc::internet {
 
         std::unique_ptr<common::ring_buffer<char, 0x80000>> stream_data_buffer_;
 
+        // True if libuv was given free space of the stream buffer to read into
+        bool recv_into_stream_buffer_;
+
         common::event open_event_;
         common::event listen_event_;
         int listen_event_result_;
@@ -227,6 +231,7 @@ namespace eka2l1::epoc::internet {
             , recv_size_(0)
             , take_available_only_(false)
             , stream_data_buffer_(nullptr)
+            , recv_into_stream_buffer_(false)
             , receive_done_cb_(nullptr)
             , broadcast_translate_cached_(false)
             , socket_accepted_hook_(nullptr) {
@@ -281,6 +286,7 @@ namespace eka2l1::epoc::internet {
     class inet_bridged_protocol : public socket::protocol {
     private:
         std::unique_ptr<std::thread> loop_thread_;
+        std::unique_ptr<inet_task_queue> task_queue_;
         kernel_system *kern_;
 
     public:
@@ -289,6 +295,15 @@ namespace eka2l1::epoc::internet {
 
         void initialize_looper();
 
+        /**
+         * @brief Run a function on the socket looper thread.
+         *
+         * The looper must already be initialized.
+         *
+         * @param func      The function to run.
+         */
+        void post_task(inet_task_queue::task func);
+
         virtual std::u16string name() const override {
             return u"INet";
         }
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <common/queue.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+struct uv_loop_s;
+struct uv_async_s;
+
+namespace eka2l1::epoc::internet {
+    struct inet_task_queue_stats {
+        std::uint64_t posted_ = 0;
+        std::uint64_t executed_ = 0;
+        std::uint64_t wakeups_ = 0;         ///< Number of times the loop woke up to run tasks.
+    };
+
+    /**
+     * @brief Run functions on the libuv loop thread, posted from any other thread.
+     *
+     * A single async handle lives as long as the queue. Posted tasks go to a lock-free queue and
+     * the loop thread runs all of them in one wakeup, instead of initializing and closing an async
+     * handle per socket operation.
+     */
+    class inet_task_queue {
+    public:
+        using task = std::function<void()>;
+
+    private:
+        uv_loop_s *loop_;
+        uv_async_s *async_;
+
+        mpsc_batch_queue<task> tasks_;
+
+        // Posts in progress are counted, so closing can wait for them and nothing sends to a closed handle
+        std::atomic<bool> closed_;
+        std::atomic<std::uint32_t> posters_;
+
+        std::atomic<std::uint64_t> posted_;
+        std::atomic<std::uint64_t> executed_;
+        std::atomic<std::uint64_t> wakeups_;
+
+        void run_pending();
+
+    public:
+        /**
+         * @brief Create the task queue and its async handle.
+         *
+         * Must be called on the loop thread, or before the loop starts running.
+         *
+         * @param loop      The loop to run the tasks on.
+         */
+        explicit inet_task_queue(uv_loop_s *loop);
+
+        /**
+         * @brief Queue a function to be run on the loop thread.
+         *
+         * Tasks are run in the order they are posted. Tasks posted after the queue is closed are dropped.
+         *
+         * @param func      The function to run.
+         * @returns False if the queue has been closed.
+         */
+        bool post(task func);
+
+        /**
+         * @brief Run the remaining tasks and close the async handle.
+         *
+         * Must be called on the loop thread, before the queue is destroyed. The handle is freed once
+         * its close callback is run by the loop.
+         */
+        void close();
+
+        uv_loop_s *loop() {
+            return loop_;
+        }
+
+        inet_task_queue_stats stats() const;
+    };
+}
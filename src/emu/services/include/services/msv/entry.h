@@ -27,6 +27,8 @@
 #include <cstdint>
 #include <optional>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace eka2l1 {
     class io_system;
@@ -51,6 +53,22 @@ namespace eka2l1::epoc::msv {
         common::roundabout folders_;
         entry root_entry_;
 
+        std::unordered_map<msv_id, visible_folder *> folder_lookup_;
+        std::unordered_map<msv_id, visible_folder *> entry_folder_cache_;       // Folder an entry was last found in
+        std::unordered_map<msv_id, std::vector<msv_id>> children_cache_;        // Children IDs of a parent, from its last complete lookup
+
+        visible_folder *find_folder(const msv_id id);
+
+        /**
+         * @brief Get the children of a parent from the children cache.
+         *
+         * @returns False if the children are not cached, or one of them is no longer loaded.
+         */
+        bool get_cached_children(const msv_id parent_id, std::vector<entry *> &children);
+        void cache_children(const msv_id parent_id, const std::vector<entry *> &children);
+        void invalidate_children(const msv_id parent_id);
+        visible_folder *get_or_create_folder(const msv_id id);
+
         bool create_standard_entries(drive_number crr_drive);
         bool move_entry_to_new_folder(entry *ent, const std::uint32_t new_parent, const std::uint32_t new_folder);
 
@@ -73,6 +91,33 @@ namespace eka2l1::epoc::msv {
             const std::uint32_t owning_service);
 
         std::optional<std::u16string> get_entry_data_file(entry *ent);
+
+        /**
+         * @brief Group all following changes to the index into one batch, until end_batch is called.
+         * 
+         * For a database-backed indexer, the batch is done in one transaction. Batches can be nested,
+         * only the outermost one is committed.
+         */
+        virtual void begin_batch() {
+        }
+
+        virtual void end_batch() {
+        }
+    };
+
+    struct entry_indexer_batch_scope {
+    private:
+        entry_indexer *indexer_;
+
+    public:
+        explicit entry_indexer_batch_scope(entry_indexer *indexer)
+            : indexer_(indexer) {
+            indexer_->begin_batch();
+        }
+
+        ~entry_indexer_batch_scope() {
+            indexer_->end_batch();
+        }
     };
 
     struct sql_entry_indexer: public entry_indexer {
@@ -85,8 +130,13 @@ namespace eka2l1::epoc::msv {
         sqlite3_stmt *find_entry_stmt_;
         sqlite3_stmt *query_child_entries_stmt_;
         sqlite3_stmt *query_child_ids_stmt_;
+        sqlite3_stmt *begin_batch_stmt_;
+        sqlite3_stmt *end_batch_stmt_;
 
         std::uint32_t id_counter_;
+        std::uint32_t batch_depth_;
+
+        bool run_batch_statement(sqlite3_stmt *&stmt, const char *sql);
 
         bool load_or_create_databases(bool &newly_created);
         bool collect_children_entries(const msv_id parent_id, std::vector<entry> &entries);
@@ -113,5 +163,8 @@ namespace eka2l1::epoc::msv {
         bool move_entry(const std::uint32_t id, const std::uint32_t new_parent) override;
 
         std::vector<entry *> get_entries_by_parent(const std::uint32_t parent_id) override;
+
+        void begin_batch() override;
+        void end_batch() override;
     };
 }
\ No newline at end of file
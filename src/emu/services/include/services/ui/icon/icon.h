@@ -22,13 +22,33 @@
 #include <services/ui/icon/common.h>
 
 #include <memory>
+#include <string>
+#include <unordered_map>
 
 namespace eka2l1 {
     constexpr std::uint32_t MAX_CACHE_SIZE = 1024;
 
+    /**
+     * @brief What decides if two requests are for the same icon.
+     */
+    struct icon_lookup_key {
+        std::u16string file_name; ///< Lowercased, since the file name is compared ignoring case.
+        int bitmap_id;
+        bool app_icon;
+
+        bool operator==(const icon_lookup_key &rhs) const {
+            return (bitmap_id == rhs.bitmap_id) && (app_icon == rhs.app_icon) && (file_name == rhs.file_name);
+        }
+    };
+
+    struct icon_lookup_key_hash {
+        std::size_t operator()(const icon_lookup_key &key) const;
+    };
+
     struct icon_data_item {
         epoc::akn_icon_params spec;
         epoc::akn_icon_srv_return_data ret;
+        icon_lookup_key key;
 
         int use_count{ 0 };
     };
@@ -53,12 +73,13 @@ namespace eka2l1 {
 
         fbs_server *fbss;
         std::vector<icon_data_item> icons;
+        std::unordered_map<icon_lookup_key, std::size_t, icon_lookup_key_hash> icon_lookup; ///< Index of each icon in the list.
 
         std::unique_ptr<service::faker> icon_process;
 
         void init_server();
         std::optional<epoc::akn_icon_srv_return_data> find_existing_icon(epoc::akn_icon_params &spec, std::size_t *idx = nullptr);
-        void add_icon(const epoc::akn_icon_srv_return_data &ret, const epoc::akn_icon_params &spec);
+        void add_icon(const epoc::akn_icon_srv_return_data &ret, const epoc::akn_icon_params &spec, icon_lookup_key &&key);
         bool cache_or_delete_icon(const std::size_t icon_idx);
 
     public:
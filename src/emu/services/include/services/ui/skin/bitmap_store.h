@@ -19,17 +19,35 @@
 
 #include <services/fbs/fbs.h>
 
-#include <vector>
+#include <cstdint>
+#include <unordered_map>
 
 namespace eka2l1::epoc {
+    /**
+     * @brief Bitmaps kept alive for the skin chunk, indexed by their handle.
+     *
+     * A bitmap may be stored more than once (for example as the mask of two items), so each
+     * handle keeps a count, and is only dropped when every stored reference is removed.
+     */
     class akn_skin_bitmap_store {
     private:
-        std::vector<fbsbitmap *> bitmap_vector;
+        struct stored_bitmap {
+            fbsbitmap *bitmap_;
+            std::uint32_t store_count_;
+        };
+
+        std::unordered_map<std::uint32_t, stored_bitmap> bitmaps_;
 
     public:
         explicit akn_skin_bitmap_store() = default;
         void store_bitmap(fbsbitmap *bitmap);
         void remove_stored_bitmap(const std::uint32_t bmp_handle);
         void destroy_bitmaps();
+
+        fbsbitmap *get_stored_bitmap(const std::uint32_t bmp_handle) const;
+
+        std::size_t stored_bitmap_count() const {
+            return bitmaps_.size();
+        }
     };
 } // namespace eka2l1
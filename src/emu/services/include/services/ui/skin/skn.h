@@ -27,8 +27,13 @@
 #include <services/ui/skin/common.h>
 
 #include <map>
+#include <string>
 #include <unordered_map>
 
+namespace eka2l1::common {
+    class chunkyseri;
+}
+
 namespace eka2l1::epoc {
     enum akn_skin_descriptor_chunk_type {
         as_desc_skin_desc = 0,
@@ -353,5 +358,43 @@ namespace eka2l1::epoc {
 
         explicit skn_file(common::ro_stream *stream, plat_ver platform_version = { 2, 8 },
             ::language lang = ::language::any);
+
+        /**
+         * @brief Construct an empty definition set, to be filled from a pre-parsed cache.
+         */
+        explicit skn_file(plat_ver platform_version, ::language lang);
+
+        /**
+         * @brief Serialize the parsed definitions. The source stream is not used.
+         */
+        void do_state(common::chunkyseri &seri);
     };
+
+    /**
+     * @brief Identify the SKN file a pre-parsed cache was built from.
+     *
+     * The cache is only valid for the same file, platform version and importer language, since
+     * restriction chunks are resolved while parsing.
+     */
+    struct skn_cache_key {
+        std::uint64_t path_hash_;
+        std::uint64_t source_size_;
+        std::uint64_t source_last_write_;
+    };
+
+    /**
+     * @brief Load pre-parsed SKN definitions from a cache file, by memory-mapping it.
+     *
+     * @param path      Path to the cache file on the host.
+     * @param key       Identity of the SKN file expected to be cached.
+     * @param file      Definition set to fill. Its platform version and language must be set.
+     *
+     * @returns True if the cache matched and was loaded.
+     */
+    bool load_skn_cache(const std::string &path, const skn_cache_key &key, skn_file &file);
+
+    /**
+     * @brief Write parsed SKN definitions to a cache file.
+     */
+    bool save_skn_cache(const std::string &path, const skn_cache_key &key, skn_file &file);
 }
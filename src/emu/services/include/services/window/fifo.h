@@ -35,6 +35,177 @@
 #include <vector>
 
 namespace eka2l1::epoc {
+    /**
+     * \brief Queue of events sharing the same priority.
+     *
+     * Events live in a ring indexed by their sequence number, so an event can be reached from its sequence
+     * in constant time. Removing an event only marks its slot dead; the head skips dead slots as it moves on.
+     *
+     * The ring doubles in size when it runs out of space. This only happens when the owner queues past its limit.
+     */
+    template <typename T>
+    class fifo_lane {
+        struct slot {
+            std::uint32_t seq = 0;
+            bool alive = false;
+            T evt;
+        };
+
+        std::vector<slot> slots_;
+
+        std::uint32_t head_; ///< Sequence of the oldest slot still held.
+        std::uint32_t tail_; ///< Sequence given to the next event.
+        std::size_t live_count_;
+
+        slot &slot_of(const std::uint32_t seq) {
+            return slots_[seq & (slots_.size() - 1)];
+        }
+
+        void trim() {
+            while ((head_ != tail_) && !slot_of(head_).alive) {
+                head_++;
+            }
+        }
+
+        void grow() {
+            std::vector<slot> new_slots(slots_.size() * 2);
+
+            // Sequences are kept, so that IDs given out stay valid
+            for (std::uint32_t seq = head_; seq != tail_; seq++) {
+                new_slots[seq & (new_slots.size() - 1)] = slot_of(seq);
+            }
+
+            slots_.swap(new_slots);
+        }
+
+    public:
+        explicit fifo_lane(const std::size_t initial_capacity)
+            : head_(0)
+            , tail_(0)
+            , live_count_(0) {
+            std::size_t capacity = 1;
+            while (capacity < initial_capacity) {
+                capacity <<= 1;
+            }
+
+            slots_.resize(capacity);
+        }
+
+        std::uint32_t push(const T &evt) {
+            if (tail_ - head_ == slots_.size()) {
+                grow();
+            }
+
+            slot &target = slot_of(tail_);
+            target.seq = tail_;
+            target.alive = true;
+            target.evt = evt;
+
+            live_count_++;
+            return tail_++;
+        }
+
+        /*! \brief Take the oldest event out of the lane.
+         *
+         * \returns False if the lane is empty.
+        */
+        bool pop(T &evt) {
+            if (live_count_ == 0) {
+                return false;
+            }
+
+            // The head is always alive after a trim
+            slot &target = slot_of(head_);
+            evt = target.evt;
+            target.alive = false;
+
+            live_count_--;
+            trim();
+
+            return true;
+        }
+
+        /*! \brief Remove an event by its sequence number.
+         *
+         * \returns False if the event is not in the lane anymore.
+        */
+        bool remove(const std::uint32_t seq) {
+            if (seq - head_ >= tail_ - head_) {
+                return false;
+            }
+
+            slot &target = slot_of(seq);
+            if (!target.alive || (target.seq != seq)) {
+                return false;
+            }
+
+            target.alive = false;
+            live_count_--;
+
+            trim();
+            return true;
+        }
+
+        /*! \brief Get the newest event in the lane.
+         *
+         * \param seq If not null, receive the sequence of the event.
+         * \returns Null if the lane is empty.
+        */
+        T *back(std::uint32_t *seq = nullptr) {
+            for (std::uint32_t current = tail_; current != head_;) {
+                current--;
+
+                slot &target = slot_of(current);
+                if (target.alive) {
+                    if (seq) {
+                        *seq = current;
+                    }
+
+                    return &target.evt;
+                }
+            }
+
+            return nullptr;
+        }
+
+        /*! \brief Iterate events from the oldest, keeping those the callback returns true for.
+         *
+         * The callback may remove other events of the lane while iterating.
+         *
+         * \returns Number of events removed because the callback returned false.
+        */
+        template <typename F>
+        std::size_t filter(F func) {
+            const std::uint32_t end = tail_;
+            std::size_t removed = 0;
+
+            for (std::uint32_t seq = head_; seq != end; seq++) {
+                slot &target = slot_of(seq);
+
+                if (target.alive && !func(seq, target.evt)) {
+                    target.alive = false;
+                    live_count_--;
+                    removed++;
+                }
+            }
+
+            trim();
+            return removed;
+        }
+
+        std::uint32_t head() const {
+            return head_;
+        }
+
+        std::size_t size() const {
+            return live_count_;
+        }
+
+        bool empty() const {
+            return live_count_ == 0;
+        }
+    };
+
     template <typename T, unsigned int MAX_ELEM = 32>
     class base_fifo {
     public:
@@ -47,40 +218,150 @@ namespace eka2l1::epoc {
             low ///< When the queue is max, the event will not be schedule, until some elements are freed
         };
 
-        struct fifo_element {
-            std::uint32_t id;
-            std::uint16_t pri;
-            T evt;
-
-            fifo_element(const std::uint32_t id, const T &evt)
-                : id(id)
-                , evt(std::move(evt)) {
+    protected:
+        // An event ID is made of the lane index, and the event sequence in that lane
+        static constexpr std::uint32_t LANE_INDEX_SHIFT = 24;
+        static constexpr std::uint32_t LANE_SEQUENCE_MASK = (1 << LANE_INDEX_SHIFT) - 1;
+        static constexpr std::size_t MAX_LANE_COUNT = 1 << (32 - LANE_INDEX_SHIFT);
+
+        struct priority_lane {
+            std::uint32_t pri;
+            fifo_lane<T> lane;
+
+            explicit priority_lane(const std::uint32_t pri)
+                : pri(pri)
+                , lane(MAX_ELEM) {
             }
         };
 
-    protected:
-        std::vector<fifo_element> q_;
+        std::vector<priority_lane> lanes_; ///< Index of a lane never changes, since it is part of event IDs.
+        std::vector<std::uint32_t> lane_order_; ///< Lane indices, from the lowest priority value to the highest.
+        std::size_t size_ = 0;
         std::mutex lock_;
 
         epoc::notify_info nof;
 
     public:
         void trigger_notification() {
-            if (q_.size() > 0)
+            if (size_ > 0)
                 nof.complete(0);
         }
 
     protected:
+        std::uint32_t get_lane_index(const std::uint32_t pri) {
+            for (const std::uint32_t lane_index : lane_order_) {
+                if (lanes_[lane_index].pri == pri) {
+                    return lane_index;
+                }
+            }
+
+            std::uint32_t lane_index = static_cast<std::uint32_t>(lanes_.size());
+
+            // Reuse lanes that are empty. Their old sequences never match anything queued later
+            for (std::uint32_t i = 0; i < lanes_.size(); i++) {
+                if (lanes_[i].lane.empty()) {
+                    lane_index = i;
+                    break;
+                }
+            }
+
+            if (lane_index == lanes_.size()) {
+                if (lanes_.size() == MAX_LANE_COUNT) {
+                    // Not going to happen, but if it does, the order is just not respected
+                    return lane_order_.back();
+                }
+
+                lanes_.emplace_back(pri);
+            } else {
+                lane_order_.erase(std::find(lane_order_.begin(), lane_order_.end(), lane_index));
+                lanes_[lane_index].pri = pri;
+            }
+
+            auto insert_pos = std::upper_bound(lane_order_.begin(), lane_order_.end(), pri,
+                [this](const std::uint32_t pri, const std::uint32_t lane_index) { return pri < lanes_[lane_index].pri; });
+
+            lane_order_.insert(insert_pos, lane_index);
+            return lane_index;
+        }
+
+        static std::uint32_t make_event_id(const std::uint32_t lane_index, const std::uint32_t seq) {
+            return (lane_index << LANE_INDEX_SHIFT) | (seq & LANE_SEQUENCE_MASK);
+        }
+
         /*! \brief Queue an event. This doesn't care about whenther the queue has reached maximum size
          *         yet
          * 
          * This method is unsafe
+         *
+         * \param pri Events with lower value are taken out first. Same priority events keep their order.
+         * \returns ID of the event, to be used with cancel_event_queue.
+        */
+        std::uint32_t queue_event_dont_care(const T &evt, const std::uint32_t pri = 0) {
+            const std::uint32_t lane_index = get_lane_index(pri);
+            const std::uint32_t seq = lanes_[lane_index].lane.push(evt);
+
+            size_++;
+            return make_event_id(lane_index, seq);
+        }
+
+        /*! \brief Get the newest event queued with a priority.
+         *
+         * This method is unsafe
+        */
+        T *last_event(const std::uint32_t pri, std::uint32_t *id = nullptr) {
+            for (const std::uint32_t lane_index : lane_order_) {
+                if (lanes_[lane_index].pri == pri) {
+                    std::uint32_t seq = 0;
+                    T *evt = lanes_[lane_index].lane.back(&seq);
+
+                    if (evt && id) {
+                        *id = make_event_id(lane_index, seq);
+                    }
+
+                    return evt;
+                }
+            }
+
+            return nullptr;
+        }
+
+        /*! \brief Remove an event by its ID.
+         *
+         * This method is unsafe
         */
-        std::uint32_t queue_event_dont_care(const T &evt) {
-            fifo_element element(static_cast<std::uint32_t>(q_.size()) + 1, evt);
-            q_.push_back(std::move(element));
+        bool remove_event(const std::uint32_t id) {
+            const std::uint32_t lane_index = id >> LANE_INDEX_SHIFT;
+            if (lane_index >= lanes_.size()) {
+                return false;
+            }
 
-            return static_cast<std::uint32_t>(q_.size());
+            fifo_lane<T> &lane = lanes_[lane_index].lane;
+
+            // Rebuild the full sequence from the low bits kept in the ID
+            const std::uint32_t seq = lane.head() + ((id - lane.head()) & LANE_SEQUENCE_MASK);
+
+            if (lane.remove(seq)) {
+                size_--;
+                return true;
+            }
+
+            return false;
+        }
+
+        /*! \brief Iterate all events in the order they would be taken out. Events the callback
+         *         returns false for are removed.
+         *
+         * The callback receives the event ID and the event. It may call remove_event.
+         *
+         * This method is unsafe
+        */
+        template <typename F>
+        void filter_events(F func) {
+            for (const std::uint32_t lane_index : lane_order_) {
+                size_ -= lanes_[lane_index].lane.filter([&](const std::uint32_t seq, T &evt) {
+                    return func(make_event_id(lane_index, seq), evt);
+                });
+            }
         }
 
     public:
@@ -96,7 +377,7 @@ namespace eka2l1::epoc {
         void set_listener(epoc::notify_info nof_info) {
             const std::lock_guard<std::mutex> guard(lock_);
 
-            if (q_.size() > 0) {
+            if (size_ > 0) {
                 // Complete with KErrNone
                 nof_info.complete(0);
                 return;
@@ -118,13 +399,7 @@ namespace eka2l1::epoc {
         */
         void cancel_event_queue(std::uint32_t id) {
             const std::lock_guard<std::mutex> guard(lock_);
-
-            auto elem_ite = std::find_if(q_.begin(), q_.end(),
-                [=](const fifo_element &elem) { return elem.id == id; });
-
-            if (elem_ite != q_.end()) {
-                q_.erase(elem_ite);
-            }
+            remove_event(id);
         }
 
         typedef bool (*walker_func)(void *userdata, T &evt);
@@ -142,14 +417,9 @@ namespace eka2l1::epoc {
          * \param userdata      Userdata passed to callback.
          */
         void walk(walker_func walker, void *userdata) {
-            for (std::uint32_t i = 0; i < q_.size();) {
-                if (!walker(userdata, q_[i].evt)) {
-                    // Delete the element
-                    q_.erase(q_.begin() + i);
-                } else {
-                    i++;
-                }
-            }
+            filter_events([=](const std::uint32_t id, T &evt) {
+                return walker(userdata, evt);
+            });
         }
 
         /*! \brief Get an event on the queue.
@@ -158,20 +428,35 @@ namespace eka2l1::epoc {
         */
         std::optional<T> get_evt_opt() {
             const std::lock_guard<std::mutex> guard(lock_);
-            if (q_.size() == 0) {
+            if (size_ == 0) {
                 return std::nullopt;
             }
 
-            fifo_element elem = std::move(q_.front());
+            for (const std::uint32_t lane_index : lane_order_) {
+                T evt;
 
-            // Keep the order. Not too efficient though
-            q_.erase(q_.begin());
-            return elem.evt;
+                if (lanes_[lane_index].lane.pop(evt)) {
+                    size_--;
+                    return evt;
+                }
+            }
+
+            return std::nullopt;
+        }
+
+        std::size_t size() {
+            const std::lock_guard<std::mutex> guard(lock_);
+            return size_;
         }
     };
 
     class event_fifo : public base_fifo<event, 32> {
     protected:
+        enum : std::uint32_t {
+            EVENT_PRIORITY_HIGH = 0,
+            EVENT_PRIORITY_NORMAL = 1
+        };
+
         /*! \brief Check if the event is high-priority
          *
          * High priority events are password, switch on and off event.
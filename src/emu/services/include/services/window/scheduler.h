@@ -37,12 +37,6 @@ namespace eka2l1::epoc {
     struct screen;
 
     struct anim_due_callback_data {
-        int screen_number;
-        animation_scheduler *sched;
-        drivers::graphics_driver *driver;
-    };
-
-    struct sched_scan_callback_data {
         animation_scheduler *sched;
         drivers::graphics_driver *driver;
     };
@@ -51,58 +45,64 @@ namespace eka2l1::epoc {
      * \brief A scheduler which schedules screen update.
      * 
      * The scheduler takes screen redraw request and schedule them. If a schedule happens on a screen
-     * that already scheduled its redraw, the due time will be updated.
+     * that already scheduled its redraw, the sooner due time is kept.
      * 
-     * The scheduler will scans and triggers redraw on these occasions:
-     * - When all screen are idled (scans triggers in granularity).
-     * - Force redraw are called (happens on screen flushing: get scan line, get screenshot, etc...)
+     * Due times are kept in a min-heap, and a single timer event is armed for the soonest one. Nothing
+     * runs while no screen is waiting for a redraw.
      */
     class animation_scheduler {
         struct anim_schedule {
             screen *scr;
             bool scheduled = false;
             std::uint64_t time;
+            std::uint32_t generation = 0; ///< Bumped on every change, so old heap entries are skipped.
         };
 
         struct screen_state {
             enum {
                 inactive = 0,
-                active = 1 << 0,
-                scheduled = 1 << 1
+                active = 1 << 0
             };
 
             std::uint8_t flags;
-            std::uint64_t time_expected_redraw;
+        };
+
+        struct due_entry {
+            std::uint64_t time;
+            int screen_number;
+            std::uint32_t generation;
         };
 
         std::vector<anim_schedule> schedules_;
         std::vector<screen_state> states_;
-        std::vector<anim_due_callback_data> callback_datas_;
+        std::vector<due_entry> due_heap_;
 
         ntimer *timing_;
         kernel_system *kern_;
 
-        sched_scan_callback_data scan_callback_data_;
+        anim_due_callback_data callback_data_;
 
         int anim_due_evt_;
-        int callback_evt_;
 
-        bool callback_scheduled_;
+        bool due_event_armed_;
+        std::uint64_t due_event_time_;
+
         std::mutex lock_;
 
-        void schedule_scans(drivers::graphics_driver *driver);
+        void push_due(const int screen_number);
+        void arm_due_event();
 
     public:
         explicit animation_scheduler(kernel_system *kern, ntimer *timing, const int total_screen);
         ~animation_scheduler();
 
         /**
-         * \brief Callback for queueing screen redraw, when the scheduler is idled.
+         * \brief Redraw all screens whose due has passed, then arm the timer for the next due.
          */
-        void idle_callback(drivers::graphics_driver *driver);
+        void process_due_animations(drivers::graphics_driver *driver);
 
         /**
-         * \brief Invoke when animation is triggered, and handle redraw.
+         * \brief Redraw a screen right away.
          * 
          * \param screen_number The number of the screen to do redraw. Based of 0.
          */
@@ -114,14 +114,10 @@ namespace eka2l1::epoc {
          */
         anim_schedule *get_scheduled_screen_update(const int scr_num);
 
-        std::int64_t get_due_delta(const bool force_redraw, const std::uint64_t due);
-
-        void scan_for_redraw(drivers::graphics_driver *driver, const int screen_number, const bool force_redraw);
-
         /**
          * \brief Schedule a screen redraw.
          * \param scr    The screen to be scheduled.
-         * \param time   Time for the redraw to occurs, since 1/1/1970.
+         * \param time   Time for the redraw to occurs, in emulated microseconds.
          */
         void schedule(drivers::graphics_driver *driver, screen *scr, const std::uint64_t time);
 
@@ -131,4 +127,4 @@ namespace eka2l1::epoc {
          */
         void unschedule(const int screen_number);
     };
-}
\ No newline at end of file
+}
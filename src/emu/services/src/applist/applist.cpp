@@ -19,6 +19,7 @@
  */
 
 #include <services/applist/applist.h>
+#include <services/applist/cache.h>
 #include <services/applist/op.h>
 #include <services/fs/fs.h>
 #include <services/context.h>
@@ -33,7 +34,9 @@
 
 #include <common/common.h>
 #include <kernel/kernel.h>
+#include <loader/mbm.h>
 #include <loader/rsc.h>
+#include <system/devices.h>
 #include <system/epoc.h>
 #include <utils/apacmd.h>
 #include <utils/bafl.h>
@@ -47,6 +50,18 @@
 
 namespace eka2l1 {
     static void populate_icon_sizes(common::chunkyseri &seri, apa_app_registry *reg) {
+        if (reg->app_icons.empty()) {
+            // Sizes read from the icon file when the registry was parsed (or loaded from the cache)
+            std::uint32_t size = static_cast<std::uint32_t>(reg->icon_sizes.size());
+            seri.absorb(size);
+            for (auto &icon_size : reg->icon_sizes) {
+                seri.absorb(icon_size.x);
+                seri.absorb(icon_size.y);
+            }
+
+            return;
+        }
+
         std::uint32_t size = reg->app_icons.size();
         seri.absorb(size);
         for (const auto &icon : reg->app_icons) {
@@ -73,10 +88,56 @@ namespace eka2l1 {
     }
 
     applist_server::~applist_server() {
+        for (auto &[drv, handles] : reg_watch_handles_) {
+            for (const std::int32_t handle : handles) {
+                reg_watcher_.unwatch(handle);
+            }
+        }
+
         io_system *io = sys->get_io_system();
         io->remove_drive_change_notify(drive_change_handle_);
     }
 
+    static bool make_registry_source_stamp(eka2l1::io_system *io, const std::u16string &path, apa_registry_source_stamp &stamp) {
+        std::optional<entry_info> info = io->get_entry_info(path);
+
+        if (!info) {
+            return false;
+        }
+
+        stamp.path_ = path;
+        stamp.last_modified_ = info->last_write;
+        stamp.size_ = info->size;
+
+        return true;
+    }
+
+    static void read_icon_sizes(eka2l1::io_system *io, apa_app_registry &reg) {
+        reg.icon_sizes.clear();
+
+        // MIF icons are scalable, only bitmaps in MBM files have a size of their own
+        if (reg.icon_file_path.empty() || (common::lowercase_ucs2_string(eka2l1::path_extension(reg.icon_file_path)) != u".mbm")) {
+            return;
+        }
+
+        symfile f = io->open_file(reg.icon_file_path, READ_MODE | BIN_MODE);
+
+        if (!f) {
+            return;
+        }
+
+        eka2l1::ro_file_stream stream(f.get());
+        loader::mbm_file mbm(reinterpret_cast<common::ro_stream *>(&stream));
+
+        if (!mbm.do_read_headers()) {
+            return;
+        }
+
+        for (const loader::sbm_header &header : mbm.sbm_headers) {
+            reg.icon_sizes.push_back(header.size_pixels);
+        }
+    }
+
     bool applist_server::load_registry_oldarch(eka2l1::io_system *io, const std::u16string &path, drive_number land_drive,
         const language ideal_lang) {
         symfile f = io->open_file(path, READ_MODE | BIN_MODE);
@@ -178,6 +239,7 @@ namespace eka2l1 {
         });
 
         std::uint64_t last_modified = f->last_modify_since_0ad();
+        const std::uint64_t rsc_size = f->size();
 
         if (find_result != regs.end()) {
             if (find_result->last_rsc_modified != last_modified) {
@@ -187,6 +249,19 @@ namespace eka2l1 {
             }
         }
 
+        if (reg_cache_) {
+            std::u16string cached_localised_path;
+
+            if (const apa_app_registry *cached = reg_cache_->find(io, nearest_path, last_modified, rsc_size, &cached_localised_path)) {
+                // Apps without a localised file are not listed, same as when parsed below
+                if (!cached_localised_path.empty()) {
+                    regs.push_back(*cached);
+                }
+
+                return true;
+            }
+        }
+
         apa_app_registry reg;
 
         reg.land_drive = land_drive;
@@ -250,6 +325,11 @@ namespace eka2l1 {
             ideal_lang, land_drive);
 
         if (localised_path.empty()) {
+            // Not listed, but still worth caching to skip parsing next time. The cache notices when a localised file appears
+            if (reg_cache_) {
+                reg_cache_->add(reg, { apa_registry_source_stamp{ nearest_path, last_modified, rsc_size } }, localised_path);
+            }
+
             return true;
         }
 
@@ -289,6 +369,26 @@ namespace eka2l1 {
             }
         }
 
+        read_icon_sizes(io, reg);
+
+        if (reg_cache_) {
+            // Remember every file this registry was built from, so the cache can tell when to reparse
+            std::vector<apa_registry_source_stamp> sources;
+            sources.push_back(apa_registry_source_stamp{ nearest_path, last_modified, rsc_size });
+
+            apa_registry_source_stamp stamp;
+
+            if (make_registry_source_stamp(io, localised_path, stamp)) {
+                sources.push_back(stamp);
+            }
+
+            if (!reg.icon_file_path.empty() && make_registry_source_stamp(io, reg.icon_file_path, stamp)) {
+                sources.push_back(stamp);
+            }
+
+            reg_cache_->add(reg, sources, localised_path);
+        }
+
         regs.push_back(std::move(reg));
         return true;
     }
@@ -329,16 +429,14 @@ namespace eka2l1 {
         switch (act) {
         case drive_action_mount:
             avail_drives_ |= 1 << (drv - drive_a);
-            if (kern->is_eka1()) {
-                modified = rescan_registries_on_drive_oldarch(io, drv);
-            } else {
-                modified = rescan_registries_on_drive_newarch(io, drv);
-            }
+            modified = rescan_registries_on_drive(io, drv);
+            watch_registries_on_drive(io, drv);
 
             break;
 
         case drive_action_unmount:
             avail_drives_ &= ~(1 << (drv - drive_a));
+            unwatch_registries_on_drive(drv);
             remove_registries_on_drive(drv);
             modified = true;
 
@@ -350,7 +448,141 @@ namespace eka2l1 {
 
         if (modified) {
             sort_registry_list();
+            save_registry_cache();
+        }
+    }
+
+    bool applist_server::rescan_registries_on_drive(eka2l1::io_system *io, const drive_number drv) {
+        if (kern->is_eka1()) {
+            return rescan_registries_on_drive_oldarch(io, drv);
+        }
+
+        return rescan_registries_on_drive_newarch(io, drv);
+    }
+
+    void applist_server::load_registry_cache() {
+        if (reg_cache_) {
+            return;
+        }
+
+        std::string firmware_code = "unknown";
+        device_manager *mngr = sys->get_device_manager();
+
+        if (mngr && mngr->get_current()) {
+            firmware_code = common::lowercase_string(mngr->get_current()->firmware_code);
+        }
+
+        // Registries of different devices may share the same path, keep them apart
+        reg_cache_ = std::make_unique<apa_registry_cache>(fmt::format("cache/applist/{}.bin", firmware_code),
+            kern->get_current_language());
+
+        if (reg_cache_->load()) {
+            LOG_INFO(SERVICE_APPLIST, "Loaded {} cached app registries", reg_cache_->size());
+        }
+    }
+
+    void applist_server::save_registry_cache() {
+        if (reg_cache_) {
+            reg_cache_->save();
+        }
+    }
+
+    void applist_server::watch_registries_on_drive(eka2l1::io_system *io, const drive_number drv) {
+        if (reg_watch_handles_.find(drv) != reg_watch_handles_.end()) {
+            return;
+        }
+
+        const std::u16string drive_root = std::u16string(1, drive_to_char16(drv)) + u":";
+        std::vector<std::u16string> folders;
+
+        if (kern->is_eka1()) {
+            folders.push_back(drive_root + u"\\System\\Apps\\");
+        } else {
+            folders.push_back(drive_root + u"\\Private\\10003a3f\\apps\\");
+            folders.push_back(drive_root + u"\\Private\\10003a3f\\import\\apps\\");
+        }
+
+        std::vector<std::int32_t> &handles = reg_watch_handles_[drv];
+        const std::uint32_t drive_bit = 1 << (drv - drive_a);
+
+        for (const std::u16string &folder : folders) {
+            std::optional<std::u16string> host_path = io->get_raw_path(folder);
+
+            if (!host_path || !io->exist(folder)) {
+                continue;
+            }
+
+            // The callback runs on the watcher thread, only mark the drive here and let the next access rescan it
+            const std::int32_t handle = reg_watcher_.watch(common::ucs2_to_utf8(*host_path), [this, drive_bit](void *userdata, common::directory_changes &changes) {
+                pending_rescan_drives_ |= drive_bit;
+            }, nullptr, common::directory_change_move | common::directory_change_creation | common::directory_change_last_write);
+
+            if (handle > 0) {
+                handles.push_back(handle);
+            }
+        }
+    }
+
+    void applist_server::unwatch_registries_on_drive(const drive_number drv) {
+        auto ite = reg_watch_handles_.find(drv);
+
+        if (ite == reg_watch_handles_.end()) {
+            return;
+        }
+
+        for (const std::int32_t handle : ite->second) {
+            reg_watcher_.unwatch(handle);
+        }
+
+        reg_watch_handles_.erase(ite);
+    }
+
+    void applist_server::process_pending_rescans(eka2l1::io_system *io) {
+        const std::uint32_t pending = pending_rescan_drives_.exchange(0) & avail_drives_;
+
+        if (!pending) {
+            return;
+        }
+
+        bool modified = false;
+
+        for (std::uint8_t i = 0; i < drive_count; i++) {
+            if (!(pending & (1 << i))) {
+                continue;
+            }
+
+            const drive_number drv = static_cast<drive_number>(static_cast<int>(drive_a) + i);
+
+            // Drop the registries that are gone, the rest is only reparsed if they changed
+            const std::size_t prev = regs.size();
+
+            common::erase_elements(regs, [this, io, drv](const apa_app_registry &reg) {
+                if ((reg.land_drive != drv) || io->exist(reg.rsc_path)) {
+                    return false;
+                }
+
+                if (reg_cache_) {
+                    reg_cache_->remove(reg.rsc_path);
+                }
+
+                return true;
+            });
+
+            if (prev != regs.size()) {
+                modified = true;
+            }
+
+            if (rescan_registries_on_drive(io, drv)) {
+                modified = true;
+            }
+        }
+
+        if (modified) {
+            LOG_INFO(SERVICE_APPLIST, "App registries changed on host, list updated");
+            sort_registry_list();
         }
+
+        save_registry_cache();
     }
 
     bool applist_server::rescan_registries_on_drive_oldarch(eka2l1::io_system *io, const drive_number drv) {
@@ -421,11 +653,18 @@ namespace eka2l1 {
             }
         }
 
+        load_registry_cache();
+
         // Delete entries that no longer exist...
         std::size_t prev = regs.size();
 
-        common::erase_elements(regs, [io](const apa_app_registry &reg) {
-            return !io->exist(reg.rsc_path);
+        common::erase_elements(regs, [this, io](const apa_app_registry &reg) {
+            if (io->exist(reg.rsc_path)) {
+                return false;
+            }
+
+            reg_cache_->remove(reg.rsc_path);
+            return true;
         });
 
         if (prev != regs.size()) {
@@ -435,17 +674,12 @@ namespace eka2l1 {
         for (std::uint8_t i = 0; i < drive_count; i++) {
             if (avail_drives_ & (1 << i)) {
                 drive_number drv = static_cast<drive_number>(static_cast<int>(drive_a) + i);
-                bool drv_modified = false;
 
-                if (kern->is_eka1()) {
-                    drv_modified = rescan_registries_on_drive_oldarch(io, drv);
-                } else {
-                    drv_modified = rescan_registries_on_drive_newarch(io, drv);
-                }
-
-                if (drv_modified) {
+                if (rescan_registries_on_drive(io, drv)) {
                     global_modified = true;
                 }
+
+                watch_registries_on_drive(io, drv);
             }
         }
 
@@ -453,6 +687,8 @@ namespace eka2l1 {
             sort_registry_list();
         }
 
+        save_registry_cache();
+
         // Register drive change callback
         if (!drive_change_handle_) {
             drive_change_handle_ = io->register_drive_change_notify([this](void *userdata, drive_number drv, drive_action act) {
@@ -523,6 +759,17 @@ namespace eka2l1 {
         return nullptr;
     }
 
+    void applist_server::refresh_registries() {
+        const std::lock_guard<std::mutex> guard(list_access_mut_);
+
+        if (!(flags & AL_INITED)) {
+            init();
+            return;
+        }
+
+        process_pending_rescans(sys->get_io_system());
+    }
+
     void applist_server::is_accepted_to_run(service::ipc_context &ctx) {
         auto exe_name = ctx.get_argument_value<std::u16string>(0);
 
@@ -669,7 +916,7 @@ namespace eka2l1 {
             return;
         }
 
-        if (reg->app_icons.size() == 0) {
+        if (reg->app_icons.empty() && reg->icon_sizes.empty()) {
             ctx.complete(epoc::error_not_supported);
             return;
         }
@@ -910,6 +1157,9 @@ namespace eka2l1 {
     }
 
     void applist_session::fetch(service::ipc_context *ctx) {
+        // No registry is referenced yet, so this is the place to apply host changes
+        server<applist_server>()->refresh_registries();
+
         const int llevel = server<applist_server>()->legacy_level();
         if (llevel == APA_LEGACY_LEVEL_OLD) {
             switch (ctx->msg->function) {
@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <services/applist/cache.h>
+
+#include <common/algorithm.h>
+#include <common/buffer.h>
+#include <common/chunkyseri.h>
+#include <common/cvt.h>
+#include <common/fileutils.h>
+#include <common/log.h>
+#include <common/path.h>
+
+#include <utils/bafl.h>
+#include <vfs/vfs.h>
+
+namespace eka2l1 {
+    static constexpr std::uint32_t APA_REGISTRY_CACHE_MAGIC = 0x43525041; // APRC
+    static constexpr std::uint32_t APA_REGISTRY_CACHE_VERSION = 2;
+
+    static void do_state_for_buf_static(common::chunkyseri &seri, epoc::buf_static<char16_t, 0x100> &buf) {
+        std::u16string str;
+
+        if (seri.get_seri_mode() != common::SERI_MODE_READ) {
+            str = buf.to_std_string(nullptr);
+        }
+
+        seri.absorb(str);
+
+        if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+            buf.assign(nullptr, str);
+        }
+    }
+
+    static void do_state_for_capability(common::chunkyseri &seri, apa_capability &caps) {
+        seri.absorb(caps.ability);
+        seri.absorb(caps.support_being_asked_to_create_new_file);
+        seri.absorb(caps.is_hidden);
+        seri.absorb(caps.launch_in_background);
+
+        std::u16string group_name;
+
+        if (seri.get_seri_mode() != common::SERI_MODE_READ) {
+            group_name = caps.group_name.to_std_string(nullptr);
+        }
+
+        seri.absorb(group_name);
+
+        if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+            caps.group_name.assign(nullptr, group_name);
+        }
+
+        seri.absorb(caps.flags);
+    }
+
+    void do_state_for_registry(common::chunkyseri &seri, apa_app_registry &reg) {
+        seri.absorb(reg.mandatory_info.uid);
+        do_state_for_buf_static(seri, reg.mandatory_info.app_path);
+        do_state_for_buf_static(seri, reg.mandatory_info.short_caption);
+        do_state_for_buf_static(seri, reg.mandatory_info.long_caption);
+
+        do_state_for_capability(seri, reg.caps);
+
+        seri.absorb(reg.rsc_path);
+        seri.absorb(reg.last_rsc_modified);
+        seri.absorb(reg.localised_info_rsc_path);
+        seri.absorb(reg.localised_info_rsc_id);
+        seri.absorb(reg.default_screen_number);
+        seri.absorb(reg.icon_count);
+        seri.absorb(reg.icon_file_path);
+
+        seri.absorb_container(reg.icon_sizes, [](common::chunkyseri &seri, eka2l1::vec2 &size) {
+            seri.absorb(size.x);
+            seri.absorb(size.y);
+        });
+
+        seri.absorb_container(reg.data_types, [](common::chunkyseri &seri, data_type &type) {
+            seri.absorb(type.priority_);
+            seri.absorb(type.type_);
+        });
+
+        seri.absorb_container(reg.view_datas, [](common::chunkyseri &seri, view_data &view) {
+            seri.absorb(view.uid_);
+            seri.absorb(view.screen_mode_);
+            seri.absorb(view.icon_count_);
+            seri.absorb(view.caption_);
+        });
+
+        seri.absorb_container(reg.ownership_list, [](common::chunkyseri &seri, std::u16string &path) {
+            seri.absorb(path);
+        });
+
+        seri.absorb(reg.land_drive);
+    }
+
+    apa_registry_cache::apa_registry_cache(const std::string &path, const language lang)
+        : path_(path)
+        , lang_(lang)
+        , dirty_(false) {
+    }
+
+    int apa_registry_cache::do_state(common::chunkyseri &seri) {
+        std::uint32_t magic = APA_REGISTRY_CACHE_MAGIC;
+        std::uint32_t version = APA_REGISTRY_CACHE_VERSION;
+        language lang = lang_;
+
+        seri.absorb(magic);
+        seri.absorb(version);
+        seri.absorb(lang);
+
+        if ((magic != APA_REGISTRY_CACHE_MAGIC) || (version != APA_REGISTRY_CACHE_VERSION)) {
+            return -1;
+        }
+
+        // Localised captions depend on the language the registries were loaded with
+        if (lang != lang_) {
+            return -2;
+        }
+
+        std::uint32_t entry_count = static_cast<std::uint32_t>(entries_.size());
+        seri.absorb(entry_count);
+
+        auto do_state_for_entry = [&](cache_entry &entry) {
+            seri.absorb_container(entry.sources_, [](common::chunkyseri &seri, apa_registry_source_stamp &stamp) {
+                seri.absorb(stamp.path_);
+                seri.absorb(stamp.last_modified_);
+                seri.absorb(stamp.size_);
+            });
+
+            seri.absorb(entry.localised_path_);
+
+            do_state_for_registry(seri, entry.registry_);
+        };
+
+        if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+            for (std::uint32_t i = 0; i < entry_count; i++) {
+                cache_entry entry;
+                do_state_for_entry(entry);
+
+                if (entry.sources_.empty()) {
+                    return -3;
+                }
+
+                entries_.emplace(common::lowercase_ucs2_string(entry.sources_[0].path_), std::move(entry));
+            }
+        } else {
+            for (auto &[path, entry] : entries_) {
+                do_state_for_entry(entry);
+            }
+        }
+
+        return 0;
+    }
+
+    bool apa_registry_cache::load() {
+        common::ro_std_file_stream stream(path_, true);
+
+        if (!stream.valid()) {
+            return false;
+        }
+
+        std::vector<std::uint8_t> buf(stream.size());
+
+        if (buf.empty() || (stream.read(buf.data(), buf.size()) != buf.size())) {
+            return false;
+        }
+
+        common::chunkyseri seri(buf.data(), buf.size(), common::SERI_MODE_READ);
+
+        if (do_state(seri) != 0) {
+            LOG_INFO(SERVICE_APPLIST, "App registry cache is outdated, rebuilding");
+
+            entries_.clear();
+            return false;
+        }
+
+        dirty_ = false;
+        return true;
+    }
+
+    bool apa_registry_cache::save() {
+        if (!dirty_) {
+            return true;
+        }
+
+        std::vector<std::uint8_t> buf;
+
+        {
+            common::chunkyseri seri(nullptr, 0, common::SERI_MODE_MEASURE);
+            do_state(seri);
+
+            buf.resize(seri.size());
+        }
+
+        common::chunkyseri seri(buf.data(), buf.size(), common::SERI_MODE_WRITE);
+        do_state(seri);
+
+        const std::string cache_dir = eka2l1::file_directory(path_);
+
+        if (!cache_dir.empty()) {
+            common::create_directories(cache_dir);
+        }
+
+        common::wo_std_file_stream stream(path_, true);
+
+        if (!stream.valid() || (stream.write(buf.data(), buf.size()) != buf.size())) {
+            LOG_WARN(SERVICE_APPLIST, "Unable to write app registry cache to {}", path_);
+            return false;
+        }
+
+        dirty_ = false;
+        return true;
+    }
+
+    const apa_app_registry *apa_registry_cache::find(io_system *io, const std::u16string &rsc_path, const std::uint64_t last_modified,
+        const std::uint64_t size, std::u16string *localised_path) {
+        auto ite = entries_.find(common::lowercase_ucs2_string(rsc_path));
+
+        if (ite == entries_.end()) {
+            return nullptr;
+        }
+
+        const std::vector<apa_registry_source_stamp> &sources = ite->second.sources_;
+
+        if ((sources[0].last_modified_ != last_modified) || (sources[0].size_ != size)) {
+            return nullptr;
+        }
+
+        // A localisable resource may have appeared or been removed without touching the recorded files
+        const apa_app_registry &reg = ite->second.registry_;
+
+        if (!reg.localised_info_rsc_path.empty()) {
+            const std::u16string current_localised_path = utils::get_nearest_lang_file(io, reg.localised_info_rsc_path, lang_, reg.land_drive);
+
+            if (common::compare_ignore_case(current_localised_path, ite->second.localised_path_) != 0) {
+                return nullptr;
+            }
+        }
+
+        for (std::size_t i = 1; i < sources.size(); i++) {
+            std::optional<entry_info> info = io->get_entry_info(sources[i].path_);
+
+            if (!info || (info->last_write != sources[i].last_modified_) || (info->size != sources[i].size_)) {
+                return nullptr;
+            }
+        }
+
+        if (localised_path) {
+            *localised_path = ite->second.localised_path_;
+        }
+
+        return &ite->second.registry_;
+    }
+
+    void apa_registry_cache::add(const apa_app_registry &reg, const std::vector<apa_registry_source_stamp> &sources,
+        const std::u16string &localised_path) {
+        if (sources.empty() || !reg.app_icons.empty()) {
+            return;
+        }
+
+        cache_entry entry;
+        entry.sources_ = sources;
+        entry.localised_path_ = localised_path;
+        entry.registry_ = reg;
+
+        entries_[common::lowercase_ucs2_string(sources[0].path_)] = std::move(entry);
+        dirty_ = true;
+    }
+
+    void apa_registry_cache::remove(const std::u16string &rsc_path) {
+        if (entries_.erase(common::lowercase_ucs2_string(rsc_path))) {
+            dirty_ = true;
+        }
+    }
+}
@@ -34,6 +34,7 @@
 #include <vfs/vfs.h>
 
 #include <fstream>
+#include <functional>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -224,6 +225,11 @@ namespace eka2l1 {
         return true;
     }
 
+    static std::string get_repo_cache_path(const std::uint32_t key, const std::string &source_path) {
+        // The same repository may exist in many folders, identify the cache with its source path too
+        return fmt::format("cache/cenrep/{:08X}_{:016X}.bin", key, static_cast<std::uint64_t>(std::hash<std::string>{}(source_path)));
+    }
+
     central_repo_server::central_repo_server(eka2l1::system *sys)
         : service::server(sys->get_kernel_system(), sys, nullptr, CENTRAL_REPO_SERVER_NAME, true)
         , id_counter(0) {
@@ -430,8 +436,24 @@ namespace eka2l1 {
                         continue;
                     }
 
+                    const std::string path_utf8 = common::ucs2_to_utf8(*path);
+                    const std::string cache_path = get_repo_cache_path(key, path_utf8);
+
                     repo->uid = key;
-                    if (parse_new_centrep_ini(common::ucs2_to_utf8(*path), *repo)) {
+
+                    if (load_cre_cache(cache_path, path_utf8, *repo)) {
+                        repo->reside_place = avail_drives[0];
+                        repo->access_count = 1;
+                        avail_drives.pop_back();
+
+                        return 0;
+                    }
+
+                    if (parse_new_centrep_ini(path_utf8, *repo)) {
+                        if (!save_cre_cache(cache_path, path_utf8, *repo)) {
+                            LOG_WARN(SERVICE_CENREP, "Unable to write precompiled cache for repo 0x{:X}", key);
+                        }
+
                         repo->reside_place = avail_drives[0];
                         repo->access_count = 1;
                         avail_drives.pop_back();
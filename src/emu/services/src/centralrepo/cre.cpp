@@ -21,9 +21,12 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <common/buffer.h>
 #include <common/chunkyseri.h>
 #include <common/cvt.h>
+#include <common/fileutils.h>
 #include <common/log.h>
+#include <common/path.h>
 
 #include <services/centralrepo/cre.h>
 #include <utils/des.h>
@@ -237,11 +240,146 @@ namespace eka2l1 {
             }
         }
 
+        if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+            repo.sort_entries();
+        }
+
         // TODO: Supply policy for entry
 
         return 0;
     }
 
+    static constexpr std::uint32_t CRE_CACHE_MAGIC = 0x43524543; // CREC
+    static constexpr std::uint32_t CRE_CACHE_VERSION = 1;
+
+    /*
+     * The cache file is a small header identifying the source it was compiled from, followed
+     * by the repository in CRE format:
+     *
+     * |    Size      |      Description               |
+     * |      4       |      Magic (CREC)              |
+     * |      4       |      Cache version             |
+     * |      8       |      Source file size          |
+     * |      8       |      Source last modified time |
+     * |      4 + n   |      Source path               |
+     * |      ...     |      CRE data                  |
+     */
+    static int do_state_for_cre_cache_header(common::chunkyseri &seri, std::uint64_t &source_size, std::uint64_t &source_last_modified,
+        std::string &source_path) {
+        std::uint32_t magic = CRE_CACHE_MAGIC;
+        std::uint32_t version = CRE_CACHE_VERSION;
+
+        seri.absorb(magic);
+        seri.absorb(version);
+
+        if ((magic != CRE_CACHE_MAGIC) || (version != CRE_CACHE_VERSION)) {
+            return -1;
+        }
+
+        seri.absorb(source_size);
+        seri.absorb(source_last_modified);
+        seri.absorb(source_path);
+
+        return 0;
+    }
+
+    static bool get_cre_cache_source_stamp(const std::string &source_path, std::uint64_t &source_size, std::uint64_t &source_last_modified) {
+        const std::int64_t size = common::file_size(source_path);
+
+        if (size < 0) {
+            return false;
+        }
+
+        source_size = static_cast<std::uint64_t>(size);
+        source_last_modified = common::get_last_modifiy_since_ad(common::utf8_to_ucs2(source_path));
+
+        return true;
+    }
+
+    bool load_cre_cache(const std::string &cache_path, const std::string &source_path, eka2l1::central_repo &repo) {
+        std::uint64_t expected_size = 0;
+        std::uint64_t expected_last_modified = 0;
+
+        if (!get_cre_cache_source_stamp(source_path, expected_size, expected_last_modified)) {
+            return false;
+        }
+
+        common::ro_std_file_stream stream(cache_path, true);
+
+        if (!stream.valid()) {
+            return false;
+        }
+
+        std::vector<std::uint8_t> buf(stream.size());
+
+        if (buf.empty() || (stream.read(buf.data(), buf.size()) != buf.size())) {
+            return false;
+        }
+
+        common::chunkyseri seri(buf.data(), buf.size(), common::SERI_MODE_READ);
+
+        std::uint64_t cached_size = 0;
+        std::uint64_t cached_last_modified = 0;
+        std::string cached_source_path;
+
+        if (do_state_for_cre_cache_header(seri, cached_size, cached_last_modified, cached_source_path) != 0) {
+            return false;
+        }
+
+        if ((cached_size != expected_size) || (cached_last_modified != expected_last_modified) || (cached_source_path != source_path)) {
+            // Source has changed since the cache was compiled
+            return false;
+        }
+
+        // Only touch the given repo once everything is read, so a broken cache can still fallback to the source
+        eka2l1::central_repo loaded_repo;
+
+        if (do_state_for_cre(seri, loaded_repo) != 0) {
+            return false;
+        }
+
+        repo = std::move(loaded_repo);
+        return true;
+    }
+
+    bool save_cre_cache(const std::string &cache_path, const std::string &source_path, eka2l1::central_repo &repo) {
+        std::uint64_t source_size = 0;
+        std::uint64_t source_last_modified = 0;
+        std::string source_path_copy = source_path;
+
+        if (!get_cre_cache_source_stamp(source_path, source_size, source_last_modified)) {
+            return false;
+        }
+
+        std::vector<std::uint8_t> bufs;
+
+        {
+            common::chunkyseri seri(nullptr, 0, common::SERI_MODE_MEASURE);
+            do_state_for_cre_cache_header(seri, source_size, source_last_modified, source_path_copy);
+            do_state_for_cre(seri, repo);
+
+            bufs.resize(seri.size());
+        }
+
+        common::chunkyseri seri(bufs.data(), bufs.size(), common::SERI_MODE_WRITE);
+        do_state_for_cre_cache_header(seri, source_size, source_last_modified, source_path_copy);
+        do_state_for_cre(seri, repo);
+
+        const std::string cache_dir = eka2l1::file_directory(cache_path);
+
+        if (!cache_dir.empty()) {
+            common::create_directories(cache_dir);
+        }
+
+        common::wo_std_file_stream stream(cache_path, true);
+
+        if (!stream.valid()) {
+            return false;
+        }
+
+        return stream.write(bufs.data(), bufs.size()) == bufs.size();
+    }
+
     void central_repo::write_changes(eka2l1::io_system *io, device_manager *mngr) {
         std::vector<std::uint8_t> bufs;
 
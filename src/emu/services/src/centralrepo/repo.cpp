@@ -61,8 +61,11 @@ namespace eka2l1 {
         entry.key = key;
         entry.data = var;
 
-        entries.push_back(entry);
+        auto ite = std::lower_bound(entries.begin(), entries.end(), key, [](const central_repo_entry &e, const std::uint32_t k) {
+            return e.key < k;
+        });
 
+        entries.insert(ite, std::move(entry));
         return true;
     }
 
@@ -78,23 +81,53 @@ namespace eka2l1 {
         entry.key = key;
         entry.data = var;
 
-        entries.push_back(entry);
+        auto ite = std::lower_bound(entries.begin(), entries.end(), key, [](const central_repo_entry &e, const std::uint32_t k) {
+            return e.key < k;
+        });
 
+        entries.insert(ite, std::move(entry));
         return true;
     }
 
     central_repo_entry *central_repo::find_entry(const std::uint32_t key) {
-        auto ite = std::find_if(entries.begin(), entries.end(), [=](const central_repo_entry &e) {
-            return e.key == key;
+        auto ite = std::lower_bound(entries.begin(), entries.end(), key, [](const central_repo_entry &e, const std::uint32_t k) {
+            return e.key < k;
         });
 
-        if (ite == entries.end()) {
+        if ((ite == entries.end()) || (ite->key != key)) {
             return nullptr;
         }
 
         return &(*ite);
     }
 
+    void central_repo::sort_entries() {
+        auto compare_key = [](const central_repo_entry &lhs, const central_repo_entry &rhs) {
+            return lhs.key < rhs.key;
+        };
+
+        // Repository files are usually written in order already
+        if (!std::is_sorted(entries.begin(), entries.end(), compare_key)) {
+            std::stable_sort(entries.begin(), entries.end(), compare_key);
+        }
+    }
+
+    std::pair<std::vector<central_repo_entry>::iterator, std::vector<central_repo_entry>::iterator>
+    central_repo::entries_in_mask_range(const std::uint32_t partial_key, const std::uint32_t mask) {
+        const std::uint32_t low_key = partial_key & mask;
+        const std::uint32_t high_key = low_key | ~mask;
+
+        auto begin = std::lower_bound(entries.begin(), entries.end(), low_key, [](const central_repo_entry &e, const std::uint32_t k) {
+            return e.key < k;
+        });
+
+        auto end = std::upper_bound(begin, entries.end(), high_key, [](const std::uint32_t k, const central_repo_entry &e) {
+            return k < e.key;
+        });
+
+        return { begin, end };
+    }
+
     void central_repo::query_entries(const std::uint32_t partial_key, const std::uint32_t mask,
         std::vector<central_repo_entry *> &matched_entries,
         const central_repo_entry_type etype) {
@@ -185,14 +218,7 @@ namespace eka2l1 {
         // If not in transaction, or if we are in transaction but read-mode
         // Directly get the repo data
         if (!active || mode == 0) {
-            auto result = std::find_if(attach_repo->entries.begin(), attach_repo->entries.end(),
-                [&](const central_repo_entry &entry) { return entry.key == key; });
-
-            if (result == attach_repo->entries.end()) {
-                return nullptr;
-            }
-
-            return &(*result);
+            return attach_repo->find_entry(key);
         }
 
         transactor.changes.emplace(key, central_repo_entry{});
@@ -537,7 +563,11 @@ namespace eka2l1 {
         found_uid_result_array[0] = 0;
         std::string cache_arg;
 
-        for (auto &entry : attach_repo->entries) {
+        auto [range_begin, range_end] = attach_repo->entries_in_mask_range(filter->partial_key, filter->id_mask);
+
+        for (auto entry_ite = range_begin; entry_ite != range_end; entry_ite++) {
+            central_repo_entry &entry = *entry_ite;
+
             // Try to match the key first
             if ((entry.key & filter->id_mask) != (filter->partial_key & filter->id_mask)) {
                 // Mask doesn't match, abandon this entry
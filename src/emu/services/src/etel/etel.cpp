@@ -58,8 +58,7 @@ namespace eka2l1 {
         call_status_prop_ = kern->create<service::property>();
         call_status_prop_->define(service::property_type::int_data, 4);
 
-        call_status_prop_->first = eka2l1::SYSTEM_AGENT_PROPERTY_CATEGORY;
-        call_status_prop_->second = epoc::ETEL_PHONE_CURRENT_CALL_UID;
+        kern->set_prop_identity(call_status_prop_, eka2l1::SYSTEM_AGENT_PROPERTY_CATEGORY, epoc::ETEL_PHONE_CURRENT_CALL_UID);
 
         call_status_prop_->set_int(epoc::etel_phone_current_call_none);
 
@@ -67,8 +66,7 @@ namespace eka2l1 {
         sim_c_status_prop_ = kern->create<service::property>();
         sim_c_status_prop_->define(service::property_type::int_data, 4);
 
-        sim_c_status_prop_->first = eka2l1::SYSTEM_AGENT_PROPERTY_CATEGORY;
-        sim_c_status_prop_->second = epoc::ETEL_ADV_SIMC_STATUS_PROP_UID;
+        kern->set_prop_identity(sim_c_status_prop_, eka2l1::SYSTEM_AGENT_PROPERTY_CATEGORY, epoc::ETEL_ADV_SIMC_STATUS_PROP_UID);
 
         sim_c_status_prop_->set_int(7);
 
@@ -76,8 +74,7 @@ namespace eka2l1 {
         network_bars_prop_ = kern->create<service::property>();
         network_bars_prop_->define(service::property_type::int_data, 4);
 
-        network_bars_prop_->first = eka2l1::SYSTEM_AGENT_PROPERTY_CATEGORY;
-        network_bars_prop_->second = epoc::ETEL_PHONE_NETWORK_BARS_UID;
+        kern->set_prop_identity(network_bars_prop_, eka2l1::SYSTEM_AGENT_PROPERTY_CATEGORY, epoc::ETEL_PHONE_NETWORK_BARS_UID);
 
         network_bars_prop_->set_int(epoc::ETEL_MAX_BAR_LEVEL * epoc::ETEL_BAR_MULTIPLIER);
 
@@ -85,8 +82,7 @@ namespace eka2l1 {
         battery_bars_prop_ = kern->create<service::property>();
         battery_bars_prop_->define(service::property_type::int_data, 4);
 
-        battery_bars_prop_->first = eka2l1::SYSTEM_AGENT_PROPERTY_CATEGORY;
-        battery_bars_prop_->second = epoc::ETEL_PHONE_BATTERY_BARS_UID;
+        kern->set_prop_identity(battery_bars_prop_, eka2l1::SYSTEM_AGENT_PROPERTY_CATEGORY, epoc::ETEL_PHONE_BATTERY_BARS_UID);
 
         battery_bars_prop_->set_int(epoc::ETEL_MAX_BAR_LEVEL * epoc::ETEL_BAR_MULTIPLIER);
 
@@ -94,16 +90,14 @@ namespace eka2l1 {
         charger_status_prop_ = kern->create<service::property>();
         charger_status_prop_->define(service::property_type::int_data, 4);
 
-        charger_status_prop_->first = eka2l1::SYSTEM_AGENT_PROPERTY_CATEGORY;
-        charger_status_prop_->second = epoc::ETEL_PHONE_CHARGER_STATUS_UID;
+        kern->set_prop_identity(charger_status_prop_, eka2l1::SYSTEM_AGENT_PROPERTY_CATEGORY, epoc::ETEL_PHONE_CHARGER_STATUS_UID);
 
         charger_status_prop_->set_int(epoc::etel_charger_status_connected);
 
         call_type_info_prop_ = kern->create<service::property>();
         call_type_info_prop_->define(service::property_type::int_data, 4);
 
-        call_type_info_prop_->first = epoc::ETEL_CALL_INFO_PROP_UID;
-        call_type_info_prop_->second = epoc::ETEL_CALL_INFO_CALL_TYPE_KEY;
+        kern->set_prop_identity(call_type_info_prop_, epoc::ETEL_CALL_INFO_PROP_UID, epoc::ETEL_CALL_INFO_CALL_TYPE_KEY);
 
         call_type_info_prop_->set_int(epoc::ETEL_CALL_INFO_PROP_CALL_NONE);
     }
@@ -54,6 +54,8 @@ namespace eka2l1::epoc::adapter {
         }
 
         *off = stbtt_GetFontOffsetForIndex(&data_[0], static_cast<int>(idx));
+
+        const std::lock_guard<std::mutex> guard(cache_info_lock);
         auto result = cache_info.find(*off);
 
         if (result != cache_info.end()) {
@@ -29,6 +29,7 @@
 #include <services/fbs/fbs.h>
 #include <services/fs/std.h>
 
+#include <common/algorithm.h>
 #include <common/cvt.h>
 #include <common/log.h>
 #include <common/thread.h>
@@ -433,6 +434,12 @@ namespace eka2l1 {
             compressor = std::make_unique<compress_queue>(this);
             compressor_thread = std::make_unique<std::thread>(compressor_thread_func, compressor.get());
         }
+
+        config::state *conf = sys->get_config();
+        shared_glyph_cache = std::make_unique<epoc::glyph_cache>(common::KB(conf->fbs_glyph_cache_size),
+            conf->fbs_glyph_prerasterize);
+
+        bitmap_file_cache = std::make_unique<epoc::mbm_cache>(common::KB(conf->fbs_bitmap_cache_size));
     }
 
     void fbs_server::connect(service::ipc_context &context) {
@@ -491,6 +498,10 @@ namespace eka2l1 {
             compressor_thread->join();
         }
 
+        if (shared_glyph_cache) {
+            shared_glyph_cache->abort();
+        }
+
         clear_all_sessions();
 
         font_obj_container.clear();
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <services/fbs/adapter/font_adapter.h>
+#include <services/fbs/glyph_cache.h>
+
+#include <common/hash.h>
+#include <common/thread.h>
+
+#include <cstring>
+
+namespace eka2l1::epoc {
+    std::size_t glyph_cache_key_hash::operator()(const glyph_cache_key &key) const noexcept {
+        std::size_t seed = 0x61797068;
+
+        common::hash_combine(seed, key.adapter_);
+        common::hash_combine(seed, key.face_index_);
+        common::hash_combine(seed, key.font_size_);
+        common::hash_combine(seed, key.baseline_offset_);
+        common::hash_combine(seed, key.codepoint_);
+
+        return seed;
+    }
+
+    static std::size_t estimate_glyph_memory_usage(const rasterized_glyph &glyph) {
+        return sizeof(rasterized_glyph) + glyph.data_.size();
+    }
+
+    glyph_cache::glyph_cache(const std::size_t memory_budget, const bool enable_prerasterize)
+        : memory_budget_(memory_budget) {
+        if (enable_prerasterize) {
+            prerasterize_queue_.max_pending_count_ = 64;
+            prerasterize_thread_ = std::make_unique<std::thread>([this]() {
+                common::set_thread_name("FBS Server glyph rasterizer thread");
+                run_prerasterize();
+            });
+        }
+    }
+
+    glyph_cache::~glyph_cache() {
+        abort();
+    }
+
+    void glyph_cache::abort() {
+        if (prerasterize_thread_) {
+            prerasterize_queue_.abort();
+            prerasterize_thread_->join();
+            prerasterize_thread_.reset();
+        }
+    }
+
+    rasterized_glyph_ptr glyph_cache::rasterize(const glyph_cache_key &key) {
+        auto glyph = std::make_shared<rasterized_glyph>();
+
+        std::uint32_t bitmap_data_size = 0;
+        const std::lock_guard<std::mutex> adapter_guard(key.adapter_->rasterize_lock());
+
+        // The returned bitmap is 8bpp single channel. Luckily Symbian likes this (at least in v3 and upper).
+        std::uint8_t *bitmap_data = key.adapter_->get_glyph_bitmap(key.face_index_, key.codepoint_, key.font_size_,
+            &glyph->width_, &glyph->height_, bitmap_data_size, &glyph->bitmap_type_);
+
+        if (!bitmap_data && !key.adapter_->does_glyph_exist(key.face_index_, key.codepoint_)) {
+            glyph->exists_ = false;
+            return glyph;
+        }
+
+        glyph->exists_ = true;
+
+        if (bitmap_data) {
+            glyph->data_.resize(bitmap_data_size);
+            std::memcpy(glyph->data_.data(), bitmap_data, bitmap_data_size);
+
+            key.adapter_->free_glyph_bitmap(bitmap_data);
+        }
+
+        std::memset(&glyph->metric_, 0, sizeof(open_font_character_metric));
+        key.adapter_->get_glyph_metric(key.face_index_, key.codepoint_, glyph->metric_, key.baseline_offset_,
+            key.font_size_);
+
+        glyph->metric_.width = static_cast<std::int16_t>(glyph->width_);
+        glyph->metric_.height = static_cast<std::int16_t>(glyph->height_);
+        glyph->metric_.bitmap_type = glyph->bitmap_type_;
+
+        return glyph;
+    }
+
+    rasterized_glyph_ptr glyph_cache::find_no_lock(const glyph_cache_key &key) {
+        auto ite = entries_.find(key);
+
+        if (ite == entries_.end()) {
+            return nullptr;
+        }
+
+        // Move to the front of the LRU list
+        lru_.splice(lru_.begin(), lru_, ite->second);
+        return ite->second->second;
+    }
+
+    void glyph_cache::add(const glyph_cache_key &key, rasterized_glyph_ptr glyph) {
+        if (entries_.find(key) != entries_.end()) {
+            // Someone else has rasterized it while we were doing it, keep the old one
+            return;
+        }
+
+        stats_.memory_usage_ += estimate_glyph_memory_usage(*glyph);
+
+        lru_.emplace_front(key, std::move(glyph));
+        entries_.emplace(key, lru_.begin());
+
+        while ((stats_.memory_usage_ > memory_budget_) && (lru_.size() > 1)) {
+            auto &victim = lru_.back();
+
+            stats_.memory_usage_ -= estimate_glyph_memory_usage(*victim.second);
+            stats_.evictions_++;
+
+            entries_.erase(victim.first);
+            lru_.pop_back();
+        }
+
+        stats_.entry_count_ = entries_.size();
+    }
+
+    rasterized_glyph_ptr glyph_cache::get(const glyph_cache_key &key) {
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+            rasterized_glyph_ptr result = find_no_lock(key);
+
+            if (result) {
+                stats_.hits_++;
+                return result;
+            }
+
+            stats_.misses_++;
+        }
+
+        // Rasterize outside of the lock, so that the background thread does not block us for too long
+        rasterized_glyph_ptr result = rasterize(key);
+
+        const std::lock_guard<std::mutex> guard(lock_);
+        add(key, result);
+
+        return result;
+    }
+
+    void glyph_cache::prerasterize(const glyph_cache_key &base_key, const std::uint32_t start_code, const std::uint32_t end_code) {
+        if (!prerasterize_thread_ || (start_code > end_code)) {
+            return;
+        }
+
+        // Never block the server thread, the range will be rasterized on demand if it's dropped
+        prerasterize_queue_.try_push(prerasterize_request{ base_key, start_code, end_code });
+    }
+
+    void glyph_cache::run_prerasterize() {
+        while (auto request = prerasterize_queue_.pop()) {
+            glyph_cache_key key = request->base_key_;
+
+            for (std::uint32_t code = request->start_code_; code <= request->end_code_; code++) {
+                key.codepoint_ = code;
+
+                {
+                    const std::lock_guard<std::mutex> guard(lock_);
+
+                    if (entries_.find(key) != entries_.end()) {
+                        continue;
+                    }
+                }
+
+                rasterized_glyph_ptr result = rasterize(key);
+
+                const std::lock_guard<std::mutex> guard(lock_);
+
+                add(key, std::move(result));
+                stats_.prerasterized_++;
+            }
+        }
+    }
+
+    glyph_cache_stats glyph_cache::stats() {
+        const std::lock_guard<std::mutex> guard(lock_);
+        return stats_;
+    }
+}
@@ -407,7 +407,8 @@ namespace eka2l1 {
         return start;
     }
 
-    void *fbs_server::load_data_to_rom(loader::mbm_file &mbmf_, const std::size_t idx_, std::size_t &size_decomp, int *err_code) {
+    void *fbs_server::load_data_to_rom(loader::mbm_file &mbmf_, const std::size_t idx_, std::size_t &size_decomp, int *err_code,
+        const epoc::mbm_file_identity *source) {
         *err_code = fbs_load_data_err_none;
         size_decomp = 0;
 
@@ -416,17 +417,25 @@ namespace eka2l1 {
             return nullptr;
         }
 
+        const std::vector<std::uint8_t> *decoded = nullptr;
+
+        if (source && bitmap_file_cache) {
+            decoded = bitmap_file_cache->get_decoded_bitmap(*source, idx_);
+        }
+
         std::size_t size_when_compressed = epoc::get_byte_width(mbmf_.sbm_headers[idx_].size_pixels.x,
                                                mbmf_.sbm_headers[idx_].bit_per_pixels)
             * mbmf_.sbm_headers[idx_].size_pixels.y;
 
-        if (!mbmf_.read_single_bitmap(idx_, nullptr, size_when_compressed)) {
+        if (decoded) {
+            size_when_compressed = decoded->size();
+        } else if (!mbmf_.read_single_bitmap(idx_, nullptr, size_when_compressed)) {
             *err_code = fbs_load_data_err_read_decomp_fail;
             return nullptr;
-        } else {
-            size_decomp = size_when_compressed;
         }
 
+        size_decomp = size_when_compressed;
+
         // Allocates from the large chunk
         // Align them with 4 bytes
         std::size_t avail_dest_size = common::align(size_when_compressed, 4);
@@ -445,6 +454,11 @@ namespace eka2l1 {
             return nullptr;
         }
 
+        if (decoded) {
+            std::copy(decoded->begin(), decoded->end(), reinterpret_cast<std::uint8_t *>(data));
+            return data;
+        }
+
         // Yay, we manage to alloc memory to load the data in
         // So let's get to work
         bool result_read = mbmf_.read_single_bitmap(idx_, reinterpret_cast<std::uint8_t *>(data), avail_dest_size);
@@ -454,6 +468,10 @@ namespace eka2l1 {
             return nullptr;
         }
 
+        if (source && bitmap_file_cache) {
+            bitmap_file_cache->add_decoded_bitmap(*source, idx_, reinterpret_cast<std::uint8_t *>(data), size_when_compressed);
+        }
+
         return data;
     }
 
@@ -639,14 +657,22 @@ namespace eka2l1 {
                 stream_for_mbm_read->seek(0, common::seek_where::beg);
             }
 
-            loader::mbm_file mbmf_(stream_for_mbm_read);
-            mbmf_.index_to_loads.push_back(load_options->bitmap_id);
+            epoc::mbm_file_identity file_identity;
+            file_identity.path_ = source->file_name();
+            file_identity.last_modified_ = source->last_modify_since_0ad();
+            file_identity.size_ = source->size();
 
-            if (!mbmf_.do_read_headers()) {
+            // The index of files loaded from before is reused, only missing headers are read
+            loader::mbm_file *mbmf_cached = fbss->bitmap_file_cache->get_index(file_identity, stream_for_mbm_read,
+                load_options->bitmap_id);
+
+            if (!mbmf_cached) {
                 ctx->complete(epoc::error_corrupt);
                 return;
             }
 
+            loader::mbm_file &mbmf_ = *mbmf_cached;
+
             // Let's do an insanity check. Is the bitmap index client given us is not valid ?
             if (!mbmf_.is_header_loaded(load_options->bitmap_id)) {
                 ctx->complete(epoc::error_not_found);
@@ -661,7 +687,7 @@ namespace eka2l1 {
             int err_code = fbs_load_data_err_none;
             std::size_t size_when_decomp = 0;
 
-            auto bmp_data = fbss->load_data_to_rom(mbmf_, load_options->bitmap_id, size_when_decomp, &err_code);
+            auto bmp_data = fbss->load_data_to_rom(mbmf_, load_options->bitmap_id, size_when_decomp, &err_code, &file_identity);
             std::uint8_t *bmp_data_base = fbss->get_large_chunk_base();
 
             switch (err_code) {
@@ -535,6 +535,16 @@ namespace eka2l1 {
         } else {
             of->glyph_cache_offset = 0;
         }
+
+        // Warm up the shared glyph cache with the characters nearly every text will use
+        epoc::glyph_cache_key glyph_key;
+        glyph_key.adapter_ = info.adapter;
+        glyph_key.face_index_ = info.idx;
+        glyph_key.font_size_ = static_cast<std::uint16_t>(info.metrics.max_height);
+        glyph_key.baseline_offset_ = bmpfont->algorithic_style.baseline_offsets_in_pixel;
+
+        serv->shared_glyph_cache->prerasterize(glyph_key, 0x20, 0x7E);
+        serv->shared_glyph_cache->prerasterize(glyph_key, 0xA0, 0xFF);
     }
 
     template <typename T>
@@ -793,19 +803,21 @@ namespace eka2l1 {
             //LOG_DEBUG(SERVICE_FBS, "Trying to rasterize character '{}' (code {})", static_cast<char>(codepoint), codepoint);
         }
 
-        int rasterized_width = 0;
-        int rasterized_height = 0;
-
         const epoc::open_font_info *info = &(font->of_info);
-        epoc::glyph_bitmap_type bitmap_type = epoc::glyph_bitmap_type::default_glyph_bitmap;
-        std::uint32_t bitmap_data_size = 0;
+        fbs_server *serv = server<fbs_server>();
 
-        // Get server font handle
-        // The returned bitmap is 8bpp single channel. Luckily Symbian likes this (at least in v3 and upper).
-        std::uint8_t *bitmap_data = info->adapter->get_glyph_bitmap(info->idx, codepoint, font->of_info.metrics.max_height,
-            &rasterized_width, &rasterized_height, bitmap_data_size, &bitmap_type);
+        // Get the glyph from the cache shared by all sessions, rasterize it if needed
+        epoc::glyph_cache_key glyph_key;
+        glyph_key.adapter_ = info->adapter;
+        glyph_key.face_index_ = info->idx;
+        glyph_key.font_size_ = static_cast<std::uint16_t>(font->of_info.metrics.max_height);
+        glyph_key.baseline_offset_ = serv->kern->is_eka1() ? reinterpret_cast<epoc::bitmapfont_v1 *>(bmp_font)->algorithic_style.baseline_offsets_in_pixel
+                                                           : reinterpret_cast<epoc::bitmapfont_v2 *>(bmp_font)->algorithic_style.baseline_offsets_in_pixel;
+        glyph_key.codepoint_ = codepoint;
 
-        if (!bitmap_data && !info->adapter->does_glyph_exist(info->idx, codepoint)) {
+        epoc::rasterized_glyph_ptr glyph = serv->shared_glyph_cache->get(glyph_key);
+
+        if (!glyph->exists_) {
             // The glyph is not available. Let the client know. With code 0, we already use '?'
             // On S^3, it expect us to return false here.
             // On lower version, it expect us to return nullptr, so use 0 here is for the best.
@@ -813,8 +825,9 @@ namespace eka2l1 {
             return;
         }
 
+        const std::uint32_t bitmap_data_size = static_cast<std::uint32_t>(glyph->data_.size());
+
         // Add it to session cache
-        fbs_server *serv = server<fbs_server>();
         kernel::process *pr = ctx->msg->own_thr->owning_process();
 
 #define MAKE_CACHE_ENTRY(entry_ver, type)                                                                                                   \
@@ -823,21 +836,15 @@ namespace eka2l1 {
     cache_entry->codepoint = codepoint;                                                                                                     \
     cache_entry->glyph_index = codepoint % session_cache->offset_array.offset_array_count;                                                  \
     cache_entry->offset = sizeof(epoc::open_font_session_cache_entry_v##entry_ver) + 1;                                                     \
-    info->adapter->get_glyph_metric(info->idx, codepoint, cache_entry->metric,                                                              \
-        reinterpret_cast<type *>(bmp_font)->algorithic_style.baseline_offsets_in_pixel,                                                     \
-        font->of_info.metrics.max_height);                                                                                                  \
-    cache_entry->metric.width = rasterized_width;                                                                                           \
-    cache_entry->metric.height = rasterized_height;                                                                                         \
-    cache_entry->metric.bitmap_type = bitmap_type;                                                                                          \
+    cache_entry->metric = glyph->metric_;                                                                                                   \
     const auto cache_entry_ptr = serv->host_ptr_to_guest_general_data(cache_entry).ptr_address();                                           \
     if (epoc::does_client_use_pointer_instead_of_offset(this)) {                                                                            \
         cache_entry->font_offset = static_cast<std::int32_t>(reinterpret_cast<type *>(bmp_font)->openfont.ptr_address());                   \
     } else {                                                                                                                                \
         cache_entry->font_offset = static_cast<std::int32_t>(reinterpret_cast<type *>(bmp_font)->openfont.ptr_address() - cache_entry_ptr); \
     }                                                                                                                                       \
-    std::memcpy(reinterpret_cast<std::uint8_t *>(cache_entry) + cache_entry->offset, bitmap_data,                                           \
+    std::memcpy(reinterpret_cast<std::uint8_t *>(cache_entry) + cache_entry->offset, glyph->data_.data(),                                   \
         bitmap_data_size);                                                                                                                  \
-    info->adapter->free_glyph_bitmap(bitmap_data);                                                                                          \
     if (epoc::does_client_use_pointer_instead_of_offset(this)) {                                                                            \
         cache_entry->offset += static_cast<std::int32_t>(cache_entry_ptr);                                                                  \
     }
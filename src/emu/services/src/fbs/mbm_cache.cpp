@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <services/fbs/mbm_cache.h>
+
+#include <common/hash.h>
+
+namespace eka2l1::epoc {
+    std::size_t decoded_bitmap_key_hash::operator()(const decoded_bitmap_key &key) const noexcept {
+        std::size_t seed = 0x6D626D63;
+
+        common::hash_combine(seed, key.path_);
+        common::hash_combine(seed, key.index_);
+
+        return seed;
+    }
+
+    mbm_cache::mbm_cache(const std::size_t memory_budget)
+        : memory_budget_(memory_budget) {
+    }
+
+    loader::mbm_file *mbm_cache::get_index(const mbm_file_identity &file, common::ro_stream *stream, const std::size_t bitmap_index) {
+        auto ite = indexes_.find(file.path_);
+
+        if ((ite != indexes_.end()) && (ite->second.last_modified_ == file.last_modified_) && (ite->second.size_ == file.size_)) {
+            loader::mbm_file *index = ite->second.file_.get();
+            index->stream = stream;
+
+            // Headers are loaded as bitmaps get requested
+            if ((bitmap_index < index->trailer.count) && !index->load_header(bitmap_index)) {
+                indexes_.erase(ite);
+                return nullptr;
+            }
+
+            stats_.index_hits_++;
+            return index;
+        }
+
+        stats_.index_misses_++;
+
+        auto new_index = std::make_unique<loader::mbm_file>(stream);
+        new_index->index_to_loads.push_back(bitmap_index);
+
+        if (!new_index->do_read_headers()) {
+            if (ite != indexes_.end()) {
+                indexes_.erase(ite);
+            }
+
+            return nullptr;
+        }
+
+        index_entry &entry = indexes_[file.path_];
+        entry.last_modified_ = file.last_modified_;
+        entry.size_ = file.size_;
+        entry.file_ = std::move(new_index);
+
+        return entry.file_.get();
+    }
+
+    void mbm_cache::remove_bitmap(std::unordered_map<decoded_bitmap_key, lru_list::iterator, decoded_bitmap_key_hash>::iterator ite) {
+        stats_.memory_usage_ -= ite->second->data_.size();
+        stats_.entry_count_--;
+
+        lru_.erase(ite->second);
+        bitmaps_.erase(ite);
+    }
+
+    const std::vector<std::uint8_t> *mbm_cache::get_decoded_bitmap(const mbm_file_identity &file, const std::size_t bitmap_index) {
+        decoded_bitmap_key key;
+        key.path_ = file.path_;
+        key.index_ = bitmap_index;
+
+        auto ite = bitmaps_.find(key);
+        if (ite == bitmaps_.end()) {
+            stats_.bitmap_misses_++;
+            return nullptr;
+        }
+
+        if ((ite->second->last_modified_ != file.last_modified_) || (ite->second->file_size_ != file.size_)) {
+            // The file changed since
+            remove_bitmap(ite);
+            stats_.bitmap_misses_++;
+
+            return nullptr;
+        }
+
+        lru_.splice(lru_.begin(), lru_, ite->second);
+        stats_.bitmap_hits_++;
+
+        return &ite->second->data_;
+    }
+
+    void mbm_cache::add_decoded_bitmap(const mbm_file_identity &file, const std::size_t bitmap_index, const std::uint8_t *data,
+        const std::size_t size) {
+        if (size > memory_budget_) {
+            return;
+        }
+
+        decoded_bitmap_key key;
+        key.path_ = file.path_;
+        key.index_ = bitmap_index;
+
+        auto existing = bitmaps_.find(key);
+        if (existing != bitmaps_.end()) {
+            remove_bitmap(existing);
+        }
+
+        while (!lru_.empty() && (stats_.memory_usage_ + size > memory_budget_)) {
+            remove_bitmap(bitmaps_.find(lru_.back().key_));
+            stats_.evictions_++;
+        }
+
+        decoded_bitmap bitmap;
+        bitmap.key_ = key;
+        bitmap.last_modified_ = file.last_modified_;
+        bitmap.file_size_ = file.size_;
+        bitmap.data_.assign(data, data + size);
+
+        lru_.push_front(std::move(bitmap));
+        bitmaps_.emplace(std::move(key), lru_.begin());
+
+        stats_.memory_usage_ += size;
+        stats_.entry_count_++;
+    }
+}
@@ -170,8 +170,7 @@ namespace eka2l1 {
         system_drive_prop->define(service::property_type::int_data, 0);
         system_drive_prop->set_int(drive_c);
 
-        system_drive_prop->first = static_cast<int>(FS_UID);
-        system_drive_prop->second = static_cast<int>(SYSTEM_DRIVE_KEY);
+        sys->get_kernel_system()->set_prop_identity(system_drive_prop, static_cast<int>(FS_UID), static_cast<int>(SYSTEM_DRIVE_KEY));
     }
 
     fs_server::~fs_server() {
@@ -35,8 +35,7 @@ namespace eka2l1::epoc::hwrm::light {
         }
 
         // Set the category and key, then define
-        infos_prop_->first = eka2l1::epoc::hwrm::SERVICE_UID;
-        infos_prop_->second = eka2l1::epoc::hwrm::light::LIGHT_STATUS_PROP_KEY;
+        kern->set_prop_identity(infos_prop_, eka2l1::epoc::hwrm::SERVICE_UID, eka2l1::epoc::hwrm::light::LIGHT_STATUS_PROP_KEY);
 
         // Define and allocate the size that fit our maximum need.
         infos_prop_->define(service::property_type::bin_data, MAXIMUM_LIGHT * sizeof(target_info));
@@ -39,14 +39,11 @@ namespace eka2l1::epoc::hwrm::power {
         }
 
         // Set the category and key, then define
-        charging_status_prop_->first = STATE_UID;
-        charging_status_prop_->second = CHARGING_STATUS_KEY;
+        kern->set_prop_identity(charging_status_prop_, STATE_UID, CHARGING_STATUS_KEY);
 
-        battery_level_prop_->first = STATE_UID;
-        battery_level_prop_->second = BATTERY_LEVEL_KEY;
+        kern->set_prop_identity(battery_level_prop_, STATE_UID, BATTERY_LEVEL_KEY);
 
-        battery_status_prop_->first = STATE_UID;
-        battery_status_prop_->second = BATTERY_STATUS_KEY;
+        kern->set_prop_identity(battery_status_prop_, STATE_UID, BATTERY_STATUS_KEY);
 
         // Define and allocate the size that fit our maximum need.
         charging_status_prop_->define(service::property_type::int_data, sizeof(std::uint32_t));
@@ -52,8 +52,7 @@ namespace eka2l1::epoc::hwrm::vibration {
         }
 
         // Set the category and key, then define
-        status_prop_->first = eka2l1::epoc::hwrm::SERVICE_UID;
-        status_prop_->second = eka2l1::epoc::hwrm::vibration::VIBRATION_STATUS_KEY;
+        kern->set_prop_identity(status_prop_, eka2l1::epoc::hwrm::SERVICE_UID, eka2l1::epoc::hwrm::vibration::VIBRATION_STATUS_KEY);
 
         // Define and allocate the size that fit our maximum need.
         status_prop_->define(service::property_type::int_data, sizeof(std::uint32_t));
@@ -43,37 +43,37 @@ extern "C" {
 #endif
 
 namespace eka2l1::epoc::internet {
-    static void close_and_delete_async(uv_async_t *async) {
-        uv_close(reinterpret_cast<uv_handle_t *>(async), [](uv_handle_t *handle) {
-            uv_async_t *real_ptr = reinterpret_cast<uv_async_t *>(handle);
-            delete real_ptr;
-        });
-    }
-
     void inet_bridged_protocol::initialize_looper() {
         if (!loop_thread_) {
+            // The loop is not running yet, so it's safe to create the task handle from here.
+            // The handle also keeps the loop alive while there is nothing else to wait for.
+            task_queue_ = std::make_unique<inet_task_queue>(uv_default_loop());
+
             loop_thread_ = std::make_unique<std::thread>([&]() {
                 common::set_thread_name("UV socket looper thread");
                 common::set_thread_priority(common::thread_priority_high);
 
-                while (uv_run(uv_default_loop(), UV_RUN_DEFAULT) == 0) {
-                    std::this_thread::sleep_for(std::chrono::microseconds(5));
-                }
+                uv_run(uv_default_loop(), UV_RUN_DEFAULT);
 
+                // Let the close callbacks of handles closed while stopping run
+                uv_run(uv_default_loop(), UV_RUN_NOWAIT);
                 uv_loop_close(uv_default_loop());
             });
         }
     }
 
+    void inet_bridged_protocol::post_task(inet_task_queue::task func) {
+        task_queue_->post(std::move(func));
+    }
+
     inet_bridged_protocol::~inet_bridged_protocol() {
         if (loop_thread_) {
-            uv_async_t *async = new uv_async_t;
-            uv_async_init(uv_default_loop(), async, [](uv_async_t *async) {
+            inet_task_queue *queue = task_queue_.get();
+            queue->post([queue]() {
+                queue->close();
                 uv_stop(uv_default_loop());
-                close_and_delete_async(async);
             });
 
-            uv_async_send(async);
             loop_thread_->join();
         }
     }
@@ -95,43 +95,36 @@ namespace eka2l1::epoc::internet {
         }
 
         if (opaque_handle_) {
-            uv_async_t *async = new uv_async_t;
-            async->data = opaque_handle_;
+            void *handle = opaque_handle_;
 
             if (protocol_ == INET_TCP_PROTOCOL_ID) {
-                uv_async_init(uv_default_loop(), async, [](uv_async_t *async) {
+                papa_->post_task([handle]() {
                     uv_shutdown_t *shut = new uv_shutdown_t;
-                    if (uv_shutdown(shut, reinterpret_cast<uv_stream_t*>(async->data), [](uv_shutdown_t *shut, int status) {
+                    if (uv_shutdown(shut, reinterpret_cast<uv_stream_t*>(handle), [](uv_shutdown_t *shut, int status) {
                         uv_close(reinterpret_cast<uv_handle_t*>(shut->handle), [](uv_handle_t *handle) {
                             delete handle;
                         });
 
                         delete shut;
                     }) < 0) {
-                        uv_close(reinterpret_cast<uv_handle_t*>(async->data), [](uv_handle_t *handle) {
+                        uv_close(reinterpret_cast<uv_handle_t*>(handle), [](uv_handle_t *handle) {
                             delete handle;
                         });
 
                         delete shut;
                     }
-
-                    close_and_delete_async(async);
                 });
             } else {
-                uv_async_init(uv_default_loop(), async, [](uv_async_t *async) {
-                    uv_udp_t *udp_h = reinterpret_cast<uv_udp_t*>(async->data);
+                papa_->post_task([handle]() {
+                    uv_udp_t *udp_h = reinterpret_cast<uv_udp_t*>(handle);
                     uv_udp_recv_stop(udp_h);
 
                     uv_close(reinterpret_cast<uv_handle_t*>(udp_h), [](uv_handle_t *handle) {
                         delete handle;
                     });
-
-                    close_and_delete_async(async);
                 });
             }
 
-            uv_async_send(async);
-
             opaque_handle_ = nullptr;
             protocol_ = 0;
         }
@@ -192,7 +185,6 @@ namespace eka2l1::epoc::internet {
             return false;
         }
 
-        uv_async_t *async = new uv_async_t;
         open_event_.reset();
 
         struct uv_sock_init_params {
@@ -204,41 +196,34 @@ namespace eka2l1::epoc::internet {
         uv_sock_init_params params;
         params.done_evt_ = &open_event_;
 
-        async->data = &params;
+        // Start the looper now, we might have the first customer!
+        papa_->initialize_looper();
+
+        uv_sock_init_params *params_ptr = &params;
 
         if (protocol_id == INET_TCP_PROTOCOL_ID) {
             opaque_handle_ = new uv_tcp_t;
             params.opaque_handle_ = opaque_handle_;
 
-            uv_async_init(uv_default_loop(), async, [](uv_async_t *async) {
-                uv_sock_init_params *params = reinterpret_cast<uv_sock_init_params*>(async->data);
-                params->result_ = uv_tcp_init(uv_default_loop(), reinterpret_cast<uv_tcp_t*>(params->opaque_handle_));
-                params->done_evt_->set();
-
-                close_and_delete_async(async);
+            papa_->post_task([params_ptr]() {
+                params_ptr->result_ = uv_tcp_init(uv_default_loop(), reinterpret_cast<uv_tcp_t*>(params_ptr->opaque_handle_));
+                params_ptr->done_evt_->set();
             });
         } else {
             opaque_handle_ = new uv_udp_t;
             params.opaque_handle_ = opaque_handle_;
 
-            uv_async_init(uv_default_loop(), async, [](uv_async_t *async) {
-                uv_sock_init_params *params = reinterpret_cast<uv_sock_init_params*>(async->data);
-                params->result_ = uv_udp_init(uv_default_loop(), reinterpret_cast<uv_udp_t*>(params->opaque_handle_));
-
-                params->done_evt_->set();
-                close_and_delete_async(async);
+            papa_->post_task([params_ptr]() {
+                params_ptr->result_ = uv_udp_init(uv_default_loop(), reinterpret_cast<uv_udp_t*>(params_ptr->opaque_handle_));
+                params_ptr->done_evt_->set();
             });
         }
 
         reinterpret_cast<uv_handle_t*>(opaque_handle_)->data = this;
 
-        uv_async_send(async);
-
-        // Start the looper now, we might have the first customer!
-        // Also unlock the kernel at this time, allow free modification, so that the socket thread can
+        // Unlock the kernel at this time, allow free modification, so that the socket thread can
         // proceed to deal with data and get to our open request >D<
         kernel_system *kern = papa_->get_kernel_system();
-        papa_->initialize_looper();
 
         kern->unlock();
         open_event_.wait();
@@ -326,8 +311,6 @@ namespace eka2l1::epoc::internet {
 
         connect_done_info_ = info;
 
-        uv_async_t *async = new uv_async_t;
-
         if (protocol_ == INET_UDP_PROTOCOL_ID) {
             struct uv_udp_connect_params {
                 inet_socket *parent_;
@@ -340,16 +323,12 @@ namespace eka2l1::epoc::internet {
             params->handle_ = reinterpret_cast<uv_udp_t*>(opaque_handle_);
 
             std::memcpy(&params->addr_, ip_addr_ptr, sizeof(sockaddr_in6));
-            async->data = params;
 
-            uv_async_init(uv_default_loop(), async, [](uv_async_t *async) {
-                uv_udp_connect_params *params = reinterpret_cast<uv_udp_connect_params*>(async->data);
-    
+            papa_->post_task([params]() {
                 const int err = uv_udp_connect(params->handle_, reinterpret_cast<const sockaddr*>(&params->addr_));
                 reinterpret_cast<inet_socket*>(params->parent_)->complete_connect_done_info(err);
 
                 delete params;
-                close_and_delete_async(async);
             });
         } else {
             struct uv_tcp_connect_params {
@@ -370,12 +349,9 @@ namespace eka2l1::epoc::internet {
             params->tcp_ = handle_tcp;
             
             std::memcpy(&params->addr_, ip_addr_ptr, sizeof(sockaddr_in6));
-            async->data = params;
             reinterpret_cast<uv_connect_t*>(opaque_connect_)->data = params;
 
-            uv_async_init(uv_default_loop(), async, [](uv_async_t *async) {
-                uv_tcp_connect_params *params = reinterpret_cast<uv_tcp_connect_params*>(async->data);
-
+            papa_->post_task([params]() {
                 int err = uv_tcp_connect(params->connect_, params->tcp_, reinterpret_cast<const sockaddr*>(&params->addr_), [](uv_connect_t *connect, const int err) {
                     uv_tcp_connect_params *params = reinterpret_cast<uv_tcp_connect_params*>(connect->data);
                     reinterpret_cast<inet_socket*>(params->tcp_->data)->complete_connect_done_info(err);
@@ -389,12 +365,8 @@ namespace eka2l1::epoc::internet {
 
                     delete params;
                 }
-
-                close_and_delete_async(async);
             });
         }
-
-        uv_async_send(async);
     }
 
     void inet_socket::bind(const epoc::socket::saddress &addr, epoc::notify_info &info) {
@@ -471,14 +443,10 @@ namespace eka2l1::epoc::internet {
         info->stream_ = reinterpret_cast<uv_stream_t*>(opaque_handle_);
         info->backlog_ = backlog;
 
-        uv_async_t *async = new uv_async_t;
-        async->data = info;
-
         reinterpret_cast<uv_stream_t*>(opaque_handle_)->data = this;
         listen_event_.reset();
 
-        uv_async_init(uv_default_loop(), async, [](uv_async_t *async) {
-            listen_info *info = reinterpret_cast<listen_info*>(async->data);
+        papa_->post_task([info]() {
             inet_socket *sock = reinterpret_cast<inet_socket*>(info->stream_->data);
 
             const int err = uv_listen(info->stream_, info->backlog_, [](uv_stream_t *server, int status) {
@@ -491,13 +459,9 @@ namespace eka2l1::epoc::internet {
             });
 
             sock->set_listen_event(err);
-
             delete info;
-            close_and_delete_async(async);
         });
 
-        uv_async_send(async);
-
         kernel_system *kern = papa_->get_kernel_system();
         kern->unlock();
 
@@ -575,19 +539,11 @@ namespace eka2l1::epoc::internet {
         task_info->done_info_ = complete_info;
         task_info->self_ = this;
 
-        uv_async_t *async = new uv_async_t;
-        async->data = task_info;
-
         // Thread-safe handling
-        uv_async_init(uv_default_loop(), async, [](uv_async_t *async) {
-            accept_task_info *task_info = reinterpret_cast<accept_task_info*>(async->data);
+        papa_->post_task([task_info]() {
             task_info->self_->handle_accept_impl(task_info->socket_ptr_, task_info->done_info_);
-
             delete task_info;
-            close_and_delete_async(async);
         });
-
-        uv_async_send(async);
     }
 
     void inet_socket::cancel_accept() {
@@ -781,12 +737,7 @@ namespace eka2l1::epoc::internet {
             task_info->self_ = this;
             send_info_ptr->data = task_info;
 
-            uv_async_t *async = new uv_async_t;
-            async->data = task_info;
-
-            uv_async_init(uv_default_loop(), async, [](uv_async_t *async) {
-                uv_udp_send_task_info *task_info = reinterpret_cast<uv_udp_send_task_info*>(async->data);
-
+            papa_->post_task([task_info]() {
                 uv_udp_set_broadcast(task_info->udp_, 1);
                 const int res = uv_udp_send(task_info->send_, task_info->udp_, &task_info->buf_sent_, 1, reinterpret_cast<const sockaddr*>(task_info->addr_), [](uv_udp_send_t *send_info, int status) {
                     uv_udp_send_task_info *task_info = reinterpret_cast<uv_udp_send_task_info*>(send_info->data);
@@ -809,11 +760,7 @@ namespace eka2l1::epoc::internet {
 
                     delete task_info;
                 }
-
-                close_and_delete_async(async);
             });
-
-            uv_async_send(async);
         } else {
             // Address is not important here.
             if (!opaque_write_info_) {
@@ -834,30 +781,41 @@ namespace eka2l1::epoc::internet {
             info->stream_ = reinterpret_cast<uv_stream_t*>(opaque_handle_);
             info->write_->data = this;
 
-            uv_async_t *async = new uv_async_t;
-            async->data = info;
-
-            uv_async_init(uv_default_loop(), async, [](uv_async_t *async) {
-                uv_tcp_write_task_info *task = reinterpret_cast<uv_tcp_write_task_info*>(async->data);
-
-                uv_write(task->write_, task->stream_, &task->buf_sent_, 1, [](uv_write_t *req, int status) {
+            papa_->post_task([info]() {
+                uv_write(info->write_, info->stream_, &info->buf_sent_, 1, [](uv_write_t *req, int status) {
                     reinterpret_cast<inet_socket*>(req->data)->complete_send_done_info(status);
                 });
 
-                delete task;
-                close_and_delete_async(async);
+                delete info;
             });
-
-            uv_async_send(async);
         }
     }
 
     void inet_socket::prepare_buffer_for_recv(const std::size_t suggested_size, void *buf_ptr) {
         uv_buf_t *buf = reinterpret_cast<uv_buf_t*>(buf_ptr);
+
+        if (protocol_ != INET_UDP_PROTOCOL_ID) {
+            // Let the stream data land directly in the ring buffer, it will be copied from there to the guest
+            if (!stream_data_buffer_) {
+                stream_data_buffer_ = std::make_unique<common::ring_buffer<char, 0x80000>>();
+            }
+
+            auto free_segment = stream_data_buffer_->write_segment();
+            if (free_segment.count_ != 0) {
+                buf->base = free_segment.data_;
+                buf->len = static_cast<std::uint32_t>(free_segment.count_);
+
+                recv_into_stream_buffer_ = true;
+                return;
+            }
+        }
+
         temp_buffer_.resize(suggested_size);
         
         buf->base = temp_buffer_.data();
         buf->len = static_cast<std::uint32_t>(suggested_size);
+
+        recv_into_stream_buffer_ = false;
     }
 
     void inet_socket::handle_udp_delivery(const std::int64_t bytes_read_arg, const void *buf_ptr, const void *addr) {
@@ -935,36 +893,29 @@ namespace eka2l1::epoc::internet {
                 error_code = epoc::error_general;
             }
         } else {
-            // We must ensure that if we want to take the data immediately, there must be nothing left in the ring buffer
-            // Else we would create data disorder, leading to corruption
-            if (take_available_only_ && (!stream_data_buffer_ || (stream_data_buffer_->size() == 0))
-                && (recv_size_ >= static_cast<std::size_t>(bytes_read_arg))) {
-                // Avoid adding things overhead, so we just gonna copy paste, and done :)
-                memcpy(read_dest_, buf->base, static_cast<std::size_t>(bytes_read_arg));
-                if (bytes_read_) {
-                    *bytes_read_ = static_cast<std::uint32_t>(bytes_read_arg);
-                }
-                bytes_taken = static_cast<std::uint32_t>(bytes_read_arg);
+            // Data always goes through the ring buffer, so that it stays in order with what was left from previous reads
+            // (accounting case also for RecvOneOrMore). Most of the time libuv has already read it into there.
+            if (recv_into_stream_buffer_) {
+                stream_data_buffer_->commit(static_cast<std::size_t>(bytes_read_arg));
             } else {
-                // Push to the queue and pop, see if we got it (accounting case also for RecvOneOrMore)
                 if (!stream_data_buffer_) {
                     stream_data_buffer_ = std::make_unique<common::ring_buffer<char, 0x80000>>();
                 }
 
                 stream_data_buffer_->push(buf->base, static_cast<std::size_t>(bytes_read_arg));
-                if (take_available_only_ || (recv_size_ <= stream_data_buffer_->size())) {
-                    auto got_data = stream_data_buffer_->pop(common::min<std::size_t>(static_cast<std::size_t>(recv_size_),
-                        stream_data_buffer_->size()));
+            }
 
-                    memcpy(read_dest_, got_data.data(), got_data.size());
-                    if (bytes_read_) {
-                        *bytes_read_ = static_cast<std::uint32_t>(got_data.size());
-                    }
+            if (take_available_only_ || (recv_size_ <= stream_data_buffer_->size())) {
+                const std::size_t size_to_pop = common::min<std::size_t>(recv_size_, stream_data_buffer_->size());
+                stream_data_buffer_->pop(read_dest_, size_to_pop);
 
-                    bytes_taken = static_cast<std::uint32_t>(got_data.size());
-                } else {
-                    return;
+                if (bytes_read_) {
+                    *bytes_read_ = static_cast<std::uint32_t>(size_to_pop);
                 }
+
+                bytes_taken = static_cast<std::uint32_t>(size_to_pop);
+            } else {
+                return;
             }
         }
 
@@ -1019,35 +970,24 @@ namespace eka2l1::epoc::internet {
             uv_udp_t *udp = reinterpret_cast<uv_udp_t*>(opaque_handle_);
             udp->data = this;
 
-            uv_async_t *task = new uv_async_t;
-            task->data = udp;
-
-            uv_async_init(uv_default_loop(), task, [](uv_async_t *async) {
-                uv_udp_t *udp = reinterpret_cast<uv_udp_t*>(async->data);
-                
+            papa_->post_task([udp]() {
                 uv_udp_set_broadcast(udp, 1);
                 uv_udp_recv_start(udp, [](uv_handle_t *handle, std::size_t suggested_size, uv_buf_t *buf) {
                     reinterpret_cast<inet_socket*>(handle->data)->prepare_buffer_for_recv(suggested_size, buf);
                 }, [](uv_udp_t *handle, ssize_t bytes_read, const uv_buf_t *buf, const sockaddr *addr_recv, std::uint32_t flags) {
                     reinterpret_cast<inet_socket*>(handle->data)->handle_udp_delivery(static_cast<std::int64_t>(bytes_read), buf, addr_recv);
                 });
-
-                close_and_delete_async(async);
             });
-        
-            uv_async_send(task);
         } else {
             if (stream_data_buffer_ && stream_data_buffer_->size()) {
                 if (take_available_only_ || (data_size <= stream_data_buffer_->size())) {
-                    std::size_t size_to_pop = common::min<std::size_t>(data_size, stream_data_buffer_->size());
-                    std::vector<char> data_result = stream_data_buffer_->pop(size_to_pop);
+                    const std::size_t size_to_pop = stream_data_buffer_->pop(data, common::min<std::size_t>(data_size,
+                        stream_data_buffer_->size()));
 
                     if (recv_size) {
                         *recv_size = static_cast<std::uint32_t>(size_to_pop);
                     }
 
-                    memcpy(data, data_result.data(), size_to_pop);
-
                     if (receive_done_cb_) {
                         receive_done_cb_(size_to_pop);
                         receive_done_cb_ = nullptr;
@@ -1061,22 +1001,13 @@ namespace eka2l1::epoc::internet {
             uv_stream_t *tcp_stream = reinterpret_cast<uv_stream_t*>(opaque_handle_);
             tcp_stream->data = this;
 
-            uv_async_t *task = new uv_async_t;
-            task->data = tcp_stream;
-
-            uv_async_init(uv_default_loop(), task, [](uv_async_t *async) {
-                uv_stream_t *tcp_stream = reinterpret_cast<uv_stream_t*>(async->data);
-
+            papa_->post_task([tcp_stream]() {
                 uv_read_start(tcp_stream, [](uv_handle_t *handle, std::size_t suggested_size, uv_buf_t *buf) {
                     reinterpret_cast<inet_socket*>(handle->data)->prepare_buffer_for_recv(suggested_size, buf);
                 }, [](uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf) {
                     reinterpret_cast<inet_socket*>(stream->data)->handle_tcp_delivery(static_cast<std::int64_t>(nread), buf);
                 });
-
-                close_and_delete_async(async);
             });
-
-            uv_async_send(task);
         }
     }
 
@@ -1085,28 +1016,21 @@ namespace eka2l1::epoc::internet {
             return;
         }
 
-        uv_async_t *async = new uv_async_t;
-
         // TODO: Length at the time of the cancel is not filled. Maybe it needs to
         if (protocol_ == INET_UDP_PROTOCOL_ID) {
             uv_udp_t *udp = reinterpret_cast<uv_udp_t*>(opaque_handle_);
-            async->data = udp;
 
-            uv_async_init(uv_default_loop(), async, [](uv_async_t *async) {
-                uv_udp_recv_stop(reinterpret_cast<uv_udp_t *>(async->data));
-                close_and_delete_async(async);
+            papa_->post_task([udp]() {
+                uv_udp_recv_stop(udp);
             });
         } else {
-            async->data = opaque_handle_;
+            uv_stream_t *stream = reinterpret_cast<uv_stream_t*>(opaque_handle_);
 
-            uv_async_init(uv_default_loop(), async, [](uv_async_t *async) {
-                uv_read_stop(reinterpret_cast<uv_stream_t*>(async->data));
-                close_and_delete_async(async);
+            papa_->post_task([stream]() {
+                uv_read_stop(stream);
             });
         }
 
-        uv_async_send(async);
-
         // Don't call
         receive_done_cb_ = nullptr;
         recv_done_info_.complete(epoc::error_cancel);
@@ -1139,13 +1063,12 @@ namespace eka2l1::epoc::internet {
 
         shutdown_info_ = complete_info;
 
-        uv_async_t *async = new uv_async_t;
-        async->data = opaque_handle_;
+        void *handle = opaque_handle_;
 
         if (protocol_ == INET_TCP_PROTOCOL_ID) {
-            uv_async_init(uv_default_loop(), async, [](uv_async_t *async) {
+            papa_->post_task([handle]() {
                 uv_shutdown_t *shut = new uv_shutdown_t;
-                int res = uv_shutdown(shut, reinterpret_cast<uv_stream_t*>(async->data), [](uv_shutdown_t *shut, int status) {
+                int res = uv_shutdown(shut, reinterpret_cast<uv_stream_t*>(handle), [](uv_shutdown_t *shut, int status) {
                     reinterpret_cast<inet_socket*>(shut->handle->data)->complete_shutdown_info(status);
                     delete shut;
                 });
@@ -1154,20 +1077,15 @@ namespace eka2l1::epoc::internet {
                     reinterpret_cast<inet_socket*>(shut->handle->data)->complete_shutdown_info(res);
                     delete shut;
                 }
-
-                close_and_delete_async(async);
             });
         } else {
-            uv_async_init(uv_default_loop(), async, [](uv_async_t *async) {
-                uv_udp_t *udp_h = reinterpret_cast<uv_udp_t*>(async->data);
+            papa_->post_task([handle]() {
+                uv_udp_t *udp_h = reinterpret_cast<uv_udp_t*>(handle);
                 uv_udp_recv_stop(udp_h);
                 
                 reinterpret_cast<inet_socket*>(udp_h->data)->complete_shutdown_info(0);
-                close_and_delete_async(async);
             });
         }
-
-        uv_async_send(async);
     }
 
     std::size_t inet_socket::get_option(const std::uint32_t option_id, const std::uint32_t option_family,
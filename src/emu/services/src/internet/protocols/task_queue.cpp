@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <services/internet/protocols/task_queue.h>
+
+#include <thread>
+
+extern "C" {
+#include <uv.h>
+}
+
+namespace eka2l1::epoc::internet {
+    inet_task_queue::inet_task_queue(uv_loop_t *loop)
+        : loop_(loop)
+        , async_(new uv_async_t)
+        , closed_(false)
+        , posters_(0)
+        , posted_(0)
+        , executed_(0)
+        , wakeups_(0) {
+        async_->data = this;
+
+        uv_async_init(loop_, async_, [](uv_async_t *async) {
+            reinterpret_cast<inet_task_queue *>(async->data)->run_pending();
+        });
+    }
+
+    void inet_task_queue::run_pending() {
+        wakeups_++;
+        tasks_.drain([this](task &func) {
+            executed_++;
+            func();
+        });
+    }
+
+    bool inet_task_queue::post(task func) {
+        // Announce the post before checking the flag. The close either sees it and waits, or the post sees the flag.
+        posters_++;
+
+        if (closed_) {
+            posters_--;
+            return false;
+        }
+
+        posted_++;
+
+        // Only the first task of a batch needs to wake the loop, the rest are taken together with it
+        if (tasks_.push(std::move(func))) {
+            uv_async_send(async_);
+        }
+
+        posters_--;
+        return true;
+    }
+
+    void inet_task_queue::close() {
+        if (closed_.exchange(true)) {
+            return;
+        }
+
+        // Wait for the posts that got past the flag to finish sending. A post is only a push and a send,
+        // so this is short. Tasks run after the wait, and any post they make is refused.
+        while (posters_ != 0) {
+            std::this_thread::yield();
+        }
+
+        run_pending();
+
+        uv_close(reinterpret_cast<uv_handle_t *>(async_), [](uv_handle_t *handle) {
+            delete reinterpret_cast<uv_async_t *>(handle);
+        });
+    }
+
+    inet_task_queue_stats inet_task_queue::stats() const {
+        inet_task_queue_stats result;
+        result.posted_ = posted_;
+        result.executed_ = executed_;
+        result.wakeups_ = wakeups_;
+
+        return result;
+    }
+}
@@ -80,7 +80,7 @@ namespace eka2l1::epoc::msv {
         }
 
         if ((ents.size() == 1) || (end_index - start_index == 0)) {
-            return add(ents[0], true);
+            return add(ents[start_index], true);
         }
 
         bool no_need_look_too_much = entries_.empty();
@@ -349,20 +349,21 @@ namespace eka2l1::epoc::msv {
 
             bool grand_child_incoming = false;
 
-            while (the_table && (entries[skipped].id_ < the_table->max_range())) {
-                skipped++;
-
+            while (the_table && (skipped < entries.size()) && (entries[skipped].id_ < the_table->max_range())) {
                 if (entries[skipped].parent_id_ != myid_) {
                     grand_child_incoming = true;
                 }
+
+                skipped++;
             }
 
             if (grand_child_incoming) {
                 the_table->grand_child_present(true);
             }
 
-            if (skipped)
-                the_table->add_tons(entries, last_skip, skipped);
+            // Range end is inclusive
+            if (skipped > last_skip)
+                the_table->add_tons(entries, last_skip, skipped - 1);
 
             if (the_table->splitable()) {
                 the_table->do_split(myid_);
@@ -376,7 +377,13 @@ namespace eka2l1::epoc::msv {
                     const std::size_t to_take = common::min<std::size_t>(more_to, entries.size() - skipped);
 
                     if (to_take > 0) {
-                        the_table->add_tons(entries, skipped, to_take);
+                        for (std::size_t i = skipped; i < skipped + to_take; i++) {
+                            if (entries[i].parent_id_ != myid_) {
+                                the_table->grand_child_present(true);
+                            }
+                        }
+
+                        the_table->add_tons(entries, skipped, skipped + to_take - 1);
                         skipped += to_take;
                     }
 
@@ -72,6 +72,67 @@ namespace eka2l1::epoc::msv {
         }
     }
 
+    visible_folder *entry_indexer::find_folder(const msv_id id) {
+        auto ite = folder_lookup_.find(id);
+        if (ite == folder_lookup_.end()) {
+            return nullptr;
+        }
+
+        return ite->second;
+    }
+
+    bool entry_indexer::get_cached_children(const msv_id parent_id, std::vector<entry *> &children) {
+        auto ite = children_cache_.find(parent_id);
+        if (ite == children_cache_.end()) {
+            return false;
+        }
+
+        // Entries live in growable tables, so only IDs are kept and resolved again here
+        children.clear();
+        children.reserve(ite->second.size());
+
+        for (const msv_id id : ite->second) {
+            entry *child = entry_indexer::get_entry(id);
+
+            if (!child || (child->parent_id_ != parent_id)) {
+                children.clear();
+                children_cache_.erase(ite);
+
+                return false;
+            }
+
+            children.push_back(child);
+        }
+
+        return true;
+    }
+
+    void entry_indexer::cache_children(const msv_id parent_id, const std::vector<entry *> &children) {
+        std::vector<msv_id> &ids = children_cache_[parent_id];
+        ids.clear();
+
+        for (const entry *child : children) {
+            ids.push_back(child->id_);
+        }
+    }
+
+    void entry_indexer::invalidate_children(const msv_id parent_id) {
+        children_cache_.erase(parent_id);
+    }
+
+    visible_folder *entry_indexer::get_or_create_folder(const msv_id id) {
+        visible_folder *folder = find_folder(id);
+        if (folder) {
+            return folder;
+        }
+
+        folder = new visible_folder(id);
+        folders_.push(&folder->indexer_link_);
+        folder_lookup_.emplace(id, folder);
+
+        return folder;
+    }
+
     static bool msv_entry_comparator(const entry &lhs, const entry &rhs) {
         return (lhs.id_ & 0x0FFFFFFF) < (rhs.id_ & 0x0FFFFFFF);
     }
@@ -140,6 +201,8 @@ namespace eka2l1::epoc::msv {
     }
 
     bool entry_indexer::create_standard_entries(drive_number crr_drive) {
+        entry_indexer_batch_scope batch(this);
+
         std::u16string DEFAULT_STANDARD_ENTRIES_FILE = u"!:\\resource\\messaging\\msgs.rsc";
         DEFAULT_STANDARD_ENTRIES_FILE[0] = drive_to_char16(rom_drv_);
 
@@ -239,31 +302,22 @@ namespace eka2l1::epoc::msv {
     
     entry *entry_indexer::add_entry(entry &ent) {
         // Provide that the proper visible folder has been found
-        common::double_linked_queue_element *first = folders_.first();
-        common::double_linked_queue_element *end = folders_.end();
-
-        do {
-            if (!first) {
-                break;
-            }
+        visible_folder *folder = find_folder(ent.visible_id_);
 
-            visible_folder *folder = E_LOFF(first, visible_folder, indexer_link_);
-            if (folder->id() == ent.visible_id_) {
-                return folder->add(ent);
+        if (!folder) {
+            if (ent.visible_id_ == static_cast<std::uint32_t>(epoc::error_not_found)) {
+                return nullptr;
             }
 
-            first = first->next;
-        } while (first != end);
-
-        if (ent.visible_id_ == static_cast<std::uint32_t>(epoc::error_not_found)) {
-            return nullptr;
+            // It's a shame really. No folder for this? We shall creates one
+            folder = get_or_create_folder(ent.visible_id_);
         }
 
-        // It's a shame really. No folder for this? We shall creates one
-        visible_folder *new_folder = new visible_folder(ent.visible_id_);
-        entry *fin = new_folder->add(ent);
-
-        folders_.push(&new_folder->indexer_link_);
+        entry *fin = folder->add(ent);
+        if (fin) {
+            entry_folder_cache_[fin->id_] = folder;
+            invalidate_children(fin->parent_id_);
+        }
 
         return fin;
     }
@@ -273,6 +327,16 @@ namespace eka2l1::epoc::msv {
             return &root_entry_;
         }
 
+        // Entries only move between folders on relocation, so the last known folder is nearly always right
+        auto cached = entry_folder_cache_.find(id);
+        if (cached != entry_folder_cache_.end()) {
+            if (auto result = cached->second->get_entry(id)) {
+                return result;
+            }
+
+            entry_folder_cache_.erase(cached);
+        }
+
         // WHERE IS IT!!!!! Get out aaaaaaaa
         common::double_linked_queue_element *first = folders_.first();
         common::double_linked_queue_element *end = folders_.end();
@@ -284,6 +348,7 @@ namespace eka2l1::epoc::msv {
 
             visible_folder *folder = E_LOFF(first, visible_folder, indexer_link_);
             if (auto result = folder->get_entry(id)) {
+                entry_folder_cache_[id] = folder;
                 return result;
             }
 
@@ -331,6 +396,11 @@ namespace eka2l1::epoc::msv {
 
             visible_folder *folder = E_LOFF(first, visible_folder, indexer_link_);
             if (auto result = folder->get_entry(ent.id_)) {
+                // The entry may leave its parent, or join a new one
+                invalidate_children(result->parent_id_);
+                invalidate_children(ent.parent_id_);
+                invalidate_children(ent.visible_id_);
+
                 entry *to_cop = nullptr;
                 entry decent_copy;
 
@@ -382,28 +452,13 @@ namespace eka2l1::epoc::msv {
         } while (first != end);
 
         if (relocate_folder) {
-            first = folders_.first();
-            end = folders_.end();
-
             // Last entry is parent, but anyway, we add all
-            do {
-                if (!first) {
-                    break;
-                }
-
-                visible_folder *folder = E_LOFF(first, visible_folder, indexer_link_);
-                if (folder->id() == relocate_folder) {
-                    folder->add_entry_list(need_relocate, false);
-                    return true;
-                }
-
-                first = first->next;
-            } while (first != end);
+            visible_folder *folder = get_or_create_folder(relocate_folder);
+            folder->add_entry_list(need_relocate, false);
 
-            visible_folder *new_folder_obj = new visible_folder(relocate_folder);
-            new_folder_obj->add_entry_list(need_relocate, false);
-
-            folders_.push(&new_folder_obj->indexer_link_);
+            for (const entry &relocated: need_relocate) {
+                entry_folder_cache_[relocated.id_] = folder;
+            }
         }
 
         return true;
@@ -435,55 +490,44 @@ namespace eka2l1::epoc::msv {
 
     bool entry_indexer::get_children_id(const std::uint32_t vf, const std::uint32_t parent_id,
         std::vector<std::uint32_t> &children_ids) {
-        common::double_linked_queue_element *first = folders_.first();
-        common::double_linked_queue_element *end = folders_.end();
+        visible_folder *folder = find_folder(vf);
+        if (!folder) {
+            return false;
+        }
 
-        do {
-            if (!first) {
-                break;
+        epoc::msv::visible_folder_children_query_error error = epoc::msv::visible_folder_children_query_ok;
+        if (parent_id != vf) {
+            entry *parent_entry = folder->get_entry(parent_id);
+            if (!parent_entry) {
+                return false;
             }
 
-            visible_folder *folder = E_LOFF(first, visible_folder, indexer_link_);
-            if (folder->id() == vf) {
-                epoc::msv::visible_folder_children_query_error error = epoc::msv::visible_folder_children_query_ok;
-                if (parent_id != vf) {
-                    entry *parent_entry = folder->get_entry(parent_id);
-                    if (!parent_entry) {
-                        return false;
-                    }
-
-                    if (!parent_entry->children_looked_up()) {
-                        return false;
-                    }
-
-                    children_ids.insert(children_ids.begin(), parent_entry->children_ids_.begin(), parent_entry->children_ids_.end());
-                } else {
-                    std::vector<entry*> ents = folder->get_children_by_parent(parent_id, &error);
+            if (!parent_entry->children_looked_up()) {
+                return false;
+            }
 
-                    if (error != epoc::msv::visible_folder_children_query_ok) {
-                        return false;
-                    }
+            children_ids.insert(children_ids.begin(), parent_entry->children_ids_.begin(), parent_entry->children_ids_.end());
+        } else {
+            std::vector<entry*> ents = folder->get_children_by_parent(parent_id, &error);
 
-                    for (auto ent: ents) {
-                        children_ids.push_back(ent->id_);
-                    }
-                }
-                
-                return true;
+            if (error != epoc::msv::visible_folder_children_query_ok) {
+                return false;
             }
 
-            first = first->next;
-        } while (first != end);
-
-        return false;
+            for (auto ent: ents) {
+                children_ids.push_back(ent->id_);
+            }
+        }
+        
+        return true;
     }
 
     bool entry_indexer::move_entry_to_new_folder(entry *ent, const std::uint32_t new_parent, const std::uint32_t new_folder) {
-        common::double_linked_queue_element *first = folders_.first();
-        common::double_linked_queue_element *end = folders_.end();
-
         std::vector<entry> need_relocate;
 
+        invalidate_children(ent->parent_id_);
+        invalidate_children(new_parent);
+
         if (ent->visible_id_ != new_folder) {
             entry copy = *ent;
             copy.parent_id_ = new_parent;
@@ -495,46 +539,22 @@ namespace eka2l1::epoc::msv {
             return true;
         }
 
-        do {
-            if (!first) {
-                break;
-            }
-
-            visible_folder *folder = E_LOFF(first, visible_folder, indexer_link_);
-            if (folder->id() == ent->visible_id_) {
-                grab_children_copy_relocated_ignorance_way(folder, ent->id_, new_folder, need_relocate);
-        
-                for (std::size_t i = 0; i < need_relocate.size(); i++) {
-                    folder->remove_entry(need_relocate[i].id_);
-                }
-                
-                break;
-            }
-
-            first = first->next;
-        } while (first != end);
-
-        first = folders_.first();
-
-        do {
-            if (!first) {
-                break;
-            }
-
-            visible_folder *folder = E_LOFF(first, visible_folder, indexer_link_);
-            if (folder->id() == new_folder) {
-                folder->add_entry_list(need_relocate, false);
-                return true;
+        if (visible_folder *old_folder_obj = find_folder(ent->visible_id_)) {
+            grab_children_copy_relocated_ignorance_way(old_folder_obj, ent->id_, new_folder, need_relocate);
+    
+            for (std::size_t i = 0; i < need_relocate.size(); i++) {
+                old_folder_obj->remove_entry(need_relocate[i].id_);
             }
-
-            first = first->next;
-        } while (first != end);
+        }
 
         // No folder, may we create one
-        visible_folder *new_folder_obj = new visible_folder(new_folder);
+        visible_folder *new_folder_obj = get_or_create_folder(new_folder);
         new_folder_obj->add_entry_list(need_relocate, false);
 
-        folders_.push(&new_folder_obj->indexer_link_);
+        for (const entry &relocated: need_relocate) {
+            entry_folder_cache_[relocated.id_] = new_folder_obj;
+        }
+
         return true;
     }
 
@@ -548,7 +568,10 @@ namespace eka2l1::epoc::msv {
         , find_entry_stmt_(nullptr)
         , query_child_entries_stmt_(nullptr)
         , query_child_ids_stmt_(nullptr)
-        , id_counter_(MSV_FIRST_FREE_ENTRY_ID - 1) {
+        , begin_batch_stmt_(nullptr)
+        , end_batch_stmt_(nullptr)
+        , id_counter_(MSV_FIRST_FREE_ENTRY_ID - 1)
+        , batch_depth_(0) {
         bool newly_created = false;
 
         if (load_or_create_databases(newly_created)) {
@@ -588,6 +611,14 @@ namespace eka2l1::epoc::msv {
             sqlite3_finalize(query_child_ids_stmt_);
         }
 
+        if (begin_batch_stmt_) {
+            sqlite3_finalize(begin_batch_stmt_);
+        }
+
+        if (end_batch_stmt_) {
+            sqlite3_finalize(end_batch_stmt_);
+        }
+
         if (database_) {
             sqlite3_close(database_);
         }
@@ -615,6 +646,16 @@ namespace eka2l1::epoc::msv {
             return false;
         }
 
+        // Write-ahead logging lets a commit be a single append, and with normal synchronous mode it is
+        // only synced on checkpoints. The index is rebuildable, so losing the last commits on a host crash is fine.
+        if (sqlite3_exec(database_, "PRAGMA journal_mode=WAL;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            LOG_WARN(SERVICE_MSV, "Unable to switch messaging database to write-ahead logging!");
+        }
+
+        if (sqlite3_exec(database_, "PRAGMA synchronous=NORMAL;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            LOG_WARN(SERVICE_MSV, "Unable to relax messaging database synchronous mode!");
+        }
+
         // Create some fundamental tables to store our msg entries
         const char *INDEX_ENTRY_TABLE_CREATE_STM = "CREATE TABLE IF NOT EXISTS IndexEntry("
             "id INTEGER,"
@@ -669,7 +710,7 @@ namespace eka2l1::epoc::msv {
         const char *MAX_ID_GET_STM = "SELECT MAX(id) FROM IndexEntry;";
         sqlite3_stmt *max_id_get_stmt_obj = nullptr;
         
-        if (sqlite3_prepare(database_, MAX_ID_GET_STM, -1, &max_id_get_stmt_obj, nullptr) == SQLITE_OK) {
+        if (sqlite3_prepare_v2(database_, MAX_ID_GET_STM, -1, &max_id_get_stmt_obj, nullptr) == SQLITE_OK) {
             const int res = sqlite3_step(max_id_get_stmt_obj);
             if ((res == SQLITE_ROW) || (res == SQLITE_DONE)) {
                 // Well, we got one result, let's see it
@@ -698,7 +739,7 @@ namespace eka2l1::epoc::msv {
         // Conduct a search in the database
         if (!visible_folder_find_stmt_) {
             const char *FIND_SUITABLE_VISIBLE_PARENT_STMT = "SELECT data, visibleParent FROM IndexEntry WHERE id=:parentId";
-            if (sqlite3_prepare(database_, FIND_SUITABLE_VISIBLE_PARENT_STMT, -1, &visible_folder_find_stmt_, nullptr) != SQLITE_OK) {
+            if (sqlite3_prepare_v2(database_, FIND_SUITABLE_VISIBLE_PARENT_STMT, -1, &visible_folder_find_stmt_, nullptr) != SQLITE_OK) {
                 LOG_ERROR(SERVICE_MSV, "Unable to prepare find visible folder statement!");
                 return 0;
             }
@@ -719,6 +760,9 @@ namespace eka2l1::epoc::msv {
             const int data = sqlite3_column_int(visible_folder_find_stmt_, 0);
             const std::uint32_t visible_folder_id = static_cast<std::uint32_t>(sqlite3_column_int(visible_folder_find_stmt_, 1));
 
+            // Don't keep the read open, it would hold back WAL checkpoints
+            sqlite3_reset(visible_folder_find_stmt_);
+
             if (data & entry::DATA_FLAG_INVISIBLE) {
                 return visible_folder_id;
             }
@@ -730,6 +774,8 @@ namespace eka2l1::epoc::msv {
     }
 
     bool sql_entry_indexer::add_or_change_entry(entry &ent, entry *&result, const bool is_add) {
+        // A change may also relocate all the children to a new folder
+        entry_indexer_batch_scope batch(this);
         sqlite3_stmt *target_stmt = nullptr;
 
         if (is_add) {
@@ -739,7 +785,7 @@ namespace eka2l1::epoc::msv {
                     ":mtmData2, :mtmData3, :relatedId, :bioType, :pcSyncCount, :reserved, :visibleParent,"
                     ":description, :details)";
 
-                if (sqlite3_prepare(database_, CREATE_ENTRY_STMT_STRING, -1, &create_entry_stmt_, nullptr) != SQLITE_OK) {
+                if (sqlite3_prepare_v2(database_, CREATE_ENTRY_STMT_STRING, -1, &create_entry_stmt_, nullptr) != SQLITE_OK) {
                     LOG_ERROR(SERVICE_MSV, "Unable to prepare index entry insert statement!");
                     return false;
                 }
@@ -756,7 +802,7 @@ namespace eka2l1::epoc::msv {
                     "bioType=:bioType, pcSyncCount=:pcSyncCount, reserved=:reserved, visibleParent=:visibleParent, description=:description, details=:details "
                     "WHERE id=:id";
 
-                if (sqlite3_prepare(database_, MODIFY_ENTRY_STMT_STRING, -1, &change_entry_stmt_, nullptr) != SQLITE_OK) {
+                if (sqlite3_prepare_v2(database_, MODIFY_ENTRY_STMT_STRING, -1, &change_entry_stmt_, nullptr) != SQLITE_OK) {
                     LOG_ERROR(SERVICE_MSV, "Unable to prepare index entry modify statement!");
                     return false;
                 }
@@ -959,7 +1005,7 @@ namespace eka2l1::epoc::msv {
                     "mtmData2, mtmData3, relatedId, bioType, pcSyncCount, reserved, visibleParent,"
                     "description, details from IndexEntry WHERE id=:id";
 
-                if (sqlite3_prepare(database_, FIND_ENTRY_STR_STM, -1, &find_entry_stmt_, nullptr) != SQLITE_OK) {
+                if (sqlite3_prepare_v2(database_, FIND_ENTRY_STR_STM, -1, &find_entry_stmt_, nullptr) != SQLITE_OK) {
                     LOG_ERROR(SERVICE_MSV, "Unable to prepare find entry statement!");
                     return nullptr;
                 }
@@ -982,6 +1028,7 @@ namespace eka2l1::epoc::msv {
             the_entry.id_ = id;
             
             fill_entry_information(the_entry, find_entry_stmt_);
+            sqlite3_reset(find_entry_stmt_);
 
             // Add to cache and receive the temporary pointer to it.
             return entry_indexer::add_entry(the_entry);
@@ -996,7 +1043,7 @@ namespace eka2l1::epoc::msv {
                     "mtmData2, mtmData3, relatedId, bioType, pcSyncCount, reserved, visibleParent,"
                     "description, details, id from IndexEntry WHERE parentId=:parent_id";
 
-            if (sqlite3_prepare(database_, QUERY_CHILD_ENTRIES_STM_STR, -1, &query_child_entries_stmt_, nullptr) != SQLITE_OK) {
+            if (sqlite3_prepare_v2(database_, QUERY_CHILD_ENTRIES_STM_STR, -1, &query_child_entries_stmt_, nullptr) != SQLITE_OK) {
                 LOG_ERROR(SERVICE_MSV, "Can't prepare collect children IDs statement!");
                 return false;
             }
@@ -1036,11 +1083,12 @@ namespace eka2l1::epoc::msv {
         visible_folder_children_query_error error = visible_folder_children_query_ok;
         std::vector<entry*> entries;
 
+        if (get_cached_children(parent_id, entries)) {
+            return entries;
+        }
+
         // Find the visible folder that parent stays in, if not complete, do db queries...
         msv_id visible_folder_id = get_suitable_visible_parent_id(parent_id);
-        
-        common::double_linked_queue_element *first = folders_.first();
-        common::double_linked_queue_element *end = folders_.end();
 
         auto gather_visible_folder_entries = [&](visible_folder *ff) -> bool {
             std::vector<entry> queries;
@@ -1078,53 +1126,47 @@ namespace eka2l1::epoc::msv {
             return true;
         };
 
-        do {
-            if (!first) {
-                break;
+        if (visible_folder *ff = find_folder(visible_folder_id)) {
+            entries = ff->get_children_by_parent(parent_id, &error);
+            if (error == visible_folder_children_incomplete) {
+                // Query all entries and then do transformation
+                gather_visible_folder_entries(ff);
             }
 
-            visible_folder *ff = E_LOFF(first, visible_folder, indexer_link_);
-            if (ff->id() == visible_folder_id) {
-                entries = ff->get_children_by_parent(parent_id, &error);
-                if (error == visible_folder_children_incomplete) {
-                    // Query all entries and then do transformation
-                    gather_visible_folder_entries(ff);
-                }
+            if ((parent_id != visible_folder_id) && (error != visible_folder_children_query_ok)) {
+                gather_target_parent_entries(ff);
+            }
 
-                if ((parent_id != visible_folder_id) && (error != visible_folder_children_query_ok)) {
-                    gather_target_parent_entries(ff);
-                }
+            // Reattempt this time again
+            if (error != visible_folder_children_query_ok) {
+                entries = ff->get_children_by_parent(parent_id, &error);
 
-                // Reattempt this time again
                 if (error != visible_folder_children_query_ok) {
-                    entries = ff->get_children_by_parent(parent_id, &error);
-
-                    if (error != visible_folder_children_query_ok) {
-                        LOG_ERROR(SERVICE_MSV, "An error occured that made it unable to retrieve children entries");
-                    }
+                    LOG_ERROR(SERVICE_MSV, "An error occured that made it unable to retrieve children entries");
+                    return entries;
                 }
-
-                return entries;
             }
 
-            first = first->next;
-        } while (first != end);
+            cache_children(parent_id, entries);
+            return entries;
+        }
 
         // Create a new folder
-        visible_folder *new_folder = new visible_folder(visible_folder_id);
+        visible_folder *new_folder = get_or_create_folder(visible_folder_id);
         gather_visible_folder_entries(new_folder);
 
         if (parent_id != visible_folder_id) {
             gather_target_parent_entries(new_folder);
         }
 
-        folders_.push(&new_folder->indexer_link_);
         entries = new_folder->get_children_by_parent(parent_id, &error);
 
         if (error != visible_folder_children_query_ok) {
             LOG_ERROR(SERVICE_MSV, "An error occured that made it unable to retrieve children entries");
+            return entries;
         }
 
+        cache_children(parent_id, entries);
         return entries;
     }
     
@@ -1138,7 +1180,7 @@ namespace eka2l1::epoc::msv {
             static const char *QUERY_CHILD_ID_REQUIRE_VF_STMT = "SELECT id FROM IndexEntry "
                 "WHERE visibleParent=:visibleParent AND parentId=:parentId";
 
-            if (sqlite3_prepare(database_, QUERY_CHILD_ID_REQUIRE_VF_STMT, -1, &query_child_ids_stmt_, nullptr) != SQLITE_OK) {
+            if (sqlite3_prepare_v2(database_, QUERY_CHILD_ID_REQUIRE_VF_STMT, -1, &query_child_ids_stmt_, nullptr) != SQLITE_OK) {
                 LOG_ERROR(SERVICE_MSV, "unable to prepare children ID query statement!");
                 return false;
             }
@@ -1198,12 +1240,14 @@ namespace eka2l1::epoc::msv {
         const std::uint32_t old_folder = ent->visible_id_;
         bool significant_move = (ent->visible_id_ != new_folder);
 
+        entry_indexer_batch_scope batch(this);
+
         // Do a database set
         if (!relocate_entry_stmt_) {
             static const char *RELOCATE_ENTRY_STMT_STR = "UPDATE IndexEntry SET parentId=:parentId, visibleParent=:visibleParent "
                 "WHERE id=:id";
 
-            if (sqlite3_prepare(database_, RELOCATE_ENTRY_STMT_STR, -1, &relocate_entry_stmt_, nullptr) != SQLITE_OK) {
+            if (sqlite3_prepare_v2(database_, RELOCATE_ENTRY_STMT_STR, -1, &relocate_entry_stmt_, nullptr) != SQLITE_OK) {
                 LOG_ERROR(SERVICE_MSV, "Error while preparing relocate entry SQL statement!");
                 return false;
             }
@@ -1230,4 +1274,46 @@ namespace eka2l1::epoc::msv {
 
         return true;
     }
+
+    bool sql_entry_indexer::run_batch_statement(sqlite3_stmt *&stmt, const char *sql) {
+        if (!stmt) {
+            if (sqlite3_prepare_v2(database_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+                LOG_ERROR(SERVICE_MSV, "Unable to prepare batch statement: {}", sql);
+                return false;
+            }
+        }
+
+        sqlite3_reset(stmt);
+        
+        const int error_code = sqlite3_step(stmt);
+        if (error_code != SQLITE_DONE) {
+            LOG_ERROR(SERVICE_MSV, "Error {} while running batch statement: {}", error_code, sql);
+            return false;
+        }
+
+        return true;
+    }
+
+    void sql_entry_indexer::begin_batch() {
+        if (!database_) {
+            return;
+        }
+
+        // Only count the batch if the transaction is open, otherwise the matching end would commit nothing
+        if ((batch_depth_ == 0) && !run_batch_statement(begin_batch_stmt_, "BEGIN IMMEDIATE;")) {
+            return;
+        }
+
+        batch_depth_++;
+    }
+
+    void sql_entry_indexer::end_batch() {
+        if (!database_ || (batch_depth_ == 0)) {
+            return;
+        }
+
+        if (--batch_depth_ == 0) {
+            run_batch_statement(end_batch_stmt_, "COMMIT;");
+        }
+    }
 }
\ No newline at end of file
@@ -61,6 +61,9 @@ namespace eka2l1::epoc::msv {
         prog->number_remaining_ = static_cast<std::uint32_t>(ids.size());
 
         io_system *io = server->get_io_system();
+
+        // Commit all the moves at once
+        epoc::msv::entry_indexer_batch_scope batch(indexer);
         
         for (std::size_t i = 0; i < ids.size(); i++) {
             epoc::msv::entry *ent = indexer->get_entry(ids[i]);
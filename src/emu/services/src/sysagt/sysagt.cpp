@@ -254,8 +254,7 @@ namespace eka2l1 {
 
         if (!prop) {
             prop = kern->create<service::property>();
-            prop->first = SYSTEM_AGENT_PROPERTY_CATEGORY;
-            prop->second = uid.value();
+            kern->set_prop_identity(prop, SYSTEM_AGENT_PROPERTY_CATEGORY, uid.value());
 
             prop->define(service::property_type::int_data, 4);
         }
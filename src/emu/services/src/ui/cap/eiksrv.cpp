@@ -70,8 +70,7 @@ namespace eka2l1::epoc::cap {
         prop_ = kern->create<service::property>();
         prop_->define(service::property_type::bin_data, sizeof(akn_status_pane_data));
 
-        prop_->first = AVKON_INTERNAL_UID;
-        prop_->second = STATUS_PANE_SYSTEM_DATA_KEY;
+        kern->set_prop_identity(prop_, AVKON_INTERNAL_UID, STATUS_PANE_SYSTEM_DATA_KEY);
 
         service::property *another_prop = kern->get_prop(epoc::hwrm::power::STATE_UID,
             epoc::hwrm::power::BATTERY_LEVEL_KEY);
@@ -115,13 +115,11 @@ namespace eka2l1::epoc::cap {
         graphics_driver_ = driver;
 
         orientation_prop_->define(service::property_type::int_data, 0);
-        orientation_prop_->first = UIKON_UID;
-        orientation_prop_->second = UIK_PREFERRED_ORIENTATION_KEY;
+        kern->set_prop_identity(orientation_prop_, UIKON_UID, UIK_PREFERRED_ORIENTATION_KEY);
         orientation_prop_->set_int(UIK_ORIENTATION_NORMAL);
 
         hardware_layout_prop_->define(service::property_type::int_data, 0);
-        hardware_layout_prop_->first = UIKON_UID;
-        hardware_layout_prop_->second = UIK_CURRENT_HARDWARE_LAYOUT_STATE;
+        kern->set_prop_identity(hardware_layout_prop_, UIKON_UID, UIK_CURRENT_HARDWARE_LAYOUT_STATE);
         hardware_layout_prop_->set_int(0);
 
         winserv_ = reinterpret_cast<window_server *>(kern->get_by_name<service::server>(
@@ -21,13 +21,42 @@
 #include <services/ui/icon/icon.h>
 #include <services/ui/icon/ops.h>
 
+#include <common/algorithm.h>
 #include <common/cvt.h>
+#include <common/hash.h>
 #include <loader/mif.h>
 #include <system/epoc.h>
 #include <utils/err.h>
 #include <vfs/vfs.h>
 
 namespace eka2l1 {
+    std::size_t icon_lookup_key_hash::operator()(const icon_lookup_key &key) const {
+        std::size_t seed = 0x61696B6E;
+
+        common::hash_combine(seed, key.file_name);
+        common::hash_combine(seed, key.bitmap_id);
+        common::hash_combine(seed, key.app_icon);
+
+        return seed;
+    }
+
+    static icon_lookup_key make_icon_lookup_key(epoc::akn_icon_params &spec) {
+        /**
+         * The original implementation only check for the equal of:
+         * - The bitmap ID.
+         * - The bitmap container file (compare folded aka ignoring case)
+         * - App icon?
+         *
+         * These three are the decesive elements that decide if two requests are trying to get the same bitmap.
+         */
+        icon_lookup_key key;
+        key.file_name = common::lowercase_ucs2_string(spec.file_name.to_std_string(nullptr));
+        key.bitmap_id = spec.bitmap_id;
+        key.app_icon = spec.app_icon;
+
+        return key;
+    }
+
     akn_icon_server_session::akn_icon_server_session(service::typical_server *svr, kernel::uid client_ss_uid, epoc::version version)
         : service::typical_session(svr, client_ss_uid, version) {
     }
@@ -81,9 +110,10 @@ namespace eka2l1 {
             return;
         }
 
-        std::size_t icon_index = 0;
-        std::optional<epoc::akn_icon_srv_return_data> cached = find_existing_icon(spec.value(), &icon_index);
-        if (!cached) {
+        icon_lookup_key key = make_icon_lookup_key(spec.value());
+
+        auto existing = icon_lookup.find(key);
+        if (existing == icon_lookup.end()) {
             eka2l1::vec2 size = spec->size;
 
             fbs_bitmap_data_info info;
@@ -109,10 +139,10 @@ namespace eka2l1 {
             ret->content_dim.y = size.y;
             ret->mask_handle = mask->id;
 
-            add_icon(ret.value(), spec.value());
+            add_icon(ret.value(), spec.value(), std::move(key));
         } else {
-            ret.emplace(cached.value());
-            icons[icon_index].use_count++;
+            ret.emplace(icons[existing->second].ret);
+            icons[existing->second].use_count++;
         }
 
         ctx->write_data_to_descriptor_argument(0, spec.value());
@@ -143,8 +173,15 @@ namespace eka2l1 {
             fbss->free_bitmap(mask);
         }
 
-        // Delete the icon from the icon item list
-        icons.erase(icons.begin() + icon_idx);
+        // Delete the icon from the icon item list. Order does not matter, so move the last one in its place
+        icon_lookup.erase(icon.key);
+
+        if (icon_idx != icons.size() - 1) {
+            icon = std::move(icons.back());
+            icon_lookup[icon.key] = icon_idx;
+        }
+
+        icons.pop_back();
 
         return true;
     }
@@ -177,38 +214,26 @@ namespace eka2l1 {
     }
 
     std::optional<epoc::akn_icon_srv_return_data> akn_icon_server::find_existing_icon(epoc::akn_icon_params &spec, std::size_t *idx) {
-        for (std::size_t i = 0; i < icons.size(); i++) {
-            epoc::akn_icon_params cached_spec = icons[i].spec;
-
-            /**
-             * The original implementation only check for the equal of:
-             * - The bitmap ID.
-             * - The bitmap container file (compare folded aka ignoring case)
-             * - App icon?
-             *
-             * These three are the decesive elements that decide if two requests are trying to get the same bitmap.
-             */
-            if (spec.bitmap_id == cached_spec.bitmap_id) {
-                if (common::compare_ignore_case(spec.file_name.to_std_string(nullptr), cached_spec.file_name.to_std_string(nullptr)) == 0) {
-                    if (spec.app_icon == cached_spec.app_icon) {
-                        if (idx) {
-                            *idx = i;
-                        }
-
-                        return icons[i].ret;
-                    }
-                }
-            }
+        auto ite = icon_lookup.find(make_icon_lookup_key(spec));
+        if (ite == icon_lookup.end()) {
+            return std::nullopt;
         }
-        return std::nullopt;
+
+        if (idx) {
+            *idx = ite->second;
+        }
+
+        return icons[ite->second].ret;
     }
 
-    void akn_icon_server::add_icon(const epoc::akn_icon_srv_return_data &ret, const epoc::akn_icon_params &spec) {
+    void akn_icon_server::add_icon(const epoc::akn_icon_srv_return_data &ret, const epoc::akn_icon_params &spec, icon_lookup_key &&key) {
         icon_data_item item;
         item.ret = ret;
         item.spec = spec;
+        item.key = std::move(key);
         item.use_count = 1;
 
-        icons.push_back(item);
+        icon_lookup.emplace(item.key, icons.size());
+        icons.push_back(std::move(item));
     }
 }
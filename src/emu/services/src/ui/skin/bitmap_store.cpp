@@ -19,29 +19,39 @@
 
 #include <services/ui/skin/bitmap_store.h>
 
-#include <vector>
-
 namespace eka2l1::epoc {
 
     void akn_skin_bitmap_store::store_bitmap(fbsbitmap *bitmap) {
-        bitmap_vector.emplace_back(bitmap);
+        if (!bitmap)
+            return;
+
+        auto result = bitmaps_.emplace(bitmap->id, stored_bitmap{ bitmap, 0 });
+        result.first->second.bitmap_ = bitmap;
+        result.first->second.store_count_++;
     }
 
     void akn_skin_bitmap_store::remove_stored_bitmap(const std::uint32_t bmp_handle) {
         if (!bmp_handle)
             return;
 
-        auto bmp_to_remove = std::find_if(bitmap_vector.begin(), bitmap_vector.end(), [&](fbsbitmap *it) -> bool {
-            return it->id == bmp_handle;
-        });
+        auto bmp_to_remove = bitmaps_.find(bmp_handle);
+        if (bmp_to_remove == bitmaps_.end())
+            return;
 
-        if (bmp_to_remove != bitmap_vector.end())
-            bitmap_vector.erase(bmp_to_remove);
+        if (--bmp_to_remove->second.store_count_ == 0)
+            bitmaps_.erase(bmp_to_remove);
     }
 
     void akn_skin_bitmap_store::destroy_bitmaps() {
-        bitmap_vector.clear();
-        bitmap_vector.shrink_to_fit();
+        bitmaps_.clear();
+    }
+
+    fbsbitmap *akn_skin_bitmap_store::get_stored_bitmap(const std::uint32_t bmp_handle) const {
+        auto ite = bitmaps_.find(bmp_handle);
+        if (ite == bitmaps_.end())
+            return nullptr;
+
+        return ite->second.bitmap_;
     }
 
 } // namespace eka2l1
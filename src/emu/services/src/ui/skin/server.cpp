@@ -25,6 +25,7 @@
 #include <services/ui/skin/utils.h>
 #include <vfs/vfs.h>
 
+#include <common/algorithm.h>
 #include <common/cvt.h>
 #include <common/log.h>
 #include <utils/err.h>
@@ -33,6 +34,9 @@
 #include <system/epoc.h>
 #include <loader/e32img.h>
 
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
 namespace eka2l1 {
     akn_skin_server_session::akn_skin_server_session(service::typical_server *svr, kernel::uid client_ss_uid, epoc::version client_version)
         : service::typical_session(svr, client_ss_uid, client_version) {
@@ -203,11 +207,32 @@ namespace eka2l1 {
             return;
         }
 
+        // Definitions are cached pre-parsed, keyed by the skin file and its size and last write time
+        const std::optional<entry_info> skin_info = io->get_entry_info(skin_path.value());
+        const std::u16string skin_path_lower = common::lowercase_ucs2_string(skin_path.value());
+
+        epoc::skn_cache_key cache_key{};
+        cache_key.path_hash_ = XXH64(skin_path_lower.data(), skin_path_lower.size() * sizeof(char16_t), 0);
+        cache_key.source_size_ = skin_info ? skin_info->size : 0;
+        cache_key.source_last_write_ = skin_info ? skin_info->last_write : 0;
+
+        const std::string cache_path = fmt::format("cache/skin/{:016X}.bin", cache_key.path_hash_);
+
+        epoc::skn_file skin_cached(epoc::plat_ver{ 2, 8 }, ::language::any);
+        if (skin_info && epoc::load_skn_cache(cache_path, cache_key, skin_cached)) {
+            chunk_maintainer_->import(skin_cached, resource_path.value_or(u""));
+            return;
+        }
+
         symfile skin_file_obj = io->open_file(skin_path.value(), READ_MODE | BIN_MODE);
         eka2l1::ro_file_stream skin_file_stream(skin_file_obj.get());
 
         epoc::skn_file skin_parser(reinterpret_cast<common::ro_stream *>(&skin_file_stream));
 
+        if (skin_info) {
+            epoc::save_skn_cache(cache_path, cache_key, skin_parser);
+        }
+
         chunk_maintainer_->import(skin_parser, resource_path.value_or(u""));
     }
 
@@ -17,9 +17,19 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <common/buffer.h>
+#include <common/chunkyseri.h>
+#include <common/fileutils.h>
 #include <common/log.h>
+#include <common/path.h>
+#include <common/virtualmem.h>
 #include <services/ui/skin/skn.h>
 
+#include <cstring>
+
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
 namespace eka2l1::epoc {
     skn_file::skn_file(common::ro_stream *stream, plat_ver platform_version, ::language lang)
         : master_chunk_size_(0)
@@ -541,4 +551,244 @@ namespace eka2l1::epoc {
 
         return chunk_size;
     }
+
+    skn_file::skn_file(plat_ver platform_version, ::language lang)
+        : master_chunk_size_(0)
+        , master_chunk_count_(0)
+        , crr_filename_id_(0)
+        , stream_(nullptr)
+        , ver_(std::move(platform_version))
+        , importer_lang_(lang) {
+    }
+
+    static void do_state_for_attrib(common::chunkyseri &seri, skn_attrib_info &attrib) {
+        seri.absorb(attrib.attrib);
+        seri.absorb(attrib.align);
+        seri.absorb(attrib.image_coord_x);
+        seri.absorb(attrib.image_coord_y);
+        seri.absorb(attrib.image_size_x);
+        seri.absorb(attrib.image_size_y);
+    }
+
+    template <typename T, typename F>
+    static void do_state_for_defs(common::chunkyseri &seri, std::map<std::uint64_t, T> &defs, F func) {
+        std::uint32_t def_count = static_cast<std::uint32_t>(defs.size());
+        seri.absorb(def_count);
+
+        if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+            for (std::uint32_t i = 0; i < def_count; i++) {
+                T def{};
+
+                seri.absorb(def.id_hash);
+                seri.absorb(def.type);
+                func(seri, def);
+
+                defs.emplace(def.id_hash, std::move(def));
+            }
+        } else {
+            for (auto &[id, def] : defs) {
+                seri.absorb(def.id_hash);
+                seri.absorb(def.type);
+                func(seri, def);
+            }
+        }
+    }
+
+    void skn_file::do_state(common::chunkyseri &seri) {
+        seri.absorb(master_chunk_size_);
+        seri.absorb(master_chunk_count_);
+        seri.absorb(crr_filename_id_);
+
+        seri.absorb(info_.author);
+        seri.absorb(info_.copyright);
+        seri.absorb(info_.version);
+        seri.absorb(info_.plat);
+
+        seri.absorb(skin_name_.lang);
+        seri.absorb(skin_name_.name);
+
+        std::uint32_t filename_count = static_cast<std::uint32_t>(filenames_.size());
+        seri.absorb(filename_count);
+
+        if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+            for (std::uint32_t i = 0; i < filename_count; i++) {
+                std::uint32_t id = 0;
+                std::u16string name;
+
+                seri.absorb(id);
+                seri.absorb(name);
+
+                filenames_.emplace(id, std::move(name));
+            }
+        } else {
+            for (auto &[id, name] : filenames_) {
+                std::uint32_t id_copy = id;
+
+                seri.absorb(id_copy);
+                seri.absorb(name);
+            }
+        }
+
+        do_state_for_defs(seri, bitmaps_, [](common::chunkyseri &seri, skn_bitmap_info &bmp) {
+            seri.absorb(bmp.filename_id);
+            seri.absorb(bmp.bmp_idx);
+            seri.absorb(bmp.mask_bitmap_idx);
+            do_state_for_attrib(seri, bmp.attrib);
+        });
+
+        do_state_for_defs(seri, img_tabs_, [](common::chunkyseri &seri, skn_image_table &tab) {
+            seri.absorb_container(tab.images);
+            do_state_for_attrib(seri, tab.attrib);
+        });
+
+        do_state_for_defs(seri, color_tabs_, [](common::chunkyseri &seri, skn_color_table &tab) {
+            seri.absorb_container(tab.colors, [](common::chunkyseri &seri, std::pair<std::int16_t, common::rgba> &color) {
+                seri.absorb(color.first);
+                seri.absorb(color.second);
+            });
+
+            do_state_for_attrib(seri, tab.attrib);
+        });
+
+        do_state_for_defs(seri, bitmap_anims_, [](common::chunkyseri &seri, skn_bitmap_animation &anim) {
+            seri.absorb(anim.interval);
+            seri.absorb(anim.play_mode);
+
+            seri.absorb_container(anim.frames, [](common::chunkyseri &seri, skn_anim_frame &frame) {
+                seri.absorb(frame.frame_bmp_hash);
+                seri.absorb(frame.time);
+                seri.absorb(frame.posx);
+                seri.absorb(frame.posy);
+            });
+
+            do_state_for_attrib(seri, anim.attrib);
+        });
+
+        seri.absorb_container(effect_queues_, [](common::chunkyseri &seri, skn_effect_queue &queue) {
+            seri.absorb(queue.id_hash);
+            seri.absorb(queue.type);
+            seri.absorb(queue.input_layer_index);
+            seri.absorb(queue.input_layer_mode);
+            seri.absorb(queue.output_layer_index);
+            seri.absorb(queue.output_layer_mode);
+            seri.absorb(queue.ref_major);
+            seri.absorb(queue.ref_minor);
+
+            seri.absorb_container(queue.effects, [](common::chunkyseri &seri, skn_effect &effect) {
+                seri.absorb(effect.uid);
+                seri.absorb(effect.input_layer_a_index);
+                seri.absorb(effect.input_layer_a_mode);
+                seri.absorb(effect.input_layer_b_index);
+                seri.absorb(effect.input_layer_b_mode);
+                seri.absorb(effect.output_layer_index);
+                seri.absorb(effect.output_layer_mode);
+
+                seri.absorb_container(effect.parameters, [](common::chunkyseri &seri, skn_effect_parameter &param) {
+                    seri.absorb(param.type);
+                    seri.absorb(param.data);
+                });
+            });
+        });
+    }
+
+    static constexpr std::uint32_t SKN_CACHE_MAGIC = 0x434E4B53; // SKNC
+    static constexpr std::uint32_t SKN_CACHE_VERSION = 1;
+
+    struct skn_cache_header {
+        std::uint32_t magic_;
+        std::uint32_t version_;
+        std::uint64_t path_hash_;
+        std::uint64_t source_size_;
+        std::uint64_t source_last_write_;
+        std::int8_t plat_major_;
+        std::int8_t plat_minor_;
+        std::uint16_t lang_;
+        std::uint32_t payload_size_;
+        std::uint64_t payload_hash_;
+    };
+
+    static skn_cache_header make_skn_cache_header(const skn_cache_key &key, const skn_file &file) {
+        skn_cache_header header{};
+        header.magic_ = SKN_CACHE_MAGIC;
+        header.version_ = SKN_CACHE_VERSION;
+        header.path_hash_ = key.path_hash_;
+        header.source_size_ = key.source_size_;
+        header.source_last_write_ = key.source_last_write_;
+        header.plat_major_ = file.ver_.first;
+        header.plat_minor_ = file.ver_.second;
+        header.lang_ = static_cast<std::uint16_t>(file.importer_lang_);
+
+        return header;
+    }
+
+    bool load_skn_cache(const std::string &path, const skn_cache_key &key, skn_file &file) {
+        const std::int64_t cache_size = common::file_size(path);
+        if (cache_size < static_cast<std::int64_t>(sizeof(skn_cache_header))) {
+            return false;
+        }
+
+        std::uint8_t *cache_data = reinterpret_cast<std::uint8_t *>(common::map_file(path, prot_read));
+        if (!cache_data) {
+            return false;
+        }
+
+        skn_cache_header header{};
+        std::memcpy(&header, cache_data, sizeof(skn_cache_header));
+
+        skn_cache_header expected = make_skn_cache_header(key, file);
+        expected.payload_size_ = header.payload_size_;
+        expected.payload_hash_ = header.payload_hash_;
+
+        bool result = (std::memcmp(&header, &expected, sizeof(skn_cache_header)) == 0)
+            && (header.payload_size_ == static_cast<std::uint64_t>(cache_size) - sizeof(skn_cache_header));
+
+        std::uint8_t *payload = cache_data + sizeof(skn_cache_header);
+
+        // Check the payload before deserializing, so a truncated or damaged file is never trusted
+        if (result && (XXH64(payload, header.payload_size_, 0) == header.payload_hash_)) {
+            common::chunkyseri seri(payload, header.payload_size_, common::SERI_MODE_READ);
+            file.do_state(seri);
+        } else {
+            result = false;
+        }
+
+        common::unmap_file(cache_data);
+        return result;
+    }
+
+    bool save_skn_cache(const std::string &path, const skn_cache_key &key, skn_file &file) {
+        std::vector<std::uint8_t> buf;
+
+        {
+            common::chunkyseri seri(nullptr, 0, common::SERI_MODE_MEASURE);
+            file.do_state(seri);
+
+            buf.resize(sizeof(skn_cache_header) + seri.size());
+        }
+
+        std::uint8_t *payload = buf.data() + sizeof(skn_cache_header);
+        const std::size_t payload_size = buf.size() - sizeof(skn_cache_header);
+
+        common::chunkyseri seri(payload, payload_size, common::SERI_MODE_WRITE);
+        file.do_state(seri);
+
+        skn_cache_header header = make_skn_cache_header(key, file);
+        header.payload_size_ = static_cast<std::uint32_t>(payload_size);
+        header.payload_hash_ = XXH64(payload, payload_size, 0);
+
+        std::memcpy(buf.data(), &header, sizeof(skn_cache_header));
+
+        const std::string cache_dir = eka2l1::file_directory(path);
+        if (!cache_dir.empty()) {
+            common::create_directories(cache_dir);
+        }
+
+        common::wo_std_file_stream stream(path, true);
+        if (!stream.valid() || (stream.write(buf.data(), buf.size()) != buf.size())) {
+            LOG_WARN(SERVICE_UI, "Unable to write skin definition cache to {}", path);
+            return false;
+        }
+
+        return true;
+    }
 }
@@ -476,7 +476,7 @@ namespace eka2l1::epoc {
 
     void gdi_command_builder::build_command_set_clip_rect_multiple(const gdi_store_command_set_clip_rect_multiple_data &cmd) {
         common::region clipped;
-        clipped.rects_.insert(clipped.rects_.begin(), cmd.rects_, cmd.rects_ + cmd.rect_count_);
+        clipped.add_rects(cmd.rects_, cmd.rect_count_);
         clipped.advance(position_);
         clipped = clipped.intersect(clip_);
 
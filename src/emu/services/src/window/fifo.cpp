@@ -42,25 +42,27 @@ namespace eka2l1::epoc {
     std::uint32_t event_fifo::queue_event(const event &evt) {
         const std::lock_guard<std::mutex> guard(lock_);
 
-        if (q_.size() == maximum_element) {
+        if (size_ >= maximum_element) {
             do_purge();
         }
 
+        const std::uint32_t pri = is_my_priority_really_high(evt.type) ? EVENT_PRIORITY_HIGH : EVENT_PRIORITY_NORMAL;
+
         if ((evt.type == epoc::event_code::touch) && ((evt.adv_pointer_evt_.evtype == epoc::event_type::drag) ||
             (evt.adv_pointer_evt_.evtype == epoc::event_type::move))) {
-            if (!q_.empty()) {
-                epoc::event &evt_last = q_.back().evt;
-                
+            std::uint32_t last_id = 0;
+
+            if (epoc::event *evt_last = last_event(pri, &last_id)) {
                 // Same delivery
-                if ((evt_last.handle == evt.handle) && (evt_last.type == evt.type) && (evt_last.adv_pointer_evt_.evtype == evt.adv_pointer_evt_.evtype)
-                    && (evt_last.adv_pointer_evt_.ptr_num == evt.adv_pointer_evt_.ptr_num)) {
-                    evt_last = evt;
-                    return static_cast<std::uint32_t>(q_.size());;
+                if ((evt_last->handle == evt.handle) && (evt_last->type == evt.type) && (evt_last->adv_pointer_evt_.evtype == evt.adv_pointer_evt_.evtype)
+                    && (evt_last->adv_pointer_evt_.ptr_num == evt.adv_pointer_evt_.ptr_num)) {
+                    *evt_last = evt;
+                    return last_id;
                 }
             }
         }
 
-        std::uint32_t result = queue_event_dont_care(evt);
+        std::uint32_t result = queue_event_dont_care(evt, pri);
         trigger_notification();
 
         return result;
@@ -76,52 +78,67 @@ namespace eka2l1::epoc {
     // Lone pointer ups
     // Lone focus lost/gain
     void event_fifo::do_purge() {
-        for (size_t i = 0; i < q_.size(); i++) {
-            switch (q_[i].evt.type) {
+        std::optional<std::uint32_t> last_focus_change_id;
+        std::optional<std::uint32_t> last_switch_on_id;
+
+        filter_events([&](const std::uint32_t id, epoc::event &evt) {
+            switch (evt.type) {
             case epoc::event_code::event_password:
                 break;
 
             case epoc::event_code::null:
             case epoc::event_code::key:
             case epoc::event_code::touch_enter:
-            case epoc::event_code::touch_exit: {
-                q_.erase(q_.begin() + i);
-                break;
-            }
+            case epoc::event_code::touch_exit:
+                return false;
 
-            case epoc::event_code::touch: {
+            case epoc::event_code::touch:
                 // TODO: implement logics in
                 // https://github.com/SymbianSource/oss.FCL.sf.os.graphics/blob/ff133bc50e6158bfb08cc093b0f0055321dcde99/windowing/windowserver/nga/SERVER/EVQUEUE.CPP#L630
                 // just purge it right now
-                q_.erase(q_.begin() + i);
-                break;
-            }
+                return false;
 
             case epoc::event_code::focus_gained:
             case epoc::event_code::focus_lost: {
-                if ((i + 1 < q_.size()) && ((q_[i + 1].evt.type == epoc::event_code::focus_gained) || (q_[i + 1].evt.type == epoc::event_code::focus_lost))) {
-                    q_.erase(q_.begin() + i + 1);
-                    q_.erase(q_.begin() + i);
+                if (last_focus_change_id) {
+                    // Pair of focus changes, they cancel each other
+                    remove_event(last_focus_change_id.value());
+                    last_focus_change_id.reset();
+
+                    return false;
                 }
 
-                break;
+                last_focus_change_id = id;
+                last_switch_on_id.reset();
+
+                return true;
             }
 
             case epoc::event_code::switch_on: {
-                if (i + 1 < q_.size() && (q_[i + 1].evt.type == epoc::event_code::switch_on)) {
-                    q_.erase(q_.begin() + i);
-                    break;
+                // Only the latest one of consecutive switch on matters
+                if (last_switch_on_id) {
+                    remove_event(last_switch_on_id.value());
                 }
+
+                last_switch_on_id = id;
+                last_focus_change_id.reset();
+
+                return true;
             }
 
             default: {
-                LOG_ERROR(SERVICE_WINDOW, "Unhandled purge of event type: {}", static_cast<int>(q_[i].evt.type));
+                LOG_ERROR(SERVICE_WINDOW, "Unhandled purge of event type: {}", static_cast<int>(evt.type));
                 assert(false);
 
                 break;
             }
             }
-        }
+
+            last_focus_change_id.reset();
+            last_switch_on_id.reset();
+
+            return true;
+        });
     }
 
     event event_fifo::get_event() {
@@ -140,40 +157,27 @@ namespace eka2l1::epoc {
         eka2l1::rect target_queue_rect(evt.top_left, evt.bottom_right);
         target_queue_rect.transform_from_symbian_rectangle();
 
-        std::size_t limit = q_.size();
-
-        for (std::size_t i = 0; i < limit; i++) {
-            eka2l1::rect queued_rect(q_[i].evt.evt_.top_left, q_[i].evt.evt_.bottom_right);
+        filter_events([&](const std::uint32_t id, redraw_event_full &queued) {
+            eka2l1::rect queued_rect(queued.evt_.top_left, queued.evt_.bottom_right);
             queued_rect.transform_from_symbian_rectangle();
 
-            if ((q_[i].evt.evt_.handle == evt.handle) && target_queue_rect.contains(queued_rect)) {
-                // The new redraw rect contains the old queued redraw rect. Remove it to avoid
-                // unneccessary redraws.
-                q_.erase(q_.begin() + i);
-                limit--;
-            }
-        }
+            // The new redraw rect contains the old queued redraw rect. Remove it to avoid
+            // unneccessary redraws.
+            return !((queued.evt_.handle == evt.handle) && target_queue_rect.contains(queued_rect));
+        });
 
         redraw_event_full full_event;
         full_event.owner_ = owner;
         full_event.evt_ = evt;
 
-        std::uint32_t id = queue_event_dont_care(full_event);
-        q_.back().pri = pri;
-
-        std::stable_sort(q_.begin(), q_.end(),
-            [&](const fifo_element &e1, const fifo_element &e2) {
-                return e1.pri < e2.pri;
-            });
-
         // Queue a redraw won't directly trigger a notification.
-        return id;
+        return queue_event_dont_care(full_event, pri);
     }
 
     void redraw_fifo::remove_events(void *owner) {
         const std::lock_guard<std::mutex> guard(lock_);
-        common::erase_elements(q_, [owner](fifo_element &elem) -> bool {
-            return elem.evt.owner_ == owner;
+        filter_events([owner](const std::uint32_t id, redraw_event_full &queued) {
+            return queued.owner_ != owner;
         });
     }
-}
\ No newline at end of file
+}
@@ -22,55 +22,97 @@
 #include <services/window/scheduler.h>
 #include <services/window/screen.h>
 
+#include <algorithm>
 #include <cassert>
 
 namespace eka2l1::epoc {
     static void on_anim_due(std::uint64_t userdata, const int cycles_late) {
         anim_due_callback_data *callback = reinterpret_cast<anim_due_callback_data *>(userdata);
-        callback->sched->invoke_due_animation(callback->driver, callback->screen_number);
+        callback->sched->process_due_animations(callback->driver);
     }
 
-    static void on_scan_callback(std::uint64_t userdata, const int cycles_late) {
-        sched_scan_callback_data *callback = reinterpret_cast<sched_scan_callback_data *>(userdata);
-        callback->sched->idle_callback(callback->driver);
+    static bool due_entry_later(const std::uint64_t lhs_time, const std::uint64_t rhs_time) {
+        return lhs_time > rhs_time;
     }
 
     animation_scheduler::animation_scheduler(kernel_system *kern, ntimer *timing, const int total_screen)
-        : kern_(kern)
-        , timing_(timing)
-        , callback_scheduled_(false) {
+        : timing_(timing)
+        , kern_(kern)
+        , due_event_armed_(false)
+        , due_event_time_(0) {
         anim_due_evt_ = timing_->register_event("anim_sched_anim_due_evt", on_anim_due);
-        callback_evt_ = timing->register_event("anim_sched_callback_evt", on_scan_callback);
 
-        // Make callback data
+        callback_data_.sched = this;
+        callback_data_.driver = nullptr;
+
         schedules_.resize(total_screen);
         states_.resize(total_screen);
-        callback_datas_.resize(total_screen);
 
         for (int i = 0; i < total_screen; i++) {
             schedules_[i].scheduled = false;
             states_[i].flags = screen_state::inactive;
-
-            callback_datas_[i].sched = this;
-            callback_datas_[i].screen_number = i;
         }
     }
 
     animation_scheduler::~animation_scheduler() {
         const std::lock_guard<std::mutex> guard(lock_);
 
-        if (callback_scheduled_) {
-            timing_->unschedule_event(callback_evt_, reinterpret_cast<std::uint64_t>(&scan_callback_data_));
+        if (due_event_armed_) {
+            timing_->unschedule_event(anim_due_evt_, reinterpret_cast<std::uint64_t>(&callback_data_));
         }
 
-        for (std::size_t i = 0; i < states_.size(); i++) {
-            if (states_[i].flags == screen_state::scheduled) {
-                timing_->unschedule_event(anim_due_evt_, reinterpret_cast<std::uint64_t>(&callback_datas_[i]));
+        timing_->remove_event(anim_due_evt_);
+    }
+
+    void animation_scheduler::push_due(const int screen_number) {
+        anim_schedule &sched = schedules_[screen_number];
+        sched.generation++;
+
+        due_heap_.push_back(due_entry{ sched.time, screen_number, sched.generation });
+        std::push_heap(due_heap_.begin(), due_heap_.end(), [](const due_entry &lhs, const due_entry &rhs) {
+            return due_entry_later(lhs.time, rhs.time);
+        });
+    }
+
+    void animation_scheduler::arm_due_event() {
+        // Throw away entries of schedules that changed since
+        while (!due_heap_.empty()) {
+            const due_entry &top = due_heap_.front();
+            const anim_schedule &sched = schedules_[top.screen_number];
+
+            if (sched.scheduled && (sched.generation == top.generation)) {
+                break;
             }
+
+            std::pop_heap(due_heap_.begin(), due_heap_.end(), [](const due_entry &lhs, const due_entry &rhs) {
+                return due_entry_later(lhs.time, rhs.time);
+            });
+
+            due_heap_.pop_back();
         }
 
-        timing_->remove_event(callback_evt_);
-        timing_->remove_event(anim_due_evt_);
+        if (due_heap_.empty()) {
+            return;
+        }
+
+        const std::uint64_t next_due = due_heap_.front().time;
+
+        if (due_event_armed_) {
+            if (due_event_time_ <= next_due) {
+                return;
+            }
+
+            // A sooner due came, move the event up
+            timing_->unschedule_event(anim_due_evt_, reinterpret_cast<std::uint64_t>(&callback_data_));
+        }
+
+        const std::uint64_t now = timing_->microseconds();
+        const std::int64_t until_due = (next_due > now) ? static_cast<std::int64_t>(next_due - now) : 0;
+
+        due_event_armed_ = true;
+        due_event_time_ = std::max(next_due, now);
+
+        timing_->schedule_event(until_due, anim_due_evt_, reinterpret_cast<std::uint64_t>(&callback_data_));
     }
 
     void animation_scheduler::schedule(drivers::graphics_driver *driver, screen *scr, const std::uint64_t time) {
@@ -81,21 +123,20 @@ namespace eka2l1::epoc {
             return;
         }
 
-        // Get the schedule
-        anim_schedule sched;
+        anim_schedule &sched = schedules_[scr->number];
+        callback_data_.driver = driver;
+
+        if (sched.scheduled && (sched.time <= time)) {
+            // The redraw already scheduled comes sooner, and will take care of this one
+            return;
+        }
+
         sched.scr = scr;
         sched.time = time;
         sched.scheduled = true;
 
-        if (schedules_[scr->number].scheduled) {
-            // Readjust the time
-            schedules_[scr->number].time = time;
-        } else {
-            // Replace with our new sched
-            schedules_[scr->number] = sched;
-        }
-
-        schedule_scans(driver);
+        push_due(scr->number);
+        arm_due_event();
     }
 
     void animation_scheduler::unschedule(const int screen_number) {
@@ -105,7 +146,9 @@ namespace eka2l1::epoc {
             return;
         }
 
+        // The heap entry becomes stale, and is dropped when it reaches the top
         schedules_[screen_number].scheduled = false;
+        schedules_[screen_number].generation++;
     }
 
     animation_scheduler::anim_schedule *animation_scheduler::get_scheduled_screen_update(const int scr_num) {
@@ -120,78 +163,58 @@ namespace eka2l1::epoc {
         return &(schedules_[scr_num]);
     }
 
-    std::int64_t animation_scheduler::get_due_delta(const bool force_redraw, const std::uint64_t due) {
-        if (force_redraw) {
-            // use granularity
-            // For now, 0
-            // TODO: Split animation vs redraw grace granularity
-            return 0;
-        }
+    void animation_scheduler::process_due_animations(drivers::graphics_driver *driver) {
+        std::vector<int> due_screens;
 
-        // TODO: Clamp to not bigger than 30 mins maybe?
-        return std::max<std::int64_t>(due - timing_->microseconds(), 0);
-    }
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+            due_event_armed_ = false;
 
-    void animation_scheduler::scan_for_redraw(drivers::graphics_driver *driver, const int screen_number, const bool force_redraw) {
-        anim_schedule *sched = get_scheduled_screen_update(screen_number);
+            const std::uint64_t now = timing_->microseconds();
 
-        if (sched) {
-            // Get screen state, check if it's active
-            // This is for future, for now we are doing all sync
-            screen_state &scr_state = states_[screen_number];
-
-            if (scr_state.flags != screen_state::active) {
-                // Get the due
-                const std::int64_t until_due = get_due_delta(force_redraw, sched->time);
-                bool should_update = true;
-
-                const std::uint64_t now = timing_->microseconds();
-
-                if (scr_state.flags == screen_state::scheduled) {
-                    // The screen update has been scheduled before. In that case, we need to check the time
-                    // the redraw was supposed to be trigger.
-                    //
-                    // If the due of this schedule is sooner, cancel the existing screen redraw schedule
-                    // and replace with our due.
-                    //
-                    // Else, wait for the existing update to finish, then do redraw.
-                    if (until_due < static_cast<std::int64_t>(scr_state.time_expected_redraw) - static_cast<std::int64_t>(now)) {
-                        // Cancel the schedule
-                        timing_->unschedule_event(anim_due_evt_, reinterpret_cast<std::uint64_t>(&callback_datas_[screen_number]));
-                    } else {
-                        should_update = false;
-                    }
+            while (!due_heap_.empty() && (due_heap_.front().time <= now)) {
+                const due_entry top = due_heap_.front();
+
+                std::pop_heap(due_heap_.begin(), due_heap_.end(), [](const due_entry &lhs, const due_entry &rhs) {
+                    return due_entry_later(lhs.time, rhs.time);
+                });
+
+                due_heap_.pop_back();
+
+                const anim_schedule &sched = schedules_[top.screen_number];
+                if (!sched.scheduled || (sched.generation != top.generation)) {
+                    continue;
                 }
 
-                if (should_update) {
-                    callback_datas_[screen_number].driver = driver;
-
-                    if (until_due == 0) {
-                        // Invoke the due right away.
-                        scr_state.time_expected_redraw = now;
-
-                        lock_.unlock();
-                        invoke_due_animation(driver, screen_number);
-                        lock_.lock();
-                    } else {
-                        scr_state.time_expected_redraw = now + until_due;
-                        scr_state.flags = screen_state::scheduled;
-                        timing_->schedule_event(static_cast<int64_t>(until_due), anim_due_evt_, reinterpret_cast<std::uint64_t>(&callback_datas_[screen_number]));
-                    }
+                if (states_[top.screen_number].flags == screen_state::active) {
+                    // Redraw in progress on another thread. It picks the schedule up again once done
+                    continue;
                 }
+
+                due_screens.push_back(top.screen_number);
             }
         }
+
+        for (const int screen_number : due_screens) {
+            invoke_due_animation(driver, screen_number);
+        }
+
+        const std::lock_guard<std::mutex> guard(lock_);
+        arm_due_event();
     }
 
     void animation_scheduler::invoke_due_animation(drivers::graphics_driver *driver, const int screen_number) {
         lock_.lock();
 
         anim_schedule *sched = get_scheduled_screen_update(screen_number);
-        epoc::screen *scr = sched->scr;
-
         assert(sched && "The returned schedule should not be nullptr");
 
+        epoc::screen *scr = sched->scr;
+
         sched->scheduled = false;
+        sched->generation++;
+
+        states_[screen_number].flags = screen_state::active;
 
         lock_.unlock();
 
@@ -211,32 +234,12 @@ namespace eka2l1::epoc {
         {
             const std::lock_guard<std::mutex> guard(lock_);
             states_[screen_number].flags = screen_state::inactive;
-        }
-    }
-
-    void animation_scheduler::idle_callback(drivers::graphics_driver *driver) {
-        lock_.lock();
-        callback_scheduled_ = false;
-
-        for (int screen_num = 0; screen_num < states_.size(); screen_num++) {
-            scan_for_redraw(driver, screen_num, false);
-        }
-
-        lock_.unlock();
-    }
 
-    void animation_scheduler::schedule_scans(drivers::graphics_driver *driver) {
-        // Schedule scan, create some screen update delay to be correspond with hardware.
-        // TODO: Maybe get rid of this function?
-        static constexpr std::uint16_t scheduled_us = 500;
-
-        if (!callback_scheduled_) {
-            // Schedule it
-            scan_callback_data_.driver = driver;
-            scan_callback_data_.sched = this;
-
-            timing_->schedule_event(scheduled_us, callback_evt_, reinterpret_cast<std::uint64_t>(&scan_callback_data_));
-            callback_scheduled_ = true;
+            if (schedules_[screen_number].scheduled) {
+                // Scheduled again while drawing, its due may have been skipped meanwhile
+                push_due(screen_number);
+                arm_due_event();
+            }
         }
     }
-}
\ No newline at end of file
+}
@@ -51,14 +51,15 @@ namespace eka2l1 {
             return std::nullopt;
         }
 
-        common::region return_result;
+        std::vector<eka2l1::rect> rects(count);
         for (std::int32_t i = 0; i < count; i++) {
-            eka2l1::rect rect = *reinterpret_cast<eka2l1::rect*>(region_rect_buffer_ptr + i * sizeof(eka2l1::rect));
-            rect.transform_from_symbian_rectangle();
-
-            return_result.rects_.push_back(std::move(rect));
+            rects[i] = *reinterpret_cast<eka2l1::rect*>(region_rect_buffer_ptr + i * sizeof(eka2l1::rect));
+            rects[i].transform_from_symbian_rectangle();
         }
 
+        common::region return_result;
+        return_result.add_rects(rects.data(), rects.size());
+
         return return_result;
     }
     
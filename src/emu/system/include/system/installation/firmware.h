@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <common/filewriter.h>
 #include <common/types.h>
 #include <system/installation/common.h>
 
@@ -30,11 +31,12 @@
 
 namespace eka2l1 {
     using device_firmware_choose_variant_callback = std::function<int(const std::vector<std::string> &)>;
+    using install_throughput_callback = std::function<void(const common::file_write_stats &)>;
 
     class device_manager;
 
     device_installation_error install_firmware(device_manager *dvc, const std::string &vpl_path,
         const std::string &drives_c_path, const std::string &drives_e_path, const std::string &drives_z_path,
         const std::string &rom_resident_path, device_firmware_choose_variant_callback choose_callback, progress_changed_callback progress_callback,
-        cancel_requested_callback cancel_cb);
+        cancel_requested_callback cancel_cb, install_throughput_callback throughput_callback = nullptr);
 }
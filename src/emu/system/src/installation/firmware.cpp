@@ -25,6 +25,7 @@
 #include <common/buffer.h>
 #include <common/cvt.h>
 #include <common/fileutils.h>
+#include <common/filewriter.h>
 #include <common/log.h>
 #include <common/path.h>
 
@@ -32,13 +33,14 @@
 #include <loader/rofs.h>
 #include <loader/rom.h>
 
+#include <chrono>
 #include <fstream>
 #include <pugixml.hpp>
 
 #include <fat/fat.h>
 
 namespace eka2l1 {
-    static void extract_file(Fat::Image &img, Fat::Entry &entry, const std::string &path) {
+    static void extract_file(Fat::Image &img, Fat::Entry &entry, const std::string &path, common::file_write_pool &writer) {
         const std::u16string filename_16 = entry.get_filename();
         std::string filename = eka2l1::add_path(path, common::ucs2_to_utf8(filename_16));
 
@@ -46,18 +48,17 @@ namespace eka2l1 {
             filename = common::lowercase_string(filename);
         }
 
-        common::wo_std_file_stream f(filename, true);
+        const std::size_t out_handle = writer.begin_file(filename);
 
         static constexpr std::uint32_t CHUNK_SIZE = 0x10000;
 
-        std::vector<std::uint8_t> temp_buf;
-        temp_buf.resize(CHUNK_SIZE);
-
         std::uint32_t size_left = entry.entry.file_size;
         std::uint32_t offset = 0;
 
         while (size_left != 0) {
             std::uint32_t size_to_take = std::min<std::uint32_t>(CHUNK_SIZE, size_left);
+            std::vector<std::uint8_t> temp_buf(size_to_take);
+
             if (img.read_from_cluster(&temp_buf[0], offset, entry.entry.starting_cluster, size_to_take) != size_to_take) {
                 break;
             }
@@ -65,11 +66,13 @@ namespace eka2l1 {
             size_left -= size_to_take;
             offset += size_to_take;
 
-            f.write(reinterpret_cast<const char *>(&temp_buf[0]), size_to_take);
+            writer.write(out_handle, std::move(temp_buf));
         }
+
+        writer.end_file(out_handle);
     }
 
-    static void extract_directory(Fat::Image &img, Fat::Entry mee, std::string dir_path) {
+    static void extract_directory(Fat::Image &img, Fat::Entry mee, std::string dir_path, common::file_write_pool &writer) {
         common::create_directories(dir_path);
 
         while (img.get_next_entry(mee)) {
@@ -87,19 +90,19 @@ namespace eka2l1 {
                         dir_name = common::lowercase_ucs2_string(dir_name);
                     }
 
-                    extract_directory(img, baby, dir_path + common::ucs2_to_utf8(dir_name) + "\\");
+                    extract_directory(img, baby, dir_path + common::ucs2_to_utf8(dir_name) + "\\", writer);
                 }
             }
 
             if ((mee.entry.file_attributes & (int)Fat::EntryAttribute::ARCHIVE) || (!(mee.entry.file_attributes & (int)Fat::EntryAttribute::DIRECTORY) && (mee.entry.file_size != 0))) {
-                extract_file(img, mee, dir_path);
+                extract_file(img, mee, dir_path, writer);
             }
         }
     }
 
     static device_installation_error dump_data_from_fpsx(loader::firmware::fpsx_header &header, common::ro_stream &stream, const std::string &drives_c_path,
         const std::string &drives_e_path, const std::string &drives_z_path, const std::string &rom_resident_path,
-        progress_changed_callback progress_cb, cancel_requested_callback cancel_cb) {
+        common::file_write_pool &writer, progress_changed_callback progress_cb, cancel_requested_callback cancel_cb) {
         if (header.type_ == loader::firmware::FPSX_TYPE_INVALID) {
             if (progress_cb)
                 progress_cb(1, 1);
@@ -110,14 +113,13 @@ namespace eka2l1 {
             return device_installation_general_failure;
         }
 
-        std::vector<char> buf;
-
         if (header.type_ == loader::firmware::FPSX_TYPE_CORE) {
             const std::string rom_path = eka2l1::add_path(rom_resident_path, "SYM_TEMP.ROM");
             const std::string rom_final_path = eka2l1::add_path(rom_resident_path, "SYM.ROM");
 
             {
-                common::wo_std_file_stream rom_stream(rom_path, true);
+                // Blocks are read here, while the pool writes the previous ones out
+                const std::size_t rom_handle = writer.begin_file(rom_path);
                 std::uint32_t ignore_bootstrap_left = 0xC00;
 
                 for (auto &root : header.btree_.roots_) {
@@ -151,22 +153,28 @@ namespace eka2l1 {
                                 }
 
                                 stream.seek(root.code_blocks_[i].data_offset_in_stream_ + skip_taken, eka2l1::common::seek_where::beg);
-                                buf.resize(root.code_blocks_[i].header_->data_size_ - skip_taken);
+                                std::vector<std::uint8_t> buf(root.code_blocks_[i].header_->data_size_ - skip_taken);
 
                                 stream.read(buf.data(), buf.size());
-                                rom_stream.write(buf.data(), buf.size());
+                                writer.write(rom_handle, std::move(buf));
 
                                 ignore_bootstrap_left -= skip_taken;
                             }
                         }
 
                         if (cancel_cb && cancel_cb()) {
+                            writer.end_file(rom_handle);
                             return device_installation_general_failure;
                         }
                     }
                 }
+
+                writer.end_file(rom_handle);
             }
 
+            // The ROM must be fully on disk before reading it back
+            writer.wait_idle();
+
             int defrag_result = 0;
 
             {
@@ -192,7 +200,7 @@ namespace eka2l1 {
             common::ro_std_file_stream rom_read_stream(rom_final_path, true);
 
             if (!loader::dump_rom_files(reinterpret_cast<common::ro_stream *>(&rom_read_stream),
-                    drives_z_path, progress_cb, cancel_cb)) {
+                    drives_z_path, progress_cb, cancel_cb, &writer)) {
                 common::remove(rom_final_path);
                 return device_installation_rom_file_corrupt;
             }
@@ -201,7 +209,7 @@ namespace eka2l1 {
         std::string image_path = eka2l1::add_path(rom_resident_path, "TEMP.IMG");
 
         {
-            common::wo_std_file_stream rom_stream(image_path, true);
+            const std::size_t image_handle = writer.begin_file(image_path);
 
             loader::firmware::block_tree_entry *appropiate_block = nullptr;
             if (header.type_ == loader::firmware::FPSX_TYPE_UDA) {
@@ -222,7 +230,7 @@ namespace eka2l1 {
             for (auto &uda_bin_block : blocks) {
                 if (uda_bin_block.ctype_ == loader::firmware::CONTENT_TYPE_CODE) {
                     stream.seek(uda_bin_block.data_offset_in_stream_, eka2l1::common::seek_where::beg);
-                    buf.resize(uda_bin_block.header_->data_size_);
+                    std::vector<std::uint8_t> buf(uda_bin_block.header_->data_size_);
 
                     stream.read(buf.data(), buf.size());
 
@@ -233,16 +241,20 @@ namespace eka2l1 {
                         }
 
                         if (buf.size() != size_start_write) {
-                            rom_stream.write(buf.data() + size_start_write, buf.size() - size_start_write);
+                            writer.write(image_handle, buf.data() + size_start_write, buf.size() - size_start_write);
                             flag = false;
                         }
                     } else {
-                        rom_stream.write(buf.data(), buf.size());
+                        writer.write(image_handle, std::move(buf));
                     }
                 }
             }
+
+            writer.end_file(image_handle);
         }
 
+        writer.wait_idle();
+
         // What to do with it now?
         if (header.type_ == loader::firmware::FPSX_TYPE_UDA) {
             // Extract the FAT image, with some twists
@@ -267,7 +279,7 @@ namespace eka2l1 {
             fat_dump_base = drives_c_path;
 
             Fat::Entry bootstrap_entry;
-            extract_directory(fat_img, bootstrap_entry, fat_dump_base);
+            extract_directory(fat_img, bootstrap_entry, fat_dump_base, writer);
 
             if (progress_cb)
                 progress_cb(1, 1);
@@ -276,7 +288,7 @@ namespace eka2l1 {
             common::ro_std_file_stream rofs_img_stream(image_path, true);
 
             // Dump quality ROFS content!!!!!
-            if (!loader::dump_rofs_system(rofs_img_stream, drives_z_path, progress_cb, cancel_cb)) {
+            if (!loader::dump_rofs_system(rofs_img_stream, drives_z_path, progress_cb, cancel_cb, &writer)) {
                 LOG_ERROR(SYSTEM, "Error while dumping ROFS!");
                 return device_installation_rofs_corrupt;
             }
@@ -290,7 +302,8 @@ namespace eka2l1 {
     device_installation_error install_firmware(device_manager *dvcmngr, const std::string &vpl_path,
         const std::string &drives_c_path, const std::string &drives_e_path, const std::string &drives_z_path,
         const std::string &rom_resident_path, device_firmware_choose_variant_callback choose_callback,
-        progress_changed_callback progress_callback, cancel_requested_callback cancel_callback) {
+        progress_changed_callback progress_callback, cancel_requested_callback cancel_callback,
+        install_throughput_callback throughput_callback) {
         std::string cur_dir;
         if (!common::get_current_directory(cur_dir)) {
             LOG_ERROR(SYSTEM, "Can't get current directory!");
@@ -422,6 +435,10 @@ namespace eka2l1 {
         std::string drives_z_temp_path = eka2l1::add_path(drives_z_path, "temp\\");
         std::size_t so_far = 0;
 
+        // This thread reads and decodes the images, the pool writes the extracted files
+        common::file_write_pool writer;
+        auto last_throughput_report = std::chrono::steady_clock::now();
+
         for (auto &fpsx_filename : filenames) {
             common::ro_std_file_stream fpsx_file_stream(fpsx_filename, true);
             std::optional<loader::firmware::fpsx_header> fpsx_head = loader::firmware::read_fpsx_header(
@@ -433,16 +450,28 @@ namespace eka2l1 {
             }
 
             progress_changed_callback wrapped_progress = nullptr;
-            if (progress_callback) {
-                wrapped_progress = [progress_callback, average_progress_max, so_far](const std::size_t taken, const std::size_t max) {
-                    return progress_callback(so_far * (100 / average_progress_max) + taken * (100 / average_progress_max) / max, 100);
+            if (progress_callback || throughput_callback) {
+                wrapped_progress = [&, so_far](const std::size_t taken, const std::size_t max) {
+                    if (throughput_callback) {
+                        const auto now = std::chrono::steady_clock::now();
+
+                        if (now - last_throughput_report >= std::chrono::milliseconds(250)) {
+                            throughput_callback(writer.stats());
+                            last_throughput_report = now;
+                        }
+                    }
+
+                    if (progress_callback) {
+                        progress_callback(so_far * (100 / average_progress_max) + taken * (100 / average_progress_max) / max, 100);
+                    }
                 };
             }
 
             const auto result = dump_data_from_fpsx(fpsx_head.value(), fpsx_file_stream, drives_c_path, drives_e_path, drives_z_temp_path,
-                rom_resident_path, wrapped_progress, cancel_callback);
+                rom_resident_path, writer, wrapped_progress, cancel_callback);
 
             if (result != device_installation_none) {
+                writer.abort();
                 common::delete_folder(drives_z_temp_path);
                 return result;
             }
@@ -450,6 +479,18 @@ namespace eka2l1 {
             so_far++;
         }
 
+        // Everything must be on disk before analyzing the extracted files
+        if (!writer.finish()) {
+            LOG_ERROR(SYSTEM, "Failed to write extracted firmware files");
+            common::delete_folder(drives_z_temp_path);
+
+            return device_installation_general_failure;
+        }
+
+        if (throughput_callback) {
+            throughput_callback(writer.stats());
+        }
+
         // Start analyze and put it into device list
         const epocver ver = loader::determine_rpkg_symbian_version(drives_z_temp_path);
 
@@ -1054,7 +1054,7 @@ namespace eka2l1 {
                 return abstract_file_system_err_code::no;
             }
 
-            if (rom_cache->burn_tree_find_entry(common::ucs2_to_utf8(path))) {
+            if (rom_cache->burn_tree_find_entry(path)) {
                 return abstract_file_system_err_code::ok;
             }
 
@@ -1082,7 +1082,7 @@ namespace eka2l1 {
                 }
             }
 
-            auto entry = rom_cache->burn_tree_find_entry(common::ucs2_to_utf8(new_path));
+            auto entry = rom_cache->burn_tree_find_entry(new_path);
             auto ff = physical_file_system::open_file(new_path, mode);
 
             // Dont change order!
@@ -1099,7 +1099,7 @@ namespace eka2l1 {
                 return std::nullopt;
             }
 
-            auto entry = rom_cache->burn_tree_find_entry(common::ucs2_to_utf8(path));
+            auto entry = rom_cache->burn_tree_find_entry(path);
 
             if (!entry) {
                 return physical_file_system::get_entry_info(path);
@@ -1121,7 +1121,7 @@ namespace eka2l1 {
             loader::rom_dir *the_base_dir = &(rom_cache->root.root_dirs[0].dir);
 
             if (!the_base_path.empty()) {
-                the_base_dir = rom_cache->burn_tree_find_dir(common::ucs2_to_utf8(clue));
+                the_base_dir = rom_cache->burn_tree_find_dir(clue);
             }
 
             if (!the_base_dir) {
@@ -74,3 +74,72 @@ TEST_CASE("detect_diff_comp_new_bigger", "detect_changes") {
     REQUIRE(removes == std::vector<int>({ 1, 7 }));
     REQUIRE(added == std::vector<int>({ 3, 9, 13, 20 }));
 }
+
+TEST_CASE("find_min_max_bytes", "min_max") {
+    std::vector<std::uint8_t> values;
+
+    for (std::size_t i = 0; i < 53; i++) {
+        values.push_back(static_cast<std::uint8_t>(40 + (i * 7) % 150));
+    }
+
+    std::uint8_t min_value = 0;
+    std::uint8_t max_value = 0;
+
+    // Put the extremes in the scalar tail to check it is merged with the vector result
+    values[51] = 3;
+    values[52] = 250;
+
+    common::find_min_max(values.data(), values.size(), min_value, max_value);
+
+    REQUIRE(min_value == 3);
+    REQUIRE(max_value == 250);
+
+    // Unaligned start, extremes inside the vectorized part
+    values[51] = 100;
+    values[52] = 100;
+    values[5] = 1;
+    values[20] = 255;
+
+    common::find_min_max(values.data() + 1, values.size() - 1, min_value, max_value);
+
+    REQUIRE(min_value == 1);
+    REQUIRE(max_value == 255);
+
+    common::find_min_max(values.data(), 0, min_value, max_value);
+
+    REQUIRE(min_value == 0xFF);
+    REQUIRE(max_value == 0);
+}
+
+TEST_CASE("find_min_max_halfwords", "min_max") {
+    std::vector<std::uint16_t> values;
+
+    for (std::size_t i = 0; i < 37; i++) {
+        values.push_back(static_cast<std::uint16_t>(1000 + (i * 331) % 4000));
+    }
+
+    std::uint16_t min_value = 0;
+    std::uint16_t max_value = 0;
+
+    // Values above 0x7FFF must not be treated as negative
+    values[9] = 0x8001;
+    values[30] = 17;
+
+    common::find_min_max(values.data(), values.size(), min_value, max_value);
+
+    REQUIRE(min_value == 17);
+    REQUIRE(max_value == 0x8001);
+
+    values[36] = 0xFFFF;
+    values[35] = 0;
+
+    common::find_min_max(values.data() + 3, values.size() - 3, min_value, max_value);
+
+    REQUIRE(min_value == 0);
+    REQUIRE(max_value == 0xFFFF);
+
+    common::find_min_max(values.data(), 5, min_value, max_value);
+
+    REQUIRE(min_value == 1000);
+    REQUIRE(max_value == 2324);
+}
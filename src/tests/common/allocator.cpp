@@ -20,8 +20,11 @@
 #include <catch2/catch.hpp>
 #include <common/allocator.h>
 
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <random>
+#include <vector>
 
 using namespace eka2l1;
 
@@ -128,4 +131,147 @@ TEST_CASE("bitmap_count_unaligned_start_end", "bitmap_allocator") {
     // First bitmap has 4 valid bits on (from offset 2), plus with bitmap 2 and 3 (4 bits before offset 70),
     // we got 4 + 12 + 4 = 20 bits
     REQUIRE(alloc.allocated_count(2, 70) == 20);
-}
\ No newline at end of file
+}
+
+TEST_CASE("block_alloc_reuse_freed_space", "block_allocator") {
+    std::vector<std::uint8_t> space(0x1000);
+    common::block_allocator alloc(space.data(), space.size());
+
+    void *first = alloc.allocate(100);
+    void *second = alloc.allocate(200);
+
+    REQUIRE(first != nullptr);
+    REQUIRE(second != nullptr);
+    REQUIRE(first != second);
+
+    REQUIRE(alloc.freep(first));
+    REQUIRE_FALSE(alloc.freep(first));
+
+    // Same size should be served from the hole just freed
+    REQUIRE(alloc.allocate(100) == first);
+}
+
+TEST_CASE("block_alloc_coalesce_neighbours", "block_allocator") {
+    std::vector<std::uint8_t> space(0x1000);
+    common::block_allocator alloc(space.data(), space.size());
+
+    void *a = alloc.allocate(0x100);
+    void *b = alloc.allocate(0x100);
+    void *c = alloc.allocate(0x100);
+    void *guard = alloc.allocate(0x100);
+
+    REQUIRE(guard != nullptr);
+
+    REQUIRE(alloc.freep(a));
+    REQUIRE(alloc.freep(c));
+    REQUIRE(alloc.freep(b));
+
+    // The three neighbours should now be one block
+    const common::block_allocator_stats stats = alloc.stats();
+    REQUIRE(stats.coalesce_count == 2);
+    REQUIRE(stats.active_block_count == 1);
+    REQUIRE(stats.free_block_count == 2);
+
+    REQUIRE(alloc.allocate(0x300) == a);
+}
+
+TEST_CASE("block_alloc_out_of_space", "block_allocator") {
+    std::vector<std::uint8_t> space(0x400);
+    common::block_allocator alloc(space.data(), space.size());
+
+    REQUIRE(alloc.allocate(0x300) != nullptr);
+    REQUIRE(alloc.allocate(0x200) == nullptr);
+
+    const common::block_allocator_stats stats = alloc.stats();
+    REQUIRE(stats.failed_alloc_count == 1);
+    REQUIRE(stats.used_size == 0x300);
+    REQUIRE(stats.largest_free_block == stats.free_size);
+}
+
+// Replay an allocation pattern similar to what the font and bitmap server does: many small glyph
+// and icon bitmaps living short, mixed with a few screen-sized bitmaps living long.
+static void replay_fbs_like_trace(common::block_allocator &alloc, const int op_count, const bool check) {
+    static constexpr std::size_t SIZE_CLASSES[] = {
+        64, 128, 176, 512, // Glyphs
+        44 * 44 * 2, 44 * 44 * 4, 88 * 88 * 4, // Icons
+        176 * 208 * 2, 240 * 320 * 2, 360 * 640 * 4 // Screen-sized
+    };
+
+    std::mt19937 rng(0x5EED);
+    std::uniform_int_distribution<int> class_dist(0, 99);
+    std::uniform_int_distribution<int> action_dist(0, 99);
+
+    std::vector<void *> live;
+    live.reserve(op_count);
+
+    for (int i = 0; i < op_count; i++) {
+        if (!live.empty() && (action_dist(rng) < 45)) {
+            const std::size_t victim = rng() % live.size();
+            const bool result = alloc.freep(live[victim]);
+
+            if (check) {
+                REQUIRE(result);
+            }
+
+            live[victim] = live.back();
+            live.pop_back();
+
+            continue;
+        }
+
+        const int pick = class_dist(rng);
+        std::size_t size = 0;
+
+        if (pick < 70) {
+            size = SIZE_CLASSES[pick % 4] + (rng() % 64);
+        } else if (pick < 97) {
+            size = SIZE_CLASSES[4 + pick % 3];
+        } else {
+            size = SIZE_CLASSES[7 + pick % 3];
+        }
+
+        void *ptr = alloc.allocate(size);
+
+        if (ptr) {
+            live.push_back(ptr);
+        }
+    }
+
+    for (void *ptr : live) {
+        const bool result = alloc.freep(ptr);
+
+        if (check) {
+            REQUIRE(result);
+        }
+    }
+}
+
+TEST_CASE("block_alloc_fbs_trace_all_freed_coalesce_back", "block_allocator") {
+    std::vector<std::uint8_t> space(0x1000000);
+    common::block_allocator alloc(space.data(), space.size());
+
+    replay_fbs_like_trace(alloc, 20000, true);
+
+    const common::block_allocator_stats stats = alloc.stats();
+    REQUIRE(stats.used_size == 0);
+    REQUIRE(stats.active_block_count == 0);
+    REQUIRE(stats.free_block_count == 1);
+    REQUIRE(stats.largest_free_block == stats.total_size);
+}
+
+TEST_CASE("block_alloc_fbs_trace_benchmark", "[.benchmark]") {
+    std::vector<std::uint8_t> space(0x4000000);
+    common::block_allocator alloc(space.data(), space.size());
+
+    static constexpr int OP_COUNT = 1000000;
+
+    const auto start = std::chrono::steady_clock::now();
+    replay_fbs_like_trace(alloc, OP_COUNT, false);
+    const auto end = std::chrono::steady_clock::now();
+
+    const common::block_allocator_stats stats = alloc.stats();
+
+    WARN("Replayed " << OP_COUNT << " operations in " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+                     << " ms, " << stats.alloc_count << " allocations, " << stats.failed_alloc_count << " failed, "
+                     << stats.coalesce_count << " coalesces");
+}
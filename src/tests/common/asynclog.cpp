@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/asynclog.h>
+
+#include <spdlog/sinks/ostream_sink.h>
+
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace eka2l1;
+
+static std::shared_ptr<spdlog::logger> make_test_logger(std::ostringstream &stream) {
+    auto sink = std::make_shared<spdlog::sinks::ostream_sink_mt>(stream);
+    auto logger = std::make_shared<spdlog::logger>("Async log test", sink);
+
+    logger->set_pattern("%v");
+    logger->set_level(spdlog::level::trace);
+
+    return logger;
+}
+
+static std::vector<std::string> split_lines(const std::string &str) {
+    std::vector<std::string> lines;
+    std::istringstream stream(str);
+    std::string line;
+
+    while (std::getline(stream, line)) {
+        lines.push_back(line);
+    }
+
+    return lines;
+}
+
+TEST_CASE("async_log_encoded_arguments", "asynclog") {
+    std::ostringstream output;
+    log::async_logger logger(make_test_logger(output));
+
+    char name_buffer[16];
+    std::strcpy(name_buffer, "first");
+
+    logger.push(COMMON, spdlog::level::info, "test.cpp", 10, "Value {} hex 0x{:X} float {:.2f}", 42, 255u, 1.5);
+    logger.push(COMMON, spdlog::level::warn, "test.cpp", 11, "Name {} {}", std::string("temporary"), name_buffer);
+    logger.push(COMMON, spdlog::level::info, "test.cpp", 12, "No arguments");
+
+    // Formatted on the calling thread, since the view is not owned by the record
+    logger.push(COMMON, spdlog::level::info, "test.cpp", 13, "View {:>6}", fmt::string_view("abc"));
+
+    // The buffer changes before the record is written, which must not be seen
+    std::strcpy(name_buffer, "second");
+
+    REQUIRE(logger.flush() == 4);
+
+    const std::vector<std::string> lines = split_lines(output.str());
+    REQUIRE(lines.size() == 4);
+    REQUIRE(lines[0] == "test.cpp:10 [Common]: Value 42 hex 0xFF float 1.50");
+    REQUIRE(lines[1] == "test.cpp:11 [Common]: Name temporary first");
+    REQUIRE(lines[2] == "test.cpp:12 [Common]: No arguments");
+    REQUIRE(lines[3] == "test.cpp:13 [Common]: View    abc");
+
+    REQUIRE(logger.stats().written_ == 4);
+    REQUIRE(logger.stats().dropped_ == 0);
+}
+
+TEST_CASE("async_log_drops_when_full", "asynclog") {
+    std::ostringstream output;
+    log::async_logger logger(make_test_logger(output), 1024);
+
+    const int push_count = 100;
+    for (int i = 0; i < push_count; i++) {
+        logger.push(COMMON, spdlog::level::trace, "test.cpp", 20, "Record {}", i);
+    }
+
+    const log::async_log_stats before_flush = logger.stats();
+    REQUIRE(before_flush.dropped_ > 0);
+
+    const std::size_t written = logger.flush();
+    REQUIRE(written + before_flush.dropped_ == push_count);
+
+    // Records that fit are kept in order, and the drop is reported
+    const std::vector<std::string> lines = split_lines(output.str());
+    REQUIRE(lines.size() == written + 1);
+    REQUIRE(lines[0] == "test.cpp:20 [Common]: Record 0");
+    REQUIRE(lines.back().find("dropped") != std::string::npos);
+
+    // Space is available again after the flush
+    logger.push(COMMON, spdlog::level::trace, "test.cpp", 21, "After flush");
+    REQUIRE(logger.flush() == 1);
+}
+
+TEST_CASE("async_log_multiple_threads", "asynclog") {
+    std::ostringstream output;
+    log::async_logger logger(make_test_logger(output));
+
+    logger.start();
+
+    const int thread_count = 4;
+    const int push_per_thread = 2000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; t++) {
+        threads.emplace_back([&logger, t]() {
+            for (int i = 0; i < push_per_thread; i++) {
+                logger.push(COMMON, spdlog::level::debug, "test.cpp", 30, "Thread {} record {}", t, i);
+            }
+        });
+    }
+
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+
+    logger.stop();
+
+    const log::async_log_stats stats = logger.stats();
+    REQUIRE(stats.written_ + stats.dropped_ == thread_count * push_per_thread);
+
+    // Records of each thread come out in the order they were pushed
+    std::vector<int> next_record(thread_count, 0);
+    std::size_t line_count = 0;
+
+    for (const std::string &line: split_lines(output.str())) {
+        int thread_index = 0;
+        int record_index = 0;
+
+        if (std::sscanf(line.c_str(), "test.cpp:30 [Common]: Thread %d record %d", &thread_index, &record_index) != 2) {
+            continue;
+        }
+
+        REQUIRE(record_index >= next_record[thread_index]);
+        next_record[thread_index] = record_index + 1;
+
+        line_count++;
+    }
+
+    REQUIRE(line_count == stats.written_);
+}
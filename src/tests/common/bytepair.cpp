@@ -0,0 +1,436 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/bytepair.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <stack>
+#include <vector>
+
+using namespace eka2l1;
+
+// The byte-at-a-time decoder the current one replaced, kept to check the output against
+static int reference_bytepair_decompress(void *destination, unsigned int dest_size, void *buffer, unsigned int buf_size) {
+    uint8_t *data8 = reinterpret_cast<uint8_t *>(buffer);
+    uint32_t lookup_table[0x200];
+
+    uint8_t *lookup_table_first = reinterpret_cast<uint8_t *>(lookup_table);
+    uint8_t *lookup_table_second = lookup_table_first + 0x100;
+
+    uint32_t marker = ~0u;
+    uint8_t p1, p2;
+
+    // Fill the table
+    uint32_t b = 0x03020100;
+    uint32_t step = 0x04040404;
+
+    std::stack<uint8_t> sec_stack;
+
+    uint8_t *buf_end = reinterpret_cast<uint8_t *>(buffer) + buf_size;
+    uint8_t *dest_end = reinterpret_cast<uint8_t *>(destination) + dest_size;
+
+    uint8_t *dest = reinterpret_cast<uint8_t *>(destination);
+
+    uint32_t *lut = (uint32_t *)(lookup_table);
+
+    do {
+        *lut++ = b;
+        b += step;
+    } while (b > step);
+
+    uint8_t total_pair = *data8++;
+
+    if (total_pair) {
+        marker = *data8++;
+        lookup_table_first[marker] = (uint8_t)(~marker);
+
+        if (total_pair < 32) {
+            uint8_t *pair_end = data8 + 3 * total_pair;
+
+            do {
+                b = *data8++;
+                p1 = *data8++;
+                p2 = *data8++;
+
+                lookup_table_first[b] = p1;
+                lookup_table_second[b] = p2;
+            } while (data8 < pair_end);
+
+        } else {
+            uint8_t *mask_st = data8;
+            data8 += 32;
+
+            for (b = 0; b < 0x100; b++) {
+                uint8_t mask = mask_st[b >> 3];
+
+                if (mask & (1 << (b & 7))) {
+                    // Read the pair
+                    p1 = *data8++;
+                    p2 = *data8++;
+
+                    lookup_table_first[b] = p1;
+                    lookup_table_second[b] = p2;
+
+                    --total_pair;
+                }
+            }
+
+            if (total_pair) {
+                return 0;
+            }
+        }
+    }
+
+    b = *data8++;
+    p1 = lookup_table_first[b];
+
+    if (p1 != b)
+        goto not_single;
+
+process_replace:
+    if (data8 >= buf_end) {
+        goto done_data8;
+    }
+
+    b = *data8++;
+    *dest++ = p1;
+
+    if (dest >= dest_end) {
+        goto done_dest;
+    }
+
+    p1 = lookup_table_first[b];
+
+    if (p1 == b)
+        goto process_replace;
+
+not_single:
+    if (b == marker) {
+        goto do_marker;
+    }
+
+do_pair:
+    p2 = lookup_table_second[b];
+    b = p1;
+    p1 = lookup_table_first[b];
+    sec_stack.push(p2);
+
+recurse:
+    if (b != p1) {
+        goto do_pair;
+    }
+
+    if (sec_stack.empty()) {
+        goto process_replace;
+    }
+
+    b = sec_stack.top();
+    sec_stack.pop();
+
+    *dest++ = p1;
+    p1 = lookup_table_first[b];
+
+    goto recurse;
+
+do_marker:
+    p1 = *data8++;
+    goto process_replace;
+
+done_data8:
+    *dest++ = p1;
+    return static_cast<int>(dest - static_cast<uint8_t *>(destination));
+
+done_dest:
+    return static_cast<int>(dest - static_cast<uint8_t *>(destination));
+
+    return 1;
+}
+
+/**
+ * \brief Compress a page with byte-pair compression, laid out like the Symbian tools do.
+ *
+ * The least frequent byte becomes the marker. Each pair is given the least frequent byte left as its token,
+ * when the pair occurs often enough to pay for escaping that byte with the marker where it is data.
+ */
+static std::vector<std::uint8_t> bytepair_compress_page(const std::vector<std::uint8_t> &page, const int max_pairs) {
+    std::vector<std::uint8_t> result;
+
+    std::uint32_t frequency[0x100] = {};
+    for (const std::uint8_t b : page) {
+        frequency[b]++;
+    }
+
+    std::vector<int> by_frequency(0x100);
+    for (int i = 0; i < 0x100; i++) {
+        by_frequency[i] = i;
+    }
+
+    std::stable_sort(by_frequency.begin(), by_frequency.end(), [&](const int lhs, const int rhs) {
+        return frequency[lhs] < frequency[rhs];
+    });
+
+    const std::uint8_t marker = static_cast<std::uint8_t>(by_frequency[0]);
+
+    // Escaped bytes are not pairable, and are flagged with bit 8
+    std::vector<int> symbols;
+    for (const std::uint8_t b : page) {
+        symbols.push_back((b == marker) ? (0x100 | b) : b);
+    }
+
+    std::vector<std::array<std::uint8_t, 3>> pairs;
+    std::vector<std::uint32_t> pair_counts(0x10000);
+
+    for (int i = 1; (i < 0x100) && (static_cast<int>(pairs.size()) < max_pairs); i++) {
+        const int token = by_frequency[i];
+
+        std::fill(pair_counts.begin(), pair_counts.end(), 0);
+
+        for (std::size_t j = 0; j + 1 < symbols.size(); j++) {
+            if ((symbols[j] < 0x100) && (symbols[j + 1] < 0x100) && (symbols[j] != token) && (symbols[j + 1] != token)) {
+                pair_counts[(symbols[j] << 8) | symbols[j + 1]]++;
+            }
+        }
+
+        const auto most_used = std::max_element(pair_counts.begin(), pair_counts.end());
+        if (*most_used <= frequency[token] + 3) {
+            break;
+        }
+
+        const int pair = static_cast<int>(most_used - pair_counts.begin());
+        std::vector<int> replaced;
+
+        for (std::size_t j = 0; j < symbols.size(); j++) {
+            if (symbols[j] == token) {
+                replaced.push_back(0x100 | token);
+            } else if ((j + 1 < symbols.size()) && (symbols[j] == (pair >> 8)) && (symbols[j + 1] == (pair & 0xFF))) {
+                replaced.push_back(token);
+                j++;
+            } else {
+                replaced.push_back(symbols[j]);
+            }
+        }
+
+        symbols = std::move(replaced);
+        pairs.push_back({ static_cast<std::uint8_t>(token), static_cast<std::uint8_t>(pair >> 8), static_cast<std::uint8_t>(pair & 0xFF) });
+    }
+
+    if (pairs.empty()) {
+        result.push_back(0);
+        result.insert(result.end(), page.begin(), page.end());
+
+        return result;
+    }
+
+    result.push_back(static_cast<std::uint8_t>(pairs.size()));
+    result.push_back(marker);
+
+    if (pairs.size() < 32) {
+        for (const auto &pair : pairs) {
+            result.insert(result.end(), pair.begin(), pair.end());
+        }
+    } else {
+        std::sort(pairs.begin(), pairs.end());
+
+        std::uint8_t mask[32] = {};
+        for (const auto &pair : pairs) {
+            mask[pair[0] >> 3] |= static_cast<std::uint8_t>(1 << (pair[0] & 7));
+        }
+
+        result.insert(result.end(), mask, mask + 32);
+
+        for (const auto &pair : pairs) {
+            result.push_back(pair[1]);
+            result.push_back(pair[2]);
+        }
+    }
+
+    for (const int symbol : symbols) {
+        if (symbol & 0x100) {
+            result.push_back(marker);
+        }
+
+        result.push_back(static_cast<std::uint8_t>(symbol & 0xFF));
+    }
+
+    return result;
+}
+
+enum class bytepair_test_data {
+    text,
+    code,
+    random,
+    mixed
+};
+
+static std::vector<std::uint8_t> make_bytepair_test_page(std::mt19937 &rng, const bytepair_test_data kind, const std::size_t size) {
+    static const char *WORDS[] = { "Symbian ", "EPOC ", "kernel ", "server ", "session ", "bitmap ", "font ", "the ", "of " };
+
+    std::vector<std::uint8_t> page;
+    std::uniform_int_distribution<int> byte_dist(0, 255);
+
+    while (page.size() < size) {
+        bytepair_test_data current = kind;
+        if (kind == bytepair_test_data::mixed) {
+            current = static_cast<bytepair_test_data>(rng() % 3);
+        }
+
+        switch (current) {
+        case bytepair_test_data::text: {
+            const char *word = WORDS[rng() % (sizeof(WORDS) / sizeof(WORDS[0]))];
+            while (*word) {
+                page.push_back(static_cast<std::uint8_t>(*word++));
+            }
+
+            break;
+        }
+
+        case bytepair_test_data::code: {
+            // ARM instruction-like words: a few common opcodes with varying registers and immediates
+            static const std::uint32_t OPCODES[] = { 0xE1A00000, 0xE5900000, 0xE5800000, 0xEB000000, 0xE3A00000 };
+            const std::uint32_t word = OPCODES[rng() % 5] | ((rng() % 16) << 12) | (rng() % 64);
+
+            for (int i = 0; i < 4; i++) {
+                page.push_back(static_cast<std::uint8_t>(word >> (i * 8)));
+            }
+
+            break;
+        }
+
+        default: {
+            const int run_length = 1 + static_cast<int>(rng() % 48);
+            for (int i = 0; i < run_length; i++) {
+                page.push_back(static_cast<std::uint8_t>(byte_dist(rng)));
+            }
+
+            break;
+        }
+        }
+    }
+
+    page.resize(size);
+    return page;
+}
+
+TEST_CASE("bytepair_matches_reference_decoder", "bytepair") {
+    std::mt19937 rng(0x5EED);
+    std::size_t mask_table_pages = 0;
+
+    for (const bytepair_test_data kind : { bytepair_test_data::text, bytepair_test_data::code, bytepair_test_data::random, bytepair_test_data::mixed }) {
+        for (const int max_pairs : { 0, 1, 10, 31, 32, 100, 250 }) {
+            for (const std::size_t page_size : { static_cast<std::size_t>(common::BYTEPAIR_PAGE_SIZE), static_cast<std::size_t>(1000), static_cast<std::size_t>(7) }) {
+                const std::vector<std::uint8_t> page = make_bytepair_test_page(rng, kind, page_size);
+                std::vector<std::uint8_t> compressed = bytepair_compress_page(page, max_pairs);
+
+                if (compressed[0] >= 32) {
+                    mask_table_pages++;
+                }
+
+                std::vector<std::uint8_t> expected(page_size);
+                std::vector<std::uint8_t> decoded(page_size);
+
+                const int expected_size = reference_bytepair_decompress(expected.data(), static_cast<unsigned int>(page_size),
+                    compressed.data(), static_cast<unsigned int>(compressed.size()));
+                const int decoded_size = common::bytepair_decompress(decoded.data(), static_cast<unsigned int>(page_size),
+                    compressed.data(), static_cast<unsigned int>(compressed.size()));
+
+                REQUIRE(expected_size == static_cast<int>(page_size));
+                REQUIRE(decoded_size == expected_size);
+                REQUIRE(expected == page);
+                REQUIRE(decoded == page);
+            }
+        }
+    }
+
+    // Both layouts of the pair table were covered
+    REQUIRE(mask_table_pages > 0);
+}
+
+TEST_CASE("bytepair_stops_at_destination_end", "bytepair") {
+    std::mt19937 rng(42);
+
+    const std::vector<std::uint8_t> page = make_bytepair_test_page(rng, bytepair_test_data::text, common::BYTEPAIR_PAGE_SIZE);
+    std::vector<std::uint8_t> compressed = bytepair_compress_page(page, 100);
+
+    // Guard bytes after the destination must be left untouched
+    std::vector<std::uint8_t> decoded(1000 + 64, 0xCD);
+    const int decoded_size = common::bytepair_decompress(decoded.data(), 1000, compressed.data(), static_cast<unsigned int>(compressed.size()));
+
+    REQUIRE(decoded_size == 1000);
+    REQUIRE(std::equal(decoded.begin(), decoded.begin() + 1000, page.begin()));
+    REQUIRE(std::all_of(decoded.begin() + 1000, decoded.end(), [](const std::uint8_t b) { return b == 0xCD; }));
+}
+
+TEST_CASE("bytepair_rejects_damaged_pair_table", "bytepair") {
+    std::uint8_t decoded[64];
+
+    // Two pairs referencing each other
+    std::uint8_t cyclic[] = { 2, 0xFE, 0x10, 0x11, 0x41, 0x11, 0x10, 0x41, 0x10 };
+    REQUIRE(common::bytepair_decompress(decoded, sizeof(decoded), cyclic, sizeof(cyclic)) == 0);
+
+    // A pair made of the marker, which has no expansion
+    std::uint8_t marker_pair[] = { 1, 0xFE, 0x10, 0xFE, 0x41, 0x10 };
+    REQUIRE(common::bytepair_decompress(decoded, sizeof(decoded), marker_pair, sizeof(marker_pair)) == 0);
+
+    // Pair table cut short
+    std::uint8_t truncated[] = { 3, 0xFE, 0x10, 0x41 };
+    REQUIRE(common::bytepair_decompress(decoded, sizeof(decoded), truncated, sizeof(truncated)) == 0);
+}
+
+TEST_CASE("bytepair_decompress_benchmark", "[.benchmark]") {
+    std::mt19937 rng(0xB17E);
+
+    const std::pair<bytepair_test_data, const char *> kinds[] = {
+        { bytepair_test_data::code, "Code" },
+        { bytepair_test_data::mixed, "Mixed" },
+        { bytepair_test_data::random, "Incompressible" }
+    };
+
+    for (const auto &[kind, kind_name] : kinds) {
+        std::vector<std::vector<std::uint8_t>> pages;
+        for (int i = 0; i < 64; i++) {
+            pages.push_back(bytepair_compress_page(make_bytepair_test_page(rng, kind, common::BYTEPAIR_PAGE_SIZE), 250));
+        }
+
+        std::vector<std::uint8_t> decoded(common::BYTEPAIR_PAGE_SIZE);
+        const int rounds = 64;
+
+        auto measure_mb_per_s = [&](int (*decompress)(void *, unsigned int, void *, unsigned int)) {
+            const auto start = std::chrono::steady_clock::now();
+
+            for (int round = 0; round < rounds; round++) {
+                for (auto &page : pages) {
+                    decompress(decoded.data(), common::BYTEPAIR_PAGE_SIZE, page.data(), static_cast<unsigned int>(page.size()));
+                }
+            }
+
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            return (static_cast<double>(rounds) * pages.size() * common::BYTEPAIR_PAGE_SIZE) / (seconds * 1024.0 * 1024.0);
+        };
+
+        const double reference_speed = measure_mb_per_s(reference_bytepair_decompress);
+        const double speed = measure_mb_per_s(common::bytepair_decompress);
+
+        WARN(kind_name << " pages: byte-at-a-time " << reference_speed << " MB/s, table decoder " << speed << " MB/s");
+    }
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/container.h>
+
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+using namespace eka2l1;
+
+TEST_CASE("ring_buffer_segments_wrap_around", "ring_buffer") {
+    common::ring_buffer<char, 16> buffer;
+    std::vector<char> source(24);
+    std::iota(source.begin(), source.end(), 0);
+
+    // Move the read/write position close to the end
+    REQUIRE(buffer.push(source.data(), 12) == 12);
+
+    char sink[12];
+    REQUIRE(buffer.pop(sink, 12) == 12);
+    REQUIRE(std::memcmp(sink, source.data(), 12) == 0);
+
+    // Fill in place. The free space is split in two at the end of the storage.
+    auto free_segment = buffer.write_segment();
+    REQUIRE(free_segment.count_ == 4);
+
+    std::memcpy(free_segment.data_, source.data() + 12, 4);
+    buffer.commit(4);
+
+    free_segment = buffer.write_segment();
+    REQUIRE(free_segment.count_ == 12);
+
+    std::memcpy(free_segment.data_, source.data() + 16, 8);
+    buffer.commit(8);
+
+    REQUIRE(buffer.size() == 12);
+
+    auto segments = buffer.read_segments(10);
+    REQUIRE(segments[0].count_ == 4);
+    REQUIRE(segments[1].count_ == 6);
+    REQUIRE(std::memcmp(segments[0].data_, source.data() + 12, 4) == 0);
+    REQUIRE(std::memcmp(segments[1].data_, source.data() + 16, 6) == 0);
+
+    // Peeking does not take the data out
+    REQUIRE(buffer.size() == 12);
+
+    buffer.consume(4);
+    REQUIRE(buffer.size() == 8);
+
+    REQUIRE(buffer.pop(sink, 12) == 8);
+    REQUIRE(std::memcmp(sink, source.data() + 16, 8) == 0);
+    REQUIRE(buffer.size() == 0);
+}
+
+TEST_CASE("ring_buffer_commit_bounded_by_free_space", "ring_buffer") {
+    common::ring_buffer<char, 8> buffer;
+    std::vector<char> source(8, 'a');
+
+    REQUIRE(buffer.push(source.data(), 6) == 6);
+    REQUIRE(buffer.write_segment().count_ == 2);
+
+    buffer.commit(5);
+    REQUIRE(buffer.size() == 8);
+    REQUIRE(buffer.write_segment().count_ == 0);
+}
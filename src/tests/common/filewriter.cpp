@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+#include <common/fileutils.h>
+#include <common/filewriter.h>
+#include <common/path.h>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace eka2l1;
+
+static constexpr const char *FILE_WRITER_TEST_FOLDER = "filewritertest";
+
+static std::vector<std::uint8_t> read_test_file(const std::string &path) {
+    std::ifstream stream(path, std::ios::binary);
+    return std::vector<std::uint8_t>(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+TEST_CASE("file_write_pool_keeps_chunk_order", "file_write_pool") {
+    static constexpr std::size_t FILE_COUNT = 16;
+    static constexpr std::size_t CHUNK_COUNT = 32;
+    static constexpr std::size_t CHUNK_SIZE = 1000;
+
+    common::delete_folder(FILE_WRITER_TEST_FOLDER);
+    common::create_directories(FILE_WRITER_TEST_FOLDER);
+
+    // A small pending limit so that queuing has to wait on the workers
+    common::file_write_pool pool(4, CHUNK_SIZE * 3);
+
+    std::vector<std::size_t> handles;
+    std::vector<std::vector<std::uint8_t>> expected(FILE_COUNT);
+
+    for (std::size_t i = 0; i < FILE_COUNT; i++) {
+        handles.push_back(pool.begin_file(eka2l1::add_path(FILE_WRITER_TEST_FOLDER, std::to_string(i) + ".bin")));
+    }
+
+    // Interleave writes to all files, each chunk is different
+    for (std::size_t chunk = 0; chunk < CHUNK_COUNT; chunk++) {
+        for (std::size_t i = 0; i < FILE_COUNT; i++) {
+            std::vector<std::uint8_t> data(CHUNK_SIZE, static_cast<std::uint8_t>(chunk * 7 + i));
+            expected[i].insert(expected[i].end(), data.begin(), data.end());
+
+            pool.write(handles[i], std::move(data));
+        }
+    }
+
+    for (std::size_t i = 0; i < FILE_COUNT; i++) {
+        pool.end_file(handles[i]);
+    }
+
+    pool.wait_idle();
+
+    const common::file_write_stats stats = pool.stats();
+    REQUIRE(stats.files_written_ == FILE_COUNT);
+    REQUIRE(stats.bytes_written_ == FILE_COUNT * CHUNK_COUNT * CHUNK_SIZE);
+    REQUIRE(stats.bytes_queued_ == stats.bytes_written_);
+
+    for (std::size_t i = 0; i < FILE_COUNT; i++) {
+        REQUIRE(read_test_file(eka2l1::add_path(FILE_WRITER_TEST_FOLDER, std::to_string(i) + ".bin")) == expected[i]);
+    }
+
+    REQUIRE(pool.finish());
+    common::delete_folder(FILE_WRITER_TEST_FOLDER);
+}
+
+TEST_CASE("file_write_pool_reports_failure", "file_write_pool") {
+    common::file_write_pool pool(2);
+
+    const std::size_t handle = pool.begin_file(eka2l1::add_path(FILE_WRITER_TEST_FOLDER, "notexist/file.bin"));
+    pool.write(handle, "abcd", 4);
+    pool.end_file(handle);
+
+    REQUIRE(!pool.finish());
+
+    // Nothing reached the disk
+    const common::file_write_stats stats = pool.stats();
+    REQUIRE(stats.bytes_queued_ == 4);
+    REQUIRE(stats.bytes_written_ == 0);
+    REQUIRE(stats.files_written_ == 0);
+}
+
+TEST_CASE("file_write_pool_abort_wakes_producer", "file_write_pool") {
+    static constexpr std::size_t CHUNK_SIZE = 0x4000;
+    static constexpr std::size_t CHUNK_COUNT = 4096;
+
+    common::delete_folder(FILE_WRITER_TEST_FOLDER);
+    common::create_directories(FILE_WRITER_TEST_FOLDER);
+
+    // The producer is mostly waiting for room while the worker writes
+    common::file_write_pool pool(1, CHUNK_SIZE * 2);
+    std::atomic<bool> producer_started{ false };
+
+    std::thread producer([&pool, &producer_started]() {
+        const std::size_t handle = pool.begin_file(eka2l1::add_path(FILE_WRITER_TEST_FOLDER, "aborted.bin"));
+        producer_started = true;
+
+        for (std::size_t i = 0; i < CHUNK_COUNT; i++) {
+            pool.write(handle, std::vector<std::uint8_t>(CHUNK_SIZE, static_cast<std::uint8_t>(i)));
+        }
+
+        pool.end_file(handle);
+    });
+
+    while (!producer_started) {
+        std::this_thread::yield();
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    pool.abort();
+
+    // Must not be left waiting for room that the stopped workers will never make
+    producer.join();
+
+    const common::file_write_stats stats = pool.stats();
+    REQUIRE(stats.bytes_written_ <= stats.bytes_queued_);
+
+    common::delete_folder(FILE_WRITER_TEST_FOLDER);
+}
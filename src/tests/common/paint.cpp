@@ -20,7 +20,11 @@
 #include <catch2/catch.hpp>
 #include <common/buffer.h>
 #include <common/paint.h>
+#include <common/svg.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <fstream>
 #include <string>
 
@@ -56,3 +60,142 @@ TEST_CASE("simple_line", "painter") {
 
     plotter.save_to_bmp(reinterpret_cast<common::wo_stream *>(&std_fstream_paint));
 }
+
+static bool pixel_equals(eka2l1::vecx<int, 4> pixel, const eka2l1::vecx<int, 4> &expected) {
+    return pixel == expected;
+}
+
+// Plotter only implementing the per-pixel interface, drawing through the default span fallbacks
+class pixel_only_plotter : public common::pixel_plotter {
+    common::buffer_32bmp_pixel_plotter impl_;
+
+public:
+    void resize(const eka2l1::vec2 &size) override {
+        impl_.resize(size);
+    }
+
+    void plot_pixel(const eka2l1::vec2 &pos, const eka2l1::vecx<int, 4> &color) override {
+        impl_.plot_pixel(pos, color);
+    }
+
+    eka2l1::vecx<int, 4> get_pixel(const eka2l1::vec2 &pos) override {
+        return impl_.get_pixel(pos);
+    }
+
+    eka2l1::vec2 &get_size() override {
+        return impl_.get_size();
+    }
+};
+
+TEST_CASE("fill_rect_clipped", "painter") {
+    common::buffer_32bmp_pixel_plotter plotter;
+    common::painter artist(&plotter);
+
+    artist.new_art({ 16, 16 });
+    artist.set_fill_color({ 10, 20, 30, 255 });
+    artist.fill_rect(eka2l1::rect({ 12, -4 }, { 10, 10 }));
+
+    REQUIRE(pixel_equals(plotter.get_pixel({ 12, 0 }), { 10, 20, 30, 255 }));
+    REQUIRE(pixel_equals(plotter.get_pixel({ 15, 5 }), { 10, 20, 30, 255 }));
+    REQUIRE(pixel_equals(plotter.get_pixel({ 11, 0 }), { 255, 255, 255, 255 }));
+    REQUIRE(pixel_equals(plotter.get_pixel({ 12, 6 }), { 255, 255, 255, 255 }));
+}
+
+TEST_CASE("blend_span_matches_per_pixel_blend", "painter") {
+    common::buffer_24bmp_pixel_plotter fast_plotter;
+    pixel_only_plotter slow_plotter;
+
+    fast_plotter.resize({ 40, 1 });
+    slow_plotter.resize({ 40, 1 });
+
+    std::uint8_t coverages[40];
+
+    for (int i = 0; i < 40; i++) {
+        coverages[i] = static_cast<std::uint8_t>(i * 255 / 39);
+        fast_plotter.plot_pixel({ i, 0 }, { i * 5, 255 - i * 3, 128, 255 });
+        slow_plotter.plot_pixel({ i, 0 }, { i * 5, 255 - i * 3, 128, 255 });
+    }
+
+    // Start out of the bitmap, to check that the span is clipped
+    fast_plotter.blend_span(0, -2, coverages, 40, { 200, 10, 60, 255 });
+    slow_plotter.blend_span(0, -2, coverages, 40, { 200, 10, 60, 255 });
+
+    for (int i = 0; i < 40; i++) {
+        const auto fast = fast_plotter.get_pixel({ i, 0 });
+        const auto slow = slow_plotter.get_pixel({ i, 0 });
+
+        for (std::size_t c = 0; c < 3; c++) {
+            REQUIRE(std::abs(fast[c] - slow[c]) <= 1);
+        }
+    }
+}
+
+TEST_CASE("anti_aliased_circle", "painter") {
+    common::buffer_32bmp_pixel_plotter plotter;
+    common::painter artist(&plotter);
+
+    artist.new_art({ 64, 64 });
+    artist.set_fill_when_draw(true);
+    artist.set_fill_color({ 0, 0, 255, 255 });
+    artist.set_brush_color({ 255, 0, 0, 255 });
+    artist.set_brush_thickness(2);
+    artist.circle({ 32, 32 }, 20);
+
+    // Inside is filled, outside is untouched
+    REQUIRE(pixel_equals(plotter.get_pixel({ 32, 32 }), { 0, 0, 255, 255 }));
+    REQUIRE(pixel_equals(plotter.get_pixel({ 2, 2 }), { 255, 255, 255, 255 }));
+
+    // The outline is solid in the middle of the ring
+    REQUIRE(pixel_equals(plotter.get_pixel({ 32 + 20, 32 }), { 255, 0, 0, 255 }));
+
+    // The outer edge of a diagonal is partially covered
+    bool found_blended = false;
+
+    for (int i = 0; i < 32; i++) {
+        const auto pix = plotter.get_pixel({ 32 + i, 32 + i });
+
+        if ((pix[0] == 255) && (pix[1] > 0) && (pix[1] < 255)) {
+            found_blended = true;
+            break;
+        }
+    }
+
+    REQUIRE(found_blended);
+}
+
+template <typename T>
+static double render_svg_icon_ms(const std::string &svg_data, const int iterations) {
+    T plotter;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < iterations; i++) {
+        common::svg_render(&plotter, svg_data.c_str(), nullptr);
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+}
+
+TEST_CASE("svg_icon_render_benchmark", "[.benchmark]") {
+    for (const int size : { 44, 88, 176, 352 }) {
+        const std::string center = std::to_string(size / 2);
+
+        // Only circles are supported by the SVG renderer for now, so the icon is made of them
+        const std::string svg_data = "<svg width=\"" + std::to_string(size) + "\" height=\"" + std::to_string(size) + "\">"
+            + "<circle cx=\"" + center + "\" cy=\"" + center + "\" r=\"" + std::to_string(size * 2 / 5)
+            + "\" stroke=\"rgb(20,40,200)\" stroke-width=\"" + std::to_string(std::max(1, size / 32)) + "\" fill=\"rgb(240,200,0)\"/>"
+            + "<circle cx=\"" + center + "\" cy=\"" + center + "\" r=\"" + std::to_string(size / 6)
+            + "\" stroke=\"black\" stroke-width=\"1\" fill=\"white\"/>"
+            + "</svg>";
+
+        const int iterations = std::max(4, 2048 / size);
+
+        const double span_24_ms = render_svg_icon_ms<common::buffer_24bmp_pixel_plotter>(svg_data, iterations);
+        const double span_32_ms = render_svg_icon_ms<common::buffer_32bmp_pixel_plotter>(svg_data, iterations);
+        const double pixel_ms = render_svg_icon_ms<pixel_only_plotter>(svg_data, iterations);
+
+        WARN(size << "x" << size << " icon: 24bpp spans " << span_24_ms << " ms, 32bpp spans " << span_32_ms
+                  << " ms, per-pixel plotter " << pixel_ms << " ms");
+    }
+}
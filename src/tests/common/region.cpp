@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/region.h>
+
+#include <array>
+#include <random>
+
+using namespace eka2l1;
+
+static constexpr int REGION_TEST_GRID_SIZE = 48;
+using region_test_grid = std::array<bool, REGION_TEST_GRID_SIZE * REGION_TEST_GRID_SIZE>;
+
+static void fill_grid(region_test_grid &grid, const eka2l1::rect &rect, const bool value) {
+    for (int y = std::max(0, rect.top.y); y < std::min(REGION_TEST_GRID_SIZE, rect.top.y + rect.size.y); y++) {
+        for (int x = std::max(0, rect.top.x); x < std::min(REGION_TEST_GRID_SIZE, rect.top.x + rect.size.x); x++) {
+            grid[y * REGION_TEST_GRID_SIZE + x] = value;
+        }
+    }
+}
+
+static region_test_grid region_to_grid(const common::region &reg) {
+    region_test_grid grid{};
+
+    for (const eka2l1::rect &rect : reg.rects_) {
+        // Rectangles of a region never overlap
+        for (int y = rect.top.y; y < rect.top.y + rect.size.y; y++) {
+            for (int x = rect.top.x; x < rect.top.x + rect.size.x; x++) {
+                REQUIRE_FALSE(grid[y * REGION_TEST_GRID_SIZE + x]);
+                grid[y * REGION_TEST_GRID_SIZE + x] = true;
+            }
+        }
+    }
+
+    return grid;
+}
+
+static void check_banded(const common::region &reg) {
+    for (std::size_t i = 1; i < reg.rects_.size(); i++) {
+        const eka2l1::rect &prev = reg.rects_[i - 1];
+        const eka2l1::rect &cur = reg.rects_[i];
+
+        REQUIRE(cur.size.x > 0);
+        REQUIRE(cur.size.y > 0);
+
+        if (prev.top.y == cur.top.y) {
+            // Same band: same height, sorted and not touching
+            REQUIRE(prev.size.y == cur.size.y);
+            REQUIRE(prev.top.x + prev.size.x < cur.top.x);
+        } else {
+            REQUIRE(prev.top.y + prev.size.y <= cur.top.y);
+        }
+    }
+}
+
+static eka2l1::rect random_rect(std::mt19937 &rng) {
+    std::uniform_int_distribution<int> pos_dist(0, REGION_TEST_GRID_SIZE - 2);
+    std::uniform_int_distribution<int> size_dist(1, REGION_TEST_GRID_SIZE / 2);
+
+    const eka2l1::vec2 top{ pos_dist(rng), pos_dist(rng) };
+    const eka2l1::vec2 size{ std::min(size_dist(rng), REGION_TEST_GRID_SIZE - top.x), std::min(size_dist(rng), REGION_TEST_GRID_SIZE - top.y) };
+
+    return eka2l1::rect(top, size);
+}
+
+TEST_CASE("region_operations_match_pixels", "region") {
+    std::mt19937 rng(0x4E61);
+
+    for (int round = 0; round < 200; round++) {
+        common::region a;
+        common::region b;
+
+        region_test_grid grid_a{};
+        region_test_grid grid_b{};
+
+        for (int i = 0; i < 6; i++) {
+            const eka2l1::rect rect = random_rect(rng);
+
+            if (i % 3 == 2) {
+                a.eliminate(rect);
+                fill_grid(grid_a, rect, false);
+            } else {
+                a.add_rect(rect);
+                fill_grid(grid_a, rect, true);
+            }
+
+            const eka2l1::rect rect_b = random_rect(rng);
+            b.add_rect(rect_b);
+            fill_grid(grid_b, rect_b, true);
+        }
+
+        check_banded(a);
+        check_banded(b);
+        REQUIRE(region_to_grid(a) == grid_a);
+
+        region_test_grid expected{};
+
+        const common::region inter = a.intersect(b);
+        check_banded(inter);
+
+        for (std::size_t i = 0; i < expected.size(); i++) {
+            expected[i] = grid_a[i] && grid_b[i];
+        }
+
+        REQUIRE(region_to_grid(inter) == expected);
+
+        common::region merged = a;
+        merged.add_region(b);
+        check_banded(merged);
+
+        for (std::size_t i = 0; i < expected.size(); i++) {
+            expected[i] = grid_a[i] || grid_b[i];
+        }
+
+        REQUIRE(region_to_grid(merged) == expected);
+
+        common::region subtracted = a;
+        subtracted.eliminate(b);
+        check_banded(subtracted);
+
+        for (std::size_t i = 0; i < expected.size(); i++) {
+            expected[i] = grid_a[i] && !grid_b[i];
+        }
+
+        REQUIRE(region_to_grid(subtracted) == expected);
+    }
+}
+
+TEST_CASE("region_same_pixels_same_rects", "region") {
+    common::region by_rows;
+    common::region by_columns;
+
+    // A 20x20 square built from stripes in two directions
+    for (int i = 0; i < 20; i += 4) {
+        by_rows.add_rect(eka2l1::rect({ 10, 10 + i }, { 20, 4 }));
+        by_columns.add_rect(eka2l1::rect({ 10 + i, 10 }, { 4, 20 }));
+    }
+
+    REQUIRE(by_rows.rects_.size() == 1);
+    REQUIRE(by_rows.identical(by_columns));
+    REQUIRE(by_rows.bounding_rect() == eka2l1::rect({ 10, 10 }, { 20, 20 }));
+
+    // Adding something already covered changes nothing
+    REQUIRE_FALSE(by_rows.add_rect(eka2l1::rect({ 12, 12 }, { 5, 5 })));
+    REQUIRE(by_rows.add_rect(eka2l1::rect({ 25, 25 }, { 10, 10 })));
+}
+
+TEST_CASE("region_bounding_clip_and_advance", "region") {
+    common::region reg;
+
+    const eka2l1::rect rects[] = {
+        eka2l1::rect({ 5, 5 }, { 10, 10 }),
+        eka2l1::rect({ 30, 0 }, { 5, 40 }),
+        eka2l1::rect({ 8, 8 }, { 10, 2 })
+    };
+
+    reg.add_rects(rects, 3);
+    REQUIRE(reg.bounding_rect() == eka2l1::rect({ 5, 0 }, { 30, 40 }));
+
+    reg.eliminate(eka2l1::rect({ 30, 0 }, { 5, 40 }));
+    REQUIRE(reg.bounding_rect() == eka2l1::rect({ 5, 5 }, { 13, 10 }));
+
+    reg.advance(eka2l1::vec2(-5, -5));
+    REQUIRE(reg.bounding_rect() == eka2l1::rect({ 0, 0 }, { 13, 10 }));
+    REQUIRE(reg.contains(eka2l1::point(12, 4)));
+    REQUIRE_FALSE(reg.contains(eka2l1::point(12, 6)));
+
+    reg.clip(eka2l1::rect({ 2, 2 }, { 4, 4 }));
+    REQUIRE(reg.rects_.size() == 1);
+    REQUIRE(reg.rects_[0] == eka2l1::rect({ 2, 2 }, { 4, 4 }));
+
+    reg.eliminate(reg.bounding_rect());
+    REQUIRE(reg.empty());
+}
@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/cvt.h>
+#include <common/unicode.h>
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace eka2l1;
+
+static std::vector<std::uint8_t> scsu_compress(const std::u16string &text) {
+    std::vector<std::uint8_t> source(text.size() * 2);
+    for (std::size_t i = 0; i < text.size(); i++) {
+        source[i * 2] = static_cast<std::uint8_t>(text[i] & 0xFF);
+        source[i * 2 + 1] = static_cast<std::uint8_t>(text[i] >> 8);
+    }
+
+    // Worst case is a mode switch followed by quoted code units
+    std::vector<std::uint8_t> dest(text.size() * 3 + 16);
+
+    common::unicode_compressor compressor;
+    int source_size = static_cast<int>(source.size());
+
+    const int written = compressor.compress(source.data(), source_size, dest.data(), static_cast<int>(dest.size()));
+    dest.resize(written);
+
+    return dest;
+}
+
+static std::u16string scsu_expand(std::vector<std::uint8_t> compressed, const std::size_t unit_count) {
+    std::vector<std::uint8_t> dest(unit_count * 2);
+
+    common::unicode_expander expander;
+    int source_size = static_cast<int>(compressed.size());
+
+    const int written = expander.expand(compressed.data(), source_size, dest.data(), static_cast<int>(dest.size()));
+
+    std::u16string result(written / 2, u'\0');
+    for (std::size_t i = 0; i < result.size(); i++) {
+        result[i] = static_cast<char16_t>(dest[i * 2] | (dest[i * 2 + 1] << 8));
+    }
+
+    return result;
+}
+
+static std::u16string make_test_text(std::mt19937 &rng, const std::size_t length, const char16_t base, const char16_t range,
+    const int ascii_percent) {
+    std::uniform_int_distribution<int> percent_dist(0, 99);
+    std::uniform_int_distribution<int> ascii_dist(0x20, 0x7E);
+    std::uniform_int_distribution<int> range_dist(0, range - 1);
+
+    std::u16string text(length, u'\0');
+    for (char16_t &c : text) {
+        c = (percent_dist(rng) < ascii_percent) ? static_cast<char16_t>(ascii_dist(rng)) : static_cast<char16_t>(base + range_dist(rng));
+    }
+
+    return text;
+}
+
+TEST_CASE("unicode_byte_runs", "unicode") {
+    std::mt19937 rng(0x5C5);
+    std::uniform_int_distribution<int> byte_dist(0x20, 0x7F);
+
+    // Every stop position, so both the SIMD blocks and the tail are covered
+    for (std::size_t stop = 0; stop <= 40; stop++) {
+        std::vector<std::uint8_t> bytes(40);
+        for (std::uint8_t &b : bytes) {
+            b = static_cast<std::uint8_t>(byte_dist(rng));
+        }
+
+        if (stop < bytes.size()) {
+            bytes[stop] = 0x80;
+        }
+
+        std::vector<std::uint8_t> units(bytes.size() * 2 + 1, 0xCC);
+
+        // Odd offset, to store unaligned
+        REQUIRE(common::widen_byte_run(bytes.data(), bytes.size(), units.data() + 1, 0x20, 0x7F) == stop);
+
+        for (std::size_t i = 0; i < stop; i++) {
+            REQUIRE(units[1 + i * 2] == bytes[i]);
+            REQUIRE(units[1 + i * 2 + 1] == 0);
+        }
+
+        std::vector<std::uint8_t> narrowed(bytes.size(), 0);
+        REQUIRE(common::narrow_unit_run(units.data() + 1, stop, narrowed.data(), 0x20, 0x7F) == stop);
+        REQUIRE(std::equal(bytes.begin(), bytes.begin() + stop, narrowed.begin()));
+    }
+
+    // Bounds are inclusive, and a high byte of a code unit stops the narrowing
+    const std::uint8_t edge_bytes[] = { 0x00, 0x01, 0x7F, 0xFF };
+    std::uint8_t edge_units[sizeof(edge_bytes) * 2];
+
+    REQUIRE(common::widen_byte_run(edge_bytes, sizeof(edge_bytes), edge_units, 0x00, 0xFF) == sizeof(edge_bytes));
+    REQUIRE(common::widen_byte_run(edge_bytes, sizeof(edge_bytes), edge_units, 0x01, 0xFF) == 0);
+
+    std::vector<std::uint8_t> units(32, 0x41);
+    for (std::size_t i = 0; i < units.size(); i += 2) {
+        units[i + 1] = 0;
+    }
+
+    units[21] = 0x01;
+
+    std::uint8_t narrowed[16];
+    REQUIRE(common::narrow_unit_run(units.data(), 16, narrowed, 0x00, 0xFF) == 10);
+    REQUIRE(common::narrow_unit_run(units.data(), 16, narrowed, 0x41, 0x41) == 10);
+    REQUIRE(common::narrow_unit_run(units.data(), 16, narrowed, 0x42, 0x7F) == 0);
+}
+
+TEST_CASE("unicode_scsu_ascii_as_is", "unicode") {
+    const std::u16string text = u"The quick brown fox jumps over the lazy dog. 0123456789 !?";
+    const std::vector<std::uint8_t> compressed = scsu_compress(text);
+
+    REQUIRE(compressed.size() == text.size());
+
+    for (std::size_t i = 0; i < text.size(); i++) {
+        REQUIRE(compressed[i] == text[i]);
+    }
+
+    REQUIRE(scsu_expand(compressed, text.size()) == text);
+}
+
+TEST_CASE("unicode_scsu_latin1_default_window", "unicode") {
+    // Bytes 0x80 to 0xFF select the default window, which holds the Latin-1 supplement
+    std::vector<std::uint8_t> compressed;
+    std::u16string expected;
+
+    for (int i = 0x20; i <= 0xFF; i++) {
+        if (i == 0x7F) {
+            continue;
+        }
+
+        compressed.push_back(static_cast<std::uint8_t>(i));
+        expected.push_back(static_cast<char16_t>(i));
+    }
+
+    REQUIRE(scsu_expand(compressed, expected.size()) == expected);
+}
+
+TEST_CASE("unicode_scsu_round_trip", "unicode") {
+    std::mt19937 rng(0x5C5);
+
+    struct text_kind {
+        char16_t base_;
+        char16_t range_;
+        int ascii_percent_;
+    };
+
+    const text_kind kinds[] = {
+        { 0x0020, 0x5F, 100 },  // ASCII
+        { 0x00A0, 0x60, 70 },   // Latin-1 with ASCII
+        { 0x0410, 0x40, 20 },   // Cyrillic
+        { 0x4E00, 0x1000, 10 }, // CJK
+        { 0x3040, 0x60, 50 }    // Hiragana with ASCII
+    };
+
+    for (const text_kind &kind : kinds) {
+        for (std::size_t length : { 1, 3, 4, 7, 15, 16, 17, 33, 200, 1000 }) {
+            const std::u16string text = make_test_text(rng, length, kind.base_, kind.range_, kind.ascii_percent_);
+            REQUIRE(scsu_expand(scsu_compress(text), text.size()) == text);
+        }
+    }
+}
+
+TEST_CASE("unicode_scsu_small_destination", "unicode") {
+    const std::u16string text = u"A long enough run of plain ASCII text, with more than one SIMD block in it";
+    const std::vector<std::uint8_t> compressed = scsu_compress(text);
+
+    // Expansion stops when the destination is full, without writing past it
+    std::vector<std::uint8_t> dest(text.size() * 2, 0xCC);
+    std::vector<std::uint8_t> source = compressed;
+
+    common::unicode_expander expander;
+    int source_size = static_cast<int>(source.size());
+
+    REQUIRE(expander.expand(source.data(), source_size, dest.data(), 20) == 20);
+
+    for (std::size_t i = 0; i < 10; i++) {
+        REQUIRE(dest[i * 2] == text[i]);
+    }
+
+    REQUIRE(dest[20] == 0xCC);
+}
+
+TEST_CASE("unicode_utf8_round_trip", "unicode") {
+    const std::u16string texts[] = {
+        u"",
+        u"Plain ASCII text that is longer than one SIMD block",
+        u"Café naïve résumé",
+        u"Привет world",
+        u"日本語のテキスト",
+        u"Emoji \U0001F600 and \U00010348 in the middle"
+    };
+
+    const std::string expected_utf8[] = {
+        "",
+        "Plain ASCII text that is longer than one SIMD block",
+        "Caf\xC3\xA9 na\xC3\xAFve r\xC3\xA9sum\xC3\xA9",
+        "\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82 world",
+        "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E\xE3\x81\xAE\xE3\x83\x86\xE3\x82\xAD\xE3\x82\xB9\xE3\x83\x88",
+        "Emoji \xF0\x9F\x98\x80 and \xF0\x90\x8D\x88 in the middle"
+    };
+
+    for (std::size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); i++) {
+        REQUIRE(common::ucs2_to_utf8(texts[i]) == expected_utf8[i]);
+        REQUIRE(common::utf8_to_ucs2(expected_utf8[i]) == texts[i]);
+    }
+
+    // A trailing NUL is dropped
+    REQUIRE(common::utf8_to_ucs2(std::string("abc\0", 4)) == u"abc");
+}
+
+TEST_CASE("unicode_utf8_invalid_input", "unicode") {
+    // Bad sequences and lone surrogates are replaced instead of throwing
+    REQUIRE(common::utf8_to_ucs2("a\xFFz") == u"a\uFFFDz");
+    REQUIRE(common::utf8_to_ucs2("a\xC3") == u"a\uFFFD");
+    REQUIRE(common::utf8_to_ucs2("\xC0\xAF") == u"\uFFFD\uFFFD");
+    REQUIRE(common::utf8_to_ucs2("\xED\xA0\x80z") == u"\uFFFD\uFFFD\uFFFDz");
+
+    const std::u16string lone_surrogate = { u'a', static_cast<char16_t>(0xD800), u'b' };
+    REQUIRE(common::ucs2_to_utf8(lone_surrogate) == "a\xEF\xBF\xBD" "b");
+}
+
+TEST_CASE("unicode_conversion_benchmark", "[.benchmark]") {
+    std::mt19937 rng(0x5C5);
+
+    const std::u16string ascii_text = make_test_text(rng, 64 * 1024, 0x20, 0x5F, 100);
+    const std::u16string mixed_text = make_test_text(rng, 64 * 1024, 0x00A0, 0x60, 90);
+    const int rounds = 64;
+
+    auto measure_mb_per_s = [&](const std::u16string &text, auto func) {
+        const auto start = std::chrono::steady_clock::now();
+
+        for (int round = 0; round < rounds; round++) {
+            func(text);
+        }
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return (static_cast<double>(rounds) * text.size() * 2) / (seconds * 1024.0 * 1024.0);
+    };
+
+    for (const auto &[text, name] : { std::make_pair(&ascii_text, "ASCII"), std::make_pair(&mixed_text, "Latin-1") }) {
+        const std::vector<std::uint8_t> compressed = scsu_compress(*text);
+        const std::string utf8 = common::ucs2_to_utf8(*text);
+
+        const double compress_speed = measure_mb_per_s(*text, [](const std::u16string &t) { scsu_compress(t); });
+        const double expand_speed = measure_mb_per_s(*text, [&](const std::u16string &t) { scsu_expand(compressed, t.size()); });
+        const double to_utf8_speed = measure_mb_per_s(*text, [](const std::u16string &t) { common::ucs2_to_utf8(t); });
+        const double from_utf8_speed = measure_mb_per_s(*text, [&](const std::u16string &) { common::utf8_to_ucs2(utf8); });
+
+        WARN(name << ": SCSU compress " << compress_speed << " MB/s, expand " << expand_speed << " MB/s, UTF-8 encode "
+                  << to_utf8_speed << " MB/s, decode " << from_utf8_speed << " MB/s");
+    }
+}
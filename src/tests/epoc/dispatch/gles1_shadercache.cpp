@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <dispatch/libraries/gles1/def.h>
+#include <dispatch/libraries/gles1/shadercache.h>
+
+#include <cstdio>
+#include <cstring>
+
+using namespace eka2l1;
+
+TEST_CASE("gles1_vertex_key_ignores_unused_states", "gles1_shadercache") {
+    const std::uint64_t statuses = dispatch::egl_context_es1::VERTEX_STATE_CLIENT_VERTEX_ARRAY
+        | dispatch::egl_context_es1::VERTEX_STATE_CLIENT_TEXCOORD0_ARRAY;
+
+    const std::uint32_t one_texture = 0b01;
+    const std::uint64_t key = dispatch::gles1_vertex_shader_key(statuses, one_texture);
+
+    // Client weight array, and light states while lighting is off, do not change the shader
+    REQUIRE(dispatch::gles1_vertex_shader_key(statuses | dispatch::egl_context_es1::VERTEX_STATE_CLIENT_WEIGHT_ARRAY, one_texture) == key);
+    REQUIRE(dispatch::gles1_vertex_shader_key(statuses | dispatch::egl_context_es1::VERTEX_STATE_LIGHT0_ON, one_texture) == key);
+
+    // Texture coordinates of an inactive unit neither
+    REQUIRE(dispatch::gles1_vertex_shader_key(statuses | dispatch::egl_context_es1::VERTEX_STATE_CLIENT_TEXCOORD1_ARRAY, one_texture) == key);
+
+    REQUIRE(dispatch::gles1_vertex_shader_key(statuses, 0b0101) != key);
+    REQUIRE(dispatch::gles1_vertex_shader_key(statuses | dispatch::egl_context_es1::VERTEX_STATE_LIGHTING_ENABLE, one_texture) != key);
+}
+
+TEST_CASE("gles1_fragment_key_ignores_unused_states", "gles1_shadercache") {
+    const std::uint64_t alpha_func_bits = 0b0100;
+    REQUIRE(dispatch::gles1_cleanse_fragment_statuses(alpha_func_bits) == 0);
+    REQUIRE(dispatch::gles1_cleanse_fragment_statuses(alpha_func_bits | dispatch::egl_context_es1::FRAGMENT_STATE_ALPHA_TEST)
+        == (alpha_func_bits | dispatch::egl_context_es1::FRAGMENT_STATE_ALPHA_TEST));
+
+    dispatch::gles_texture_env_info env_infos[dispatch::GLES1_EMU_MAX_TEXTURE_COUNT];
+    std::memset(env_infos, 0, sizeof(env_infos));
+
+    env_infos[0].env_mode_ = dispatch::gles_texture_env_info::ENV_MODE_MODULATE;
+
+    const std::uint64_t key = dispatch::gles1_fragment_shader_key(0, 0b01, env_infos);
+
+    // The environment of an inactive unit is not part of the key
+    env_infos[1].env_mode_ = dispatch::gles_texture_env_info::ENV_MODE_DECAL;
+    REQUIRE(dispatch::gles1_fragment_shader_key(0, 0b01, env_infos) == key);
+
+    env_infos[0].env_mode_ = dispatch::gles_texture_env_info::ENV_MODE_REPLACE;
+    REQUIRE(dispatch::gles1_fragment_shader_key(0, 0b01, env_infos) != key);
+
+    // Bits outside of the fields, which a state filled field by field leaves uninitialized, are not hashed
+    dispatch::gles_texture_env_info garbage_env_infos[dispatch::GLES1_EMU_MAX_TEXTURE_COUNT];
+    std::memset(garbage_env_infos, 0xFF, sizeof(garbage_env_infos));
+
+    const dispatch::gles_texture_env_info &source = env_infos[0];
+    dispatch::gles_texture_env_info &dest = garbage_env_infos[0];
+
+    dest.env_mode_ = source.env_mode_;
+    dest.src0_rgb_ = source.src0_rgb_;
+    dest.src1_rgb_ = source.src1_rgb_;
+    dest.src2_rgb_ = source.src2_rgb_;
+    dest.src0_a_ = source.src0_a_;
+    dest.src1_a_ = source.src1_a_;
+    dest.src2_a_ = source.src2_a_;
+    dest.src0_rgb_op_ = source.src0_rgb_op_;
+    dest.src1_rgb_op_ = source.src1_rgb_op_;
+    dest.src2_rgb_op_ = source.src2_rgb_op_;
+    dest.src0_a_op_ = source.src0_a_op_;
+    dest.src1_a_op_ = source.src1_a_op_;
+    dest.src2_a_op_ = source.src2_a_op_;
+    dest.combine_rgb_func_ = source.combine_rgb_func_;
+    dest.combine_a_func_ = source.combine_a_func_;
+
+    REQUIRE(dispatch::gles1_fragment_shader_key(0, 0b01, garbage_env_infos) == dispatch::gles1_fragment_shader_key(0, 0b01, env_infos));
+}
+
+TEST_CASE("gles1_shader_disk_cache_round_trip", "gles1_shadercache") {
+    const std::string cache_path = "gles1_shader_cache_test.bin";
+    const std::uint32_t source_flavour = 3;
+
+    dispatch::gles1_cached_program program;
+    program.vertex_key_ = 0x1234;
+    program.fragment_key_ = 0xABCDEF0123456789ULL;
+    program.vertex_statuses_ = dispatch::egl_context_es1::VERTEX_STATE_CLIENT_VERTEX_ARRAY;
+    program.fragment_statuses_ = dispatch::egl_context_es1::FRAGMENT_STATE_FOG_ENABLE;
+    program.active_texs_ = 0b01;
+
+    {
+        dispatch::gles1_shader_disk_cache cache(cache_path, source_flavour);
+        cache.add_vertex_source(program.vertex_key_, "void main() { gl_Position = vec4(0.0); }");
+        cache.add_fragment_source(program.fragment_key_, "void main() { gl_FragColor = vec4(1.0); }");
+        cache.add_program(program);
+        cache.add_program(program);
+
+        REQUIRE(cache.programs().size() == 1);
+        REQUIRE(cache.save());
+    }
+
+    dispatch::gles1_shader_disk_cache cache(cache_path, source_flavour);
+    REQUIRE(cache.load());
+    REQUIRE(cache.programs().size() == 1);
+
+    const dispatch::gles1_cached_program &loaded = cache.programs()[0];
+    REQUIRE(loaded.vertex_key_ == program.vertex_key_);
+    REQUIRE(loaded.fragment_key_ == program.fragment_key_);
+    REQUIRE(loaded.vertex_statuses_ == program.vertex_statuses_);
+    REQUIRE(loaded.fragment_statuses_ == program.fragment_statuses_);
+    REQUIRE(loaded.active_texs_ == program.active_texs_);
+
+    const std::string *vertex_source = cache.find_vertex_source(program.vertex_key_);
+    REQUIRE(vertex_source);
+    REQUIRE(*vertex_source == "void main() { gl_Position = vec4(0.0); }");
+    REQUIRE(cache.find_fragment_source(program.fragment_key_));
+    REQUIRE_FALSE(cache.find_fragment_source(program.vertex_key_));
+
+    // Sources generated for another backend must not be used
+    dispatch::gles1_shader_disk_cache other_backend_cache(cache_path, source_flavour + 1);
+    REQUIRE_FALSE(other_backend_cache.load());
+    REQUIRE(other_backend_cache.programs().empty());
+
+    std::remove(cache_path.c_str());
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <dispatch/libraries/gles_shared/shadow.h>
+
+using namespace eka2l1;
+
+// Take out the recorded commands without running them, and count them
+static std::size_t take_command_count(drivers::graphics_command_builder &builder) {
+    drivers::command_list list = builder.retrieve_command_list();
+    const std::size_t count = list.size_;
+
+    delete[] list.base_;
+    return count;
+}
+
+static void record_draw_state(dispatch::gles_state_shadow &shadow, const drivers::blend_factor dest_factor) {
+    shadow.set_feature(drivers::graphics_feature::blend, true);
+    shadow.set_feature(drivers::graphics_feature::depth_test, false);
+    shadow.blend_formula(drivers::blend_equation::add, drivers::blend_equation::add, drivers::blend_factor::frag_out_alpha,
+        dest_factor, drivers::blend_factor::one, drivers::blend_factor::zero);
+    shadow.set_depth_mask(0xFFFFFFFF);
+    shadow.bind_texture(5, 0);
+}
+
+TEST_CASE("gles_shadow_elide_redundant_state", "gles_shadow") {
+    drivers::graphics_command_builder builder;
+    dispatch::gles_state_shadow shadow(builder);
+
+    // The first draw has to set everything
+    record_draw_state(shadow, drivers::blend_factor::one_minus_frag_out_alpha);
+    REQUIRE(take_command_count(builder) == 5);
+
+    // The same state again before every other draw
+    for (int i = 0; i < 10; i++) {
+        record_draw_state(shadow, drivers::blend_factor::one_minus_frag_out_alpha);
+    }
+
+    REQUIRE(take_command_count(builder) == 0);
+
+    // Only the blend formula changes
+    record_draw_state(shadow, drivers::blend_factor::one);
+    REQUIRE(take_command_count(builder) == 1);
+
+    REQUIRE(shadow.stats().emitted_ == 6);
+    REQUIRE(shadow.stats().elided_features_ == 22);
+    REQUIRE(shadow.stats().elided_states_ == 21);
+    REQUIRE(shadow.stats().elided_texture_binds_ == 11);
+
+    // A new command list does not know what the driver state is
+    shadow.invalidate();
+    record_draw_state(shadow, drivers::blend_factor::one);
+    REQUIRE(take_command_count(builder) == 5);
+
+    shadow.done_frame();
+
+    REQUIRE(shadow.last_frame_stats().total_elided() == 54);
+    REQUIRE(shadow.stats().emitted_ == 0);
+    REQUIRE(shadow.stats().total_elided() == 0);
+}
+
+TEST_CASE("gles_shadow_stencil_faces", "gles_shadow") {
+    drivers::graphics_command_builder builder;
+    dispatch::gles_state_shadow shadow(builder);
+
+    shadow.set_stencil_mask(drivers::rendering_face::back_and_front, 0xFF);
+    shadow.set_stencil_mask(drivers::rendering_face::front, 0xFF);
+    shadow.set_stencil_mask(drivers::rendering_face::back, 0xFF);
+
+    REQUIRE(take_command_count(builder) == 1);
+
+    // Back face changes alone, setting both faces must not be dropped afterwards
+    shadow.set_stencil_mask(drivers::rendering_face::back, 0x0F);
+    shadow.set_stencil_mask(drivers::rendering_face::back_and_front, 0xFF);
+    shadow.set_stencil_mask(drivers::rendering_face::back_and_front, 0xFF);
+
+    REQUIRE(take_command_count(builder) == 2);
+}
+
+TEST_CASE("gles_shadow_uniforms_per_program", "gles_shadow") {
+    drivers::graphics_command_builder builder;
+    dispatch::gles_state_shadow shadow(builder);
+
+    float matrix[16] = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+
+    shadow.use_program(1);
+    shadow.set_dynamic_uniform(0, drivers::shader_var_type::mat4, matrix, sizeof(matrix));
+    shadow.use_program(2);
+    shadow.set_dynamic_uniform(0, drivers::shader_var_type::mat4, matrix, sizeof(matrix));
+
+    REQUIRE(take_command_count(builder) == 4);
+
+    // Both programs still have the matrix
+    shadow.use_program(1);
+    shadow.set_dynamic_uniform(0, drivers::shader_var_type::mat4, matrix, sizeof(matrix));
+    shadow.use_program(1);
+    shadow.set_dynamic_uniform(0, drivers::shader_var_type::mat4, matrix, sizeof(matrix));
+
+    REQUIRE(take_command_count(builder) == 1);
+    REQUIRE(shadow.stats().elided_program_binds_ == 1);
+    REQUIRE(shadow.stats().elided_uniforms_ == 2);
+
+    matrix[12] = 5.0f;
+    shadow.set_dynamic_uniform(0, drivers::shader_var_type::mat4, matrix, sizeof(matrix));
+
+    REQUIRE(take_command_count(builder) == 1);
+
+    // Something else drew with its own program
+    shadow.invalidate_bindings();
+    shadow.use_program(1);
+    shadow.set_dynamic_uniform(0, drivers::shader_var_type::mat4, matrix, sizeof(matrix));
+
+    REQUIRE(take_command_count(builder) == 2);
+}
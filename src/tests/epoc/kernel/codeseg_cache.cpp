@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <kernel/codeseg.h>
+
+#include <vector>
+
+using namespace eka2l1;
+
+static kernel::codeseg_image_key make_image_key(const std::uint64_t image_hash) {
+    kernel::codeseg_image_key key;
+    key.image_hash_ = image_hash;
+    key.dependencies_hash_ = 0x1234;
+    key.code_run_addr_ = 0x70000000;
+    key.data_run_addr_ = 0x00400000;
+
+    return key;
+}
+
+TEST_CASE("codeseg_image_cache_hit_and_miss", "codeseg_cache") {
+    kernel::codeseg_image_cache cache;
+
+    const std::vector<std::uint8_t> code(64, 0xAA);
+    const std::vector<std::uint8_t> data(16, 0x55);
+
+    const kernel::codeseg_image_key key = make_image_key(0xDEADBEEF);
+    cache.add(key, code.data(), code.size(), data.data(), data.size());
+
+    REQUIRE(cache.count() == 1);
+    REQUIRE(cache.total_size() == code.size() + data.size());
+
+    const kernel::codeseg_image_cache::entry *hit = cache.find(key);
+    REQUIRE(hit);
+    REQUIRE(hit->code_ == code);
+    REQUIRE(hit->data_ == data);
+
+    // Patching an image changes its hash, the relocated bytes stored for the old one must not be used
+    REQUIRE_FALSE(cache.find(make_image_key(0xDEADBEF0)));
+
+    // Same image relocated somewhere else neither
+    kernel::codeseg_image_key moved_key = key;
+    moved_key.code_run_addr_ += 0x1000;
+    REQUIRE_FALSE(cache.find(moved_key));
+
+    // Adding the same image twice does not count it twice
+    cache.add(key, code.data(), code.size(), data.data(), data.size());
+    REQUIRE(cache.count() == 1);
+    REQUIRE(cache.total_size() == code.size() + data.size());
+}
+
+TEST_CASE("codeseg_image_cache_lru_eviction", "codeseg_cache") {
+    static constexpr std::size_t IMAGE_SIZE = 100;
+    kernel::codeseg_image_cache cache(IMAGE_SIZE * 2);
+
+    const std::vector<std::uint8_t> code(IMAGE_SIZE, 0xCC);
+
+    cache.add(make_image_key(1), code.data(), code.size(), nullptr, 0);
+    cache.add(make_image_key(2), code.data(), code.size(), nullptr, 0);
+
+    // Touch the first image so the second one becomes the least recently used
+    REQUIRE(cache.find(make_image_key(1)));
+
+    cache.add(make_image_key(3), code.data(), code.size(), nullptr, 0);
+
+    REQUIRE(cache.count() == 2);
+    REQUIRE(cache.total_size() == IMAGE_SIZE * 2);
+    REQUIRE(cache.find(make_image_key(1)));
+    REQUIRE_FALSE(cache.find(make_image_key(2)));
+    REQUIRE(cache.find(make_image_key(3)));
+
+    // An image bigger than the whole cache is never stored, and evicts nothing
+    const std::vector<std::uint8_t> huge_code(IMAGE_SIZE * 3, 0xDD);
+    cache.add(make_image_key(4), huge_code.data(), huge_code.size(), nullptr, 0);
+
+    REQUIRE(cache.count() == 2);
+    REQUIRE_FALSE(cache.find(make_image_key(4)));
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+#include <loader/rom.h>
+
+using namespace eka2l1;
+
+static loader::rom_entry make_rom_file(const std::u16string &name, const std::uint32_t size) {
+    loader::rom_entry entry;
+    entry.size = size;
+    entry.address_lin = 0;
+    entry.attrib = 0;
+    entry.name_len = static_cast<std::uint8_t>(name.length());
+    entry.name = name;
+
+    return entry;
+}
+
+/**
+ * Build a small burn tree by hand, and make sure lookups through the path index behave like
+ * the tree walk did: case-insensitive, drive independent, and files and directories kept apart.
+ */
+TEST_CASE("rom_path_index_lookup", "rom") {
+    loader::rom romf;
+
+    loader::rom_dir bin;
+    bin.name = u"Bin";
+    bin.entries.push_back(make_rom_file(u"EUser.dll", 100));
+    bin.entries.push_back(make_rom_file(u"efile.exe", 200));
+
+    loader::rom_dir sys;
+    sys.name = u"sys";
+    sys.subdirs.push_back(bin);
+
+    loader::root_dir root;
+    root.dir.entries.push_back(make_rom_file(u"readme.txt", 300));
+    root.dir.subdirs.push_back(sys);
+
+    romf.root.num_root_dirs = 1;
+    romf.root.root_dirs.push_back(root);
+    romf.build_path_index();
+
+    auto euser = romf.burn_tree_find_entry(u"Z:\\sys\\bin\\euser.dll");
+    REQUIRE(euser);
+    REQUIRE(euser->size == 100);
+
+    auto efile = romf.burn_tree_find_entry(std::string("z:/SYS/BIN//EFILE.EXE"));
+    REQUIRE(efile);
+    REQUIRE(efile->size == 200);
+
+    REQUIRE(romf.burn_tree_find_entry(u"z:\\readme.txt"));
+    REQUIRE(!romf.burn_tree_find_entry(u"z:\\sys\\bin\\ekern.exe"));
+    REQUIRE(!romf.burn_tree_find_entry(u"z:\\sys\\bin"));
+
+    loader::rom_dir *bin_dir = romf.burn_tree_find_dir(u"z:\\Sys\\Bin\\");
+    REQUIRE(bin_dir);
+    REQUIRE(bin_dir->entries.size() == 2);
+
+    REQUIRE(!romf.burn_tree_find_dir(u"z:\\sys\\bin\\euser.dll"));
+    REQUIRE(!romf.burn_tree_find_dir(u"z:\\"));
+
+    // The index must stay valid once the ROM is moved to its final owner
+    loader::rom moved = std::move(romf);
+    REQUIRE(moved.burn_tree_find_dir(u"z:\\sys") == &moved.root.root_dirs[0].dir.subdirs[0]);
+    REQUIRE(moved.burn_tree_find_entry(u"z:\\sys\\bin\\euser.dll"));
+}
@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <catch2/catch.hpp>
+
+#include <common/buffer.h>
+#include <common/fileutils.h>
+#include <common/path.h>
+#include <loader/sis_fields.h>
+#include <package/sis_extractor.h>
+
+#include <miniz.h>
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace eka2l1;
+
+static constexpr const char *SIS_EXTRACT_TEST_FOLDER = "sisextracttest";
+
+/**
+ * Build the data part of a SIS package in memory. Each added file is put in the same data unit,
+ * and its (optionally compressed) content is appended to the package stream.
+ */
+struct synthetic_sis_data {
+    loader::sis_data data_;
+    std::shared_ptr<loader::sis_data_unit> unit_;
+    std::vector<std::uint8_t> stream_buffer_;
+
+    explicit synthetic_sis_data() {
+        unit_ = std::make_shared<loader::sis_data_unit>();
+        data_.data_units.fields.push_back(unit_);
+    }
+
+    std::uint32_t add_file(const std::vector<std::uint8_t> &content, const bool compress) {
+        std::vector<std::uint8_t> stored = content;
+
+        if (compress) {
+            mz_ulong compressed_size = mz_compressBound(static_cast<mz_ulong>(content.size()));
+            stored.resize(compressed_size);
+
+            REQUIRE(mz_compress2(stored.data(), &compressed_size, content.data(), static_cast<mz_ulong>(content.size()), MZ_BEST_SPEED) == MZ_OK);
+            stored.resize(compressed_size);
+        }
+
+        auto file_data = std::make_shared<loader::sis_file_data>();
+        file_data->raw_data.algorithm = compress ? loader::sis_compressed_algorithm::deflated : loader::sis_compressed_algorithm::none;
+        file_data->raw_data.uncompressed_size = content.size();
+        file_data->raw_data.offset = stream_buffer_.size();
+
+        // Field length also counts the algorithm and the uncompressed size
+        const std::uint64_t field_len = stored.size() + 12;
+        file_data->raw_data.len_low = static_cast<std::uint32_t>(field_len);
+        file_data->raw_data.len_high = static_cast<std::uint32_t>(field_len >> 32);
+
+        stream_buffer_.insert(stream_buffer_.end(), stored.begin(), stored.end());
+        unit_->data_unit.fields.push_back(file_data);
+
+        return static_cast<std::uint32_t>(unit_->data_unit.fields.size() - 1);
+    }
+};
+
+static std::vector<std::uint8_t> make_test_content(const std::size_t size, const std::uint32_t seed) {
+    // Some repeating words, so that it compresses like real data does
+    static const char *WORDS[] = { "symbian ", "series60 ", "install ", "package ", "\n", "0123456789 " };
+
+    std::mt19937 rng(seed);
+    std::vector<std::uint8_t> content;
+    content.reserve(size);
+
+    while (content.size() < size) {
+        const char *word = WORDS[rng() % (sizeof(WORDS) / sizeof(WORDS[0]))];
+
+        for (; *word && (content.size() < size); word++) {
+            content.push_back(static_cast<std::uint8_t>(*word));
+        }
+    }
+
+    return content;
+}
+
+static std::vector<std::uint8_t> read_whole_file(const std::string &path) {
+    std::ifstream stream(path, std::ios::binary);
+    return std::vector<std::uint8_t>(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+TEST_CASE("sis_extract_parallel_matches_content", "sis_extractor") {
+    common::delete_folder(SIS_EXTRACT_TEST_FOLDER);
+
+    synthetic_sis_data sis;
+    std::vector<loader::sis_extractor::target> targets;
+    std::vector<std::vector<std::uint8_t>> expected;
+
+    // Compressed, stored, and one file that inflates far beyond a single output chunk
+    for (std::uint32_t i = 0; i < 12; i++) {
+        std::vector<std::uint8_t> content = make_test_content(0x8000 + i * 0x3123, i);
+        const bool compress = (i % 3) != 0;
+
+        loader::sis_extractor::target target;
+        target.file_path_ = eka2l1::add_path(SIS_EXTRACT_TEST_FOLDER, "sys/bin/file" + std::to_string(i) + ".bin");
+        target.data_index_ = sis.add_file(content, compress);
+        target.data_unit_index_ = 0;
+
+        targets.push_back(target);
+        expected.push_back(std::move(content));
+    }
+
+    std::vector<std::uint8_t> zeros(0x800000, 0);
+
+    loader::sis_extractor::target zero_target;
+    zero_target.file_path_ = eka2l1::add_path(SIS_EXTRACT_TEST_FOLDER, "private/zeros.dat");
+    zero_target.data_index_ = sis.add_file(zeros, true);
+    zero_target.data_unit_index_ = 0;
+
+    targets.push_back(zero_target);
+    expected.push_back(zeros);
+
+    // Big enough for its compressed data to be read in several chunks
+    std::vector<std::uint8_t> big_content = make_test_content(0x300000, 1234);
+
+    loader::sis_extractor::target big_target;
+    big_target.file_path_ = eka2l1::add_path(SIS_EXTRACT_TEST_FOLDER, "private/big.dat");
+    big_target.data_index_ = sis.add_file(big_content, true);
+    big_target.data_unit_index_ = 0;
+
+    targets.push_back(big_target);
+    expected.push_back(std::move(big_content));
+
+    // Targeting an already targeted file again, the later one should win
+    loader::sis_extractor::target overwrite_target = targets[1];
+    overwrite_target.data_index_ = sis.add_file(expected[4], true);
+
+    targets.push_back(overwrite_target);
+    expected[1] = expected[4];
+    expected.push_back(expected[4]);
+
+    common::ro_buf_stream stream(sis.stream_buffer_.data(), sis.stream_buffer_.size());
+    loader::sis_extractor extractor(reinterpret_cast<common::ro_stream *>(&stream), &sis.data_);
+
+    std::size_t last_progress = 0;
+    std::size_t last_total = 0;
+
+    REQUIRE(extractor.extract(targets, [&](const std::size_t progress, const std::size_t total) {
+        REQUIRE(progress >= last_progress);
+
+        last_progress = progress;
+        last_total = total;
+    }, nullptr, 4));
+
+    REQUIRE(last_total != 0);
+    REQUIRE(last_progress == last_total);
+
+    for (std::size_t i = 0; i < targets.size(); i++) {
+        REQUIRE(read_whole_file(targets[i].file_path_) == expected[i]);
+    }
+
+    common::delete_folder(SIS_EXTRACT_TEST_FOLDER);
+}
+
+TEST_CASE("sis_extract_cancel_removes_files", "sis_extractor") {
+    common::delete_folder(SIS_EXTRACT_TEST_FOLDER);
+
+    synthetic_sis_data sis;
+    std::vector<loader::sis_extractor::target> targets;
+
+    for (std::uint32_t i = 0; i < 4; i++) {
+        loader::sis_extractor::target target;
+        target.file_path_ = eka2l1::add_path(SIS_EXTRACT_TEST_FOLDER, "cancel" + std::to_string(i) + ".bin");
+        target.data_index_ = sis.add_file(make_test_content(0x40000, i), true);
+        target.data_unit_index_ = 0;
+
+        targets.push_back(target);
+    }
+
+    common::ro_buf_stream stream(sis.stream_buffer_.data(), sis.stream_buffer_.size());
+    loader::sis_extractor extractor(reinterpret_cast<common::ro_stream *>(&stream), &sis.data_);
+
+    REQUIRE(!extractor.extract(targets, nullptr, []() { return true; }, 1));
+
+    for (const auto &target : targets) {
+        REQUIRE(!common::exists(target.file_path_));
+    }
+
+    common::delete_folder(SIS_EXTRACT_TEST_FOLDER);
+}
+
+TEST_CASE("sis_extract_benchmark", "[.benchmark]") {
+    static constexpr std::uint32_t FILE_COUNT = 24;
+    static constexpr std::size_t FILE_SIZE = 0x200000;
+
+    common::delete_folder(SIS_EXTRACT_TEST_FOLDER);
+
+    synthetic_sis_data sis;
+    std::vector<loader::sis_extractor::target> targets;
+
+    for (std::uint32_t i = 0; i < FILE_COUNT; i++) {
+        loader::sis_extractor::target target;
+        target.file_path_ = eka2l1::add_path(SIS_EXTRACT_TEST_FOLDER, "bench" + std::to_string(i) + ".bin");
+        target.data_index_ = sis.add_file(make_test_content(FILE_SIZE, i), true);
+        target.data_unit_index_ = 0;
+
+        targets.push_back(target);
+    }
+
+    auto run_with_workers = [&](const std::size_t worker_count) {
+        common::ro_buf_stream stream(sis.stream_buffer_.data(), sis.stream_buffer_.size());
+        loader::sis_extractor extractor(reinterpret_cast<common::ro_stream *>(&stream), &sis.data_);
+
+        const auto start = std::chrono::steady_clock::now();
+        REQUIRE(extractor.extract(targets, nullptr, nullptr, worker_count));
+
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    const auto single_time = run_with_workers(1);
+    const auto parallel_time = run_with_workers(0);
+
+    WARN("Extracted " << FILE_COUNT << " files (" << (FILE_COUNT * FILE_SIZE) / (1024 * 1024) << " MB) in "
+                      << single_time << " ms on one worker, " << parallel_time << " ms on all cores");
+
+    common::delete_folder(SIS_EXTRACT_TEST_FOLDER);
+}
@@ -19,12 +19,16 @@
 
 #include <loader/rsc.h>
 #include <services/applist/applist.h>
+#include <services/applist/cache.h>
 #include <vfs/vfs.h>
 
 #include <common/algorithm.h>
 #include <common/buffer.h>
+#include <common/cvt.h>
+#include <common/fileutils.h>
 
 #include <catch2/catch.hpp>
+#include <cstdio>
 
 using namespace eka2l1;
 
@@ -85,3 +89,80 @@ TEST_CASE("mandatory_check_localise", "applist_registeration") {
     REQUIRE(reg.mandatory_info.short_caption.to_std_string(nullptr) == u"ITried");
     REQUIRE(reg.mandatory_info.long_caption.to_std_string(nullptr) == u"ITried");
 }
+
+TEST_CASE("registry_cache_round_trip", "applist_registeration") {
+    std::vector<std::uint8_t> dat;
+    REQUIRE(read_resource_from_file("applistassets//sample_reg.rsc", 1, dat));
+
+    common::ro_buf_stream app_info_resource_stream(&dat[0], dat.size());
+    apa_app_registry reg;
+
+    REQUIRE(read_registeration_info(reinterpret_cast<common::ro_stream *>(&app_info_resource_stream), reg, drive_c));
+
+    reg.rsc_path = u"C:\\Private\\10003a3f\\import\\apps\\sample_reg.rsc";
+    reg.mandatory_info.short_caption.assign(nullptr, u"ITried");
+    reg.caps.group_name.assign(nullptr, u"Games");
+    reg.land_drive = drive_c;
+    reg.localised_info_rsc_path = u"C:\\resource\\apps\\sample.rsc";
+    reg.icon_sizes = { eka2l1::vec2(44, 44), eka2l1::vec2(44, 44) };
+
+    // The localisable resource does not exist yet
+    const std::string drive_path = "applistassets//registry_cache_drive";
+    common::remove(drive_path + "//resource//apps//sample.rsc");
+    common::create_directories(drive_path + "//resource//apps");
+
+    io_system io;
+    auto physical_fs = create_physical_filesystem(epocver::epoc94, "");
+    io.add_filesystem(physical_fs);
+    io.mount_physical_path(drive_c, drive_media::physical, io_attrib_internal, common::utf8_to_ucs2(drive_path));
+
+    const std::string cache_path = "applistassets//registry_cache_test.bin";
+
+    {
+        apa_registry_cache cache(cache_path, language::en);
+        cache.add(reg, { apa_registry_source_stamp{ reg.rsc_path, 1234, 56 } }, u"");
+
+        REQUIRE(cache.save());
+    }
+
+    apa_registry_cache cache(cache_path, language::en);
+    REQUIRE(cache.load());
+    REQUIRE(cache.size() == 1);
+
+    // Lookup is case insensitive, as paths are on the device
+    std::u16string cached_localised_path = u"unset";
+    const apa_app_registry *cached_ptr = cache.find(&io, u"c:\\private\\10003a3f\\import\\apps\\SAMPLE_REG.RSC", 1234, 56,
+        &cached_localised_path);
+    REQUIRE(cached_ptr);
+
+    // No localisable resource was found for it, so the app is not listed
+    REQUIRE(cached_localised_path.empty());
+
+    apa_app_registry cached = *cached_ptr;
+
+    REQUIRE(cached.mandatory_info.app_path.to_std_string(nullptr) == reg.mandatory_info.app_path.to_std_string(nullptr));
+    REQUIRE(cached.mandatory_info.short_caption.to_std_string(nullptr) == u"ITried");
+    REQUIRE(cached.caps.group_name.to_std_string(nullptr) == u"Games");
+    REQUIRE(cached.land_drive == drive_c);
+    REQUIRE(cached.icon_sizes == reg.icon_sizes);
+
+    // Registration file changed, the cached one must not be used
+    REQUIRE_FALSE(cache.find(&io, reg.rsc_path, 1234, 57));
+    REQUIRE_FALSE(cache.find(&io, reg.rsc_path, 1235, 56));
+
+    // A localisable resource appeared, captions must be read from it
+    {
+        FILE *localised = std::fopen((drive_path + "//resource//apps//sample.rsc").c_str(), "wb");
+        REQUIRE(localised);
+        std::fclose(localised);
+    }
+
+    REQUIRE_FALSE(cache.find(&io, reg.rsc_path, 1234, 56));
+
+    // Captions are localised, so a cache built with another language is dropped
+    apa_registry_cache other_lang_cache(cache_path, language::fr);
+    REQUIRE_FALSE(other_lang_cache.load());
+
+    std::remove(cache_path.c_str());
+    common::remove(drive_path + "//resource//apps//sample.rsc");
+}
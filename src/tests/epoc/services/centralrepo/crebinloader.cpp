@@ -19,10 +19,13 @@
  */
 
 #include <catch2/catch.hpp>
+#include <services/centralrepo/centralrepo.h>
 #include <services/centralrepo/cre.h>
 
 #include <common/chunkyseri.h>
 
+#include <algorithm>
+#include <cstdio>
 #include <fstream>
 
 using namespace eka2l1;
@@ -52,4 +55,61 @@ TEST_CASE("generic_cre_loading", "centralrepo") {
     REQUIRE(repo.uid == 0x101F876F);
     REQUIRE(repo.entries.size() == 19);
     REQUIRE(repo.single_policies.size() == 19);
-}
\ No newline at end of file
+}
+
+TEST_CASE("cre_entries_sorted_lookup", "centralrepo") {
+    central_repo repo;
+
+    central_repo_entry_variant var;
+    var.etype = central_repo_entry_type::integer;
+
+    for (const std::uint32_t key : { 0x0203u, 0x0101u, 0x0305u, 0x0102u, 0x0201u }) {
+        var.intd = key;
+        REQUIRE(repo.add_new_entry(key, var));
+    }
+
+    REQUIRE_FALSE(repo.add_new_entry(0x0101, var));
+    REQUIRE(std::is_sorted(repo.entries.begin(), repo.entries.end(), [](const central_repo_entry &lhs, const central_repo_entry &rhs) {
+        return lhs.key < rhs.key;
+    }));
+
+    REQUIRE(repo.find_entry(0x0305));
+    REQUIRE(repo.find_entry(0x0305)->data.intd == 0x0305);
+    REQUIRE_FALSE(repo.find_entry(0x0202));
+
+    auto [begin, end] = repo.entries_in_mask_range(0x0200, 0xFFFFFF00);
+
+    REQUIRE(std::distance(begin, end) == 2);
+    REQUIRE(begin->key == 0x0201);
+    REQUIRE((begin + 1)->key == 0x0203);
+}
+
+TEST_CASE("cre_cache_round_trip", "centralrepo") {
+    const std::string source_path = "centralrepoassets/EFFF0000.ini";
+    const std::string cache_path = "centralrepoassets/EFFF0000.cache.bin";
+
+    central_repo repo;
+    repo.uid = 0xEFFF0000;
+
+    REQUIRE(parse_new_centrep_ini(source_path, repo));
+    REQUIRE(save_cre_cache(cache_path, source_path, repo));
+
+    central_repo cached_repo;
+
+    REQUIRE(load_cre_cache(cache_path, source_path, cached_repo));
+    REQUIRE(cached_repo.uid == repo.uid);
+    REQUIRE(cached_repo.entries.size() == repo.entries.size());
+
+    central_repo_entry *e = cached_repo.find_entry(13);
+
+    REQUIRE(e);
+    REQUIRE(e->data.etype == central_repo_entry_type::real);
+    REQUIRE(e->data.reald == 5.7);
+    REQUIRE(cached_repo.find_entry(78)->metadata_val == 12);
+
+    // Cache compiled from another source must not be picked up
+    central_repo other_repo;
+    REQUIRE_FALSE(load_cre_cache(cache_path, "centralrepoassets/EFFF0001.ini", other_repo));
+
+    std::remove(cache_path.c_str());
+}
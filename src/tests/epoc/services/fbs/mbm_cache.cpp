@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <services/fbs/mbm_cache.h>
+
+#include <common/buffer.h>
+
+#include <fstream>
+#include <vector>
+
+using namespace eka2l1;
+
+static std::vector<std::uint8_t> read_test_mbm() {
+    std::ifstream fi("loaderassets/face.mbm", std::ios::binary);
+    return std::vector<std::uint8_t>(std::istreambuf_iterator<char>(fi), std::istreambuf_iterator<char>());
+}
+
+TEST_CASE("mbm_cache_reuses_index", "mbm_cache") {
+    std::vector<std::uint8_t> data = read_test_mbm();
+    REQUIRE(!data.empty());
+
+    epoc::mbm_cache cache(4096);
+
+    epoc::mbm_file_identity identity;
+    identity.path_ = u"z:\\resource\\apps\\face.mbm";
+    identity.last_modified_ = 100;
+    identity.size_ = data.size();
+
+    common::ro_buf_stream stream(data.data(), data.size());
+    loader::mbm_file *index = cache.get_index(identity, reinterpret_cast<common::ro_stream *>(&stream), 0);
+
+    REQUIRE(index);
+    REQUIRE(index->is_header_loaded(0));
+    REQUIRE(index->sbm_headers[0].bitmap_size == 3545);
+    REQUIRE(cache.stats().index_misses_ == 1);
+
+    common::ro_buf_stream second_stream(data.data(), data.size());
+    REQUIRE(cache.get_index(identity, reinterpret_cast<common::ro_stream *>(&second_stream), 0) == index);
+    REQUIRE(cache.stats().index_hits_ == 1);
+
+    // Out of range bitmaps are not an error, the caller checks if the header is loaded
+    loader::mbm_file *same_index = cache.get_index(identity, reinterpret_cast<common::ro_stream *>(&second_stream), 5);
+    REQUIRE(same_index);
+    REQUIRE_FALSE(same_index->is_header_loaded(5));
+
+    // A modified file is read again
+    identity.last_modified_ = 200;
+    cache.get_index(identity, reinterpret_cast<common::ro_stream *>(&second_stream), 0);
+    REQUIRE(cache.stats().index_misses_ == 2);
+
+    // Data that is not an MBM is rejected
+    std::vector<std::uint8_t> garbage(16, 0xFF);
+    common::ro_buf_stream garbage_stream(garbage.data(), garbage.size());
+
+    identity.path_ = u"c:\\garbage.mbm";
+    REQUIRE_FALSE(cache.get_index(identity, reinterpret_cast<common::ro_stream *>(&garbage_stream), 0));
+}
+
+TEST_CASE("mbm_cache_decoded_bitmaps_lru", "mbm_cache") {
+    epoc::mbm_cache cache(100);
+
+    epoc::mbm_file_identity identity;
+    identity.path_ = u"z:\\resource\\apps\\avkon2.mbm";
+    identity.last_modified_ = 1;
+    identity.size_ = 1000;
+
+    const std::vector<std::uint8_t> payload(40, 0xAB);
+
+    REQUIRE_FALSE(cache.get_decoded_bitmap(identity, 0));
+
+    cache.add_decoded_bitmap(identity, 0, payload.data(), payload.size());
+    cache.add_decoded_bitmap(identity, 1, payload.data(), payload.size());
+
+    const std::vector<std::uint8_t> *decoded = cache.get_decoded_bitmap(identity, 0);
+    REQUIRE(decoded);
+    REQUIRE(*decoded == payload);
+
+    // Bitmap 1 is the least recently used, so it goes first
+    cache.add_decoded_bitmap(identity, 2, payload.data(), payload.size());
+
+    REQUIRE(cache.get_decoded_bitmap(identity, 0));
+    REQUIRE_FALSE(cache.get_decoded_bitmap(identity, 1));
+    REQUIRE(cache.get_decoded_bitmap(identity, 2));
+
+    REQUIRE(cache.stats().evictions_ == 1);
+    REQUIRE(cache.stats().entry_count_ == 2);
+    REQUIRE(cache.stats().memory_usage_ == 80);
+
+    // Data of a file that has changed since is dropped
+    identity.size_ = 2000;
+    REQUIRE_FALSE(cache.get_decoded_bitmap(identity, 0));
+    REQUIRE(cache.stats().entry_count_ == 1);
+
+    // Too big to ever fit
+    const std::vector<std::uint8_t> big_payload(200, 0);
+    cache.add_decoded_bitmap(identity, 3, big_payload.data(), big_payload.size());
+    REQUIRE_FALSE(cache.get_decoded_bitmap(identity, 3));
+}
@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <services/internet/protocols/task_queue.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <uv.h>
+}
+
+using namespace eka2l1;
+using namespace eka2l1::epoc::internet;
+
+// Runs a private loop on its own thread, the same way the INet protocol does with the default one
+struct test_looper {
+    uv_loop_t loop_;
+    std::unique_ptr<inet_task_queue> queue_;
+    std::thread thread_;
+
+    explicit test_looper() {
+        uv_loop_init(&loop_);
+        queue_ = std::make_unique<inet_task_queue>(&loop_);
+
+        thread_ = std::thread([this]() {
+            uv_run(&loop_, UV_RUN_DEFAULT);
+            uv_run(&loop_, UV_RUN_NOWAIT);
+        });
+    }
+
+    ~test_looper() {
+        inet_task_queue *queue = queue_.get();
+        uv_loop_t *loop = &loop_;
+
+        queue->post([queue, loop]() {
+            queue->close();
+            uv_stop(loop);
+        });
+
+        thread_.join();
+        uv_loop_close(&loop_);
+    }
+};
+
+TEST_CASE("task_queue_keeps_post_order", "inet_task_queue") {
+    static constexpr int PRODUCER_COUNT = 4;
+    static constexpr int TASK_PER_PRODUCER = 2000;
+
+    // Only touched on the loop thread
+    std::vector<std::vector<int>> results(PRODUCER_COUNT);
+    inet_task_queue_stats stats;
+
+    {
+        test_looper looper;
+        std::vector<std::thread> producers;
+
+        for (int i = 0; i < PRODUCER_COUNT; i++) {
+            producers.emplace_back([&looper, &results, i]() {
+                for (int j = 0; j < TASK_PER_PRODUCER; j++) {
+                    looper.queue_->post([&results, i, j]() {
+                        results[i].push_back(j);
+                    });
+                }
+            });
+        }
+
+        for (auto &producer : producers) {
+            producer.join();
+        }
+
+        std::promise<void> drained;
+        looper.queue_->post([&drained]() {
+            drained.set_value();
+        });
+
+        REQUIRE(drained.get_future().wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+        stats = looper.queue_->stats();
+    }
+
+    for (int i = 0; i < PRODUCER_COUNT; i++) {
+        REQUIRE(results[i].size() == TASK_PER_PRODUCER);
+
+        for (int j = 0; j < TASK_PER_PRODUCER; j++) {
+            REQUIRE(results[i][j] == j);
+        }
+    }
+
+    REQUIRE(stats.posted_ == PRODUCER_COUNT * TASK_PER_PRODUCER + 1);
+    REQUIRE(stats.executed_ == stats.posted_);
+    REQUIRE(stats.wakeups_ <= stats.posted_);
+}
+
+TEST_CASE("task_queue_batches_tasks_in_one_wakeup", "inet_task_queue") {
+    static constexpr int TASK_COUNT = 100;
+
+    test_looper looper;
+
+    std::promise<void> release;
+    std::shared_future<void> release_future = release.get_future().share();
+
+    // Keep the loop busy, so that everything posted after is picked up in one go
+    looper.queue_->post([release_future]() {
+        release_future.wait();
+    });
+
+    int executed = 0;
+
+    for (int i = 0; i < TASK_COUNT; i++) {
+        looper.queue_->post([&executed]() {
+            executed++;
+        });
+    }
+
+    std::promise<void> drained;
+    looper.queue_->post([&drained]() {
+        drained.set_value();
+    });
+
+    release.set_value();
+    REQUIRE(drained.get_future().wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+
+    REQUIRE(executed == TASK_COUNT);
+    REQUIRE(looper.queue_->stats().wakeups_ <= 2);
+}
+
+TEST_CASE("task_queue_close_while_posting", "inet_task_queue") {
+    static constexpr int PRODUCER_COUNT = 4;
+
+    std::atomic<int> accepted{ 0 };
+    std::atomic<int> executed{ 0 };
+
+    {
+        test_looper looper;
+        std::vector<std::thread> producers;
+
+        // Keep posting until the queue refuses, so some posts race with the close
+        for (int i = 0; i < PRODUCER_COUNT; i++) {
+            producers.emplace_back([&looper, &accepted, &executed]() {
+                while (looper.queue_->post([&executed]() { executed++; })) {
+                    accepted++;
+                }
+            });
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        inet_task_queue *queue = looper.queue_.get();
+        looper.queue_->post([queue]() {
+            queue->close();
+        });
+
+        for (auto &producer : producers) {
+            producer.join();
+        }
+    }
+
+    // Every accepted task still runs, the rest were refused instead of sent to a closed handle
+    REQUIRE(accepted > 0);
+    REQUIRE(executed == accepted);
+}
+
+TEST_CASE("task_queue_udp_loopback", "inet_task_queue") {
+    static constexpr int PACKET_COUNT = 64;
+
+    struct udp_state {
+        uv_udp_t receiver_;
+        uv_udp_t sender_;
+        sockaddr_in receiver_addr_;
+
+        int received_ = 0;
+        int send_failed_ = 0;
+        std::promise<void> all_received_;
+    } state;
+
+    test_looper looper;
+    uv_loop_t *loop = &looper.loop_;
+
+    std::promise<int> bound;
+
+    looper.queue_->post([&state, &bound, loop]() {
+        uv_udp_init(loop, &state.receiver_);
+        uv_udp_init(loop, &state.sender_);
+
+        state.receiver_.data = &state;
+
+        sockaddr_in addr;
+        uv_ip4_addr("127.0.0.1", 0, &addr);
+
+        int err = uv_udp_bind(&state.receiver_, reinterpret_cast<const sockaddr *>(&addr), 0);
+        if (err == 0) {
+            int name_len = sizeof(sockaddr_in);
+            err = uv_udp_getsockname(&state.receiver_, reinterpret_cast<sockaddr *>(&state.receiver_addr_), &name_len);
+        }
+
+        if (err == 0) {
+            err = uv_udp_recv_start(&state.receiver_, [](uv_handle_t *handle, std::size_t suggested_size, uv_buf_t *buf) {
+                static char recv_buffer[2048];
+                buf->base = recv_buffer;
+                buf->len = sizeof(recv_buffer);
+            }, [](uv_udp_t *handle, ssize_t nread, const uv_buf_t *buf, const sockaddr *addr, unsigned flags) {
+                udp_state *state = reinterpret_cast<udp_state *>(handle->data);
+                if ((nread == 4) && (++state->received_ == PACKET_COUNT)) {
+                    state->all_received_.set_value();
+                }
+            });
+        }
+
+        bound.set_value(err);
+    });
+
+    REQUIRE(bound.get_future().get() == 0);
+
+    // One post per packet, like a guest doing small datagram sends
+    static const char payload[4] = { 'E', 'K', 'A', '2' };
+
+    for (int i = 0; i < PACKET_COUNT; i++) {
+        looper.queue_->post([&state]() {
+            uv_udp_send_t *req = new uv_udp_send_t;
+            uv_buf_t buf = uv_buf_init(const_cast<char *>(payload), sizeof(payload));
+
+            if (uv_udp_send(req, &state.sender_, &buf, 1, reinterpret_cast<const sockaddr *>(&state.receiver_addr_),
+                [](uv_udp_send_t *req, int status) { delete req; }) < 0) {
+                state.send_failed_++;
+                delete req;
+            }
+        });
+    }
+
+    const bool all_arrived = (state.all_received_.get_future().wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+
+    std::promise<void> closed;
+    looper.queue_->post([&state, &closed]() {
+        uv_close(reinterpret_cast<uv_handle_t *>(&state.receiver_), nullptr);
+        uv_close(reinterpret_cast<uv_handle_t *>(&state.sender_), nullptr);
+        closed.set_value();
+    });
+
+    closed.get_future().wait();
+
+    REQUIRE(state.send_failed_ == 0);
+    REQUIRE(all_arrived);
+    REQUIRE(state.received_ == PACKET_COUNT);
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/fileutils.h>
+#include <services/msv/entry.h>
+#include <vfs/vfs.h>
+
+#include <memory>
+#include <vector>
+
+using namespace eka2l1;
+
+static constexpr const char16_t *MSV_TEST_FOLDER = u"C:\\private\\1000484b\\Mail2\\";
+
+struct msv_test_io {
+    io_system io_;
+
+    explicit msv_test_io() {
+        common::delete_folder("msvtestdrive");
+        common::create_directories("msvtestdrive");
+
+        auto physical_fs = create_physical_filesystem(epocver::epoc94, "");
+
+        io_.add_filesystem(physical_fs);
+        io_.mount_physical_path(drive_c, drive_media::physical, io_attrib_internal, u"msvtestdrive");
+        io_.create_directories(MSV_TEST_FOLDER);
+    }
+
+    ~msv_test_io() {
+        io_.unmount(drive_c);
+        common::delete_folder("msvtestdrive");
+    }
+};
+
+static epoc::msv::entry make_folder_entry(const std::uint32_t parent) {
+    epoc::msv::entry ent;
+    ent.parent_id_ = parent;
+    ent.type_uid_ = epoc::msv::MSV_FOLDER_UID;
+    ent.mtm_uid_ = epoc::msv::MSV_MSG_TYPE_UID;
+    ent.service_id_ = epoc::msv::MSV_LOCAL_SERVICE_ID_VALUE;
+    ent.description_ = u"Folder";
+
+    return ent;
+}
+
+static epoc::msv::entry make_message_entry(const std::uint32_t parent, const int index) {
+    epoc::msv::entry ent;
+    ent.parent_id_ = parent;
+    ent.type_uid_ = epoc::msv::MSV_NORMAL_UID;
+    ent.mtm_uid_ = epoc::msv::MSV_MSG_TYPE_UID;
+    ent.service_id_ = epoc::msv::MSV_LOCAL_SERVICE_ID_VALUE;
+    ent.size_ = index;
+    ent.description_ = u"Message";
+
+    return ent;
+}
+
+TEST_CASE("msv_sql_indexer_batch_move_and_reload", "msv") {
+    static constexpr int MESSAGE_COUNT = 200;
+
+    msv_test_io test_io;
+
+    std::uint32_t source_id = 0;
+    std::uint32_t target_id = 0;
+    std::vector<std::uint32_t> message_ids;
+
+    {
+        epoc::msv::sql_entry_indexer indexer(&test_io.io_, MSV_TEST_FOLDER, language::en);
+
+        epoc::msv::entry source = make_folder_entry(epoc::msv::MSV_ROOT_ID_VALUE);
+        epoc::msv::entry target = make_folder_entry(epoc::msv::MSV_ROOT_ID_VALUE);
+
+        REQUIRE(indexer.add_entry(source));
+        REQUIRE(indexer.add_entry(target));
+
+        source_id = source.id_;
+        target_id = target.id_;
+
+        {
+            epoc::msv::entry_indexer_batch_scope batch(&indexer);
+
+            for (int i = 0; i < MESSAGE_COUNT; i++) {
+                epoc::msv::entry message = make_message_entry(source_id, i);
+                REQUIRE(indexer.add_entry(message));
+
+                message_ids.push_back(message.id_);
+            }
+        }
+
+        {
+            epoc::msv::entry_indexer_batch_scope batch(&indexer);
+
+            for (int i = 0; i < MESSAGE_COUNT; i += 2) {
+                REQUIRE(indexer.move_entry(message_ids[i], target_id));
+            }
+        }
+
+        // Lookups must follow the entries to their new folder
+        for (int i = 0; i < MESSAGE_COUNT; i++) {
+            epoc::msv::entry *ent = indexer.get_entry(message_ids[i]);
+
+            REQUIRE(ent);
+            REQUIRE(ent->size_ == i);
+            REQUIRE(ent->parent_id_ == (((i % 2) == 0) ? target_id : source_id));
+        }
+    }
+
+    // Everything done in the batches must have been committed
+    epoc::msv::sql_entry_indexer reloaded(&test_io.io_, MSV_TEST_FOLDER, language::en);
+
+    REQUIRE(reloaded.get_entries_by_parent(target_id).size() == MESSAGE_COUNT / 2);
+    REQUIRE(reloaded.get_entries_by_parent(source_id).size() == MESSAGE_COUNT / 2);
+
+    for (int i = 0; i < MESSAGE_COUNT; i++) {
+        epoc::msv::entry *ent = reloaded.get_entry(message_ids[i]);
+
+        REQUIRE(ent);
+        REQUIRE(ent->size_ == i);
+        REQUIRE(ent->parent_id_ == (((i % 2) == 0) ? target_id : source_id));
+    }
+}
+
+TEST_CASE("msv_sql_indexer_children_cache", "msv") {
+    msv_test_io test_io;
+    epoc::msv::sql_entry_indexer indexer(&test_io.io_, MSV_TEST_FOLDER, language::en);
+
+    epoc::msv::entry source = make_folder_entry(epoc::msv::MSV_ROOT_ID_VALUE);
+    epoc::msv::entry target = make_folder_entry(epoc::msv::MSV_ROOT_ID_VALUE);
+
+    REQUIRE(indexer.add_entry(source));
+    REQUIRE(indexer.add_entry(target));
+
+    std::vector<std::uint32_t> message_ids;
+
+    for (int i = 0; i < 4; i++) {
+        epoc::msv::entry message = make_message_entry(source.id_, i);
+        REQUIRE(indexer.add_entry(message));
+
+        message_ids.push_back(message.id_);
+    }
+
+    REQUIRE(indexer.get_entries_by_parent(source.id_).size() == 4);
+    REQUIRE(indexer.get_entries_by_parent(target.id_).empty());
+
+    // Served from the cache, and must still be right after every kind of change
+    REQUIRE(indexer.get_entries_by_parent(source.id_).size() == 4);
+
+    epoc::msv::entry added = make_message_entry(source.id_, 4);
+    REQUIRE(indexer.add_entry(added));
+    REQUIRE(indexer.get_entries_by_parent(source.id_).size() == 5);
+
+    REQUIRE(indexer.move_entry(message_ids[0], target.id_));
+    REQUIRE(indexer.get_entries_by_parent(source.id_).size() == 4);
+
+    std::vector<epoc::msv::entry *> target_children = indexer.get_entries_by_parent(target.id_);
+    REQUIRE(target_children.size() == 1);
+    REQUIRE(target_children[0]->id_ == message_ids[0]);
+
+    epoc::msv::entry changed = *indexer.get_entry(message_ids[1]);
+    changed.parent_id_ = target.id_;
+    REQUIRE(indexer.change_entry(changed));
+
+    REQUIRE(indexer.get_entries_by_parent(source.id_).size() == 3);
+    REQUIRE(indexer.get_entries_by_parent(target.id_).size() == 2);
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <services/ui/skin/skn.h>
+
+#include <common/fileutils.h>
+
+#include <fstream>
+
+using namespace eka2l1;
+
+static const char *SKN_CACHE_TEST_PATH = "skncachetest/test.bin";
+
+static void make_test_definitions(epoc::skn_file &skn) {
+    skn.skin_name_.lang = 1;
+    skn.skin_name_.name = u"Test skin";
+    skn.filenames_.emplace(3, u"skin.mbm");
+
+    epoc::skn_bitmap_info bmp{};
+    bmp.id_hash = 0x1000500000010ULL;
+    bmp.type = epoc::skn_def_type::bitmap;
+    bmp.filename_id = 3;
+    bmp.bmp_idx = 4;
+    bmp.mask_bitmap_idx = 5;
+    bmp.attrib.image_size_x = 176;
+    skn.bitmaps_.emplace(bmp.id_hash, bmp);
+
+    epoc::skn_color_table colors{};
+    colors.id_hash = 0x1000500000020ULL;
+    colors.type = epoc::skn_def_type::color_tbl;
+    colors.colors.push_back({ 2, 0xFF00FF00 });
+    colors.colors.push_back({ -1, 0x12345678 });
+    skn.color_tabs_.emplace(colors.id_hash, colors);
+
+    epoc::skn_effect_queue queue{};
+    queue.id_hash = 0x1000500000030ULL;
+    queue.output_layer_mode = 2;
+
+    epoc::skn_effect effect{};
+    effect.uid = 0x10204ADB;
+    effect.parameters.push_back({ 1, std::string("\x01\x02\x00\x03", 4) });
+    queue.effects.push_back(effect);
+
+    skn.effect_queues_.push_back(queue);
+}
+
+TEST_CASE("skn_cache_round_trip", "skn_cache") {
+    epoc::skn_file source(epoc::plat_ver{ 2, 8 }, language::any);
+    make_test_definitions(source);
+
+    const epoc::skn_cache_key key{ 0xABCDEF, 4096, 1234567 };
+    REQUIRE(epoc::save_skn_cache(SKN_CACHE_TEST_PATH, key, source));
+
+    epoc::skn_file loaded(epoc::plat_ver{ 2, 8 }, language::any);
+    REQUIRE(epoc::load_skn_cache(SKN_CACHE_TEST_PATH, key, loaded));
+
+    REQUIRE(loaded.skin_name_.name == u"Test skin");
+    REQUIRE(loaded.filenames_.at(3) == u"skin.mbm");
+
+    const epoc::skn_bitmap_info &bmp = loaded.bitmaps_.at(0x1000500000010ULL);
+    REQUIRE(bmp.filename_id == 3);
+    REQUIRE(bmp.bmp_idx == 4);
+    REQUIRE(bmp.mask_bitmap_idx == 5);
+    REQUIRE(bmp.attrib.image_size_x == 176);
+
+    const epoc::skn_color_table &colors = loaded.color_tabs_.at(0x1000500000020ULL);
+    REQUIRE(colors.colors.size() == 2);
+    REQUIRE(colors.colors[1].first == -1);
+    REQUIRE(colors.colors[1].second == 0x12345678);
+
+    REQUIRE(loaded.effect_queues_.size() == 1);
+    REQUIRE(loaded.effect_queues_[0].output_layer_mode == 2);
+    REQUIRE(loaded.effect_queues_[0].effects[0].uid == 0x10204ADB);
+    REQUIRE(loaded.effect_queues_[0].effects[0].parameters[0].data == std::string("\x01\x02\x00\x03", 4));
+
+    common::remove(SKN_CACHE_TEST_PATH);
+}
+
+TEST_CASE("skn_cache_rejects_stale_or_damaged", "skn_cache") {
+    epoc::skn_file source(epoc::plat_ver{ 2, 8 }, language::any);
+    make_test_definitions(source);
+
+    const epoc::skn_cache_key key{ 0xABCDEF, 4096, 1234567 };
+    REQUIRE(epoc::save_skn_cache(SKN_CACHE_TEST_PATH, key, source));
+
+    // The skin file was modified since
+    const epoc::skn_cache_key newer_key{ 0xABCDEF, 4096, 1234568 };
+    epoc::skn_file stale(epoc::plat_ver{ 2, 8 }, language::any);
+    REQUIRE(!epoc::load_skn_cache(SKN_CACHE_TEST_PATH, newer_key, stale));
+
+    // Restriction chunks were resolved for another platform
+    epoc::skn_file other_platform(epoc::plat_ver{ 3, 0 }, language::any);
+    REQUIRE(!epoc::load_skn_cache(SKN_CACHE_TEST_PATH, key, other_platform));
+
+    {
+        std::fstream fo(SKN_CACHE_TEST_PATH, std::ios::binary | std::ios::in | std::ios::out);
+        fo.seekp(-1, std::ios::end);
+        fo.put('\x7F');
+    }
+
+    epoc::skn_file damaged(epoc::plat_ver{ 2, 8 }, language::any);
+    REQUIRE(!epoc::load_skn_cache(SKN_CACHE_TEST_PATH, key, damaged));
+    REQUIRE(damaged.bitmaps_.empty());
+
+    common::remove(SKN_CACHE_TEST_PATH);
+}
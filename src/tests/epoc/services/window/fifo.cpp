@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <services/window/fifo.h>
+
+#include <chrono>
+#include <cstring>
+
+using namespace eka2l1;
+
+static epoc::redraw_event make_redraw(const std::uint32_t handle, const int left) {
+    epoc::redraw_event evt;
+    evt.handle = handle;
+    evt.top_left = eka2l1::vec2(left, 0);
+    evt.bottom_right = eka2l1::vec2(left + 10, 10);
+
+    return evt;
+}
+
+static epoc::event make_pointer_event(const std::uint32_t handle, const epoc::event_type type, const std::uint8_t ptr_num) {
+    epoc::event evt(handle, epoc::event_code::touch);
+    std::memset(&evt.adv_pointer_evt_, 0, sizeof(epoc::adv_pointer_event));
+
+    evt.adv_pointer_evt_.evtype = type;
+    evt.adv_pointer_evt_.ptr_num = ptr_num;
+
+    return evt;
+}
+
+TEST_CASE("redraw_fifo_priority_lanes", "window_fifo") {
+    epoc::redraw_fifo fifo;
+    int owner = 0;
+
+    fifo.queue_event(&owner, make_redraw(1, 0), 3);
+    fifo.queue_event(&owner, make_redraw(2, 20), 1);
+    fifo.queue_event(&owner, make_redraw(3, 40), 3);
+    fifo.queue_event(&owner, make_redraw(4, 60), 0);
+
+    // Lowest priority value first, same priority in queue order
+    const std::uint32_t expected_handles[] = { 4, 2, 1, 3 };
+
+    for (const std::uint32_t handle : expected_handles) {
+        auto evt = fifo.get_evt_opt();
+        REQUIRE(evt);
+        REQUIRE(evt->evt_.handle == handle);
+    }
+
+    REQUIRE_FALSE(fifo.get_evt_opt());
+}
+
+TEST_CASE("redraw_fifo_cancel_by_id", "window_fifo") {
+    epoc::redraw_fifo fifo;
+    int owner = 0;
+    int other_owner = 0;
+
+    std::vector<std::uint32_t> ids;
+
+    // More than the initial capacity, so that the lane has to grow
+    for (std::uint32_t i = 0; i < 100; i++) {
+        ids.push_back(fifo.queue_event((i % 10 == 0) ? &other_owner : &owner, make_redraw(i, static_cast<int>(i) * 20), 2));
+    }
+
+    fifo.cancel_event_queue(ids[51]);
+    fifo.cancel_event_queue(ids[51]);
+    fifo.cancel_event_queue(ids[99]);
+    fifo.cancel_event_queue(0xFFFFFFFF);
+
+    fifo.remove_events(&other_owner);
+    REQUIRE(fifo.size() == 88);
+
+    for (std::uint32_t i = 0; i < 99; i++) {
+        if ((i == 51) || (i % 10 == 0)) {
+            continue;
+        }
+
+        auto evt = fifo.get_evt_opt();
+        REQUIRE(evt);
+        REQUIRE(evt->evt_.handle == i);
+    }
+
+    REQUIRE_FALSE(fifo.get_evt_opt());
+
+    // An ID of an event taken out does not remove anything queued afterwards
+    const std::uint32_t new_id = fifo.queue_event(&owner, make_redraw(500, 0), 2);
+    fifo.cancel_event_queue(ids[0]);
+    REQUIRE(fifo.size() == 1);
+
+    fifo.cancel_event_queue(new_id);
+    REQUIRE(fifo.size() == 0);
+}
+
+TEST_CASE("redraw_fifo_drops_covered_redraws", "window_fifo") {
+    epoc::redraw_fifo fifo;
+    int owner = 0;
+
+    fifo.queue_event(&owner, make_redraw(1, 5), 0);
+
+    epoc::redraw_event bigger;
+    bigger.handle = 1;
+    bigger.top_left = eka2l1::vec2(0, 0);
+    bigger.bottom_right = eka2l1::vec2(50, 50);
+
+    fifo.queue_event(&owner, bigger, 1);
+    REQUIRE(fifo.size() == 1);
+
+    auto evt = fifo.get_evt_opt();
+    REQUIRE(evt);
+    REQUIRE(evt->evt_.bottom_right == eka2l1::vec2(50, 50));
+}
+
+TEST_CASE("event_fifo_coalesce_and_priority", "window_fifo") {
+    epoc::event_fifo fifo;
+
+    fifo.queue_event(make_pointer_event(1, epoc::event_type::button1down, 0));
+
+    epoc::event drag = make_pointer_event(1, epoc::event_type::drag, 0);
+    for (int i = 0; i < 10; i++) {
+        drag.adv_pointer_evt_.pos = eka2l1::vec2(i, i);
+        fifo.queue_event(drag);
+    }
+
+    // Drag of another finger is kept apart
+    fifo.queue_event(make_pointer_event(1, epoc::event_type::drag, 1));
+    fifo.queue_event(epoc::event(0, epoc::event_code::switch_on));
+
+    REQUIRE(fifo.size() == 4);
+
+    REQUIRE(fifo.get_event().type == epoc::event_code::switch_on);
+    REQUIRE(fifo.get_event().adv_pointer_evt_.evtype == epoc::event_type::button1down);
+
+    const epoc::event last_drag = fifo.get_event();
+    REQUIRE(last_drag.adv_pointer_evt_.evtype == epoc::event_type::drag);
+    REQUIRE(last_drag.adv_pointer_evt_.pos == eka2l1::vec2(9, 9));
+
+    REQUIRE(fifo.get_event().adv_pointer_evt_.ptr_num == 1);
+    REQUIRE(fifo.get_event().type == epoc::event_code::null);
+}
+
+TEST_CASE("event_fifo_purge_when_full", "window_fifo") {
+    epoc::event_fifo fifo;
+
+    fifo.queue_event(epoc::event(1, epoc::event_code::focus_lost));
+    fifo.queue_event(epoc::event(1, epoc::event_code::focus_gained));
+
+    for (std::uint8_t i = 0; i < epoc::event_fifo::maximum_element - 2; i++) {
+        fifo.queue_event(make_pointer_event(1, epoc::event_type::drag, i % 2));
+    }
+
+    REQUIRE(fifo.size() == epoc::event_fifo::maximum_element);
+
+    // Pointer events and the pair of focus changes go away
+    fifo.queue_event(epoc::event(1, epoc::event_code::focus_gained));
+    REQUIRE(fifo.size() == 1);
+    REQUIRE(fifo.get_event().type == epoc::event_code::focus_gained);
+}
+
+TEST_CASE("event_fifo_pointer_flood_benchmark", "[.benchmark]") {
+    static constexpr std::uint32_t EVENT_COUNT = 4000000;
+    static constexpr std::uint32_t DRAIN_EVERY = 24;
+
+    epoc::event_fifo fifo;
+    epoc::event evt = make_pointer_event(1, epoc::event_type::drag, 0);
+
+    std::uint64_t drained = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    for (std::uint32_t i = 0; i < EVENT_COUNT; i++) {
+        // Alternate fingers so that moves are not merged together
+        evt.adv_pointer_evt_.ptr_num = static_cast<std::uint8_t>(i & 1);
+        evt.adv_pointer_evt_.pos = eka2l1::vec2(static_cast<int>(i & 0xFF), 0);
+
+        fifo.queue_event(evt);
+
+        if ((i % DRAIN_EVERY) == DRAIN_EVERY - 1) {
+            while (fifo.get_evt_opt()) {
+                drained++;
+            }
+        }
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    REQUIRE(drained > 0);
+
+    WARN("Queued " << EVENT_COUNT << " pointer events (" << drained << " taken out) in " << elapsed / 1000 << " ms, "
+                   << (elapsed * 1000.0) / EVENT_COUNT << " ns per event");
+}